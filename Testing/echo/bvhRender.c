@@ -0,0 +1,276 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/echo.h"
+
+/*
+** Tests:
+** echoBVHSet
+** echoRTRender (with and without parm->bvh and parm->packet)
+**
+** that tracing rays through a bounding volume hierarchy (built with one
+** or more threads, either by echoRTRender or by echoBVHSet), one at a
+** time or in packets, gives the same image as intersecting each ray with
+** all the objects in the scene.  The images are
+** not exactly the same only because the superquadric intersection found
+** by Newton-Raphson depends slightly on the ray's far limit, which depends
+** on the order that objects are tested.
+*/
+
+/* puts many randomly placed objects in a list, which is then either split
+   (as by tenGlyphGen) if bvhThreads is 0, or else put in a BVH built with
+   bvhThreads threads; plus a floor and a light */
+static int
+makeScene(echoScene *scene, int bvhThreads) {
+  static const char me[]="makeScene";
+  echoObject *list, *obj, *inst, *top;
+  echoPos_t matx[16], A[16], B[16], xx, yy, zz, *pos;
+  int ii, *vert;
+
+  airSrandMT(4242);
+  list = echoObjectNew(scene, echoTypeList);
+  for (ii=0; ii<500; ii++) {
+    xx = AIR_AFFINE(0, airDrandMT(), 1, -4, 4);
+    yy = AIR_AFFINE(0, airDrandMT(), 1, -4, 4);
+    zz = AIR_AFFINE(0, airDrandMT(), 1, -1, 3);
+    inst = NULL;
+    switch (ii % 4) {
+    case 0:
+      obj = echoObjectNew(scene, echoTypeSphere);
+      echoSphereSet(obj, xx, yy, zz, AIR_AFFINE(0, airDrandMT(), 1, 0.1, 0.4));
+      break;
+    case 1:
+      obj = echoObjectNew(scene, echoTypeTriangle);
+      echoTriangleSet(obj, xx, yy, zz,
+                      xx + 0.6*airDrandMT(), yy + 0.3, zz - 0.2,
+                      xx - 0.2, yy + 0.5*airDrandMT(), zz + 0.6);
+      break;
+    case 2:
+      /* a little tetrahedron; the TriMesh owns pos and vert */
+      pos = AIR_CALLOC(3*4, echoPos_t);
+      vert = AIR_CALLOC(3*4, int);
+      if (!( pos && vert )) {
+        biffAddf(ECHO, "%s: couldn't allocate mesh %d", me, ii);
+        airFree(pos);
+        airFree(vert);
+        return 1;
+      }
+      ELL_3V_SET(pos + 3*0, xx, yy, zz);
+      ELL_3V_SET(pos + 3*1, xx + 0.5, yy, zz);
+      ELL_3V_SET(pos + 3*2, xx, yy + 0.5, zz);
+      ELL_3V_SET(pos + 3*3, xx, yy, zz + 0.5);
+      ELL_3V_SET(vert + 3*0, 0, 2, 1);
+      ELL_3V_SET(vert + 3*1, 0, 1, 3);
+      ELL_3V_SET(vert + 3*2, 0, 3, 2);
+      ELL_3V_SET(vert + 3*3, 1, 2, 3);
+      obj = echoObjectNew(scene, echoTypeTriMesh);
+      echoTriMeshSet(obj, 4, pos, 4, vert);
+      break;
+    default:
+      if (ii % 8 == 3) {
+        obj = echoObjectNew(scene, echoTypeSuperquad);
+        echoSuperquadSet(obj, 2, 0.6, 1.4);
+      } else {
+        obj = echoObjectNew(scene, echoTypeCube);
+      }
+      ELL_4M_SCALE_SET(A, 0.1 + 0.3*airDrandMT(), 0.2, 0.3);
+      ELL_4M_ROTATE_Z_SET(B, 2*AIR_PI*airDrandMT());
+      ELL_4M_MUL(matx, B, A);
+      ELL_4M_TRANSLATE_SET(B, xx, yy, zz);
+      ELL_4M_MUL(A, B, matx);
+      inst = echoObjectNew(scene, echoTypeInstance);
+      echoInstanceSet(inst, A, obj);
+      break;
+    }
+    echoColorSet(obj, AIR_CAST(echoCol_t, airDrandMT()),
+                 AIR_CAST(echoCol_t, airDrandMT()),
+                 AIR_CAST(echoCol_t, airDrandMT()), 1);
+    if (ii % 5) {
+      echoMatterPhongSet(scene, obj, 0.1f, 0.6f, 0.3f, 40);
+    } else {
+      echoMatterMetalSet(scene, obj, 0.8f, 0.1f, 0.3f, 0);
+    }
+    echoListAdd(list, inst ? inst : obj);
+  }
+  if (bvhThreads) {
+    top = echoObjectNew(scene, echoTypeBVH);
+    if (echoBVHSet(top, list, bvhThreads)) {
+      biffAddf(ECHO, "%s: trouble with %d threads", me, bvhThreads);
+      return 1;
+    }
+  } else {
+    top = echoListSplit3(scene, list, 10);
+  }
+  echoObjectAdd(scene, top);
+
+  obj = echoObjectNew(scene, echoTypeRectangle);
+  echoRectangleSet(obj, -6, -6, -1.5,  12, 0, 0,  0, 12, 0);
+  echoColorSet(obj, 1, 1, 1, 1);
+  echoMatterPhongSet(scene, obj, 0.1f, 0.6f, 0.3f, 40);
+  echoObjectAdd(scene, obj);
+  obj = echoObjectNew(scene, echoTypeRectangle);
+  echoRectangleSet(obj, 3, 2, 8,  1, 0, 0,  0, 1, 0);
+  echoColorSet(obj, 1, 1, 1, 1);
+  echoMatterLightSet(scene, obj, 1, 0);
+  echoObjectAdd(scene, obj);
+  return 0;
+}
+
+/* renders scene into nrgba (only the RGBA channels, since the last one
+   is render time) */
+static int
+render(Nrrd *nrgba, echoScene *scene, int bvh, int packet, int numThreads,
+       int numSamples) {
+  static const char me[]="render";
+  limnCamera *cam;
+  echoRTParm *parm;
+  echoGlobalState *gstate;
+  Nrrd *nraw;
+  size_t cmin[3], cmax[3];
+  airArray *mop;
+
+  mop = airMopNew();
+  cam = limnCameraNew();
+  airMopAdd(mop, cam, (airMopper)limnCameraNix, airMopAlways);
+  parm = echoRTParmNew();
+  airMopAdd(mop, parm, (airMopper)echoRTParmNix, airMopAlways);
+  gstate = echoGlobalStateNew();
+  airMopAdd(mop, gstate, (airMopper)echoGlobalStateNix, airMopAlways);
+  nraw = nrrdNew();
+  airMopAdd(mop, nraw, (airMopper)nrrdNuke, airMopAlways);
+
+  ELL_3V_SET(cam->from, 9, 7, 12);
+  ELL_3V_SET(cam->at, 0, 0, 0);
+  ELL_3V_SET(cam->up, 0, 0, 1);
+  cam->neer = cam->dist = cam->faar = 0;
+  cam->atRelative = AIR_TRUE;
+  cam->rightHanded = AIR_TRUE;
+  cam->uRange[0] = -5;
+  cam->uRange[1] = 5;
+  cam->vRange[0] = -5;
+  cam->vRange[1] = 5;
+  /* without jittering, the image doesn't depend on the number of threads.
+     With it, the image depends on the random numbers, which are drawn
+     per-thread: with seedRand off each thread is seeded with its index
+     (instead of the time), so renders with the same number of threads
+     are repeatable */
+  parm->jitterType = numSamples > 1 ? echoJitterGrid : echoJitterNone;
+  parm->numSamples = numSamples;
+  parm->seedRand = AIR_FALSE;
+  parm->imgResU = 80;
+  parm->imgResV = 80;
+  parm->shadow = 1.0;
+  parm->maxRecDepth = 4;
+  parm->bvh = bvh;
+  parm->packet = packet;
+  parm->numThreads = numThreads;
+  if (echoRTRender(nraw, cam, scene, parm, gstate)) {
+    biffAddf(ECHO, "%s: trouble rendering", me);
+    airMopError(mop); return 1;
+  }
+  ELL_3V_SET(cmin, 0, 0, 0);
+  ELL_3V_SET(cmax, 3, nraw->axis[1].size-1, nraw->axis[2].size-1);
+  if (nrrdCrop(nrgba, nraw, cmin, cmax)) {
+    biffMovef(ECHO, NRRD, "%s: trouble cropping", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+#define ALT_NUM 7
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  /* alternatives to the split scene without BVH and with 1 thread:
+     (BVH threads for echoBVHSet, parm->bvh, parm->packet,
+     parm->numThreads, parm->numSamples); the jittered 16-sample
+     renders use 1 thread, like the reference, so that they use the
+     same random numbers */
+  static const int bvhThreads[ALT_NUM] = {0, 0, 1, 3, 0, 0, 2};
+  static const int bvh[ALT_NUM] = {AIR_TRUE, AIR_TRUE, AIR_FALSE, AIR_TRUE,
+                                   AIR_TRUE, AIR_TRUE, AIR_TRUE};
+  static const int packet[ALT_NUM] = {AIR_FALSE, AIR_FALSE, AIR_FALSE,
+                                      AIR_FALSE, AIR_TRUE, AIR_FALSE,
+                                      AIR_TRUE};
+  static const int numThreads[ALT_NUM] = {1, 3, 1, 2, 1, 1, 1};
+  static const int numSamples[ALT_NUM] = {1, 1, 1, 1, 16, 16, 16};
+  echoScene *scene;
+  Nrrd *nref, *nalt;
+  airArray *mop;
+  unsigned int ai;
+  int differ;
+  char explain[AIR_STRLEN_LARGE];
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nref = nrrdNew();
+  airMopAdd(mop, nref, (airMopper)nrrdNuke, airMopAlways);
+  nalt = nrrdNew();
+  airMopAdd(mop, nalt, (airMopper)nrrdNuke, airMopAlways);
+
+  for (ai=0; ai<ALT_NUM; ai++) {
+    if (!ai || numSamples[ai] != numSamples[ai-1]) {
+      scene = echoSceneNew();
+      airMopAdd(mop, scene, (airMopper)echoSceneNix, airMopAlways);
+      if (makeScene(scene, 0)
+          || render(nref, scene, AIR_FALSE, AIR_FALSE, 1, numSamples[ai])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(ECHO), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+    }
+    /* new scene for each alternative, since the BVH built by
+       echoRTRender stays in the scene */
+    scene = echoSceneNew();
+    airMopAdd(mop, scene, (airMopper)echoSceneNix, airMopAlways);
+    if (makeScene(scene, bvhThreads[ai])
+        || render(nalt, scene, bvh[ai], packet[ai], numThreads[ai],
+                  numSamples[ai])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(ECHO), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (nrrdCompare(nref, nalt, AIR_TRUE /* onlyData */,
+                    1e-4 /* epsilon, for superquads */, &differ, explain)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble comparing:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (differ) {
+      fprintf(stderr, "%s: image with BVH (%d %d %d %d %d) differs: %s\n",
+              me, bvhThreads[ai], bvh[ai], packet[ai], numThreads[ai],
+              numSamples[ai], explain);
+      airMopError(mop); return 1;
+    }
+  }
+  printf("%s: good: same images with BVHs as without\n", me);
+
+  airMopOkay(mop);
+  return 0;
+}
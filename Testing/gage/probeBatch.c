@@ -0,0 +1,168 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageProbeBatch
+**
+** that the answers from probing a batch of positions (in random order,
+** and some outside the volume) are exactly the same as from probing
+** them one at a time with gageProbeSpace
+*/
+
+#define POS_NUM 2000
+#define ANS_NUM 3
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  Nrrd *nin;
+  double *vin, *pos, *ans[ANS_NUM], kparm[NRRD_KERNEL_PARMS_NUM];
+  const double *ansPtr[ANS_NUM];
+  const gagePerVolume *bpvl[ANS_NUM];
+  int item[ANS_NUM] = {gageSclValue, gageSclGradVec, gageSclHessian},
+    *errNum, E;
+  size_t stride[ANS_NUM], ii, nn, sx=20, sy=18, sz=16;
+  unsigned int ai, vi, ansLen[ANS_NUM], si;
+  airArray *mop;
+  gageContext *gctx;
+  gagePerVolume *pvl;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeDouble, 3, sx, sy, sz)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.2, 0.7);
+  vin = AIR_CAST(double *, nin->data);
+  nn = nrrdElementNumber(nin);
+  airSrandMT(4242);
+  for (ii=0; ii<nn; ii++) {
+    vin[ii] = airDrandMT();
+  }
+
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_TRUE);
+  kparm[0] = 1.0; kparm[1] = 0.0; kparm[2] = 0.5;
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, nrrdKernelBCCubic, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11, nrrdKernelBCCubicD, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel22, nrrdKernelBCCubicDD, kparm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  for (ai=0; ai<ANS_NUM; ai++) {
+    if (!E) E |= gageQueryItemOn(gctx, pvl, item[ai]);
+  }
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up:\n%s\n", me, err);
+    airMopError(mop); return 1;
+  }
+
+  /* random positions, some of which are outside */
+  pos = AIR_CALLOC(3*POS_NUM, double);
+  airMopAdd(mop, pos, airFree, airMopAlways);
+  errNum = AIR_CALLOC(POS_NUM, int);
+  airMopAdd(mop, errNum, airFree, airMopAlways);
+  for (ii=0; ii<POS_NUM; ii++) {
+    pos[0 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sx);
+    pos[1 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sy);
+    pos[2 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sz);
+  }
+  for (ai=0; ai<ANS_NUM; ai++) {
+    bpvl[ai] = pvl;
+    ansPtr[ai] = gageAnswerPointer(gctx, pvl, item[ai]);
+    ansLen[ai] = gageAnswerLength(gctx, pvl, item[ai]);
+    /* padding the answers, to test the strides */
+    stride[ai] = ansLen[ai] + 1;
+    ans[ai] = AIR_CALLOC(stride[ai]*POS_NUM, double);
+    airMopAdd(mop, ans[ai], airFree, airMopAlways);
+  }
+
+  /* si == 0: index space without clamping; si == 1: world space with
+     clamping */
+  for (si=0; si<2; si++) {
+    int indexSpace, clamp;
+    size_t failNum;
+    indexSpace = !si;
+    clamp = !!si;
+    if (gageProbeBatch(gctx, ans, stride, bpvl, item, ANS_NUM, errNum,
+                       pos, 3, POS_NUM, indexSpace, clamp)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing batch:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    failNum = 0;
+    for (ii=0; ii<POS_NUM; ii++) {
+      const double *pp;
+      int ret;
+      pp = pos + 3*ii;
+      ret = gageProbeSpace(gctx, pp[0], pp[1], pp[2], indexSpace, clamp);
+      if (!!ret != (gageErrNone != errNum[ii])) {
+        fprintf(stderr, "%s: position %u: single probe %s, batch %s\n", me,
+                AIR_CAST(unsigned int, ii), ret ? "failed" : "okay",
+                gageErrNone != errNum[ii] ? "failed" : "okay");
+        airMopError(mop); return 1;
+      }
+      failNum += !!ret;
+      for (ai=0; ai<ANS_NUM; ai++) {
+        for (vi=0; vi<ansLen[ai]; vi++) {
+          double bval;
+          bval = ans[ai][vi + stride[ai]*ii];
+          if (ret ? AIR_EXISTS(bval) : bval != ansPtr[ai][vi]) {
+            fprintf(stderr, "%s: position %u: batch %s[%u] %.17g != "
+                    "single %.17g\n", me, AIR_CAST(unsigned int, ii),
+                    airEnumStr(gageScl, item[ai]), vi, bval,
+                    ret ? AIR_NAN : ansPtr[ai][vi]);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+    }
+    if (clamp ? failNum : !failNum) {
+      fprintf(stderr, "%s: unexpectedly %u failed probes (clamp %d)\n", me,
+              AIR_CAST(unsigned int, failNum), clamp);
+      airMopError(mop); return 1;
+    }
+    printf("%s: good: %u positions (%u outside), %s space\n", me,
+           POS_NUM, AIR_CAST(unsigned int, failNum),
+           indexSpace ? "index" : "world");
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,176 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageProbe
+** gageScl3PFilterN
+**
+** that the filter weights gage computes for its most common kernels
+** (without calling the kernels' evalN_d) are exactly those from evalN_d,
+** and that the scalar value, gradient, and Hessian (computed by gage in
+** one pass over the value cache) are the same as from gageScl3PFilterN,
+** at random positions, integral positions, and the volume edges
+*/
+
+#define KERN_NUM 5
+#define POS_NUM 500
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  Nrrd *nin;
+  double *vin, *fw, ww[3*8], val, gvec[3], hess[9], pos[3];
+  static const char *const kstr[KERN_NUM][3] = {
+    {"tent", "cubicd:1,0.5", "cubicdd:1,0.5"},
+    {"cubic:1,0", "cubicd:1,0", "cubicdd:1,0"},
+    {"cubic:0,0.5", "cubicd:0,0.5", "cubicdd:0,0.5"},
+    {"bspl3", "bspl3d", "bspl3dd"},
+    {"c4hexic", "c4hexicd", "c4hexicdd"}};
+  static const int kidx[3] = {gageKernel00, gageKernel11, gageKernel22},
+    needD[3] = {AIR_TRUE, AIR_TRUE, AIR_TRUE};
+  size_t ii, nn, sx=14, sy=13, sz=12;
+  unsigned int ki, kk, pi, vi, fd;
+  const double *ans[3];
+  airArray *mop;
+  int E;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeDouble, 3, sx, sy, sz)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.3, 0.8);
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoCenter,
+                     nrrdCenterNode, nrrdCenterNode, nrrdCenterNode);
+  vin = AIR_CAST(double *, nin->data);
+  nn = nrrdElementNumber(nin);
+  airSrandMT(4545);
+  for (ii=0; ii<nn; ii++) {
+    vin[ii] = airDrandMT();
+  }
+
+  for (ki=0; ki<KERN_NUM; ki++) {
+    NrrdKernelSpec *ksp[3];
+    gageContext *gctx;
+    gagePerVolume *pvl;
+    gctx = gageContextNew();
+    airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+    gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+    gageParmSet(gctx, gageParmCheckIntegrals, AIR_FALSE);
+    gageParmSet(gctx, gageParmGradMagCurvMin, 0.0);
+    E = 0;
+    for (kk=0; kk<3; kk++) {
+      ksp[kk] = nrrdKernelSpecNew();
+      airMopAdd(mop, ksp[kk], (airMopper)nrrdKernelSpecNix, airMopAlways);
+      if (!E) E |= nrrdKernelSpecParse(ksp[kk], kstr[ki][kk]);
+    }
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing kernels:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+    for (kk=0; kk<3; kk++) {
+      if (!E) E |= gageKernelSet(gctx, kidx[kk], ksp[kk]->kernel,
+                                 ksp[kk]->parm);
+    }
+    if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+    if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclValue);
+    if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclGradVec);
+    if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclHessian);
+    if (!E) E |= gageUpdate(gctx);
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    ans[0] = gageAnswerPointer(gctx, pvl, gageSclValue);
+    ans[1] = gageAnswerPointer(gctx, pvl, gageSclGradVec);
+    ans[2] = gageAnswerPointer(gctx, pvl, gageSclHessian);
+    fd = 2*gctx->radius;
+    for (pi=0; pi<POS_NUM; pi++) {
+      switch (pi % 5) {
+      case 0:
+        /* integral positions */
+        ELL_3V_SET(pos, airRandInt(sx), airRandInt(sy), airRandInt(sz));
+        break;
+      case 1:
+        /* at the high edge, where fractional position is 1 */
+        ELL_3V_SET(pos, sx-1, sy-1, airDrandMT()*(sz-1));
+        break;
+      default:
+        ELL_3V_SET(pos, airDrandMT()*(sx-1), airDrandMT()*(sy-1),
+                   airDrandMT()*(sz-1));
+        break;
+      }
+      if (gageProbe(gctx, pos[0], pos[1], pos[2])) {
+        fprintf(stderr, "%s: probe (%g,%g,%g) failed: %s\n", me,
+                pos[0], pos[1], pos[2], gctx->errStr);
+        airMopError(mop); return 1;
+      }
+      for (kk=0; kk<3; kk++) {
+        fw = gctx->fw + fd*3*kidx[kk];
+        ksp[kk]->kernel->evalN_d(ww, gctx->fsl, fd*3, ksp[kk]->parm);
+        for (vi=0; vi<fd*3; vi++) {
+          if (fw[vi] != ww[vi]) {
+            fprintf(stderr, "%s: %s at (%g,%g,%g): weight[%u] %.17g != "
+                    "evalN_d %.17g\n", me, kstr[ki][kk],
+                    pos[0], pos[1], pos[2], vi, fw[vi], ww[vi]);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+      gageScl3PFilterN(gctx->shape, fd, pvl->iv3, pvl->iv2, pvl->iv1,
+                       gctx->fw + fd*3*gageKernel00,
+                       gctx->fw + fd*3*gageKernel11,
+                       gctx->fw + fd*3*gageKernel22,
+                       &val, gvec, hess, needD);
+      for (vi=0; vi<9; vi++) {
+        if ((!vi && val != ans[0][0])
+            || (vi < 3 && gvec[vi] != ans[1][vi])
+            || hess[vi] != ans[2][vi]) {
+          fprintf(stderr, "%s: %s at (%g,%g,%g): answers differ from "
+                  "gageScl3PFilterN (at [%u])\n", me, kstr[ki][0],
+                  pos[0], pos[1], pos[2], vi);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    printf("%s: good: %s\n", me, kstr[ki][0]);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
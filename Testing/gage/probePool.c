@@ -0,0 +1,202 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageProbePoolNew
+** gageProbePoolPos
+** gageProbePoolGrid
+** gageProbePoolNix
+**
+** that probing positions (some outside) and grids with a pool of threads
+** gives exactly the same answers as probing one at a time with
+** gageProbeSpace, for any number of threads and any chunk size
+*/
+
+#define POS_NUM 1500
+#define ALT_NUM 4
+
+static int
+check(const char *me, const char *what, const double *out,
+      const double *ans, unsigned int ansLen, size_t ii, int ret) {
+  unsigned int vi;
+
+  out += ansLen*ii;
+  for (vi=0; vi<ansLen; vi++) {
+    if (ret ? AIR_EXISTS(out[vi]) : out[vi] != ans[vi]) {
+      fprintf(stderr, "%s: %s %u: pool [%u] %.17g != single %.17g\n", me,
+              what, AIR_CAST(unsigned int, ii), vi, out[vi],
+              ret ? AIR_NAN : ans[vi]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  Nrrd *nin, *nout;
+  double *vin, *pos, *out, kparm[NRRD_KERNEL_PARMS_NUM],
+    orig[3], edge[3*3];
+  const double *ans;
+  static const unsigned int threadNum[ALT_NUM] = {1, 2, 3, 5};
+  static const size_t chunkSize[ALT_NUM] = {0, 1, 77, 1000};
+  size_t ii, nn, sx=20, sy=18, sz=16, gsize[3] = {13, 11, 7}, coord[3],
+    failNum;
+  unsigned int ti, ansLen;
+  airArray *mop;
+  gageContext *gctx;
+  gagePerVolume *pvl;
+  int E;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeDouble, 3, sx, sy, sz)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.2, 0.7);
+  vin = AIR_CAST(double *, nin->data);
+  nn = nrrdElementNumber(nin);
+  airSrandMT(4343);
+  for (ii=0; ii<nn; ii++) {
+    vin[ii] = airDrandMT();
+  }
+
+  gctx = gageContextNew();
+  airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+  gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+  gageParmSet(gctx, gageParmCheckIntegrals, AIR_TRUE);
+  kparm[0] = 1.0; kparm[1] = 0.0; kparm[2] = 0.5;
+  E = 0;
+  if (!E) E |= !(pvl = gagePerVolumeNew(gctx, nin, gageKindScl));
+  if (!E) E |= gageKernelSet(gctx, gageKernel00, nrrdKernelBCCubic, kparm);
+  if (!E) E |= gageKernelSet(gctx, gageKernel11, nrrdKernelBCCubicD, kparm);
+  if (!E) E |= gagePerVolumeAttach(gctx, pvl);
+  if (!E) E |= gageQueryItemOn(gctx, pvl, gageSclGradVec);
+  if (!E) E |= gageUpdate(gctx);
+  if (E) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up:\n%s\n", me, err);
+    airMopError(mop); return 1;
+  }
+  ans = gageAnswerPointer(gctx, pvl, gageSclGradVec);
+  ansLen = gageAnswerLength(gctx, pvl, gageSclGradVec);
+
+  /* random positions, some of which are outside */
+  pos = AIR_CALLOC(3*POS_NUM, double);
+  airMopAdd(mop, pos, airFree, airMopAlways);
+  for (ii=0; ii<POS_NUM; ii++) {
+    pos[0 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sx);
+    pos[1 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sy);
+    pos[2 + 3*ii] = AIR_AFFINE(0, airDrandMT(), 1, -1, sz);
+  }
+  /* a slightly oblique grid, in world space */
+  ELL_3V_SET(orig, 0.5, 0.9, 0.6);
+  ELL_3V_SET(edge + 0, 1.4, 0.1, 0.0);
+  ELL_3V_SET(edge + 3, 0.0, 1.8, 0.2);
+  ELL_3V_SET(edge + 6, 0.1, 0.0, 1.5);
+
+  for (ti=0; ti<ALT_NUM; ti++) {
+    gageProbePool *pool;
+    if (!(pool = gageProbePoolNew(gctx, threadNum[ti]))) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble making pool:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    if (chunkSize[ti]) {
+      pool->chunkSize = chunkSize[ti];
+    }
+    E = gageProbePoolPos(pool, nout, nrrdTypeDouble, pvl, gageSclGradVec,
+                         pos, 3, POS_NUM, AIR_TRUE, AIR_FALSE);
+    failNum = pool->failNum;
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing positions:\n%s\n", me, err);
+      gageProbePoolNix(pool); airMopError(mop); return 1;
+    }
+    out = AIR_CAST(double *, nout->data);
+    nn = 0;
+    for (ii=0; ii<POS_NUM; ii++) {
+      int ret;
+      ret = gageProbeSpace(gctx, pos[0 + 3*ii], pos[1 + 3*ii], pos[2 + 3*ii],
+                           AIR_TRUE, AIR_FALSE);
+      nn += !!ret;
+      if (check(me, "position", out, ans, ansLen, ii, ret)) {
+        gageProbePoolNix(pool); airMopError(mop); return 1;
+      }
+    }
+    if (nn != failNum || !failNum) {
+      fprintf(stderr, "%s: pool failNum %u, but %u single failures\n", me,
+              AIR_CAST(unsigned int, failNum), AIR_CAST(unsigned int, nn));
+      gageProbePoolNix(pool); airMopError(mop); return 1;
+    }
+
+    E = gageProbePoolGrid(pool, nout, nrrdTypeDouble, pvl, gageSclGradVec,
+                          orig, edge, gsize, 3, 3, AIR_FALSE, AIR_TRUE);
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing grid:\n%s\n", me, err);
+      gageProbePoolNix(pool); airMopError(mop); return 1;
+    }
+    out = AIR_CAST(double *, nout->data);
+    coord[0] = coord[1] = coord[2] = 0;
+    for (ii=0; ii<gsize[0]*gsize[1]*gsize[2]; ii++) {
+      double pp[3];
+      unsigned int ai, vi;
+      int ret;
+      ELL_3V_COPY(pp, orig);
+      for (ai=0; ai<3; ai++) {
+        for (vi=0; vi<3; vi++) {
+          pp[vi] += AIR_CAST(double, coord[ai])*edge[vi + 3*ai];
+        }
+      }
+      ret = gageProbeSpace(gctx, pp[0], pp[1], pp[2], AIR_FALSE, AIR_TRUE);
+      if (check(me, "grid point", out, ans, ansLen, ii, ret)) {
+        gageProbePoolNix(pool); airMopError(mop); return 1;
+      }
+      NRRD_COORD_INCR(coord, gsize, 3, 0);
+    }
+    gageProbePoolNix(pool);
+    printf("%s: good: %u threads (%u positions outside)\n", me,
+           threadNum[ti], AIR_CAST(unsigned int, failNum));
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
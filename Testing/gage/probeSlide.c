@@ -0,0 +1,185 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/gage.h"
+
+/*
+** Tests:
+** gageProbe
+** gageContextCopy
+** gagePointReset
+**
+** that probing along paths that move by one voxel at a time (so that
+** the iv3 caches are slid rather than refilled) gives exactly the same
+** answers as probing the same positions with a copy of the context
+** after gagePointReset (which forces the iv3 caches to be completely
+** refilled), for scalar and vector volumes, with kernels of different
+** support
+*/
+
+#define STEP_NUM 400
+#define KERN_NUM 3
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  Nrrd *nscl, *nvec;
+  double *vscl, pos[3], step[3];
+  float *vvec;
+  const double *sptr, *vptr, *rsptr, *rvptr;
+  static const char *const kstr[KERN_NUM][2] = {
+    {"tent", "fordif"},
+    {"bccubic:1,0,0.5", "bccubicd:1,0,0.5"},
+    {"c4hexic", "c4hexicd"}};
+  size_t ii, nn, sx=19, sy=17, sz=15;
+  unsigned int ki, pi, si, vi, slen, vlen;
+  airArray *mop;
+  int E;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nscl = nrrdNew();
+  airMopAdd(mop, nscl, (airMopper)nrrdNuke, airMopAlways);
+  nvec = nrrdNew();
+  airMopAdd(mop, nvec, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nscl, nrrdTypeDouble, 3, sx, sy, sz)
+      || nrrdAlloc_va(nvec, nrrdTypeFloat, 4, AIR_CAST(size_t, 3),
+                      sx, sy, sz)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nscl, nrrdAxisInfoSpacing, 1.0, 1.2, 0.7);
+  nrrdAxisInfoSet_va(nvec, nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.2, 0.7);
+  vscl = AIR_CAST(double *, nscl->data);
+  nn = nrrdElementNumber(nscl);
+  airSrandMT(4444);
+  for (ii=0; ii<nn; ii++) {
+    vscl[ii] = airDrandMT();
+  }
+  vvec = AIR_CAST(float *, nvec->data);
+  for (ii=0; ii<3*nn; ii++) {
+    vvec[ii] = AIR_CAST(float, airDrandMT());
+  }
+
+  for (ki=0; ki<KERN_NUM; ki++) {
+    NrrdKernelSpec *ksp00, *ksp11;
+    gageContext *gctx, *rctx;
+    gagePerVolume *spvl, *vpvl;
+    ksp00 = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp00, (airMopper)nrrdKernelSpecNix, airMopAlways);
+    ksp11 = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp11, (airMopper)nrrdKernelSpecNix, airMopAlways);
+    gctx = gageContextNew();
+    airMopAdd(mop, gctx, (airMopper)gageContextNix, airMopAlways);
+    gageParmSet(gctx, gageParmRenormalize, AIR_FALSE);
+    gageParmSet(gctx, gageParmCheckIntegrals, AIR_TRUE);
+    E = 0;
+    if (!E) E |= nrrdKernelSpecParse(ksp00, kstr[ki][0]);
+    if (!E) E |= nrrdKernelSpecParse(ksp11, kstr[ki][1]);
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing kernels:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!E) E |= !(spvl = gagePerVolumeNew(gctx, nscl, gageKindScl));
+    if (!E) E |= !(vpvl = gagePerVolumeNew(gctx, nvec, gageKindVec));
+    if (!E) E |= gageKernelSet(gctx, gageKernel00, ksp00->kernel,
+                               ksp00->parm);
+    if (!E) E |= gageKernelSet(gctx, gageKernel11, ksp11->kernel,
+                               ksp11->parm);
+    if (!E) E |= gagePerVolumeAttach(gctx, spvl);
+    if (!E) E |= gagePerVolumeAttach(gctx, vpvl);
+    if (!E) E |= gageQueryItemOn(gctx, spvl, gageSclGradVec);
+    if (!E) E |= gageQueryItemOn(gctx, vpvl, gageVecJacobian);
+    if (!E) E |= gageUpdate(gctx);
+    if (!E) E |= !(rctx = gageContextCopy(gctx));
+    if (E) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble setting up:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    sptr = gageAnswerPointer(gctx, spvl, gageSclGradVec);
+    slen = gageAnswerLength(gctx, spvl, gageSclGradVec);
+    vptr = gageAnswerPointer(gctx, vpvl, gageVecJacobian);
+    vlen = gageAnswerLength(gctx, vpvl, gageVecJacobian);
+    airMopAdd(mop, rctx, (airMopper)gageContextNix, airMopAlways);
+    rsptr = gageAnswerPointer(rctx, rctx->pvl[0], gageSclGradVec);
+    rvptr = gageAnswerPointer(rctx, rctx->pvl[1], gageVecJacobian);
+
+    /* pi == 0: scanline along X; pi == 1: slanted, sub-voxel steps, which
+       move along one, two, or three axes at a time; pi == 2: backwards
+       along Z, across the volume edge */
+    for (pi=0; pi<3; pi++) {
+      switch (pi) {
+      case 0:
+        ELL_3V_SET(pos, 0.2, 7.3, 6.6);
+        ELL_3V_SET(step, 18.0/STEP_NUM, 0, 0);
+        break;
+      case 1:
+        ELL_3V_SET(pos, 1.1, 2.3, 1.4);
+        ELL_3V_SET(step, 16.0/STEP_NUM, 13.3/STEP_NUM, 11.1/STEP_NUM);
+        break;
+      case 2:
+        ELL_3V_SET(pos, 8.4, 9.1, 14.0);
+        ELL_3V_SET(step, 0, 0, -14.0/STEP_NUM);
+        break;
+      }
+      for (si=0; si<STEP_NUM; si++) {
+        gagePointReset(&(rctx->point));
+        if (gageProbe(gctx, pos[0], pos[1], pos[2])
+            || gageProbe(rctx, pos[0], pos[1], pos[2])) {
+          fprintf(stderr, "%s: probe (%g,%g,%g) failed: %s\n", me,
+                  pos[0], pos[1], pos[2], gctx->errStr);
+          airMopError(mop); return 1;
+        }
+        for (vi=0; vi<slen; vi++) {
+          if (sptr[vi] != rsptr[vi]) {
+            fprintf(stderr, "%s: %s (%g,%g,%g): scl[%u] %.17g != %.17g\n",
+                    me, kstr[ki][0], pos[0], pos[1], pos[2], vi,
+                    sptr[vi], rsptr[vi]);
+            airMopError(mop); return 1;
+          }
+        }
+        for (vi=0; vi<vlen; vi++) {
+          if (vptr[vi] != rvptr[vi]) {
+            fprintf(stderr, "%s: %s (%g,%g,%g): vec[%u] %.17g != %.17g\n",
+                    me, kstr[ki][0], pos[0], pos[1], pos[2], vi,
+                    vptr[vi], rvptr[vi]);
+            airMopError(mop); return 1;
+          }
+        }
+        ELL_3V_INCR(pos, step);
+      }
+    }
+    printf("%s: good: %s\n", me, kstr[ki][0]);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,269 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/hoover.h"
+
+/*
+** Tests:
+** hooverContextNew
+** hooverRender
+** hooverThreadStatsPrint
+**
+** that rendering with tiles of various sizes (and with whole scanlines),
+** with one or more threads, casts every ray exactly once and gives
+** exactly the same image (also when a tile is bigger than the image),
+** and that the per-thread statistics add up to the same totals.  The
+** "volume" rendered here is an analytic function of position, summed
+** along rays that stop once the sum gets big enough.
+*/
+
+#define SIZE_U 53
+#define SIZE_V 37
+#define ALT_NUM 7
+
+typedef struct {
+  double *img;
+  unsigned int *hits;
+} tileRender;
+
+typedef struct {
+  int ui, vi;
+  double sum;
+} tileThread;
+
+static int
+renderBegin(void **renderP, void *user) {
+  *renderP = user;
+  return 0;
+}
+
+static int
+threadBegin(void **threadP, void *render, void *user, int whichThread) {
+  AIR_UNUSED(render);
+  AIR_UNUSED(user);
+  AIR_UNUSED(whichThread);
+  *threadP = calloc(1, sizeof(tileThread));
+  return !*threadP;
+}
+
+static int
+rayBegin(void *_thread, void *render, void *user, int uIndex, int vIndex,
+         double rayLen, double rayStartWorld[3], double rayStartIndex[3],
+         double rayDirWorld[3], double rayDirIndex[3]) {
+  tileThread *thread;
+
+  AIR_UNUSED(render);
+  AIR_UNUSED(user);
+  AIR_UNUSED(rayLen);
+  AIR_UNUSED(rayStartWorld);
+  AIR_UNUSED(rayStartIndex);
+  AIR_UNUSED(rayDirWorld);
+  AIR_UNUSED(rayDirIndex);
+  thread = AIR_CAST(tileThread *, _thread);
+  thread->ui = uIndex;
+  thread->vi = vIndex;
+  thread->sum = 0;
+  return 0;
+}
+
+static double
+sample(void *_thread, void *render, void *user, int num, double rayT,
+       int inside, double samplePosWorld[3], double samplePosIndex[3]) {
+  tileThread *thread;
+
+  AIR_UNUSED(render);
+  AIR_UNUSED(user);
+  AIR_UNUSED(num);
+  AIR_UNUSED(rayT);
+  AIR_UNUSED(samplePosWorld);
+  thread = AIR_CAST(tileThread *, _thread);
+  if (inside) {
+    thread->sum += 0.1*(1 + sin(0.4*samplePosIndex[0])
+                        *cos(0.3*samplePosIndex[1] + 0.2*samplePosIndex[2]));
+  }
+  /* finish rays early, as with opacity in compositing */
+  return thread->sum > 2 ? 0.0 : 0.05;
+}
+
+static int
+rayEnd(void *_thread, void *_render, void *user) {
+  tileThread *thread;
+  tileRender *render;
+
+  AIR_UNUSED(user);
+  thread = AIR_CAST(tileThread *, _thread);
+  render = AIR_CAST(tileRender *, _render);
+  render->img[thread->ui + SIZE_U*thread->vi] = thread->sum;
+  render->hits[thread->ui + SIZE_U*thread->vi] += 1;
+  return 0;
+}
+
+static int
+threadEnd(void *thread, void *render, void *user) {
+  AIR_UNUSED(render);
+  AIR_UNUSED(user);
+  free(thread);
+  return 0;
+}
+
+static int
+renderEnd(void *render, void *user) {
+  AIR_UNUSED(render);
+  AIR_UNUSED(user);
+  return 0;
+}
+
+/* renders into rndr, and puts total statistics in *total */
+static int
+render(tileRender *rndr, hooverThreadStats *total,
+       int tileSize, unsigned int threadNum) {
+  hooverContext *ctx;
+  int E, errCode, errThread;
+  unsigned int ti;
+
+  memset(rndr->hits, 0, SIZE_U*SIZE_V*sizeof(unsigned int));
+  ctx = hooverContextNew();
+  ELL_3V_SET(ctx->cam->from, 3, 5, 4);
+  ELL_3V_SET(ctx->cam->at, 0, 0, 0);
+  ELL_3V_SET(ctx->cam->up, 0, 0, 1);
+  ctx->cam->atRelative = AIR_TRUE;
+  ctx->cam->neer = -2;
+  ctx->cam->dist = 0;
+  ctx->cam->faar = 2;
+  ctx->cam->fov = 25;
+  ELL_3V_SET(ctx->volSize, 30, 25, 20);
+  ELL_3V_SET(ctx->volSpacing, 1.0, 1.0, 1.0);
+  ctx->imgSize[0] = SIZE_U;
+  ctx->imgSize[1] = SIZE_V;
+  ctx->user = rndr;
+  ctx->numThreads = threadNum;
+  ctx->tileSize = tileSize;
+  ctx->renderBegin = renderBegin;
+  ctx->threadBegin = threadBegin;
+  ctx->rayBegin = rayBegin;
+  ctx->sample = sample;
+  ctx->rayEnd = rayEnd;
+  ctx->threadEnd = threadEnd;
+  ctx->renderEnd = renderEnd;
+  E = hooverRender(ctx, &errCode, &errThread);
+  if (E) {
+    if (hooverErrInit == E) {
+      char *err = biffGetDone(HOOVER);
+      fprintf(stderr, "trouble:\n%s", err);
+      free(err);
+    } else {
+      fprintf(stderr, "%s error (code %d, thread %d)\n",
+              airEnumStr(hooverErr, E), errCode, errThread);
+    }
+    hooverContextNix(ctx);
+    return 1;
+  }
+  memset(total, 0, sizeof(hooverThreadStats));
+  for (ti=0; ti<threadNum; ti++) {
+    total->tileNum += ctx->threadStats[ti].tileNum;
+    total->rayNum += ctx->threadStats[ti].rayNum;
+    total->sampleNum += ctx->threadStats[ti].sampleNum;
+    total->skipNum += ctx->threadStats[ti].skipNum;
+  }
+  if (3 == threadNum) {
+    hooverThreadStatsPrint(stdout, ctx);
+  }
+  hooverContextNix(ctx);
+  return 0;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  /* alternatives to scanlines with one thread: (tile size, threads);
+     the last tile size is far bigger than the image */
+  static const int tileSize[ALT_NUM] = {16, 7, 1, 0, 16, 64, 100000};
+  static const unsigned int threadNum[ALT_NUM] = {1, 1, 1, 3, 3, 2, 2};
+  tileRender rndrS, rndrM;
+  hooverThreadStats statS, statM;
+  airArray *mop;
+  unsigned int ai, ii, tileNum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  rndrS.img = AIR_CALLOC(SIZE_U*SIZE_V, double);
+  airMopAdd(mop, rndrS.img, airFree, airMopAlways);
+  rndrS.hits = AIR_CALLOC(SIZE_U*SIZE_V, unsigned int);
+  airMopAdd(mop, rndrS.hits, airFree, airMopAlways);
+  rndrM.img = AIR_CALLOC(SIZE_U*SIZE_V, double);
+  airMopAdd(mop, rndrM.img, airFree, airMopAlways);
+  rndrM.hits = AIR_CALLOC(SIZE_U*SIZE_V, unsigned int);
+  airMopAdd(mop, rndrM.hits, airFree, airMopAlways);
+  if (!( rndrS.img && rndrS.hits && rndrM.img && rndrM.hits )) {
+    fprintf(stderr, "%s: couldn't allocate images\n", me);
+    airMopError(mop); return 1;
+  }
+
+  if (render(&rndrS, &statS, 0, 1)) {
+    fprintf(stderr, "%s: trouble rendering scanlines\n", me);
+    airMopError(mop); return 1;
+  }
+  if (!( SIZE_V == statS.tileNum
+         && SIZE_U*SIZE_V == statS.rayNum
+         && statS.skipNum > 0 )) {
+    fprintf(stderr, "%s: got unexpected stats (%u tiles, %u rays, %u "
+            "skipped) for scanlines\n", me, statS.tileNum,
+            AIR_CAST(unsigned int, statS.rayNum),
+            AIR_CAST(unsigned int, statS.skipNum));
+    airMopError(mop); return 1;
+  }
+  for (ai=0; ai<ALT_NUM; ai++) {
+    if (render(&rndrM, &statM, tileSize[ai], threadNum[ai])) {
+      fprintf(stderr, "%s: trouble rendering with tile size %d, "
+              "%u threads\n", me, tileSize[ai], threadNum[ai]);
+      airMopError(mop); return 1;
+    }
+    for (ii=0; ii<SIZE_U*SIZE_V; ii++) {
+      if (1 != rndrM.hits[ii] || rndrS.img[ii] != rndrM.img[ii]) {
+        fprintf(stderr, "%s: pixel (%u,%u) hit %u times, value %g != %g "
+                "with tile size %d, %u threads\n", me, ii % SIZE_U,
+                ii / SIZE_U, rndrM.hits[ii], rndrM.img[ii], rndrS.img[ii],
+                tileSize[ai], threadNum[ai]);
+        airMopError(mop); return 1;
+      }
+    }
+    tileNum = (tileSize[ai]
+               ? (((SIZE_U + tileSize[ai] - 1)/tileSize[ai])
+                  *((SIZE_V + tileSize[ai] - 1)/tileSize[ai]))
+               : SIZE_V);
+    if (!( tileNum == statM.tileNum
+           && statS.rayNum == statM.rayNum
+           && statS.sampleNum == statM.sampleNum
+           && statS.skipNum == statM.skipNum )) {
+      fprintf(stderr, "%s: stats differ with tile size %d, %u threads\n",
+              me, tileSize[ai], threadNum[ai]);
+      airMopError(mop); return 1;
+    }
+  }
+  printf("%s: good: same image from tiles and threads\n", me);
+
+  airMopOkay(mop);
+  return 0;
+}
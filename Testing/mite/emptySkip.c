@@ -0,0 +1,225 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/mite.h"
+
+/*
+** Tests:
+** miteUserNew
+** miteRenderBegin (with emptySkip)
+** miteSample (leaping over empty space)
+** miteRenderEnd
+**
+** that rendering with empty space skipping leaps over most of the samples
+** of a mostly transparent volume, without changing the image beyond
+** round-off in the accumulated ray position
+*/
+
+#define SIZE 40
+
+static int
+render(Nrrd *nout, double *emptyNumP, Nrrd *nsin, Nrrd *ntxf,
+       const char *k00, int emptySkip, int threadNum, int tileSize) {
+  static const char me[]="render";
+  static const char * const kstr[3] = {NULL, "cubicd:1,0", "cubicdd:1,0"};
+  static const int kidx[3] = {gageKernel00, gageKernel11, gageKernel22};
+  NrrdKernelSpec *ksp;
+  miteUser *muu;
+  airArray *mop;
+  unsigned int ki;
+  int E, Ecode, Ethread;
+
+  mop = airMopNew();
+  muu = miteUserNew();
+  airMopAdd(mop, muu, (airMopper)miteUserNix, airMopAlways);
+  muu->nsin = nsin;
+  muu->ntxf = &ntxf;
+  muu->ntxfNum = 1;
+  muu->nout = nout;
+  for (ki=0; ki<3; ki++) {
+    ksp = nrrdKernelSpecNew();
+    airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+    if (nrrdKernelSpecParse(ksp, ki ? kstr[ki] : k00)) {
+      biffMovef(MITE, NRRD, "%s: trouble with kernel %u", me, ki);
+      airMopError(mop); return 1;
+    }
+    muu->ksp[kidx[ki]] = ksp;
+  }
+  airStrcpy(muu->shadeStr, AIR_STRLEN_MED, "phong:gage(scalar:n)");
+  muu->rangeInit[miteRangeKa] = 0.1;
+  muu->rangeInit[miteRangeKd] = 0.6;
+  muu->rangeInit[miteRangeKs] = 0.3;
+  muu->rangeInit[miteRangeSP] = 30;
+  muu->rayStep = 0.01;
+  muu->emptySkip = emptySkip;
+  ELL_3V_SET(muu->lit->amb, 1, 1, 1);
+  ELL_3V_SET(muu->lit->_dir[0], 0, 0, -1);
+  ELL_3V_SET(muu->lit->col[0], 1, 1, 1);
+  muu->lit->on[0] = AIR_TRUE;
+  muu->lit->vsp[0] = AIR_TRUE;
+  ELL_3V_SET(muu->hctx->cam->from, 10, 3, 2);
+  ELL_3V_SET(muu->hctx->cam->at, 0, 0, 0);
+  ELL_3V_SET(muu->hctx->cam->up, 0, 0, 1);
+  muu->hctx->cam->rightHanded = AIR_TRUE;
+  muu->hctx->cam->atRelative = AIR_TRUE;
+  muu->hctx->cam->neer = -1;
+  muu->hctx->cam->dist = 0;
+  muu->hctx->cam->faar = 1;
+  muu->hctx->cam->fov = 16;
+  muu->hctx->imgSize[0] = 48;
+  muu->hctx->imgSize[1] = 40;
+  muu->hctx->numThreads = threadNum;
+  muu->hctx->tileSize = tileSize;
+  if (limnCameraAspectSet(muu->hctx->cam, muu->hctx->imgSize[0],
+                          muu->hctx->imgSize[1], nrrdCenterCell)
+      || limnCameraUpdate(muu->hctx->cam)
+      || limnLightUpdate(muu->lit, muu->hctx->cam)) {
+    biffMovef(MITE, LIMN, "%s: trouble with camera", me);
+    airMopError(mop); return 1;
+  }
+  if (gageShapeSet(muu->shape, nsin, 0)) {
+    biffMovef(MITE, GAGE, "%s: trouble with shape", me);
+    airMopError(mop); return 1;
+  }
+  muu->hctx->shape = muu->shape;
+  muu->hctx->user = muu;
+  muu->hctx->renderBegin = (hooverRenderBegin_t *)miteRenderBegin;
+  muu->hctx->threadBegin = (hooverThreadBegin_t *)miteThreadBegin;
+  muu->hctx->rayBegin = (hooverRayBegin_t *)miteRayBegin;
+  muu->hctx->sample = (hooverSample_t *)miteSample;
+  muu->hctx->rayEnd = (hooverRayEnd_t *)miteRayEnd;
+  muu->hctx->threadEnd = (hooverThreadEnd_t *)miteThreadEnd;
+  muu->hctx->renderEnd = (hooverRenderEnd_t *)miteRenderEnd;
+  E = hooverRender(muu->hctx, &Ecode, &Ethread);
+  if (E) {
+    if (hooverErrInit == E) {
+      biffMovef(MITE, HOOVER, "%s: trouble starting render", me);
+    } else {
+      biffAddf(MITE, "%s: %s error (code %d, thread %d)", me,
+               airEnumStr(hooverErr, E), Ecode, Ethread);
+    }
+    airMopError(mop); return 1;
+  }
+  fprintf(stderr, "\n");
+  *emptyNumP = muu->emptyNum;
+  airMopOkay(mop);
+  return 0;
+}
+
+#define CASE_NUM 4
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const char * const k00[CASE_NUM] = {"tent", "cubic:0,0.5",
+                                             "bspl3", "cubic:0,0.5"};
+  static const int threadNum[CASE_NUM] = {1, 1, 1, 3};
+  static const int tileSize[CASE_NUM] = {16, 16, 16, 5};
+  Nrrd *nsin, *ntxf, *nplain, *nskip;
+  airArray *mop;
+  float *sdata, *tdata;
+  double xx, yy, zz, emptyNum;
+  unsigned int xi, yi, zi, ti, ci;
+  int differ;
+  char explain[AIR_STRLEN_LARGE];
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nsin = nrrdNew();
+  airMopAdd(mop, nsin, (airMopper)nrrdNuke, airMopAlways);
+  ntxf = nrrdNew();
+  airMopAdd(mop, ntxf, (airMopper)nrrdNuke, airMopAlways);
+  nplain = nrrdNew();
+  airMopAdd(mop, nplain, (airMopper)nrrdNuke, airMopAlways);
+  nskip = nrrdNew();
+  airMopAdd(mop, nskip, (airMopper)nrrdNuke, airMopAlways);
+
+  /* a blob off-center in an otherwise empty volume */
+  if (nrrdAlloc_va(nsin, nrrdTypeFloat, 3, AIR_CAST(size_t, SIZE),
+                   AIR_CAST(size_t, SIZE), AIR_CAST(size_t, SIZE))
+      || nrrdAlloc_va(ntxf, nrrdTypeFloat, 2, AIR_CAST(size_t, 1),
+                      AIR_CAST(size_t, 64))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nrrdAxisInfoSet_va(nsin, nrrdAxisInfoSpacing, 0.05, 0.05, 0.05);
+  nrrdAxisInfoSet_va(nsin, nrrdAxisInfoCenter,
+                     nrrdCenterCell, nrrdCenterCell, nrrdCenterCell);
+  sdata = AIR_CAST(float *, nsin->data);
+  for (zi=0; zi<SIZE; zi++) {
+    zz = zi - 0.6*SIZE;
+    for (yi=0; yi<SIZE; yi++) {
+      yy = yi - 0.4*SIZE;
+      for (xi=0; xi<SIZE; xi++) {
+        xx = xi - 0.45*SIZE;
+        sdata[xi + SIZE*(yi + SIZE*zi)] =
+          AIR_CAST(float, 100*exp(-(xx*xx + yy*yy + zz*zz)/30.0));
+      }
+    }
+  }
+  /* opacity is zero for values below about 15 */
+  tdata = AIR_CAST(float *, ntxf->data);
+  for (ti=0; ti<64; ti++) {
+    tdata[ti] = AIR_CAST(float, ti < 10 ? 0.0 : 0.3);
+  }
+  ntxf->axis[0].label = airStrdup("A");
+  ntxf->axis[1].label = airStrdup("gage(scalar:v)");
+  ntxf->axis[1].min = 0;
+  ntxf->axis[1].max = 100;
+
+  for (ci=0; ci<CASE_NUM; ci++) {
+    if (render(nplain, &emptyNum, nsin, ntxf, k00[ci], AIR_FALSE, 1, 16)
+        || render(nskip, &emptyNum, nsin, ntxf, k00[ci], AIR_TRUE,
+                  threadNum[ci], tileSize[ci])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(MITE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble rendering:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (nrrdCompare(nplain, nskip, AIR_TRUE /* onlyData */,
+                    1e-10 /* epsilon */, &differ, explain)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble comparing:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (differ) {
+      fprintf(stderr, "%s: %s with and without skipping differ: %s\n",
+              me, k00[ci], explain);
+      airMopError(mop); return 1;
+    }
+    if (!( emptyNum > 0 )) {
+      fprintf(stderr, "%s: %s: didn't skip any empty space\n", me, k00[ci]);
+      airMopError(mop); return 1;
+    }
+    printf("%s: good: %s with %d threads, same after leaping %g samples\n",
+           me, k00[ci], threadNum[ci], emptyNum);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,291 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdArithUnaryOp, nrrdArithBinaryOp, nrrdArithTernaryOp,
+** nrrdArithIterBinaryOp, nrrdArithIterTernaryOpSelect,
+** nrrdDefaultThreadNum
+**
+** that the element-wise operations, with any number of threads, and
+** whether or not they use the type-specific fast paths, give exactly
+** the same values as operating on the values as doubles, one at a time
+*/
+
+#define NUM 70001
+#define TYPE_NUM 5
+
+/* the double-precision operations, as documented */
+static double
+refOp(unsigned int argNum, int op, double a, double b, double c) {
+  double ret = AIR_NAN;
+
+  switch (argNum) {
+  case 1:
+    switch (op) {
+    case nrrdUnaryOpNegative: ret = -a; break;
+    case nrrdUnaryOpAbs: ret = AIR_ABS(a); break;
+    case nrrdUnaryOpSqrt: ret = sqrt(a); break;
+    case nrrdUnaryOpSin: ret = sin(a); break;
+    }
+    break;
+  case 2:
+    switch (op) {
+    case nrrdBinaryOpAdd: case nrrdBinaryOpAddClamp: ret = a + b; break;
+    case nrrdBinaryOpSubtract: case nrrdBinaryOpSubtractClamp:
+      ret = a - b; break;
+    case nrrdBinaryOpMultiply: case nrrdBinaryOpMultiplyClamp:
+      ret = a * b; break;
+    case nrrdBinaryOpDivide: ret = a / b; break;
+    case nrrdBinaryOpMin: ret = AIR_MIN(a, b); break;
+    case nrrdBinaryOpMax: ret = AIR_MAX(a, b); break;
+    case nrrdBinaryOpLT: ret = (a < b); break;
+    case nrrdBinaryOpNotEqual: ret = (a != b); break;
+    case nrrdBinaryOpAtan2: ret = atan2(a, b); break;
+    }
+    break;
+  case 3:
+    switch (op) {
+    case nrrdTernaryOpAdd: ret = a + b + c; break;
+    case nrrdTernaryOpMin: b = AIR_MIN(b, c); ret = AIR_MIN(a, b); break;
+    case nrrdTernaryOpClamp: ret = AIR_CLAMP(a, b, c); break;
+    case nrrdTernaryOpIfElse: ret = (a ? b : c); break;
+    }
+    break;
+  }
+  return ret;
+}
+
+static int
+refClamp(unsigned int argNum, int op) {
+  return (2 == argNum
+          && (nrrdBinaryOpAddClamp == op
+              || nrrdBinaryOpSubtractClamp == op
+              || nrrdBinaryOpMultiplyClamp == op));
+}
+
+/* compares nout with refOp of the inputs; a NULL nin means fixed value */
+static int
+check(const char *what, const Nrrd *nout, unsigned int argNum, int op,
+      const Nrrd *nin[3], const double fix[3]) {
+  static const char me[]="check";
+  double val[3], want, got;
+  size_t II, num;
+  unsigned int ai;
+
+  num = nrrdElementNumber(nout);
+  for (II=0; II<num; II++) {
+    for (ai=0; ai<argNum; ai++) {
+      val[ai] = (nin[ai]
+                 ? nrrdDLookup[nin[ai]->type](nin[ai]->data,
+                                              II % nrrdElementNumber(nin[ai]))
+                 : fix[ai]);
+    }
+    want = refOp(argNum, op, val[0], val[1], val[2]);
+    if (refClamp(argNum, op)) {
+      want = nrrdDClamp[nout->type](want);
+    }
+    /* pass through the output type */
+    nrrdDInsert[nout->type](&want, 0, want);
+    want = nrrdDLookup[nout->type](&want, 0);
+    got = nrrdDLookup[nout->type](nout->data, II);
+    if (!( want == got || (airIsNaN(want) && airIsNaN(got)) )) {
+      biffAddf(NRRD, "%s: %s (%s, op %d): value[%u] %.17g != wanted %.17g",
+               me, what, airEnumStr(nrrdType, nout->type), op,
+               AIR_CAST(unsigned int, II), got, want);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const int type[TYPE_NUM] = {nrrdTypeUChar, nrrdTypeShort,
+                                     nrrdTypeFloat, nrrdTypeDouble,
+                                     nrrdTypeInt};
+  static const int uop[] = {nrrdUnaryOpNegative, nrrdUnaryOpAbs,
+                            nrrdUnaryOpSqrt, nrrdUnaryOpSin};
+  static const int bop[] = {nrrdBinaryOpAdd, nrrdBinaryOpSubtract,
+                            nrrdBinaryOpMultiply, nrrdBinaryOpDivide,
+                            nrrdBinaryOpMin, nrrdBinaryOpMax,
+                            nrrdBinaryOpLT, nrrdBinaryOpNotEqual,
+                            nrrdBinaryOpAddClamp, nrrdBinaryOpSubtractClamp,
+                            nrrdBinaryOpMultiplyClamp, nrrdBinaryOpAtan2};
+  static const int top[] = {nrrdTernaryOpAdd, nrrdTernaryOpMin,
+                            nrrdTernaryOpClamp, nrrdTernaryOpIfElse};
+  /* fixed values: exactly representable in all types, or not */
+  static const double fixVal[2] = {3.0, 0.3};
+  static const unsigned int threadNum[2] = {1, 3};
+  Nrrd *nin[TYPE_NUM][3], *nshort, *nout;
+  const Nrrd *narg[3];
+  NrrdIter *iter[3];
+  double fix[3];
+  airArray *mop;
+  size_t II;
+  unsigned int ti, oi, hi, fi, ai, uopNum, bopNum, topNum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  uopNum = AIR_CAST(unsigned int, sizeof(uop)/sizeof(int));
+  bopNum = AIR_CAST(unsigned int, sizeof(bop)/sizeof(int));
+  topNum = AIR_CAST(unsigned int, sizeof(top)/sizeof(int));
+
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  nshort = nrrdNew();
+  airMopAdd(mop, nshort, (airMopper)nrrdNuke, airMopAlways);
+  for (ai=0; ai<3; ai++) {
+    iter[ai] = nrrdIterNew();
+    airMopAdd(mop, iter[ai], (airMopper)nrrdIterNix, airMopAlways);
+  }
+  airSrandMT(4242);
+  for (ti=0; ti<TYPE_NUM; ti++) {
+    for (ai=0; ai<3; ai++) {
+      nin[ti][ai] = nrrdNew();
+      airMopAdd(mop, nin[ti][ai], (airMopper)nrrdNuke, airMopAlways);
+      if (nrrdAlloc_va(nin[ti][ai], type[ti], 1, AIR_CAST(size_t, NUM))) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      for (II=0; II<NUM; II++) {
+        double val;
+        /* lots of small values (for equality and division), and some
+           big ones (for overflow), and negative ones */
+        val = (II % 3
+               ? airRandInt(7)
+               : AIR_AFFINE(0, airDrandMT(), 1, -300, 300));
+        if (nrrdTypeUChar == type[ti]) {
+          val = AIR_ABS(val);
+        }
+        if (nrrdTypeFloat == type[ti] || nrrdTypeDouble == type[ti]) {
+          val = (II % 5 ? val : val*1e37);
+          val = (II % 1001 ? val : AIR_NAN);
+        }
+        nrrdDInsert[type[ti]](nin[ti][ai]->data, II, val);
+      }
+    }
+  }
+  /* a short nrrd for the iterators to wrap around */
+  if (nrrdAlloc_va(nshort, nrrdTypeFloat, 1, AIR_CAST(size_t, 777))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (II=0; II<777; II++) {
+    nrrdFInsert[nrrdTypeFloat](nshort->data, II, AIR_CAST(float, II % 9));
+  }
+
+  for (hi=0; hi<2; hi++) {
+    nrrdDefaultThreadNum = threadNum[hi];
+    for (ti=0; ti<TYPE_NUM; ti++) {
+      narg[0] = nin[ti][0];
+      narg[1] = nin[ti][1];
+      narg[2] = nin[ti][2];
+      for (oi=0; oi<uopNum; oi++) {
+        if (nrrdArithUnaryOp(nout, uop[oi], narg[0])
+            || check("unary", nout, 1, uop[oi], narg, fix)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+      }
+      for (oi=0; oi<bopNum; oi++) {
+        if (nrrdArithBinaryOp(nout, bop[oi], narg[0], narg[1])
+            || check("binary", nout, 2, bop[oi], narg, fix)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        /* with a fixed value first, or a short float nrrd second */
+        for (fi=0; fi<3; fi++) {
+          const Nrrd *nfix[3];
+          nfix[0] = fi < 2 ? NULL : narg[0];
+          nfix[1] = fi < 2 ? narg[1] : nshort;
+          fix[0] = fixVal[fi % 2];
+          if (fi < 2) {
+            nrrdIterSetValue(iter[0], fix[0]);
+          } else {
+            nrrdIterSetNrrd(iter[0], nfix[0]);
+          }
+          nrrdIterSetNrrd(iter[1], nfix[1]);
+          if (nrrdArithIterBinaryOp(nout, bop[oi], iter[0], iter[1])
+              || check("iter binary", nout, 2, bop[oi], nfix, fix)) {
+            char *err;
+            airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+            fprintf(stderr, "%s: trouble:\n%s", me, err);
+            airMopError(mop); return 1;
+          }
+          if (nfix[1] == nshort
+              && iter[1]->left != 777 - 1 - NUM % 777) {
+            fprintf(stderr, "%s: iterator left at %u, not %u\n", me,
+                    AIR_CAST(unsigned int, iter[1]->left),
+                    AIR_CAST(unsigned int, 777 - 1 - NUM % 777));
+            airMopError(mop); return 1;
+          }
+        }
+      }
+      for (oi=0; oi<topNum; oi++) {
+        if (nrrdArithTernaryOp(nout, top[oi], narg[0], narg[1], narg[2])
+            || check("ternary", nout, 3, top[oi], narg, fix)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        for (fi=0; fi<2; fi++) {
+          const Nrrd *nfix[3];
+          nfix[0] = narg[0];
+          nfix[1] = NULL;
+          nfix[2] = narg[2];
+          fix[1] = fixVal[fi];
+          nrrdIterSetNrrd(iter[0], nfix[0]);
+          nrrdIterSetValue(iter[1], fix[1]);
+          nrrdIterSetNrrd(iter[2], nfix[2]);
+          if (nrrdArithIterTernaryOpSelect(nout, top[oi], iter[0], iter[1],
+                                           iter[2], 2)
+              || check("iter ternary", nout, 3, top[oi], nfix, fix)) {
+            char *err;
+            airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+            fprintf(stderr, "%s: trouble:\n%s", me, err);
+            airMopError(mop); return 1;
+          }
+        }
+      }
+    }
+    printf("%s: good with %u threads\n", me, threadNum[hi]);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
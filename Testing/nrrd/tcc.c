@@ -0,0 +1,271 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdCCFind
+** nrrdCCSize
+** nrrdCCAdjacency
+**
+** that the (possibly multi-threaded) connected components are exactly
+** those found by a flood fill started at each unlabeled sample in raster
+** order, with values, sizes, and adjacencies to match, for 2-D and 3-D
+** data at every connectivity
+*/
+
+/*
+** the flood-fill reference: labels the CCs of uint array val (sizes sx,
+** sy, sz) into id, and returns the number of CCs. stack needs room for
+** every sample.
+*/
+static unsigned int
+floodRef(unsigned int *id, size_t *stack, const unsigned int *val,
+         const size_t *size, unsigned int conny) {
+  size_t NN, II, JJ, top, xi, yi, zi;
+  unsigned int numid;
+  int dx, dy, dz;
+
+  NN = size[0]*size[1]*size[2];
+  for (II=0; II<NN; II++) {
+    id[II] = UINT_MAX;
+  }
+  numid = 0;
+  for (II=0; II<NN; II++) {
+    if (UINT_MAX != id[II]) {
+      continue;
+    }
+    id[II] = numid;
+    stack[0] = II;
+    top = 1;
+    while (top) {
+      JJ = stack[--top];
+      xi = JJ % size[0];
+      yi = (JJ/size[0]) % size[1];
+      zi = JJ/(size[0]*size[1]);
+      for (dz=-1; dz<=1; dz++) {
+        for (dy=-1; dy<=1; dy++) {
+          for (dx=-1; dx<=1; dx++) {
+            size_t KK;
+            unsigned int nz;
+            nz = !!dx + !!dy + !!dz;
+            if (!nz || nz > conny
+                || (dx < 0 && !xi) || (dx > 0 && xi+1 == size[0])
+                || (dy < 0 && !yi) || (dy > 0 && yi+1 == size[1])
+                || (dz < 0 && !zi) || (dz > 0 && zi+1 == size[2])) {
+              continue;
+            }
+            KK = (xi + dx) + size[0]*((yi + dy) + size[1]*(zi + dz));
+            if (UINT_MAX == id[KK] && val[KK] == val[II]) {
+              id[KK] = numid;
+              stack[top++] = KK;
+            }
+          }
+        }
+      }
+    }
+    numid++;
+  }
+  return numid;
+}
+
+/* the brute-force reference for nrrdCCAdjacency on CC ids "id" */
+static void
+adjRef(unsigned char *adj, const unsigned int *id, const size_t *size,
+       unsigned int numid, unsigned int conny) {
+  size_t II, xi, yi, zi;
+  int dx, dy, dz;
+
+  for (zi=0; zi<size[2]; zi++) {
+    for (yi=0; yi<size[1]; yi++) {
+      for (xi=0; xi<size[0]; xi++) {
+        II = xi + size[0]*(yi + size[1]*zi);
+        for (dz=-1; dz<=1; dz++) {
+          for (dy=-1; dy<=1; dy++) {
+            for (dx=-1; dx<=1; dx++) {
+              size_t KK;
+              unsigned int nz;
+              nz = !!dx + !!dy + !!dz;
+              if (!nz || nz > conny
+                  || (dx < 0 && !xi) || (dx > 0 && xi+1 == size[0])
+                  || (dy < 0 && !yi) || (dy > 0 && yi+1 == size[1])
+                  || (dz < 0 && !zi) || (dz > 0 && zi+1 == size[2])) {
+                continue;
+              }
+              KK = (xi + dx) + size[0]*((yi + dy) + size[1]*(zi + dz));
+              if (id[KK] != id[II]) {
+                adj[id[KK] + AIR_CAST(size_t, numid)*id[II]] = 1;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return;
+}
+
+#define THREAD_NUM 3
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const unsigned int threadNum[THREAD_NUM] = {1, 3, 7};
+  /* 2-D as 1300 x 1 x 1300, and 3-D; big enough for 7 threads */
+  static const size_t size[2][3] = {{1300, 1, 1300}, {100, 90, 180}};
+  static const int type[2] = {nrrdTypeUShort, nrrdTypeUChar};
+  Nrrd *nwrap, *nin, *ncc, *nval, *nsize, *nadj, *ntmp;
+  airArray *mop;
+  unsigned int *val, *ref, *cc, *csz, vi, dim, conny, ti, numid;
+  unsigned char *refAdj;
+  size_t *stack, NN, II;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nwrap = nrrdNew();
+  airMopAdd(mop, nwrap, (airMopper)nrrdNix, airMopAlways);
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  ncc = nrrdNew();
+  airMopAdd(mop, ncc, (airMopper)nrrdNuke, airMopAlways);
+  nval = nrrdNew();
+  airMopAdd(mop, nval, (airMopper)nrrdNuke, airMopAlways);
+  nsize = nrrdNew();
+  airMopAdd(mop, nsize, (airMopper)nrrdNuke, airMopAlways);
+  nadj = nrrdNew();
+  airMopAdd(mop, nadj, (airMopper)nrrdNuke, airMopAlways);
+  ntmp = nrrdNew();
+  airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+  airSrandMT(4242);
+
+  for (dim=2; dim<=3; dim++) {
+    const size_t *sz;
+    sz = size[dim-2];
+    NN = sz[0]*sz[1]*sz[2];
+    val = AIR_CALLOC(NN, unsigned int);
+    airMopAdd(mop, val, airFree, airMopAlways);
+    ref = AIR_CALLOC(NN, unsigned int);
+    airMopAdd(mop, ref, airFree, airMopAlways);
+    stack = AIR_CALLOC(NN, size_t);
+    airMopAdd(mop, stack, airFree, airMopAlways);
+    /* vi == 0: random binary values, so that components percolate
+       through all the slabs; vi == 1: smooth bands of a few values */
+    for (vi=0; vi<2; vi++) {
+      for (II=0; II<NN; II++) {
+        double xx, yy, zz;
+        xx = AIR_CAST(double, II % sz[0]);
+        yy = AIR_CAST(double, (II/sz[0]) % sz[1]);
+        zz = AIR_CAST(double, II/(sz[0]*sz[1]));
+        val[II] = (vi
+                   ? AIR_CAST(unsigned int, 1.5*(3 + sin(xx/9) + cos(yy/7)
+                                                 + sin(zz/5 + xx/23)))
+                   : AIR_CAST(unsigned int, airRandInt(2)));
+      }
+      if (nrrdWrap_va(nwrap, val, nrrdTypeUInt, 3, sz[0], sz[1], sz[2])
+          || nrrdConvert(nin, nwrap, type[dim-2])
+          || (2 == dim && nrrdAxesDelete(nin, nin, 1))) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble setting up:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      for (conny=1; conny<=dim; conny++) {
+        numid = floodRef(ref, stack, val, sz, conny);
+        refAdj = NULL;
+        if (vi) {
+          refAdj = AIR_CALLOC(AIR_CAST(size_t, numid)*numid,
+                              unsigned char);
+          airMopAdd(mop, refAdj, airFree, airMopAlways);
+          adjRef(refAdj, ref, sz, numid, conny);
+        }
+        for (ti=0; ti<THREAD_NUM; ti++) {
+          nrrdDefaultThreadNum = threadNum[ti];
+          if (nrrdCCFind(ncc, &nval, nin, nrrdTypeDefault, conny)
+              || nrrdConvert(ntmp, ncc, nrrdTypeUInt)
+              || nrrdCCSize(nsize, ntmp)
+              || (vi && nrrdCCAdjacency(nadj, ntmp, conny))) {
+            char *err;
+            airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+            fprintf(stderr, "%s: trouble:\n%s", me, err);
+            airMopError(mop); return 1;
+          }
+          cc = AIR_CAST(unsigned int *, ntmp->data);
+          for (II=0; II<NN; II++) {
+            if (cc[II] != ref[II]) {
+              fprintf(stderr, "%s: %u-D (%u), conny %u, %u threads: "
+                      "id[%u] = %u != %u\n", me, dim, vi, conny,
+                      threadNum[ti], AIR_CAST(unsigned int, II),
+                      cc[II], ref[II]);
+              airMopError(mop); return 1;
+            }
+          }
+          if (numid != nval->axis[0].size
+              || numid != nsize->axis[0].size) {
+            fprintf(stderr, "%s: %u-D (%u), conny %u, %u threads: "
+                    "%u ids but %u values and %u sizes\n", me, dim, vi,
+                    conny, threadNum[ti], numid,
+                    AIR_CAST(unsigned int, nval->axis[0].size),
+                    AIR_CAST(unsigned int, nsize->axis[0].size));
+            airMopError(mop); return 1;
+          }
+          csz = AIR_CAST(unsigned int *, nsize->data);
+          for (II=0; II<NN; II++) {
+            csz[cc[II]] -= 1;
+            if (nrrdDLookup[nval->type](nval->data, cc[II]) != val[II]) {
+              fprintf(stderr, "%s: %u-D (%u), conny %u, %u threads: "
+                      "wrong value for id %u\n", me, dim, vi, conny,
+                      threadNum[ti], cc[II]);
+              airMopError(mop); return 1;
+            }
+          }
+          for (II=0; II<numid; II++) {
+            if (csz[II]) {
+              fprintf(stderr, "%s: %u-D (%u), conny %u, %u threads: "
+                      "wrong size for id %u\n", me, dim, vi, conny,
+                      threadNum[ti], AIR_CAST(unsigned int, II));
+              airMopError(mop); return 1;
+            }
+          }
+          if (vi) {
+            size_t NA;
+            NA = AIR_CAST(size_t, numid)*numid;
+            if (numid != nadj->axis[0].size
+                || memcmp(nadj->data, refAdj, NA)) {
+              fprintf(stderr, "%s: %u-D, conny %u, %u threads: "
+                      "wrong adjacency\n", me, dim, conny, threadNum[ti]);
+              airMopError(mop); return 1;
+            }
+          }
+        }
+        printf("%s: good: %u-D (%u), conny %u: %u CCs\n", me, dim, vi,
+               conny, numid);
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,246 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdLoad with nio->readCrop, for various encodings, attached and
+** detached data, data split across many files, and line and byte skips,
+** against plain nrrdLoad followed by nrrdCrop
+*/
+
+#if defined(WIN32) || defined(_WIN32)
+#  define COMMIT "c"
+#else
+#  define COMMIT ""
+#endif
+
+#define ROI_NUM 7
+
+static int
+save(const char *fname, const Nrrd *nin, const NrrdEncoding *enc,
+     int multi) {
+  static const char me[]="save";
+  NrrdIoState *nio;
+  airArray *mop;
+
+  mop = airMopNew();
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nio->encoding = enc;
+  if (multi) {
+    /* one data file per slice along the slowest axis */
+    nio->dataFNFormat = airStrdup("tcrM-%02d.raw");
+    nio->dataFNMin = 0;
+    nio->dataFNMax = AIR_CAST(int, nin->axis[nin->dim-1].size) - 1;
+    nio->dataFNStep = 1;
+    nio->dataFileDim = nin->dim - 1;
+  }
+  if (nrrdSave(fname, nin, nio)) {
+    biffAddf(NRRD, "%s: trouble saving %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* writes raw data of nin after some lines and bytes to skip */
+static int
+saveSkip(const char *hname, const char *dname, const Nrrd *nin) {
+  static const char me[]="saveSkip";
+  char stmp[3][AIR_STRLEN_SMALL];
+  FILE *file;
+
+  if (!(file = fopen(hname, "w" COMMIT))) {
+    biffAddf(NRRD, "%s: couldn't open %s for writing", me, hname);
+    return 1;
+  }
+  fprintf(file, "NRRD0004\n");
+  fprintf(file, "type: %s\n", airEnumStr(nrrdType, nin->type));
+  fprintf(file, "dimension: 3\n");
+  fprintf(file, "sizes: %s %s %s\n",
+          airSprintSize_t(stmp[0], nin->axis[0].size),
+          airSprintSize_t(stmp[1], nin->axis[1].size),
+          airSprintSize_t(stmp[2], nin->axis[2].size));
+  fprintf(file, "encoding: raw\n");
+  fprintf(file, "endian: %s\n", airEnumStr(airEndian, airMyEndian()));
+  fprintf(file, "line skip: 2\n");
+  fprintf(file, "byte skip: 7\n");
+  fprintf(file, "data file: %s\n", dname);
+  fclose(file);
+  if (!(file = fopen(dname, "wb" COMMIT))) {
+    biffAddf(NRRD, "%s: couldn't open %s for writing", me, dname);
+    return 1;
+  }
+  fprintf(file, "first line\nsecond line\n1234567");
+  fwrite(nin->data, nrrdElementSize(nin), nrrdElementNumber(nin), file);
+  fclose(file);
+  return 0;
+}
+
+/* loads crop [min,max] of fname, and compares with crop of nfull */
+static int
+check(const char *fname, const Nrrd *nfull,
+      const size_t *min, const size_t *max) {
+  static const char me[]="check";
+  NrrdIoState *nio;
+  Nrrd *nroi, *ncrop;
+  airArray *mop;
+  char explain[AIR_STRLEN_LARGE];
+  size_t cmin[NRRD_DIM_MAX], cmax[NRRD_DIM_MAX];
+  unsigned int ai;
+  int differ;
+
+  mop = airMopNew();
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nroi = nrrdNew();
+  airMopAdd(mop, nroi, (airMopper)nrrdNuke, airMopAlways);
+  ncrop = nrrdNew();
+  airMopAdd(mop, ncrop, (airMopper)nrrdNuke, airMopAlways);
+  nio->readCrop = AIR_TRUE;
+  for (ai=0; ai<nfull->dim; ai++) {
+    cmin[ai] = nio->readCropMin[ai] = min[ai];
+    cmax[ai] = nio->readCropMax[ai] = max[ai];
+  }
+  if (nrrdLoad(nroi, fname, nio)
+      || nrrdCrop(ncrop, nfull, cmin, cmax)
+      || nrrdCompare(ncrop, nroi, AIR_FALSE /* onlyData */,
+                     0.0 /* epsilon */, &differ, explain)) {
+    biffAddf(NRRD, "%s: trouble loading or comparing %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  if (differ) {
+    biffAddf(NRRD, "%s: crop of %s differs: %s", me, fname, explain);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const size_t roiMin[ROI_NUM][3] = {{0, 0, 0},
+                                            {5, 6, 7},
+                                            {0, 0, 3},
+                                            {0, 4, 2},
+                                            {3, 0, 0},
+                                            {22, 18, 16},
+                                            {9, 2, 1}};
+  static const size_t roiMax[ROI_NUM][3] = {{22, 18, 16},
+                                            {5, 6, 7},
+                                            {22, 18, 9},
+                                            {22, 10, 15},
+                                            {3, 18, 16},
+                                            {22, 18, 16},
+                                            {17, 15, 12}};
+  static const char * const fname[] = {"tcrA.nrrd", "tcrB.nhdr",
+                                       "tcrM.nhdr", "tcrS.nhdr"};
+  const NrrdEncoding *enc[5];
+  Nrrd *nin, *nfull;
+  airArray *mop;
+  short *data;
+  size_t ii;
+  unsigned int ei, fi, ri, encNum;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nfull = nrrdNew();
+  airMopAdd(mop, nfull, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeShort, 3, AIR_CAST(size_t, 23),
+                   AIR_CAST(size_t, 19), AIR_CAST(size_t, 17))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  data = AIR_CAST(short *, nin->data);
+  airSrandMT(4242);
+  for (ii=0; ii<nrrdElementNumber(nin); ii++) {
+    data[ii] = AIR_CAST(short, 30000*(airDrandMT() - 0.5));
+  }
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoSpacing, 1.0, 1.5, 2.5);
+  nrrdAxisInfoSet_va(nin, nrrdAxisInfoLabel, "x", "y", "z");
+  nin->content = airStrdup("tcropread");
+
+  encNum = 0;
+  enc[encNum++] = nrrdEncodingRaw;
+  enc[encNum++] = nrrdEncodingAscii;
+  if (nrrdEncodingGzip->available()) {
+    enc[encNum++] = nrrdEncodingGzip;
+    enc[encNum++] = nrrdEncodingGzipBlocked;
+  }
+  if (nrrdEncodingBzip2->available()) {
+    enc[encNum++] = nrrdEncodingBzip2;
+  }
+  for (ei=0; ei<encNum; ei++) {
+    if (save(fname[0], nin, enc[ei], AIR_FALSE)
+        || save(fname[1], nin, enc[ei], AIR_FALSE)
+        || (nrrdEncodingRaw == enc[ei]
+            && (save(fname[2], nin, enc[ei], AIR_TRUE)
+                || saveSkip(fname[3], "tcrS.dat", nin)))) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble saving:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    for (fi=0; fi<(nrrdEncodingRaw == enc[ei] ? 4u : 2u); fi++) {
+      if (nrrdLoad(nfull, fname[fi], NULL)) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble loading:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      for (ri=0; ri<ROI_NUM; ri++) {
+        if (check(fname[fi], nfull, roiMin[ri], roiMax[ri])) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble with %s region %u:\n%s",
+                  me, enc[ei]->name, ri, err);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    printf("%s: good: %s\n", me, enc[ei]->name);
+  }
+
+  /* the data files not overlapping the region should never be opened */
+  remove("tcrM-00.raw");
+  if (check(fname[2], nin, roiMin[6], roiMax[6])) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble without first data file:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  printf("%s: good: unneeded files unread\n", me);
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,217 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdSave, nrrdLoad with nrrdEncodingGzipBlocked, with various block
+** sizes and numbers of threads, attached and detached data, byte skips
+** (which only decompress the blocks needed), and reading that data with
+** plain nrrdEncodingGzip (since blocks are concatenated gzip members)
+*/
+
+#if defined(WIN32) || defined(_WIN32)
+#  define COMMIT "c"
+#else
+#  define COMMIT ""
+#endif
+
+#define DATA_NUM 100003
+
+static int
+save(const char *fname, const Nrrd *nin, size_t blockSize,
+     unsigned int threadNum) {
+  static const char me[]="save";
+  NrrdIoState *nio;
+  airArray *mop;
+
+  mop = airMopNew();
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nio->encoding = nrrdEncodingGzipBlocked;
+  nio->zlibBlockSize = blockSize;
+  nio->threadNum = threadNum;
+  if (nrrdSave(fname, nin, nio)) {
+    biffAddf(NRRD, "%s: trouble saving %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* loads fname, and makes sure that it is the same as ncmp */
+static int
+check(const char *fname, const Nrrd *ncmp, unsigned int threadNum) {
+  static const char me[]="check";
+  NrrdIoState *nio;
+  Nrrd *nin;
+  airArray *mop;
+  char explain[AIR_STRLEN_LARGE];
+  int differ;
+
+  mop = airMopNew();
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nio->threadNum = threadNum;
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdLoad(nin, fname, nio)
+      || nrrdCompare(ncmp, nin, AIR_TRUE /* onlyData */, 0.0 /* epsilon */,
+                     &differ, explain)) {
+    biffAddf(NRRD, "%s: trouble loading or comparing %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  if (differ) {
+    biffAddf(NRRD, "%s: %s (with %u threads) differs: %s", me,
+             fname, threadNum, explain);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* writes a header for uchar data in tgzbA.raw.gz */
+static int
+header(const char *fname, const char *enc, size_t num, long int byteSkip) {
+  static const char me[]="header";
+  char stmp[AIR_STRLEN_SMALL];
+  FILE *file;
+
+  if (!(file = fopen(fname, "w" COMMIT))) {
+    biffAddf(NRRD, "%s: couldn't open %s for writing", me, fname);
+    return 1;
+  }
+  fprintf(file, "NRRD0006\n");
+  fprintf(file, "type: uchar\n");
+  fprintf(file, "dimension: 1\n");
+  fprintf(file, "sizes: %s\n", airSprintSize_t(stmp, num));
+  fprintf(file, "encoding: %s\n", enc);
+  if (byteSkip) {
+    fprintf(file, "byte skip: %ld\n", byteSkip);
+  }
+  fprintf(file, "data file: tgzbA.raw.gz\n");
+  fclose(file);
+  return 0;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const size_t blockSize[3] = {0, 1000, 4099};
+  static const unsigned int threadNum[3] = {1, 3, 2};
+  /* data range [lo, hi] to read via byte skip; a negative lo means
+     using a negative byte skip to read hi+1 bytes at end of data */
+  static const long int skipLo[4] = {1, 2500, 3001, -1};
+  static const long int skipHi[4] = {999, 2999, 99000, 77777};
+  Nrrd *nuc, *nfl, *ncrop;
+  airArray *mop;
+  unsigned char *uc;
+  float *fl;
+  size_t ii, cmin[1], cmax[1];
+  unsigned int bi, ti, si;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nuc = nrrdNew();
+  airMopAdd(mop, nuc, (airMopper)nrrdNuke, airMopAlways);
+  nfl = nrrdNew();
+  airMopAdd(mop, nfl, (airMopper)nrrdNuke, airMopAlways);
+  ncrop = nrrdNew();
+  airMopAdd(mop, ncrop, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nuc, nrrdTypeUChar, 1, AIR_CAST(size_t, DATA_NUM))
+      || nrrdAlloc_va(nfl, nrrdTypeFloat, 3, AIR_CAST(size_t, 31),
+                      AIR_CAST(size_t, 37), AIR_CAST(size_t, 41))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  /* something compressible, but not too compressible */
+  airSrandMT(4242);
+  uc = AIR_CAST(unsigned char *, nuc->data);
+  for (ii=0; ii<DATA_NUM; ii++) {
+    uc[ii] = AIR_CAST(unsigned char, (ii/7) % 13 + 4*airDrandMT());
+  }
+  fl = AIR_CAST(float *, nfl->data);
+  for (ii=0; ii<nrrdElementNumber(nfl); ii++) {
+    fl[ii] = AIR_CAST(float, sin(ii/100.0) + 0.01*airDrandMT());
+  }
+
+  for (bi=0; bi<3; bi++) {
+    for (ti=0; ti<3; ti++) {
+      if (save("tgzb.nrrd", nfl, blockSize[bi], threadNum[ti])
+          || check("tgzb.nrrd", nfl, threadNum[(ti+1) % 3])
+          || save("tgzbA.nhdr", nuc, blockSize[bi], threadNum[ti])
+          || check("tgzbA.nhdr", nuc, threadNum[(ti+2) % 3])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+  printf("%s: good: round-trips\n", me);
+
+  /* tgzbA.raw.gz now has nuc in blocks of 4099 bytes */
+  if (header("tgzbB.nhdr", "gzip", DATA_NUM, 0)
+      || check("tgzbB.nhdr", nuc, 1)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble reading as plain gzip:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  printf("%s: good: plain gzip\n", me);
+  for (si=0; si<4; si++) {
+    size_t num;
+    long int skip;
+    if (skipLo[si] >= 0) {
+      cmin[0] = AIR_CAST(size_t, skipLo[si]);
+      cmax[0] = AIR_CAST(size_t, skipHi[si]);
+      skip = skipLo[si];
+    } else {
+      cmin[0] = DATA_NUM - 1 - AIR_CAST(size_t, skipHi[si]);
+      cmax[0] = DATA_NUM - 1;
+      skip = -1;
+    }
+    num = cmax[0] - cmin[0] + 1;
+    for (ti=0; ti<3; ti++) {
+      if (nrrdCrop(ncrop, nuc, cmin, cmax)
+          || header("tgzbB.nhdr", "gzip-blocked", num, skip)
+          || check("tgzbB.nhdr", ncrop, threadNum[ti])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble with byte skip %ld:\n%s",
+                me, skip, err);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+  printf("%s: good: byte skips\n", me);
+
+  airMopOkay(mop);
+  return 0;
+}
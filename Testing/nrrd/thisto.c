@@ -0,0 +1,258 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdHisto
+** nrrdHistoAxis
+** nrrdHistoJoint
+**
+** that the (possibly multi-threaded) histograms are exactly those made
+** by counting one value at a time in the output type, including when
+** the counts saturate the output type, for a range of input types
+*/
+
+/* the value-at-a-time reference for nrrdHisto and nrrdHistoJoint */
+static void
+histoRef(Nrrd *nout, const Nrrd *const *nin, const NrrdRange *const *range,
+         unsigned int numNin, const size_t *bins, const int *clamp,
+         int joint) {
+  size_t II, NN, Iout, coord[NRRD_DIM_MAX];
+  unsigned int ai;
+  double val, min, max, count;
+
+  NN = nrrdElementNumber(nin[0]);
+  for (II=0; II<NN; II++) {
+    for (ai=0; ai<numNin; ai++) {
+      val = nrrdDLookup[nin[ai]->type](nin[ai]->data, II);
+      min = range[ai]->min;
+      max = range[ai]->max;
+      if (!AIR_EXISTS(val)) {
+        break;
+      }
+      if (!AIR_IN_CL(AIR_MIN(min, max), val, AIR_MAX(min, max))) {
+        if (!clamp[ai]) {
+          break;
+        }
+        val = AIR_CLAMP(AIR_MIN(min, max), val, AIR_MAX(min, max));
+      }
+      coord[ai] = (joint
+                   ? AIR_CAST(size_t, airIndexClampULL(min, val, max,
+                                                       bins[ai]))
+                   : airIndex(min, val, max + (min == max),
+                              AIR_CAST(unsigned int, bins[ai])));
+    }
+    if (ai < numNin) {
+      continue;
+    }
+    NRRD_INDEX_GEN(Iout, coord, bins, numNin);
+    count = nrrdDLookup[nout->type](nout->data, Iout);
+    count = nrrdDClamp[nout->type](count + 1);
+    nrrdDInsert[nout->type](nout->data, Iout, count);
+  }
+}
+
+static void
+histoAxisRef(Nrrd *nout, const Nrrd *nin, const NrrdRange *range,
+             unsigned int hax, size_t bins) {
+  size_t II, NN, Iout, cIn[NRRD_DIM_MAX], szIn[NRRD_DIM_MAX],
+    szOut[NRRD_DIM_MAX];
+  double val, count;
+
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szOut);
+  szOut[hax] = bins;
+  NN = nrrdElementNumber(nin);
+  for (II=0; II<NN; II++) {
+    val = nrrdDLookup[nin->type](nin->data, II);
+    if (AIR_EXISTS(val) && AIR_IN_CL(range->min, val, range->max)) {
+      NRRD_COORD_GEN(cIn, szIn, nin->dim, II);
+      cIn[hax] = airIndex(range->min, val, range->max,
+                          AIR_CAST(unsigned int, bins));
+      NRRD_INDEX_GEN(Iout, cIn, szOut, nin->dim);
+      count = nrrdDLookup[nout->type](nout->data, Iout);
+      count = nrrdDClamp[nout->type](count + 1);
+      nrrdDInsert[nout->type](nout->data, Iout, count);
+    }
+  }
+}
+
+static int
+same(const Nrrd *nout, const Nrrd *nref, const char *what,
+     unsigned int threadNum) {
+  size_t size;
+
+  size = nrrdElementNumber(nref)*nrrdElementSize(nref);
+  if (nout->type != nref->type
+      || nrrdElementNumber(nout) != nrrdElementNumber(nref)
+      || memcmp(nout->data, nref->data, size)) {
+    fprintf(stderr, "%s with %u threads differs from reference\n",
+            what, threadNum);
+    return 0;
+  }
+  return 1;
+}
+
+#define TYPE_NUM 5
+#define SX 96
+#define SY 80
+#define SZ 72
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const int inType[TYPE_NUM] = {nrrdTypeUChar, nrrdTypeShort,
+                                       nrrdTypeUShort, nrrdTypeFloat,
+                                       nrrdTypeDouble};
+  static const int outType[TYPE_NUM] = {nrrdTypeUInt, nrrdTypeFloat,
+                                        nrrdTypeUChar, nrrdTypeDouble,
+                                        nrrdTypeShort};
+  static const unsigned int threadNum[2] = {1, 3};
+  static const size_t hbins[3] = {100, 90, 128};
+  static const size_t jbins[3][3] = {{40, 30, 20},   /* private counts */
+                                     {128, 128, 128},  /* bin blocks */
+                                     {256, 300, 1}};
+  static const int clamp[3] = {AIR_FALSE, AIR_TRUE, AIR_FALSE};
+  char what[AIR_STRLEN_MED];
+  Nrrd *nin[3], *nout, *nref;
+  NrrdRange *range[3];
+  const Nrrd *cnin[3];
+  const NrrdRange *crange[3];
+  airArray *mop;
+  size_t ii, nn;
+  unsigned int ti, ci, ai, hax;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  nref = nrrdNew();
+  airMopAdd(mop, nref, (airMopper)nrrdNuke, airMopAlways);
+  airSrandMT(4242);
+  for (ci=0; ci<TYPE_NUM; ci++) {
+    for (ai=0; ai<3; ai++) {
+      double (*ins)(void *, size_t, double);
+      nin[ai] = nrrdNew();
+      airMopAdd(mop, nin[ai], (airMopper)nrrdNuke, airMopAlways);
+      if (nrrdAlloc_va(nin[ai], inType[(ci + ai) % TYPE_NUM], 3,
+                       AIR_CAST(size_t, SX), AIR_CAST(size_t, SY),
+                       AIR_CAST(size_t, SZ))) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      ins = nrrdDInsert[nin[ai]->type];
+      nn = nrrdElementNumber(nin[ai]);
+      for (ii=0; ii<nn; ii++) {
+        /* skewed, so that some bins are full enough to saturate */
+        double rr = airDrandMT();
+        ins(nin[ai]->data, ii, 3*(ai+1)*rr*rr*rr*(ai ? 100 : 80) - 17);
+      }
+      if (!nrrdTypeIsIntegral[nin[ai]->type]) {
+        ins(nin[ai]->data, nn/3, AIR_NAN);
+        ins(nin[ai]->data, nn/2, AIR_POS_INF);
+      }
+      range[ai] = nrrdRangeNewSet(nin[ai], nrrdBlind8BitRangeState);
+      airMopAdd(mop, range[ai], (airMopper)nrrdRangeNix, airMopAlways);
+      if (1 == ai) {
+        /* a range that excludes some values, for clamping or not */
+        range[ai]->min = 40;
+        range[ai]->max = 400;
+      }
+      cnin[ai] = nin[ai];
+      crange[ai] = range[ai];
+    }
+    for (ti=0; ti<2; ti++) {
+      nrrdDefaultThreadNum = threadNum[ti];
+      /* nrrdHisto */
+      nrrdEmpty(nout);
+      nrrdEmpty(nref);
+      sprintf(what, "nrrdHisto(%s->%s)",
+              airEnumStr(nrrdType, nin[0]->type),
+              airEnumStr(nrrdType, outType[ci]));
+      if (nrrdHisto(nout, nin[0], NULL, NULL, hbins[0], outType[ci])
+          || nrrdMaybeAlloc_va(nref, outType[ci], 1, hbins[0])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      histoRef(nref, cnin, crange, 1, hbins, clamp, AIR_FALSE);
+      if (!same(nout, nref, what, threadNum[ti])) {
+        airMopError(mop); return 1;
+      }
+      /* nrrdHistoAxis */
+      for (hax=0; hax<3; hax++) {
+        size_t size[3] = {SX, SY, SZ};
+        nrrdEmpty(nref);
+        size[hax] = hbins[hax];
+        sprintf(what, "nrrdHistoAxis(%s->%s, axis %u)",
+                airEnumStr(nrrdType, nin[1]->type),
+                airEnumStr(nrrdType, outType[ci]), hax);
+        if (nrrdHistoAxis(nout, nin[1], range[1], hax, hbins[hax],
+                          outType[ci])
+            || nrrdMaybeAlloc_nva(nref, outType[ci], 3, size)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        histoAxisRef(nref, nin[1], range[1], hax, hbins[hax]);
+        if (!same(nout, nref, what, threadNum[ti])) {
+          airMopError(mop); return 1;
+        }
+      }
+      /* nrrdHistoJoint */
+      for (ai=0; ai<3; ai++) {
+        unsigned int numNin = 2 == ai ? 2 : 3;
+        nrrdEmpty(nref);
+        sprintf(what, "nrrdHistoJoint(%u %s... -> %s, %u bins)",
+                numNin, airEnumStr(nrrdType, nin[0]->type),
+                airEnumStr(nrrdType, outType[ci]),
+                AIR_CAST(unsigned int, jbins[ai][0]));
+        if (nrrdHistoJoint(nout, cnin, crange, numNin, NULL, jbins[ai],
+                           outType[ci], clamp)
+            || nrrdMaybeAlloc_nva(nref, outType[ci], numNin, jbins[ai])) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        histoRef(nref, cnin, crange, numNin, jbins[ai], clamp, AIR_TRUE);
+        if (!same(nout, nref, what, threadNum[ti])) {
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    printf("%s: good: %s -> %s\n", me, airEnumStr(nrrdType, nin[0]->type),
+           airEnumStr(nrrdType, outType[ci]));
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
@@ -0,0 +1,193 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdRangeSummaryNew
+** nrrdRangeSummarySet
+** nrrdRangeSummaryPercentile
+** nrrdRangePercentileSet (with hbins == 0)
+**
+** that percentiles found by selection (repeatedly, with the summary
+** remembering earlier selections) are those found by sorting, and that
+** percentiles from a sample are within the stated rank error
+*/
+
+static int
+dcmp(const void *_a, const void *_b) {
+  double a, b;
+  a = *AIR_CAST(const double *, _a);
+  b = *AIR_CAST(const double *, _b);
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* the percentile from sorted values, as documented */
+static double
+percRef(const double *sorted, size_t num, double perc) {
+  double rank, frac;
+  size_t klo;
+
+  rank = perc*AIR_CAST(double, num - 1)/100;
+  klo = AIR_CAST(size_t, rank);
+  frac = rank - AIR_CAST(double, klo);
+  return (frac > 0 && klo + 1 < num
+          ? AIR_LERP(frac, sorted[klo], sorted[klo+1])
+          : sorted[klo]);
+}
+
+#define PERC_NUM 9
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const double perc[PERC_NUM] = {50, 1, 99, 0, 100, 2.5, 97.5,
+                                        33.3333, 50};
+  static const int type[3] = {nrrdTypeFloat, nrrdTypeUShort,
+                              nrrdTypeDouble};
+  NrrdRangeSummary *summ;
+  NrrdRange *range;
+  Nrrd *nin;
+  airArray *mop;
+  double *sorted, val[PERC_NUM], (*ins)(void *, size_t, double);
+  size_t ii, nn, sn, lo, hi;
+  unsigned int ti, pi, rep;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  summ = nrrdRangeSummaryNew();
+  airMopAdd(mop, summ, (airMopper)nrrdRangeSummaryNix, airMopAlways);
+  range = nrrdRangeNew(AIR_NAN, AIR_NAN);
+  airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
+  airSrandMT(4242);
+  for (ti=0; ti<3; ti++) {
+    if (nrrdAlloc_va(nin, type[ti], 2, AIR_CAST(size_t, 301),
+                     AIR_CAST(size_t, 203))) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    nn = nrrdElementNumber(nin);
+    ins = nrrdDInsert[nin->type];
+    for (ii=0; ii<nn; ii++) {
+      /* lots of repeated values, and some far outliers */
+      double rr = airDrandMT();
+      ins(nin->data, ii, (ii % 97
+                          ? AIR_CAST(int, 1000*rr*rr)
+                          : 60000*airDrandMT()));
+    }
+    if (nrrdTypeUShort != nin->type) {
+      ins(nin->data, nn/2, AIR_NAN);
+      ins(nin->data, nn/3, AIR_NAN);
+    }
+    /* reference: sort existent values */
+    sorted = AIR_CALLOC(nn, double);
+    airMopAdd(mop, sorted, airFree, airMopAlways);
+    for (ii=sn=0; ii<nn; ii++) {
+      double vv = nrrdDLookup[nin->type](nin->data, ii);
+      if (AIR_EXISTS(vv)) {
+        sorted[sn++] = vv;
+      }
+    }
+    qsort(sorted, sn, sizeof(double), dcmp);
+    /* exact, and repeated queries on the same summary */
+    for (rep=0; rep<3; rep++) {
+      if (nrrdRangeSummarySet(summ, nin, 0)
+          || nrrdRangeSummaryPercentile(val, summ, perc, PERC_NUM)) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      for (pi=0; pi<PERC_NUM; pi++) {
+        if (val[pi] != percRef(sorted, sn, perc[pi])) {
+          fprintf(stderr, "%s: %s %g-percentile %g != correct %g\n", me,
+                  airEnumStr(nrrdType, nin->type), perc[pi], val[pi],
+                  percRef(sorted, sn, perc[pi]));
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    if (summ->valNum != sn || summ->min != sorted[0]
+        || summ->max != sorted[sn-1] || summ->rankError) {
+      fprintf(stderr, "%s: %s summary wrong\n", me,
+              airEnumStr(nrrdType, nin->type));
+      airMopError(mop); return 1;
+    }
+    /* through nrrdRangePercentileSet */
+    if (nrrdRangePercentileSet(range, nin, 2.5, 1, 0,
+                               nrrdBlind8BitRangeFalse)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (range->min != percRef(sorted, sn, 2.5)
+        || range->max != percRef(sorted, sn, 99)) {
+      fprintf(stderr, "%s: %s range [%g,%g] wrong\n", me,
+              airEnumStr(nrrdType, nin->type), range->min, range->max);
+      airMopError(mop); return 1;
+    }
+    /* from a sample: the values found have to be in the right range of
+       ranks in the sorted list */
+    if (nrrdRangeSummarySet(summ, nin, 5000)
+        || nrrdRangeSummaryPercentile(val, summ, perc, PERC_NUM)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (!( summ->stride > 1 && summ->rankError > 0
+           && summ->rankError < 0.05 )) {
+      fprintf(stderr, "%s: sampled summary stride %u, rank error %g\n",
+              me, AIR_CAST(unsigned int, summ->stride), summ->rankError);
+      airMopError(mop); return 1;
+    }
+    for (pi=0; pi<PERC_NUM; pi++) {
+      double err = summ->rankError*AIR_CAST(double, sn);
+      for (lo=0; lo<sn && sorted[lo] < val[pi]; lo++)
+        ;
+      for (hi=lo; hi<sn && sorted[hi] <= val[pi]; hi++)
+        ;
+      /* any rank in [lo,hi] is consistent with val[pi] */
+      if (perc[pi]*(sn-1)/100 + 1 < lo - err
+          || perc[pi]*(sn-1)/100 > hi + err) {
+        fprintf(stderr, "%s: %s sampled %g-percentile %g (ranks [%u,%u]) "
+                "outside error %g\n", me, airEnumStr(nrrdType, nin->type),
+                perc[pi], val[pi], AIR_CAST(unsigned int, lo),
+                AIR_CAST(unsigned int, hi), err);
+        airMopError(mop); return 1;
+      }
+    }
+    printf("%s: good: %s\n", me, airEnumStr(nrrdType, nin->type));
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
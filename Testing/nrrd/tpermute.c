@@ -0,0 +1,202 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdAxesPermute
+** nrrdShuffle
+**
+** that permuting and shuffling (done with tiles and multiple threads
+** when the scanlines are short) move every element to where a plain
+** element-by-element reordering puts it, for a range of element sizes
+*/
+
+#define CASE_NUM 7
+
+/* output axis ai is input axis axes[ai]; the reference permutation */
+static void
+permuteRef(char *out, const char *in, size_t esz, unsigned int dim,
+           const size_t *szIn, const unsigned int *axes) {
+  size_t cIn[NRRD_DIM_MAX], cOut[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX],
+    ii, nn, idxIn;
+  unsigned int ai;
+
+  nn = 1;
+  for (ai=0; ai<dim; ai++) {
+    szOut[ai] = szIn[axes[ai]];
+    nn *= szIn[ai];
+  }
+  for (ii=0; ii<nn; ii++) {
+    NRRD_COORD_GEN(cOut, szOut, dim, ii);
+    for (ai=0; ai<dim; ai++) {
+      cIn[axes[ai]] = cOut[ai];
+    }
+    NRRD_INDEX_GEN(idxIn, cIn, szIn, dim);
+    memcpy(out + ii*esz, in + idxIn*esz, esz);
+  }
+}
+
+static void
+shuffleRef(char *out, const char *in, size_t esz, unsigned int dim,
+           const size_t *size, unsigned int axis, const size_t *perm) {
+  size_t coord[NRRD_DIM_MAX], ii, nn, idxIn;
+  unsigned int ai;
+
+  nn = 1;
+  for (ai=0; ai<dim; ai++) {
+    nn *= size[ai];
+  }
+  for (ii=0; ii<nn; ii++) {
+    NRRD_COORD_GEN(coord, size, dim, ii);
+    coord[axis] = perm[coord[axis]];
+    NRRD_INDEX_GEN(idxIn, coord, size, dim);
+    memcpy(out + ii*esz, in + idxIn*esz, esz);
+  }
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  /* small first axes make for scanlines of 12 and 16 bytes */
+  static const int type[CASE_NUM] = {nrrdTypeUChar, nrrdTypeShort,
+                                     nrrdTypeFloat, nrrdTypeDouble,
+                                     nrrdTypeFloat, nrrdTypeDouble,
+                                     nrrdTypeUShort};
+  static const unsigned int dim[CASE_NUM] = {3, 3, 4, 3, 4, 4, 2};
+  static const size_t size[CASE_NUM][4] = {{45, 67, 39, 1},
+                                           {170, 133, 50, 1},
+                                           {3, 21, 17, 40},
+                                           {64, 81, 43, 1},
+                                           {4, 19, 23, 35},
+                                           {2, 31, 37, 11},
+                                           {301, 257, 1, 1}};
+  static const unsigned int axes[CASE_NUM][4] = {{2, 0, 1, 0},
+                                                 {1, 2, 0, 0},
+                                                 {0, 3, 1, 2},
+                                                 {2, 1, 0, 0},
+                                                 {0, 2, 3, 1},
+                                                 {0, 3, 2, 1},
+                                                 {1, 0, 0, 0}};
+  static const unsigned int threadNum[2] = {1, 3};
+  Nrrd *nin, *nout, *nref;
+  airArray *mop;
+  size_t ii, nn, esz, *perm;
+  unsigned int ci, ti, ai;
+  unsigned char *in;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  nref = nrrdNew();
+  airMopAdd(mop, nref, (airMopper)nrrdNuke, airMopAlways);
+  airSrandMT(4242);
+  for (ci=0; ci<CASE_NUM; ci++) {
+    if (nrrdAlloc_nva(nin, type[ci], dim[ci], size[ci])
+        || nrrdCopy(nref, nin)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    in = AIR_CAST(unsigned char *, nin->data);
+    esz = nrrdElementSize(nin);
+    nn = nrrdElementNumber(nin);
+    for (ii=0; ii<nn*esz; ii++) {
+      in[ii] = AIR_CAST(unsigned char, airRandInt(256));
+    }
+    permuteRef(AIR_CAST(char *, nref->data), AIR_CAST(char *, nin->data),
+               esz, dim[ci], size[ci], axes[ci]);
+    for (ti=0; ti<2; ti++) {
+      nrrdDefaultThreadNum = threadNum[ti];
+      if (nrrdAxesPermute(nout, nin, axes[ci])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble permuting:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      if (memcmp(nout->data, nref->data, nn*esz)) {
+        fprintf(stderr, "%s: case %u permute with %u threads wrong\n",
+                me, ci, threadNum[ti]);
+        airMopError(mop); return 1;
+      }
+      for (ai=0; ai<dim[ci]; ai++) {
+        if (nout->axis[ai].size != size[ci][axes[ci][ai]]) {
+          fprintf(stderr, "%s: case %u permute axis %u size wrong\n",
+                  me, ci, ai);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    /* shuffle (reversal plus a repeat) along the last axis and axis 0 */
+    for (ai=0; ai<dim[ci]; ai += dim[ci]-1) {
+      perm = AIR_CALLOC(size[ci][ai], size_t);
+      airMopAdd(mop, perm, airFree, airMopAlways);
+      for (ii=0; ii<size[ci][ai]; ii++) {
+        perm[ii] = size[ci][ai] - 1 - ii;
+      }
+      perm[0] = perm[1];
+      shuffleRef(AIR_CAST(char *, nref->data), AIR_CAST(char *, nin->data),
+                 esz, dim[ci], size[ci], ai, perm);
+      for (ti=0; ti<2; ti++) {
+        nrrdDefaultThreadNum = threadNum[ti];
+        if (nrrdShuffle(nout, nin, ai, perm)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble shuffling:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        if (memcmp(nout->data, nref->data, nn*esz)) {
+          fprintf(stderr, "%s: case %u shuffle axis %u with %u threads "
+                  "wrong\n", me, ci, ai, threadNum[ti]);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    /* in-place permutation */
+    permuteRef(AIR_CAST(char *, nref->data), AIR_CAST(char *, nin->data),
+               esz, dim[ci], size[ci], axes[ci]);
+    if (nrrdAxesPermute(nin, nin, axes[ci])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble permuting in place:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (memcmp(nin->data, nref->data, nn*esz)) {
+      fprintf(stderr, "%s: case %u in-place permute wrong\n", me, ci);
+      airMopError(mop); return 1;
+    }
+    printf("%s: good: case %u (%u-byte %s)\n", me, ci,
+           AIR_CAST(unsigned int, esz), airEnumStr(nrrdType, type[ci]));
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
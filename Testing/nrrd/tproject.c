@@ -0,0 +1,213 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdProject, nrrdMeasureLine, nrrdDefaultThreadNum
+**
+** that nrrdProject, which computes the accumulating measures (like
+** min, max, mean, L2, variance) by sweeping through contiguous blocks
+** of columns with multiple threads, gives exactly what nrrdMeasureLine
+** gives on each gathered scanline, including with non-existent values
+*/
+
+#define SX 70
+#define SY 61
+#define SZ 53
+#define TYPE_NUM 5
+#define MEASR_NUM 14
+
+/* projects nin along axis by gathering each line for nrrdMeasureLine */
+static int
+refProject(Nrrd *nout, const Nrrd *nin, unsigned int axis, int measr,
+           int oType) {
+  static const char me[]="refProject";
+  size_t ii, ei, colNum, rowNum, linLen, rowIdx, colIdx, iElSz, oElSz,
+    osize[2];
+  char *line, *oData;
+  const char *iData;
+  unsigned int ai, oi;
+  airArray *mop;
+
+  colNum = rowNum = 1;
+  oi = 0;
+  for (ai=0; ai<3; ai++) {
+    if (ai < axis) {
+      colNum *= nin->axis[ai].size;
+    } else if (ai > axis) {
+      rowNum *= nin->axis[ai].size;
+    }
+    if (ai != axis) {
+      osize[oi++] = nin->axis[ai].size;
+    }
+  }
+  linLen = nin->axis[axis].size;
+  iElSz = nrrdTypeSize[nin->type];
+  oElSz = nrrdTypeSize[oType];
+  mop = airMopNew();
+  line = AIR_CALLOC(linLen*iElSz, char);
+  airMopAdd(mop, line, airFree, airMopAlways);
+  if (!line || nrrdMaybeAlloc_va(nout, oType, 2, osize[0], osize[1])) {
+    biffAddf(NRRD, "%s: couldn't allocate", me);
+    airMopError(mop); return 1;
+  }
+  iData = AIR_CAST(const char *, nin->data);
+  oData = AIR_CAST(char *, nout->data);
+  ii = 0;
+  for (rowIdx=0; rowIdx<rowNum; rowIdx++) {
+    for (colIdx=0; colIdx<colNum; colIdx++) {
+      for (ei=0; ei<linLen; ei++) {
+        memcpy(line + ei*iElSz,
+               iData + iElSz*(colIdx + colNum*(ei + linLen*rowIdx)), iElSz);
+      }
+      nrrdMeasureLine[measr](oData + oElSz*ii, oType, line, nin->type,
+                             linLen, AIR_NAN, AIR_NAN);
+      ii++;
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* same values, with NaNs being equal to each other */
+static int
+differ(const Nrrd *na, const Nrrd *nb, size_t *idxP) {
+  double aa, bb;
+  size_t ii, nn;
+
+  nn = nrrdElementNumber(na);
+  if (na->type != nb->type || nn != nrrdElementNumber(nb)) {
+    *idxP = 0;
+    return 1;
+  }
+  for (ii=0; ii<nn; ii++) {
+    aa = nrrdDLookup[na->type](na->data, ii);
+    bb = nrrdDLookup[nb->type](nb->data, ii);
+    if (!( aa == bb || (airIsNaN(aa) && airIsNaN(bb)) )) {
+      *idxP = ii;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const int type[TYPE_NUM] = {nrrdTypeUChar, nrrdTypeShort,
+                                     nrrdTypeInt, nrrdTypeLLong,
+                                     nrrdTypeFloat};
+  static const int measr[MEASR_NUM] = {
+    nrrdMeasureMin, nrrdMeasureMax, nrrdMeasureMean, nrrdMeasureProduct,
+    nrrdMeasureSum, nrrdMeasureL1, nrrdMeasureL2, nrrdMeasureL4,
+    nrrdMeasureNormalizedL2, nrrdMeasureRootMeanSquare, nrrdMeasureLinf,
+    nrrdMeasureVariance, nrrdMeasureSD, nrrdMeasureMedian};
+  static const unsigned int threadNum[2] = {1, 3};
+  Nrrd *nin, *nref, *nout;
+  airArray *mop;
+  size_t xi, yi, zi, ii;
+  unsigned int ti, mi, axis, hi, oti;
+  int oType;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nref = nrrdNew();
+  airMopAdd(mop, nref, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  for (ti=0; ti<TYPE_NUM; ti++) {
+    if (nrrdMaybeAlloc_va(nin, type[ti], 3, AIR_CAST(size_t, SX),
+                          AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airSrandMT(4242);
+    ii = 0;
+    for (zi=0; zi<SZ; zi++) {
+      for (yi=0; yi<SY; yi++) {
+        for (xi=0; xi<SX; xi++) {
+          double val;
+          val = AIR_AFFINE(0, airDrandMT(), 1, -20, 100);
+          if (nrrdTypeFloat == type[ti]) {
+            double rr = airDrandMT();
+            if (xi < 2 && yi < 2) {
+              /* whole lines along Z of non-existent values */
+              val = (xi ? AIR_POS_INF : AIR_NAN);
+            } else if (rr < 0.05) {
+              val = AIR_NAN;
+            } else if (rr < 0.07) {
+              val = (rr < 0.06 ? AIR_NEG_INF : AIR_POS_INF);
+            }
+          } else if (nrrdTypeUChar == type[ti]) {
+            val = AIR_ABS(val);
+          }
+          nrrdDInsert[type[ti]](nin->data, ii++, val);
+        }
+      }
+    }
+    for (axis=0; axis<3; axis++) {
+      for (mi=0; mi<MEASR_NUM; mi++) {
+        for (oti=0; oti<2; oti++) {
+          oType = (oti
+                   ? nrrdTypeFloat
+                   : nrrdTypeDefault);
+          for (hi=0; hi<2; hi++) {
+            size_t idx;
+            nrrdDefaultThreadNum = threadNum[hi];
+            if (nrrdProject(nout, nin, axis, measr[mi], oType)
+                || refProject(nref, nin, axis, measr[mi], nout->type)) {
+              char *err;
+              airMopAdd(mop, err = biffGetDone(NRRD), airFree,
+                        airMopAlways);
+              fprintf(stderr, "%s: trouble projecting:\n%s", me, err);
+              airMopError(mop); return 1;
+            }
+            if (differ(nout, nref, &idx)) {
+              fprintf(stderr, "%s: %s %s along %u to %s with %u threads "
+                      "differs at %u: %.17g != %.17g\n", me,
+                      airEnumStr(nrrdType, type[ti]),
+                      airEnumStr(nrrdMeasure, measr[mi]), axis,
+                      airEnumStr(nrrdType, nout->type), threadNum[hi],
+                      AIR_CAST(unsigned int, idx),
+                      nrrdDLookup[nout->type](nout->data, idx),
+                      nrrdDLookup[nref->type](nref->data, idx));
+              airMopError(mop); return 1;
+            }
+          }
+        }
+      }
+    }
+    printf("%s: good: %s\n", me, airEnumStr(nrrdType, type[ti]));
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
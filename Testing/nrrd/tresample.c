@@ -0,0 +1,180 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdResampleContextNew
+** nrrdResampleThreadNumSet
+** nrrdResampleMemoryBudgetSet
+** nrrdResampleExecute
+** nrrdCompare
+**
+** that multi-threaded resampling, and resampling in slabs to stay within
+** a memory budget, give exactly the same output as plain single-threaded
+** resampling
+*/
+
+static int
+resample(Nrrd *nout, const Nrrd *nin, NrrdKernelSpec *ksp,
+         const double *scale, int typeOut, int nonExist, int boundary,
+         unsigned int threadNum, size_t memBudget) {
+  static const char me[]="resample";
+  NrrdResampleContext *rsmc;
+  unsigned int ai;
+  airArray *mop;
+  int E;
+
+  mop = airMopNew();
+  rsmc = nrrdResampleContextNew();
+  airMopAdd(mop, rsmc, (airMopper)nrrdResampleContextNix, airMopAlways);
+  E = AIR_FALSE;
+  if (!E) E |= nrrdResampleInputSet(rsmc, nin);
+  for (ai=0; ai<nin->dim; ai++) {
+    if (scale[ai]) {
+      size_t samples;
+      samples = AIR_ROUNDUP(scale[ai]*nin->axis[ai].size);
+      if (!E) E |= nrrdResampleKernelSet(rsmc, ai, ksp->kernel,
+                                         ksp->parm);
+      if (!E) E |= nrrdResampleSamplesSet(rsmc, ai, samples);
+      if (!E) E |= nrrdResampleRangeFullSet(rsmc, ai);
+    } else {
+      if (!E) E |= nrrdResampleKernelSet(rsmc, ai, NULL, NULL);
+    }
+  }
+  if (!E) E |= nrrdResampleBoundarySet(rsmc, boundary);
+  if (!E) E |= nrrdResamplePadValueSet(rsmc, 42.0);
+  if (!E) E |= nrrdResampleTypeOutSet(rsmc, typeOut);
+  if (!E) E |= nrrdResampleRenormalizeSet(rsmc, AIR_TRUE);
+  if (!E) E |= nrrdResampleNonExistentSet(rsmc, nonExist);
+  if (!E) E |= nrrdResampleThreadNumSet(rsmc, threadNum);
+  if (!E) E |= nrrdResampleMemoryBudgetSet(rsmc, memBudget);
+  if (!E) E |= nrrdResampleExecute(rsmc, nout);
+  if (E) {
+    biffAddf(NRRD, "%s: trouble resampling with %u threads, budget %u",
+             me, threadNum, AIR_CAST(unsigned int, memBudget));
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+#define CASE_NUM 4
+#define ALT_NUM 6
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const char * const kstr[CASE_NUM] = {"tent", "cubic:0,0.5",
+                                              "c4h", "gauss:1.5,3"};
+  static const double scale[CASE_NUM][3] = {{1.7, 0.6, 2.3},
+                                            {0, 1.5, 0.4},
+                                            {2.1, 1.9, 0},
+                                            {0.5, 0, 3.0}};
+  static const int typeOut[CASE_NUM] = {nrrdTypeDefault, nrrdTypeUChar,
+                                        nrrdTypeDouble, nrrdTypeShort};
+  /* alternatives to 1 thread without budget: (threads, memory budget) */
+  static const unsigned int threadNum[ALT_NUM] = {2, 3, 16, 1, 1, 3};
+  static const size_t memBudget[ALT_NUM] = {0, 0, 0, 1, 20000, 60000};
+  NrrdKernelSpec *ksp;
+  Nrrd *nin, *nsngl, *nmult;
+  airArray *mop;
+  float *in;
+  size_t ii, nn;
+  unsigned int ci, ti;
+  int differ;
+  char explain[AIR_STRLEN_LARGE];
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nsngl = nrrdNew();
+  airMopAdd(mop, nsngl, (airMopper)nrrdNuke, airMopAlways);
+  nmult = nrrdNew();
+  airMopAdd(mop, nmult, (airMopper)nrrdNuke, airMopAlways);
+  ksp = nrrdKernelSpecNew();
+  airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeFloat, 3, AIR_CAST(size_t, 23),
+                   AIR_CAST(size_t, 19), AIR_CAST(size_t, 17))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  in = AIR_CAST(float *, nin->data);
+  nn = nrrdElementNumber(nin);
+  airSrandMT(4242);
+  for (ii=0; ii<nn; ii++) {
+    in[ii] = AIR_CAST(float, 200*airDrandMT());
+  }
+  /* some non-existent values to exercise the non-existent handling */
+  in[nn/3] = AIR_CAST(float, AIR_NAN);
+  in[nn/2] = AIR_CAST(float, AIR_NAN);
+
+  for (ci=0; ci<CASE_NUM; ci++) {
+    int nonExist, boundary;
+    if (nrrdKernelSpecParse(ksp, kstr[ci])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing \"%s\":\n%s", me, kstr[ci], err);
+      airMopError(mop); return 1;
+    }
+    nonExist = (ci % 2
+                ? nrrdResampleNonExistentRenormalize
+                : nrrdResampleNonExistentNoop);
+    boundary = ci < 2 ? nrrdBoundaryBleed : nrrdBoundaryPad;
+    if (resample(nsngl, nin, ksp, scale[ci], typeOut[ci], nonExist,
+                 boundary, 1, 0)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    for (ti=0; ti<ALT_NUM; ti++) {
+      if (resample(nmult, nin, ksp, scale[ci], typeOut[ci], nonExist,
+                   boundary, threadNum[ti], memBudget[ti])
+          || nrrdCompare(nsngl, nmult, AIR_FALSE /* onlyData */,
+                         0.0 /* epsilon */, &differ, explain)) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      if (differ) {
+        fprintf(stderr, "%s: %s with 1 and %u threads (budget %u) "
+                "differ: %s\n", me, kstr[ci], threadNum[ti],
+                AIR_CAST(unsigned int, memBudget[ti]), explain);
+        airMopError(mop); return 1;
+      }
+    }
+    printf("%s: good: %s same with more threads and budgets\n",
+           me, kstr[ci]);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
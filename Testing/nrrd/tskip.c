@@ -34,7 +34,8 @@
 /*
 ** Tests:
 ** nrrdLoad with positive and negative byte skipping on data read,
-** with nrrdEncodingRaw
+** with nrrdEncodingRaw, optionally with nio->mapData
+** nrrdDataMapped
 */
 
 static const char *tskipInfo = "for testing byte skipping in nrrd files";
@@ -47,16 +48,17 @@ main(int argc, const char **argv) {
   hestParm *hparm;
   airArray *mop;
   /* variables specific to this program */
-  int negskip, progress;
+  int negskip, progress, mapping;
   Nrrd *nref, *nin;
   size_t *size, ii, nn, tick, pad[2];
   unsigned int axi, refCRC, gotCRC, sizeNum;
   char *berr, *outS[2], stmp[AIR_STRLEN_SMALL], doneStr[AIR_STRLEN_SMALL];
   airRandMTState *rng;
-  unsigned int seed, *rdata, printbytes;
+  unsigned int seed, *rdata, printbytes, mapLevel, loadi;
   unsigned char *dataUC;
   double time0, time1;
   FILE *fout;
+  NrrdIoState *nio;
 
   /* start-up */
   mop = airMopNew();
@@ -75,6 +77,9 @@ main(int argc, const char **argv) {
   hestOptAdd(&hopt, "pb", "print", airTypeUInt, 1, 1, &printbytes, "0",
              "bytes to print at beginning and end of data, to help "
              "debug problems");
+  hestOptAdd(&hopt, "map", "level", airTypeUInt, 1, 1, &mapLevel, "0",
+             "memory-mapping of data on read: 0 for none, 1 to allow "
+             "it (but falling back to reading is ok), 2 to require it");
   hestOptAdd(&hopt, "o", "out.data out.nhdr", airTypeString, 2, 2,
              outS, NULL, "output filenames of data and header");
   hestParseOrDie(hopt, argc-1, argv+1, hparm, me, tskipInfo,
@@ -203,39 +208,62 @@ main(int argc, const char **argv) {
   airMopSingleOkay(mop, fout);
 
   /* read it in, make sure it checks out */
-  fprintf(stderr, "reading data . . . \n");
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
   nin = nrrdNew();
   airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
-  if (nrrdLoad(nin, outS[1], NULL)) {
-    airMopAdd(mop, berr=biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error reading back in: %s\n", me, berr);
-    airMopError(mop); return 1;
-  }
-  if (printbytes) {
-    size_t bi, rpb, local_nn;
-    char local_stmp[AIR_STRLEN_SMALL];
-    local_nn = nrrdElementSize(nin)*nrrdElementNumber(nin);
-    rpb = AIR_MIN(printbytes, local_nn);
-    dataUC = AIR_CAST(unsigned char *, nin->data);
-    fprintf(stderr, "FOUND %s bytes at beginning:\n",
-            airSprintSize_t(local_stmp, rpb));
-    for (bi=0; bi<rpb; bi++) {
-      fprintf(stderr, "%x ", dataUC[bi]);
+  /* with mapping, the second load (into the same nrrd, freeing the
+     first mapping) makes sure that scribbling on the first didn't
+     change the file */
+  for (loadi=0; loadi<(mapLevel ? 2u : 1u); loadi++) {
+    fprintf(stderr, "reading data . . . \n");
+    nrrdIoStateInit(nio);
+    nio->mapData = !!mapLevel;
+    if (nrrdLoad(nin, outS[1], nio)) {
+      airMopAdd(mop, berr=biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: error reading back in: %s\n", me, berr);
+      airMopError(mop); return 1;
     }
-    fprintf(stderr, "...\n");
-    fprintf(stderr, "FOUND %s bytes at end:\n",
-            airSprintSize_t(local_stmp, rpb));
-    fprintf(stderr, "...");
-    for (bi=local_nn - rpb; bi<local_nn; bi++) {
-      fprintf(stderr, " %x", dataUC[bi]);
+    mapping = nrrdDataMapped(nin->data);
+    fprintf(stderr, "data %s mapped\n", mapping ? "was" : "was not");
+    if (mapping && !mapLevel) {
+      fprintf(stderr, "%s: data mapped without asking for it\n", me);
+      airMopError(mop); return 1;
     }
-    fprintf(stderr, "\n");
-  }
-  fprintf(stderr, "finding new CRC . . . \n");
-  gotCRC = nrrdCRC32(nin, airEndianBig);
-  if (refCRC != gotCRC) {
-    fprintf(stderr, "%s: got CRC %u but wanted %u\n", me, gotCRC, refCRC);
-    airMopError(mop); return 1;
+    if (!mapping && 2 == mapLevel) {
+      fprintf(stderr, "%s: data not mapped but it was required\n", me);
+      airMopError(mop); return 1;
+    }
+    if (printbytes) {
+      size_t bi, rpb, local_nn;
+      char local_stmp[AIR_STRLEN_SMALL];
+      local_nn = nrrdElementSize(nin)*nrrdElementNumber(nin);
+      rpb = AIR_MIN(printbytes, local_nn);
+      dataUC = AIR_CAST(unsigned char *, nin->data);
+      fprintf(stderr, "FOUND %s bytes at beginning:\n",
+              airSprintSize_t(local_stmp, rpb));
+      for (bi=0; bi<rpb; bi++) {
+        fprintf(stderr, "%x ", dataUC[bi]);
+      }
+      fprintf(stderr, "...\n");
+      fprintf(stderr, "FOUND %s bytes at end:\n",
+              airSprintSize_t(local_stmp, rpb));
+      fprintf(stderr, "...");
+      for (bi=local_nn - rpb; bi<local_nn; bi++) {
+        fprintf(stderr, " %x", dataUC[bi]);
+      }
+      fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "finding new CRC . . . \n");
+    gotCRC = nrrdCRC32(nin, airEndianBig);
+    if (refCRC != gotCRC) {
+      fprintf(stderr, "%s: got CRC %u but wanted %u\n", me, gotCRC, refCRC);
+      airMopError(mop); return 1;
+    }
+    /* mapped data is copy-on-write; this must not reach the file */
+    rdata = AIR_CAST(unsigned int *, nin->data);
+    rdata[0] += 1;
+    rdata[nrrdElementNumber(nin)-1] += 1;
   }
   fprintf(stderr, "(all ok)\n");
 
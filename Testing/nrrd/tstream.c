@@ -0,0 +1,284 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/nrrd.h"
+
+/*
+** Tests:
+** nrrdStreamWriteOpen, nrrdStreamSlabWrite, nrrdStreamWrite,
+** nrrdStreamReadOpen, nrrdStreamSlabRead, nrrdStreamRead,
+** nrrdStreamClose, nrrdHestIterNumber
+**
+** that writing data in pieces with a NrrdStream, with various encodings
+** and attached or detached data, gives what nrrdLoad reads as the whole
+** array, and that reading it back in pieces gives the same pieces.  Also
+** that for operands that can't be opened as files (as for "unu 2op
+** -stream"), nrrdHestIterNumber decides between a number and a missing
+** file the same way nrrdHestIter does
+*/
+
+#define SX 23
+#define SY 19
+#define SZ 17
+
+/* writes nin to fname with encoding enc, in slabs of sliceNum slices,
+   except for the last slab, which is written value by value */
+static int
+save(const char *fname, const Nrrd *nin, const NrrdEncoding *enc,
+      size_t sliceNum) {
+  static const char me[]="save";
+  NrrdStream *nst;
+  Nrrd *nslab;
+  size_t zi, cmin[3], cmax[3], sliceSize;
+  const float *data;
+  airArray *mop;
+
+  mop = airMopNew();
+  nst = nrrdStreamNew();
+  airMopAdd(mop, nst, (airMopper)nrrdStreamNix, airMopAlways);
+  nslab = nrrdNew();
+  airMopAdd(mop, nslab, (airMopper)nrrdNuke, airMopAlways);
+  nst->nio->encoding = enc;
+  if (nrrdStreamWriteOpen(nst, fname, nin)) {
+    biffAddf(NRRD, "%s: trouble opening %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  cmin[0] = cmin[1] = 0;
+  cmax[0] = SX-1;
+  cmax[1] = SY-1;
+  sliceSize = SX*SY;
+  for (zi=0; zi+sliceNum<SZ; zi+=sliceNum) {
+    cmin[2] = zi;
+    cmax[2] = zi+sliceNum-1;
+    if (nrrdCrop(nslab, nin, cmin, cmax)
+        || nrrdStreamSlabWrite(nst, nslab)) {
+      biffAddf(NRRD, "%s: trouble writing slab at %u", me,
+               AIR_CAST(unsigned int, zi));
+      airMopError(mop); return 1;
+    }
+  }
+  data = AIR_CAST(const float *, nin->data);
+  for (; zi*sliceSize<SX*SY*SZ; zi++) {
+    if (nrrdStreamWrite(nst, data + zi*sliceSize, sliceSize)) {
+      biffAddf(NRRD, "%s: trouble writing slice %u", me,
+               AIR_CAST(unsigned int, zi));
+      airMopError(mop); return 1;
+    }
+  }
+  if (nrrdStreamClose(nst)) {
+    biffAddf(NRRD, "%s: trouble closing %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* loads fname whole, and in slabs of at most maxBytes, and compares
+   both with ncmp */
+static int
+check(const char *fname, const Nrrd *ncmp, size_t maxBytes) {
+  static const char me[]="check";
+  NrrdStream *nst;
+  Nrrd *nin, *nslab, *ncrop;
+  size_t zi, cmin[3], cmax[3];
+  char explain[AIR_STRLEN_LARGE];
+  int differ;
+  airArray *mop;
+
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nslab = nrrdNew();
+  airMopAdd(mop, nslab, (airMopper)nrrdNuke, airMopAlways);
+  ncrop = nrrdNew();
+  airMopAdd(mop, ncrop, (airMopper)nrrdNuke, airMopAlways);
+  nst = nrrdStreamNew();
+  airMopAdd(mop, nst, (airMopper)nrrdStreamNix, airMopAlways);
+  if (nrrdLoad(nin, fname, NULL)
+      || nrrdCompare(ncmp, nin, AIR_FALSE /* onlyData */, 0.0 /* epsilon */,
+                     &differ, explain)) {
+    biffAddf(NRRD, "%s: trouble loading or comparing %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  if (differ) {
+    biffAddf(NRRD, "%s: %s differs: %s", me, fname, explain);
+    airMopError(mop); return 1;
+  }
+  if (nrrdStreamReadOpen(nst, fname)) {
+    biffAddf(NRRD, "%s: trouble opening %s", me, fname);
+    airMopError(mop); return 1;
+  }
+  cmin[0] = cmin[1] = 0;
+  cmax[0] = SX-1;
+  cmax[1] = SY-1;
+  zi = 0;
+  while (nst->elementDone < nst->elementNum) {
+    if (nrrdStreamSlabRead(nst, nslab, maxBytes)) {
+      biffAddf(NRRD, "%s: trouble reading slab at %u", me,
+               AIR_CAST(unsigned int, zi));
+      airMopError(mop); return 1;
+    }
+    cmin[2] = zi;
+    cmax[2] = zi + nslab->axis[2].size - 1;
+    if (nrrdCrop(ncrop, ncmp, cmin, cmax)
+        || nrrdCompare(ncrop, nslab, AIR_TRUE /* onlyData */, 0.0,
+                       &differ, explain)) {
+      biffAddf(NRRD, "%s: trouble comparing slab at %u", me,
+               AIR_CAST(unsigned int, zi));
+      airMopError(mop); return 1;
+    }
+    if (differ) {
+      biffAddf(NRRD, "%s: %s slab at %u differs: %s", me, fname,
+               AIR_CAST(unsigned int, zi), explain);
+      airMopError(mop); return 1;
+    }
+    zi += nslab->axis[2].size;
+  }
+  if (SZ != zi || nrrdStreamClose(nst)) {
+    biffAddf(NRRD, "%s: read %u slices of %s, not %u", me,
+             AIR_CAST(unsigned int, zi), fname, SZ);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/* checks that str (which can't be opened) is taken as the number want
+   by both nrrdHestIterNumber and nrrdHestIter if isNum, or as a missing
+   file by both if !isNum */
+static int
+operand(const char *str, int isNum, double want) {
+  static const char me[]="operand";
+  char err[AIR_STRLEN_HUGE];
+  NrrdStream *nst;
+  NrrdIter *iter;
+  double val;
+  int ret;
+
+  nst = nrrdStreamNew();
+  ret = nrrdStreamReadOpen(nst, str);
+  nrrdStreamNix(nst);
+  if (2 != ret) {
+    biffAddf(NRRD, "%s: opening \"%s\" returned %d, not 2", me, str, ret);
+    return 1;
+  }
+  biffDone(NRRD);
+  if (isNum != nrrdHestIterNumber(&val, str)) {
+    biffAddf(NRRD, "%s: \"%s\" %s a number for nrrdHestIterNumber", me, str,
+             isNum ? "isn't" : "is");
+    return 1;
+  }
+  if (isNum && val != want) {
+    biffAddf(NRRD, "%s: \"%s\" gave %g, not %g", me, str, val, want);
+    return 1;
+  }
+  iter = NULL;
+  ret = nrrdHestIter->parse(&iter, str, err);
+  val = AIR_NAN;
+  if (!ret) {
+    val = nrrdIterValue(iter);
+    nrrdIterNix(iter);
+  }
+  if (isNum == !!ret || (isNum && val != want)) {
+    biffAddf(NRRD, "%s: nrrdHestIter disagrees about \"%s\"", me, str);
+    return 1;
+  }
+  return 0;
+}
+
+#define OPND_NUM 5
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  static const char * const fname[2] = {"tstream.nrrd", "tstreamA.nhdr"};
+  static const size_t sliceNum[3] = {1, 4, 20};
+  static const size_t maxBytes[3] = {1, 3*SX*SY*sizeof(float), 1 << 20};
+  /* none of these exist as files */
+  static const char * const opnd[OPND_NUM] = {"3", "-2.5e1", "3scan.nrrd",
+                                              "x7.nrrd", "3.nrrd"};
+  static const int opndIsNum[OPND_NUM] = {AIR_TRUE, AIR_TRUE, AIR_FALSE,
+                                          AIR_FALSE, AIR_FALSE};
+  static const double opndVal[OPND_NUM] = {3, -25, 0, 0, 0};
+  const NrrdEncoding *enc[3];
+  Nrrd *nin;
+  airArray *mop;
+  float *in;
+  size_t ii;
+  unsigned int ei, fi, si;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeFloat, 3, AIR_CAST(size_t, SX),
+                   AIR_CAST(size_t, SY), AIR_CAST(size_t, SZ))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nin->axis[2].spacing = 1.5;
+  in = AIR_CAST(float *, nin->data);
+  airSrandMT(4242);
+  for (ii=0; ii<SX*SY*SZ; ii++) {
+    in[ii] = AIR_CAST(float, (ii % 101) + airDrandMT());
+  }
+  enc[0] = nrrdEncodingRaw;
+  enc[1] = nrrdEncodingGzip;
+  enc[2] = nrrdEncodingBzip2;
+
+  for (ei=0; ei<3; ei++) {
+    if (!enc[ei]->available()) {
+      printf("%s: skipping unavailable %s\n", me, enc[ei]->name);
+      continue;
+    }
+    for (fi=0; fi<2; fi++) {
+      for (si=0; si<3; si++) {
+        if (save(fname[fi], nin, enc[ei], sliceNum[si])
+            || check(fname[fi], nin, maxBytes[(si+fi) % 3])) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble with %s %s:\n%s", me,
+                  enc[ei]->name, fname[fi], err);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    printf("%s: good: %s\n", me, enc[ei]->name);
+  }
+  for (ii=0; ii<OPND_NUM; ii++) {
+    if (operand(opnd[ii], opndIsNum[ii], opndVal[ii])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble with operand:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+  }
+  printf("%s: good: operands\n", me);
+
+  airMopOkay(mop);
+  return 0;
+}
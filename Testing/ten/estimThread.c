@@ -0,0 +1,261 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** tenEstimateThreadNumSet
+** tenEstimate1TensorVolume4D
+** tenEstimate1TensorSingle_d
+**
+** that estimating tensors with more than one thread gives exactly the
+** same tensors, B0, and fitting error as with one thread, and that the
+** volume estimation (which does linear least-squares on blocks of voxels
+** at once) gives the same as estimating one voxel at a time
+*/
+
+#define GRAD_NUM 13
+#define ALT_NUM 3
+
+static int
+setup(tenEstimateContext *tec, const Nrrd *ngrad, int method,
+      unsigned int threadNum) {
+  int E;
+
+  E = 0;
+  if (!E) E |= tenEstimateMethodSet(tec, method);
+  if (!E) E |= tenEstimateGradientsSet(tec, ngrad, 1000, AIR_TRUE);
+  if (!E) E |= tenEstimateValueMinSet(tec, 1.0);
+  if (!E) E |= tenEstimateThresholdSet(tec, 50, 10);
+  if (!E) E |= tenEstimateThreadNumSet(tec, threadNum);
+  if (!E) {
+    if (tenEstimate1MethodLLS == method) {
+      tec->recordErrorLogDwi = AIR_TRUE;
+    } else {
+      tec->recordErrorDwi = AIR_TRUE;
+    }
+  }
+  if (!E) E |= tenEstimateUpdate(tec);
+  return E;
+}
+
+static int
+estimate(Nrrd *nten, Nrrd **nB0P, Nrrd **nterrP, const Nrrd *ndwi,
+         const Nrrd *ngrad, int method, unsigned int threadNum) {
+  static const char me[]="estimate";
+  tenEstimateContext *tec;
+  airArray *mop;
+  int E;
+
+  mop = airMopNew();
+  tec = tenEstimateContextNew();
+  airMopAdd(mop, tec, (airMopper)tenEstimateContextNix, airMopAlways);
+  E = 0;
+  if (!E) E |= setup(tec, ngrad, method, threadNum);
+  if (!E) E |= tenEstimate1TensorVolume4D(tec, nten, nB0P, nterrP,
+                                          ndwi, nrrdTypeDouble);
+  if (E) {
+    biffAddf(TEN, "%s: trouble estimating with %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** compares volume estimates with estimating one voxel at a time
+*/
+static int
+compareSingle(int *differP, const Nrrd *nten, const Nrrd *nB0,
+              const Nrrd *nterr, const Nrrd *ndwi, const Nrrd *ngrad,
+              int method) {
+  static const char me[]="compareSingle";
+  tenEstimateContext *tec;
+  const double *vten, *vB0, *verr, *dwi;
+  double ten[7], B0, err;
+  size_t II, NN;
+  unsigned int ci, allNum;
+  airArray *mop;
+
+  mop = airMopNew();
+  tec = tenEstimateContextNew();
+  airMopAdd(mop, tec, (airMopper)tenEstimateContextNix, airMopAlways);
+  if (setup(tec, ngrad, method, 1)) {
+    biffAddf(TEN, "%s: trouble setting up", me);
+    airMopError(mop); return 1;
+  }
+  vten = AIR_CAST(const double *, nten->data);
+  vB0 = AIR_CAST(const double *, nB0->data);
+  verr = AIR_CAST(const double *, nterr->data);
+  dwi = AIR_CAST(const double *, ndwi->data);
+  allNum = AIR_UINT(ndwi->axis[0].size);
+  NN = nrrdElementNumber(nB0);
+  *differP = AIR_FALSE;
+  for (II=0; II<NN; II++) {
+    if (tenEstimate1TensorSingle_d(tec, ten, dwi + allNum*II)) {
+      biffAddf(TEN, "%s: trouble at voxel %u", me, AIR_UINT(II));
+      airMopError(mop); return 1;
+    }
+    B0 = tec->estimatedB0;
+    err = (tenEstimate1MethodLLS == method
+           ? tec->errorLogDwi
+           : tec->errorDwi);
+    for (ci=0; ci<7; ci++) {
+      *differP |= (ten[ci] != vten[ci + 7*II]);
+    }
+    *differP |= (B0 != vB0[II] || err != verr[II]);
+    if (*differP) {
+      fprintf(stderr, "%s: voxel %u differs\n", me, AIR_UINT(II));
+      break;
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+int
+main(int argc, const char **argv) {
+  const char *me;
+  static const int method[] = {tenEstimate1MethodLLS,
+                               tenEstimate1MethodWLS};
+  static const unsigned int threadNum[ALT_NUM] = {2, 3, 8};
+  Nrrd *ngrad, *ndwi, *nten[2], *nB0[2], *nterr[2];
+  double *grad, *dwi, ten[7], gg[3], dd;
+  size_t sx=7, sy=6, sz=5, II, NN;
+  unsigned int gi, mi, ti, ni;
+  int differ;
+  char explain[AIR_STRLEN_LARGE];
+  airArray *mop;
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  ngrad = nrrdNew();
+  airMopAdd(mop, ngrad, (airMopper)nrrdNuke, airMopAlways);
+  ndwi = nrrdNew();
+  airMopAdd(mop, ndwi, (airMopper)nrrdNuke, airMopAlways);
+  for (ni=0; ni<2; ni++) {
+    nten[ni] = nrrdNew();
+    airMopAdd(mop, nten[ni], (airMopper)nrrdNuke, airMopAlways);
+  }
+  if (nrrdAlloc_va(ngrad, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                   AIR_CAST(size_t, GRAD_NUM))
+      || nrrdAlloc_va(ndwi, nrrdTypeDouble, 4, AIR_CAST(size_t, GRAD_NUM),
+                      sx, sy, sz)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airSrandMT(4343);
+  /* one non-DW image, and random unit-length gradients */
+  grad = AIR_CAST(double *, ngrad->data);
+  ELL_3V_SET(grad, 0, 0, 0);
+  for (gi=1; gi<GRAD_NUM; gi++) {
+    do {
+      ELL_3V_SET(gg, airDrandMT()-0.5, airDrandMT()-0.5, airDrandMT()-0.5);
+    } while (ELL_3V_LEN(gg) < 0.1);
+    ELL_3V_NORM(grad + 3*gi, gg, dd);
+  }
+  /* noisy DWIs from random tensors */
+  dwi = AIR_CAST(double *, ndwi->data);
+  NN = sx*sy*sz;
+  for (II=0; II<NN; II++) {
+    double B0;
+    B0 = 100 + 400*airDrandMT();
+    TEN_T_SET(ten, 1.0,
+              0.0015 + 0.001*airDrandMT(), 0.0003*(airDrandMT()-0.5),
+              0.0003*(airDrandMT()-0.5), 0.0008 + 0.001*airDrandMT(),
+              0.0003*(airDrandMT()-0.5), 0.0004 + 0.0004*airDrandMT());
+    for (gi=0; gi<GRAD_NUM; gi++) {
+      double *g;
+      g = grad + 3*gi;
+      dd = (ten[1]*g[0]*g[0] + 2*ten[2]*g[0]*g[1] + 2*ten[3]*g[0]*g[2]
+            + ten[4]*g[1]*g[1] + 2*ten[5]*g[1]*g[2] + ten[6]*g[2]*g[2]);
+      dwi[gi + GRAD_NUM*II] = (B0*exp(-1000*dd)
+                               *(1 + 0.05*(airDrandMT()-0.5)));
+    }
+  }
+
+  for (mi=0; mi<AIR_UINT(sizeof(method)/sizeof(int)); mi++) {
+    const char *mstr;
+    mstr = airEnumStr(tenEstimate1Method, method[mi]);
+    if (estimate(nten[0], nB0 + 0, nterr + 0, ndwi, ngrad, method[mi], 1)) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, nB0[0], (airMopper)nrrdNuke, airMopAlways);
+    airMopAdd(mop, nterr[0], (airMopper)nrrdNuke, airMopAlways);
+    if (compareSingle(&differ, nten[0], nB0[0], nterr[0], ndwi, ngrad,
+                      method[mi])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (differ) {
+      fprintf(stderr, "%s: %s volume and single voxel estimates differ\n",
+              me, mstr);
+      airMopError(mop); return 1;
+    }
+    for (ti=0; ti<ALT_NUM; ti++) {
+      if (estimate(nten[1], nB0 + 1, nterr + 1, ndwi, ngrad, method[mi],
+                   threadNum[ti])) {
+        char *err;
+        airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+        fprintf(stderr, "%s: trouble:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+      airMopAdd(mop, nB0[1], (airMopper)nrrdNuke, airMopAlways);
+      airMopAdd(mop, nterr[1], (airMopper)nrrdNuke, airMopAlways);
+      for (ni=0; ni<3; ni++) {
+        const Nrrd *nsngl, *nmult;
+        nsngl = (!ni ? nten[0] : (1 == ni ? nB0[0] : nterr[0]));
+        nmult = (!ni ? nten[1] : (1 == ni ? nB0[1] : nterr[1]));
+        if (nrrdCompare(nsngl, nmult, AIR_FALSE /* onlyData */,
+                        0.0 /* epsilon */, &differ, explain)) {
+          char *err;
+          airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+          fprintf(stderr, "%s: trouble comparing:\n%s", me, err);
+          airMopError(mop); return 1;
+        }
+        if (differ) {
+          fprintf(stderr, "%s: %s with 1 and %u threads: %s differ: %s\n",
+                  me, mstr, threadNum[ti],
+                  (!ni ? "tensors" : (1 == ni ? "B0s" : "errors")),
+                  explain);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+    printf("%s: good: %s same with more threads, and per voxel\n",
+           me, mstr);
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
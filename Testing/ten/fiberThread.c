@@ -0,0 +1,257 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "teem/ten.h"
+
+/*
+** Tests:
+** tenFiberContextNew
+** tenFiberThreadNumSet
+** tenFiberContextCopy
+** tenFiberMultiNew
+** tenFiberMultiTrace
+**
+** that tracing fibers from many seedpoints with more than one thread
+** gives exactly the same fibers, in the same order, as with one thread,
+** including when the tenFiberMulti is re-used for another tracing
+*/
+
+#define SIZE_X 30
+#define SIZE_Y 34
+#define SIZE_Z 12
+#define SEED_NUM 700
+#define ALT_NUM 4
+
+static int
+trace(tenFiberMulti *tfml, const Nrrd *nten, const Nrrd *nseed,
+      unsigned int threadNum) {
+  static const char me[]="trace";
+  tenFiberContext *tfx;
+  NrrdKernelSpec *ksp;
+  airArray *mop;
+  int E;
+
+  mop = airMopNew();
+  tfx = tenFiberContextNew(nten);
+  if (!tfx) {
+    biffAddf(TEN, "%s: couldn't create context", me);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, tfx, (airMopper)tenFiberContextNix, airMopAlways);
+  ksp = nrrdKernelSpecNew();
+  airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  E = 0;
+  if (!E) E |= nrrdKernelSpecParse(ksp, "cubic:0,0.5");
+  if (E) {
+    biffMovef(TEN, NRRD, "%s: couldn't parse kernel", me);
+    airMopError(mop); return 1;
+  }
+  if (!E) E |= tenFiberTypeSet(tfx, tenFiberTypeTensorLine);
+  if (!E) E |= tenFiberKernelSet(tfx, ksp->kernel, ksp->parm);
+  if (!E) E |= tenFiberIntgSet(tfx, tenFiberIntgRK4);
+  if (!E) E |= tenFiberProbeItemSet(tfx, tenGageFA);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopAniso, tenAniso_FA, 0.45);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopLength, 12.0);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopNumSteps, 300);
+  if (!E) E |= tenFiberStopSet(tfx, tenFiberStopBounds);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, 0.2);
+  if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace, AIR_TRUE);
+  if (!E) E |= tenFiberThreadNumSet(tfx, threadNum);
+  if (!E) E |= tenFiberUpdate(tfx);
+  if (!E) E |= tenFiberMultiTrace(tfx, tfml, nseed);
+  if (E) {
+    biffAddf(TEN, "%s: trouble tracing with %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+static int
+fiberSame(const tenFiberSingle *fa, const tenFiberSingle *fb,
+          char explain[AIR_STRLEN_LARGE]) {
+  int differ;
+
+  if (!(fa->dirIdx == fb->dirIdx
+        && fa->dirNum == fb->dirNum
+        && fa->seedPos[0] == fb->seedPos[0]
+        && fa->seedPos[1] == fb->seedPos[1]
+        && fa->seedPos[2] == fb->seedPos[2])) {
+    strcpy(explain, "different seed");
+    return AIR_FALSE;
+  }
+  if (fa->whyNowhere != fb->whyNowhere) {
+    strcpy(explain, "different whyNowhere");
+    return AIR_FALSE;
+  }
+  if (tenFiberStopUnknown != fa->whyNowhere) {
+    return AIR_TRUE;
+  }
+  if (!(fa->stepNum[0] == fb->stepNum[0]
+        && fa->stepNum[1] == fb->stepNum[1]
+        && fa->halfLen[0] == fb->halfLen[0]
+        && fa->halfLen[1] == fb->halfLen[1]
+        && fa->whyStop[0] == fb->whyStop[0]
+        && fa->whyStop[1] == fb->whyStop[1])) {
+    strcpy(explain, "different steps, lengths, or stops");
+    return AIR_FALSE;
+  }
+  if (nrrdCompare(fa->nvert, fb->nvert, AIR_TRUE /* onlyData */,
+                  0.0 /* epsilon */, &differ, explain)) {
+    strcpy(explain, "couldn't compare vertices");
+    return AIR_FALSE;
+  }
+  if (!differ) {
+    if (nrrdCompare(fa->nval, fb->nval, AIR_TRUE /* onlyData */,
+                    0.0 /* epsilon */, &differ, explain)) {
+      strcpy(explain, "couldn't compare values");
+      return AIR_FALSE;
+    }
+  }
+  return !differ;
+}
+
+int
+main(int argc, const char *argv[]) {
+  const char *me;
+  /* alternatives to 1 thread */
+  static const unsigned int threadNum[ALT_NUM] = {2, 3, 8, 1};
+  Nrrd *nten, *nseed, *nseedBig;
+  tenFiberMulti *tfmlS, *tfmlM;
+  airArray *mop;
+  float *ten;
+  double *seed, eval[3], evec[9], tt[7], xx, yy, zz, rr;
+  unsigned int xi, yi, zi, si, ti, fi, seedBigNum;
+  char explain[AIR_STRLEN_LARGE];
+
+  AIR_UNUSED(argc);
+  me = argv[0];
+  mop = airMopNew();
+
+  /* tensors with circular principal eigenvectors around the volume
+     center, getting less anisotropic away from a preferred radius */
+  nten = nrrdNew();
+  airMopAdd(mop, nten, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nten, nrrdTypeFloat, 4, AIR_CAST(size_t, 7),
+                   AIR_CAST(size_t, SIZE_X), AIR_CAST(size_t, SIZE_Y),
+                   AIR_CAST(size_t, SIZE_Z))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  nten->axis[0].kind = nrrdKind3DMaskedSymMatrix;
+  nrrdAxisInfoSet_va(nten, nrrdAxisInfoSpacing, AIR_NAN, 1.0, 1.0, 1.0);
+  ten = AIR_CAST(float *, nten->data);
+  for (zi=0; zi<SIZE_Z; zi++) {
+    for (yi=0; yi<SIZE_Y; yi++) {
+      for (xi=0; xi<SIZE_X; xi++) {
+        xx = xi - (SIZE_X-1)/2.0;
+        yy = yi - (SIZE_Y-1)/2.0;
+        zz = zi - (SIZE_Z-1)/2.0;
+        rr = sqrt(xx*xx + yy*yy) + 0.001;
+        ELL_3V_SET(evec + 0, -yy/rr, xx/rr, 0.1*zz/SIZE_Z);
+        ELL_3V_NORM(evec + 0, evec + 0, rr);
+        ELL_3V_SET(evec + 3, xx/rr, yy/rr, 0);
+        ELL_3V_NORM(evec + 3, evec + 3, rr);
+        ELL_3V_CROSS(evec + 6, evec + 0, evec + 3);
+        rr = fabs(sqrt(xx*xx + yy*yy) - 9);
+        ELL_3V_SET(eval, 1.0, 0.2 + 0.06*rr, 0.15 + 0.05*rr);
+        tenMakeSingle_d(tt, 1.0, eval, evec);
+        TEN_T_COPY_TT(ten, float, tt);
+        ten += 7;
+      }
+    }
+  }
+
+  /* the big seed list is traced first, so that the smaller list re-uses
+     (and shortens) the fiber arrays */
+  seedBigNum = SEED_NUM + SEED_NUM/3;
+  nseedBig = nrrdNew();
+  airMopAdd(mop, nseedBig, (airMopper)nrrdNuke, airMopAlways);
+  nseed = nrrdNew();
+  airMopAdd(mop, nseed, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdAlloc_va(nseedBig, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                   AIR_CAST(size_t, seedBigNum))
+      || nrrdAlloc_va(nseed, nrrdTypeDouble, 2, AIR_CAST(size_t, 3),
+                      AIR_CAST(size_t, SEED_NUM))) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  airSrandMT(4242);
+  seed = AIR_CAST(double *, nseedBig->data);
+  for (si=0; si<seedBigNum; si++) {
+    ELL_3V_SET(seed + 3*si,
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_X-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_Y-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_Z-1));
+  }
+  seed = AIR_CAST(double *, nseed->data);
+  for (si=0; si<SEED_NUM; si++) {
+    ELL_3V_SET(seed + 3*si,
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_X-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_Y-1),
+               AIR_AFFINE(0, airDrandMT(), 1, 0, SIZE_Z-1));
+  }
+
+  tfmlS = tenFiberMultiNew();
+  airMopAdd(mop, tfmlS, (airMopper)tenFiberMultiNix, airMopAlways);
+  tfmlM = tenFiberMultiNew();
+  airMopAdd(mop, tfmlM, (airMopper)tenFiberMultiNix, airMopAlways);
+  if (!( tfmlS && tfmlM )
+      || trace(tfmlS, nten, nseed, 1)
+      || trace(tfmlM, nten, nseedBig, 3)) {
+    char *err;
+    airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble:\n%s", me, err);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<ALT_NUM; ti++) {
+    if (trace(tfmlM, nten, nseed, threadNum[ti])) {
+      char *err;
+      airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    if (tfmlS->fiberNum != tfmlM->fiberNum) {
+      fprintf(stderr, "%s: got %u fibers with 1 thread, but %u with %u\n",
+              me, tfmlS->fiberNum, tfmlM->fiberNum, threadNum[ti]);
+      airMopError(mop); return 1;
+    }
+    for (fi=0; fi<tfmlS->fiberNum; fi++) {
+      if (!fiberSame(tfmlS->fiber + fi, tfmlM->fiber + fi, explain)) {
+        fprintf(stderr, "%s: fiber %u differs with 1 and %u threads: %s\n",
+                me, fi, threadNum[ti], explain);
+        airMopError(mop); return 1;
+      }
+    }
+  }
+  printf("%s: good: %u fibers same with more threads\n",
+         me, tfmlS->fiberNum);
+
+  airMopOkay(mop);
+  return 0;
+}
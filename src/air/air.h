@@ -341,6 +341,10 @@ AIR_EXPORT int airThreadJoin(airThread *thread, void **retP);
 AIR_EXPORT airThread *airThreadNix(airThread *thread);
 
 AIR_EXPORT airThreadMutex *airThreadMutexNew(void);
+/* sets *mutexP to a new mutex if it is NULL; safe to call from many
+   threads at once (for lazily creating a mutex shared by all threads).
+   Returns *mutexP, which is NULL only if the mutex couldn't be made */
+AIR_EXPORT airThreadMutex *airThreadMutexNewOnce(airThreadMutex **mutexP);
 AIR_EXPORT int airThreadMutexLock(airThreadMutex *mutex);
 AIR_EXPORT int airThreadMutexUnlock(airThreadMutex *mutex);
 AIR_EXPORT airThreadMutex *airThreadMutexNix(airThreadMutex *mutex);
@@ -93,6 +93,22 @@ airThreadMutexNew(void) {
   return mutex;
 }
 
+/* serializes all airThreadMutexNewOnce calls */
+static pthread_mutex_t _airThreadOnceLock = PTHREAD_MUTEX_INITIALIZER;
+
+airThreadMutex *
+airThreadMutexNewOnce(airThreadMutex **mutexP) {
+  airThreadMutex *mutex;
+
+  pthread_mutex_lock(&_airThreadOnceLock);
+  if (!*mutexP) {
+    *mutexP = airThreadMutexNew();
+  }
+  mutex = *mutexP;
+  pthread_mutex_unlock(&_airThreadOnceLock);
+  return mutex;
+}
+
 int
 airThreadMutexLock(airThreadMutex *mutex) {
 
@@ -259,6 +275,21 @@ airThreadMutexNew() {
   return mutex;
 }
 
+airThreadMutex *
+airThreadMutexNewOnce(airThreadMutex **mutexP) {
+  airThreadMutex *mutex;
+
+  if (!*mutexP) {
+    /* if another thread got there first, use its mutex instead */
+    mutex = airThreadMutexNew();
+    if (mutex && InterlockedCompareExchangePointer((PVOID volatile *)mutexP,
+                                                   mutex, NULL)) {
+      airThreadMutexNix(mutex);
+    }
+  }
+  return *mutexP;
+}
+
 int
 airThreadMutexLock(airThreadMutex *mutex) {
 
@@ -467,6 +498,15 @@ airThreadMutexNew(void) {
   return mutex;
 }
 
+airThreadMutex *
+airThreadMutexNewOnce(airThreadMutex **mutexP) {
+
+  if (!*mutexP) {
+    *mutexP = airThreadMutexNew();
+  }
+  return *mutexP;
+}
+
 int
 airThreadMutexLock(airThreadMutex *mutex) {
   char me[]="airThreadMutexLock";
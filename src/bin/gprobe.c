@@ -45,24 +45,24 @@ printans(FILE *file, const double *ans, unsigned int len) {
 }
 
 static int
-gridProbe(gageContext *ctx, gagePerVolume *pvl, int what,
+gridProbe(gageProbePool *pool, gagePerVolume *pvl, int what,
           Nrrd *nout, int typeOut, Nrrd *_ngrid,
-          int indexSpace, int verbose, int clamp, int scaleIsTau,
+          int indexSpace, int clamp, int scaleIsTau,
           double eft, double eftVal) {
   char me[]="gridProbe";
+  gageContext *ctx;
   Nrrd *ngrid;
   airArray *mop;
-  double *grid, pos[4];
-  const double *answer;
-  unsigned int ansLen, dim, aidx, baseDim, gridDim;
-  size_t sizeOut[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX], II, NN;
-  double (*ins)(void *v, size_t I, double d);
+  double *grid, pos[4], edge[4*NRRD_DIM_MAX];
+  unsigned int ansLen, dim, aidx, baseDim, gridDim, posLen, vi;
+  size_t sizeGrid[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX], II;
   char stmp[2][AIR_STRLEN_SMALL];
 
-  if (!(ctx && pvl && nout && _ngrid)) {
+  if (!(pool && pvl && nout && _ngrid)) {
     biffAddf(GAGE, "%s: got NULL pointer", me);
     return 1;
   }
+  ctx = pool->ctx;
   if (airEnumValCheck(nrrdType, typeOut)) {
     biffAddf(GAGE, "%s: type %d not valid", me, typeOut);
     return 1;
@@ -116,7 +116,6 @@ gridProbe(gageContext *ctx, gagePerVolume *pvl, int what,
              1 + gridDim, gridDim);
     airMopError(mop); return 1;
   }
-  answer = gageAnswerPointer(ctx, pvl, what);
   ansLen = pvl->kind->table[what].answerLength;
   baseDim = 1 == ansLen ? 0 : 1;
   dim = baseDim + gridDim;
@@ -124,81 +123,44 @@ gridProbe(gageContext *ctx, gagePerVolume *pvl, int what,
     biffAddf(GAGE, "%s: output dimension %u unreasonable", me, dim);
     airMopError(mop); return 1;
   }
-  if (ansLen > 1) {
-    sizeOut[0] = ansLen;
-    coordOut[0] = 0;
-  }
-  NN = 1;
+  /* the pool wants positions (and edge vectors) with only as many
+     coordinates as are used for probing */
+  posLen = ctx->stackPos ? 4 : 3;
   for (aidx=0; aidx<gridDim; aidx++) {
-    sizeOut[aidx + baseDim] = AIR_ROUNDUP_UI(grid[0 + 5*(aidx+1)]);
-    NN *= sizeOut[aidx + baseDim];
-    coordOut[aidx + baseDim] = 0;
+    sizeGrid[aidx] = AIR_ROUNDUP_UI(grid[0 + 5*(aidx+1)]);
+    for (vi=0; vi<posLen; vi++) {
+      edge[vi + posLen*aidx] = grid[1 + vi + 5*(1+aidx)];
+    }
   }
-  if (nrrdMaybeAlloc_nva(nout, typeOut, dim, sizeOut)) {
-    biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+  pool->scaleIsTau = scaleIsTau;
+  pool->edgeFracMax = eft;
+  pool->edgeFracVal = eftVal;
+  if (gageProbePoolGrid(pool, nout, typeOut, pvl, what,
+                        grid + 1 + 5*0, edge, sizeGrid, gridDim, posLen,
+                        indexSpace, clamp)) {
+    biffAddf(GAGE, "%s: trouble probing", me);
     airMopError(mop); return 1;
   }
-  ins = nrrdDInsert[nout->type];
-  for (II=0; II<NN; II++) {
-    int E;
-    if (verbose && 3 == gridDim
-        && !coordOut[0+baseDim] && !coordOut[1+baseDim]) {
-      if (verbose > 1) {
-        fprintf(stderr, "z = ");
-      }
-      fprintf(stderr, " %s/%s",
-              airSprintSize_t(stmp[0], coordOut[2+baseDim]),
-              airSprintSize_t(stmp[1], sizeOut[2+baseDim]));
-      fflush(stderr);
-      if (verbose > 1) {
-        fprintf(stderr, "\n");
-      }
+  if (pool->failNum) {
+    /* recover the (first) position that failed */
+    II = pool->failIdx;
+    for (aidx=0; aidx<gridDim; aidx++) {
+      coordOut[aidx] = II % sizeGrid[aidx];
+      II /= sizeGrid[aidx];
     }
     ELL_4V_COPY(pos, grid + 1 + 5*0);
     for (aidx=0; aidx<gridDim; aidx++) {
       ELL_4V_SCALE_ADD2(pos, 1, pos,
-                        AIR_CAST(double, coordOut[aidx + baseDim]),
+                        AIR_CAST(double, coordOut[aidx]),
                         grid + 1 + 5*(1+aidx));
     }
-    if (scaleIsTau && ctx->stackPos) {
-      /* have to convert given tau values to sigma */
-      pos[3] = airSigmaOfTau(pos[3]);
-    }
-    /*
-    printf("%s: %u -> (%u %u) -> %g %g %g %g (%s)\n", me,
-           AIR_UINT(II),
-           AIR_UINT(coordOut[0+baseDim]),
-           AIR_UINT(coordOut[1+baseDim]),
-           pos[0], pos[1], pos[2], pos[3],
-           indexSpace ? "index" : "world");
-    */
-    E = (ctx->stackPos
-         ? gageStackProbeSpace(ctx, pos[0], pos[1], pos[2], pos[3],
-                               indexSpace, clamp)
-         : gageProbeSpace(ctx, pos[0], pos[1], pos[2],
-                          indexSpace, clamp));
-    if (E) {
-      biffAddf(GAGE, "%s: trouble at II=%s =(%g,%g,%g,%g):\n%s\n(%d)\n", me,
-               airSprintSize_t(stmp[0], II),
-               pos[0], pos[1], pos[2], pos[3],
-               ctx->errStr, ctx->errNum);
-      airMopError(mop); return 1;
-    }
-    if (1 == ansLen) {
-      ins(nout->data, II, (ctx->edgeFrac > eft
-                           ? eftVal
-                           : *answer));
-    } else {
-      for (aidx=0; aidx<ansLen; aidx++) {
-        ins(nout->data, aidx + ansLen*II, (ctx->edgeFrac > eft
-                                           ? eftVal
-                                           : answer[aidx]));
-      }
-    }
-    NRRD_COORD_INCR(coordOut, sizeOut, dim, baseDim);
-  }
-  if (verbose && verbose <= 1) {
-    fprintf(stderr, "\n");
+    biffAddf(GAGE, "%s: trouble at II=%s =(%g,%g,%g,%g): %s "
+             "(and %s other failures)\n", me,
+             airSprintSize_t(stmp[0], pool->failIdx),
+             pos[0], pos[1], pos[2], pos[3],
+             airEnumDesc(gageErr, pool->failErrNum),
+             airSprintSize_t(stmp[1], pool->failNum-1));
+    airMopError(mop); return 1;
   }
 
   if (!indexSpace) {
@@ -249,7 +211,9 @@ main(int argc, const char *argv[]) {
   unsigned int ansLen, *skip, skipNum, pntPosNum,
     nonSbpOpi[NON_SBP_OPT_NUM], nsi;
   gageStackBlurParm *sbpIN, *sbpCL, *sbp;
+  gageProbePool *pool;
   int otype, clamp, scaleIsTau;
+  unsigned int threadNum;
   char stmp[4][AIR_STRLEN_SMALL];
 
   me = argv[0];
@@ -311,6 +275,10 @@ main(int argc, const char *argv[]) {
              "If this frac exceeds the first \"thresh\" "
              "value given here, then the saved value for the probe will be "
              "the second value \"val\" given here");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to probe with (when probing at a list of "
+             "positions, or on a grid). The output doesn't depend on "
+             "the number of threads.");
   hestOptAdd(&hopt, "zz", "bool", airTypeBool, 1, 1, &zeroZ, "false",
              "enable \"zeroZ\" behavior in gage that partially "
              "implements working with 3D images as if they are 2D");
@@ -656,11 +624,17 @@ main(int argc, const char *argv[]) {
     airMopOkay(mop); return 0;
   }
 
+  /* all other probing is done with (possibly) multiple threads */
+  if (!(pool = gageProbePoolNew(ctx, threadNum))) {
+    airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble setting up probing:\n%s\n", me, err);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, pool, (airMopper)gageProbePoolNix, airMopAlways);
+
   if (_npos) {
     /* given a nrrd of probe locations */
-    double *pos, (*ins)(void *v, size_t I, double d);
-    size_t II, NN;
-    unsigned int aidx;
+    size_t NN;
     if (!(2 == _npos->dim
           && (3 == _npos->axis[0].size || 4 == _npos->axis[0].size))) {
       fprintf(stderr, "%s: need npos 2-D 3-by-N or 4-by-N "
@@ -680,50 +654,29 @@ main(int argc, const char *argv[]) {
     airMopAdd(mop, npos, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
     nout = nrrdNew();
     airMopAdd(mop, nout, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
-    if (nrrdConvert(npos, _npos, nrrdTypeDouble)
-        || nrrdMaybeAlloc_va(nout, otype, 2,
-                             AIR_CAST(size_t, ansLen),
-                             AIR_CAST(size_t, NN))) {
+    if (nrrdConvert(npos, _npos, nrrdTypeDouble)) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: trouble with npos or nout:\n%s\n", me, err);
+      fprintf(stderr, "%s: trouble with npos:\n%s\n", me, err);
       airMopError(mop); return 1;
     }
 
-    pos = AIR_CAST(double *, npos->data);
-    ins = nrrdDInsert[nout->type];
-    for (II=0; II<NN; II++) {
-      if (sbp) {
-        gageStackProbeSpace(ctx, pos[0], pos[1], pos[2], pos[3],
-                            probeSpaceIndex, clamp);
-      } else {
-        gageProbeSpace(ctx, pos[0], pos[1], pos[2],
-                       probeSpaceIndex, clamp);
-      }
-      if (1 == ansLen) {
-        ins(nout->data, II, (ctx->edgeFrac > edgeFracInfo[0]
-                             ? edgeFracInfo[1]
-                             : *answer));
-      } else {
-        for (aidx=0; aidx<ansLen; aidx++) {
-          ins(nout->data, aidx + ansLen*II, (ctx->edgeFrac > edgeFracInfo[0]
-                                             ? edgeFracInfo[1]
-                                             : answer[aidx]));
-        }
-      }
-      /*
-      if (sbp) {
-        printf("%s: %s(%s:%g,%g,%g,%g) = ", me, airEnumStr(kind->enm, what),
-               probeSpaceIndex ? "index" : "world",
-               pos[0], pos[1], pos[2], pos[3]);
-      } else {
-        printf("%s: %s(%s:%g,%g,%g) = ", me, airEnumStr(kind->enm, what),
-               probeSpaceIndex ? "index" : "world",
-               pos[0], pos[1], pos[2]);
-      }
-      printans(stdout, answer, ansLen);
-      printf("\n");
-      */
-      pos += _npos->axis[0].size;
+    pool->edgeFracMax = edgeFracInfo[0];
+    pool->edgeFracVal = edgeFracInfo[1];
+    if (gageProbePoolPos(pool, nout, otype, pvl, what,
+                         AIR_CAST(const double *, npos->data),
+                         AIR_UINT(npos->axis[0].size), NN,
+                         probeSpaceIndex, clamp)) {
+      airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble probing:\n%s\n", me, err);
+      airMopError(mop); return 1;
+    }
+    if (pool->failNum) {
+      fprintf(stderr, "%s: WARNING: %s of %s probes failed (first at "
+              "index %s: %s); saved NaN for those\n", me,
+              airSprintSize_t(stmp[0], pool->failNum),
+              airSprintSize_t(stmp[1], NN),
+              airSprintSize_t(stmp[2], pool->failIdx),
+              airEnumDesc(gageErr, pool->failErrNum));
     }
     if (nrrdSave(outS, nout, NULL)) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
@@ -859,11 +812,11 @@ main(int argc, const char *argv[]) {
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
   gageParmSet(ctx, gageParmVerbose, verbose);
   t0 = airTime();
-  if (gridProbe(ctx, pvl, what, nout, otype, ngrid,
+  if (gridProbe(pool, pvl, what, nout, otype, ngrid,
                 (_ngrid
                  ? probeSpaceIndex  /* user specifies grid space */
                  : AIR_TRUE),       /* copying vprobe index-space behavior */
-                verbose, clamp, scaleIsTau,
+                clamp, scaleIsTau,
                 edgeFracInfo[0], edgeFracInfo[1])) {
     /* note hijacking of GAGE key */
     airMopAdd(mop, err = biffGetDone(GAGE), airFree, airMopAlways);
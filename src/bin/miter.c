@@ -133,12 +133,20 @@ main(int argc, const char *argv[]) {
              "-1 -1", "pixel for which to turn on verbose messages");
   hestOptAdd(&hopt, "n1", "near1", airTypeDouble, 1, 1, &(muu->opacNear1),
              "0.99", "opacity close enough to 1.0 to terminate ray");
+  hestOptAdd(&hopt, "es", NULL, airTypeInt, 0, 0, &(muu->emptySkip), NULL,
+             "skip empty space: find the blocks of the volume where the "
+             "opacity transfer function is zero, and leap rays over them "
+             "without sampling");
   hestOptAdd(&hopt, "nt", "# threads", airTypeInt, 1, 1,
              &(muu->hctx->numThreads), "1",
              (airThreadCapable
               ? "number of threads hoover should use"
               : "if pthreads where enabled in this Teem build, this is how "
               "you would control the number of threads hoover should use"));
+  hestOptAdd(&hopt, "tile", "size", airTypeInt, 1, 1,
+             &(muu->hctx->tileSize), "16", "rays are cast in tiles of "
+             "this many pixels on a side, handed out to threads one at a "
+             "time; 0 means whole scanlines");
   hestOptAdd(&hopt, "o", "filename", airTypeString, 1, 1, &outS,
              NULL, "file to write output nrrd to");
   hestParseOrDie(hopt, argc-1, argv+1, hparm,
@@ -279,6 +287,12 @@ main(int argc, const char *argv[]) {
   fprintf(stderr, "\n");
   fprintf(stderr, "%s: rendering time = %g secs\n", me, muu->rendTime);
   fprintf(stderr, "%s: sampling rate = %g Khz\n", me, muu->sampRate);
+  if (muu->emptySkip) {
+    fprintf(stderr, "%s: leapt over %g of %g samples (%g%%) as empty\n", me,
+            muu->emptyNum, muu->sampNum + muu->emptyNum,
+            100*muu->emptyNum/AIR_MAX(1, muu->sampNum + muu->emptyNum));
+  }
+  hooverThreadStatsPrint(stderr, muu->hctx);
   if (muu->ndebug) {
     /* if its been generated, we should save it */
     sprintf(debugStr, "%04d-%04d-debug.nrrd", verbPix[0], verbPix[1]);
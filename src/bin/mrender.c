@@ -534,6 +534,10 @@ main(int argc, const char *argv[]) {
   hestOptAdd(&hopt, "nt", "# threads", airTypeInt, 1, 1,
              &(uu->hctx->numThreads),
              "1", "number of threads hoover should use");
+  hestOptAdd(&hopt, "tile", "size", airTypeInt, 1, 1,
+             &(uu->hctx->tileSize), "16", "rays are cast in tiles of "
+             "this many pixels on a side, handed out to threads one at a "
+             "time; 0 means whole scanlines");
   hestOptAdd(&hopt, "vp", "img coords", airTypeInt, 2, 2, &(uu->verbPixel),
              "-1 -1", "pixel coordinates for which to turn on all verbose "
              "debugging messages, or \"-1 -1\" to disable this.");
@@ -670,6 +674,7 @@ main(int argc, const char *argv[]) {
     airMopError(mop);
     return 1;
   }
+  hooverThreadStatsPrint(stderr, uu->hctx);
 
   if (1) {
     ELL_3V_SUB(uu->imgU, uu->imgU, uu->imgOrig);
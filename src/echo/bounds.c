@@ -171,6 +171,16 @@ BNDS_TMPL(Instance,
           ELL_3V_MAX(hi, hi, b[7]);
           )
 
+BNDS_TMPL(BVH,
+          if (obj->nodeNum) {
+            ELL_3V_COPY(lo, obj->node[0].min);
+            ELL_3V_COPY(hi, obj->node[0].max);
+          } else {
+            ELL_3V_SET(lo, ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+            ELL_3V_SET(hi, ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+          }
+          )
+
 _echoBoundsGet_t
 _echoBoundsGet[ECHO_TYPE_NUM] = {
   (_echoBoundsGet_t)_echoSphere_bounds,
@@ -185,6 +195,7 @@ _echoBoundsGet[ECHO_TYPE_NUM] = {
   (_echoBoundsGet_t)_echoSplit_bounds,
   (_echoBoundsGet_t)_echoList_bounds,
   (_echoBoundsGet_t)_echoInstance_bounds,
+  (_echoBoundsGet_t)_echoBVH_bounds,
 };
 
 void
@@ -0,0 +1,542 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "echo.h"
+#include "privateEcho.h"
+
+/*
+** The BVH is built top-down with the surface area heuristic (SAH),
+** evaluated at _ECHO_BVH_BIN_NUM bins along each axis of the bounding box
+** of the object centroids.  _ECHO_BVH_COST_NODE and _ECHO_BVH_COST_OBJ
+** are the relative costs of traversing a node and intersecting an object.
+*/
+#define _ECHO_BVH_BIN_NUM 16
+#define _ECHO_BVH_COST_NODE 1.0
+#define _ECHO_BVH_COST_OBJ 2.0
+
+/* one object to be put in the BVH, with its bounds and their center */
+typedef struct {
+  echoPos_t lo[3], hi[3], mid[3];
+  echoObject *obj;
+} _echoBVHRef;
+
+/* a subtree that one of the threads builds on its own */
+typedef struct {
+  int nodeIdx, depth;
+  unsigned int refIdx, refNum;
+} _echoBVHTask;
+
+typedef struct {
+  _echoBVHRef *ref;
+  echoBVHNode *node;        /* while building, a subtree over N objects
+                               uses (at most) 2*N - 1 nodes, starting with
+                               its root; its first child starts right after
+                               the root, and its second child starts right
+                               after the space for the first child */
+  _echoBVHTask *task;
+  unsigned int taskNum, taskNext;
+  airThreadMutex *mutex;
+} _echoBVHJob;
+
+/*
+** The objects put into the BVH are the things that aren't themselves
+** only collections of other objects: Lists, AABBoxes, Splits, and other
+** BVHs are opened up, but Instances are not.  Isosurfaces (which can't
+** be intersected) and objects with empty bounds are left out.
+*/
+static unsigned int
+_echoBVHRefNum(echoObject *obj) {
+  unsigned int ii, num;
+
+  if (!obj) {
+    return 0;
+  }
+  switch (obj->type) {
+  case echoTypeList:
+    num = 0;
+    for (ii=0; ii<LIST(obj)->objArr->len; ii++) {
+      num += _echoBVHRefNum(LIST(obj)->obj[ii]);
+    }
+    break;
+  case echoTypeAABBox:
+    num = _echoBVHRefNum(AABBOX(obj)->obj);
+    break;
+  case echoTypeSplit:
+    num = (_echoBVHRefNum(SPLIT(obj)->obj0)
+           + _echoBVHRefNum(SPLIT(obj)->obj1));
+    break;
+  case echoTypeBVH:
+    num = AIR_CAST(unsigned int, BVH(obj)->objNum);
+    break;
+  case echoTypeIsosurface:
+    num = 0;
+    break;
+  default:
+    num = 1;
+    break;
+  }
+  return num;
+}
+
+static void
+_echoBVHRefFill(_echoBVHRef *ref, unsigned int *refNumP, echoObject *obj) {
+  unsigned int ii;
+  _echoBVHRef *rr;
+
+  if (!obj) {
+    return;
+  }
+  switch (obj->type) {
+  case echoTypeList:
+    for (ii=0; ii<LIST(obj)->objArr->len; ii++) {
+      _echoBVHRefFill(ref, refNumP, LIST(obj)->obj[ii]);
+    }
+    break;
+  case echoTypeAABBox:
+    _echoBVHRefFill(ref, refNumP, AABBOX(obj)->obj);
+    break;
+  case echoTypeSplit:
+    _echoBVHRefFill(ref, refNumP, SPLIT(obj)->obj0);
+    _echoBVHRefFill(ref, refNumP, SPLIT(obj)->obj1);
+    break;
+  case echoTypeBVH:
+    for (ii=0; ii<AIR_CAST(unsigned int, BVH(obj)->objNum); ii++) {
+      _echoBVHRefFill(ref, refNumP, BVH(obj)->obj[ii]);
+    }
+    break;
+  case echoTypeIsosurface:
+    break;
+  default:
+    rr = ref + *refNumP;
+    echoBoundsGet(rr->lo, rr->hi, obj);
+    if (!( AIR_EXISTS(rr->lo[0]) && AIR_EXISTS(rr->hi[0])
+           && AIR_EXISTS(rr->lo[1]) && AIR_EXISTS(rr->hi[1])
+           && AIR_EXISTS(rr->lo[2]) && AIR_EXISTS(rr->hi[2])
+           && rr->lo[0] <= rr->hi[0]
+           && rr->lo[1] <= rr->hi[1]
+           && rr->lo[2] <= rr->hi[2] )) {
+      break;
+    }
+    ELL_3V_LERP(rr->mid, 0.5, rr->lo, rr->hi);
+    rr->obj = obj;
+    *refNumP += 1;
+    break;
+  }
+  return;
+}
+
+static double
+_echoBVHArea(const echoPos_t lo[3], const echoPos_t hi[3]) {
+  double dx, dy, dz;
+
+  dx = hi[0] - lo[0];
+  dy = hi[1] - lo[1];
+  dz = hi[2] - lo[2];
+  return 2*(dx*dy + dy*dz + dz*dx);
+}
+
+static unsigned int
+_echoBVHBin(echoPos_t mid, echoPos_t cmin, echoPos_t cmax) {
+  unsigned int bi;
+
+  bi = AIR_CAST(unsigned int, _ECHO_BVH_BIN_NUM*(mid - cmin)/(cmax - cmin));
+  return AIR_MIN(bi, _ECHO_BVH_BIN_NUM-1);
+}
+
+/*
+** _echoBVHNodeBuild
+**
+** builds the subtree over refNum refs starting at ref[refIdx], with its
+** root at node[nodeIdx].  The two children of nodes at depth taskDepth-1
+** are not built, but are instead saved as tasks (taskDepth < 0 means never
+** to do that).
+*/
+static void
+_echoBVHNodeBuild(_echoBVHJob *job, int nodeIdx, unsigned int refIdx,
+                  unsigned int refNum, int depth, int taskDepth) {
+  echoBVHNode *node;
+  _echoBVHRef *ref, tmp;
+  echoPos_t cmin[3], cmax[3], blo[_ECHO_BVH_BIN_NUM][3],
+    bhi[_ECHO_BVH_BIN_NUM][3], slo[3], shi[3];
+  double area, cost, bestCost, larea[_ECHO_BVH_BIN_NUM];
+  unsigned int ii, jj, bi, snum, bestBin, leftNum,
+    bnum[_ECHO_BVH_BIN_NUM], lnum[_ECHO_BVH_BIN_NUM];
+  int ax, bestAx;
+
+  node = job->node + nodeIdx;
+  ref = job->ref + refIdx;
+  ELL_3V_SET(node->min, ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+  ELL_3V_SET(node->max, ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+  ELL_3V_SET(cmin, ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+  ELL_3V_SET(cmax, ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+  for (ii=0; ii<refNum; ii++) {
+    ELL_3V_MIN(node->min, node->min, ref[ii].lo);
+    ELL_3V_MAX(node->max, node->max, ref[ii].hi);
+    ELL_3V_MIN(cmin, cmin, ref[ii].mid);
+    ELL_3V_MAX(cmax, cmax, ref[ii].mid);
+  }
+  node->kid = -1;
+  node->axis = 0;
+  if (1 == refNum || depth >= ECHO_BVH_DEPTH_MAX) {
+    node->objIdx = AIR_CAST(int, refIdx);
+    node->objNum = AIR_CAST(int, refNum);
+    return;
+  }
+
+  /* find the cheapest split, between bins bestBin-1 and bestBin */
+  area = _echoBVHArea(node->min, node->max);
+  area = area > 0 ? area : 1;
+  bestCost = 0;
+  bestAx = -1;
+  bestBin = 0;
+  for (ax=0; ax<3; ax++) {
+    if (!( cmax[ax] > cmin[ax] )) {
+      continue;
+    }
+    for (bi=0; bi<_ECHO_BVH_BIN_NUM; bi++) {
+      bnum[bi] = 0;
+      ELL_3V_SET(blo[bi], ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+      ELL_3V_SET(bhi[bi], ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+    }
+    for (ii=0; ii<refNum; ii++) {
+      bi = _echoBVHBin(ref[ii].mid[ax], cmin[ax], cmax[ax]);
+      bnum[bi]++;
+      ELL_3V_MIN(blo[bi], blo[bi], ref[ii].lo);
+      ELL_3V_MAX(bhi[bi], bhi[bi], ref[ii].hi);
+    }
+    /* sweep from below to learn what's left of each split ... */
+    snum = 0;
+    ELL_3V_SET(slo, ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+    ELL_3V_SET(shi, ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+    for (bi=0; bi<_ECHO_BVH_BIN_NUM-1; bi++) {
+      if (bnum[bi]) {
+        snum += bnum[bi];
+        ELL_3V_MIN(slo, slo, blo[bi]);
+        ELL_3V_MAX(shi, shi, bhi[bi]);
+      }
+      lnum[bi] = snum;
+      larea[bi] = snum ? _echoBVHArea(slo, shi) : 0;
+    }
+    /* ... and from above to evaluate the splits */
+    snum = 0;
+    ELL_3V_SET(slo, ECHO_POS_MAX, ECHO_POS_MAX, ECHO_POS_MAX);
+    ELL_3V_SET(shi, ECHO_POS_MIN, ECHO_POS_MIN, ECHO_POS_MIN);
+    for (bi=_ECHO_BVH_BIN_NUM-1; bi>0; bi--) {
+      if (bnum[bi]) {
+        snum += bnum[bi];
+        ELL_3V_MIN(slo, slo, blo[bi]);
+        ELL_3V_MAX(shi, shi, bhi[bi]);
+      }
+      if (!( lnum[bi-1] && snum )) {
+        continue;
+      }
+      cost = (_ECHO_BVH_COST_NODE
+              + _ECHO_BVH_COST_OBJ*(larea[bi-1]*lnum[bi-1]
+                                    + _echoBVHArea(slo, shi)*snum)/area);
+      if (-1 == bestAx || cost < bestCost) {
+        bestCost = cost;
+        bestAx = ax;
+        bestBin = bi;
+      }
+    }
+  }
+
+  if (refNum <= ECHO_BVH_LEAF_MAX
+      && (-1 == bestAx || bestCost >= _ECHO_BVH_COST_OBJ*refNum)) {
+    /* a leaf is as good as any split */
+    node->objIdx = AIR_CAST(int, refIdx);
+    node->objNum = AIR_CAST(int, refNum);
+    return;
+  }
+  if (-1 == bestAx) {
+    /* all the centers are the same; split the refs in half */
+    leftNum = refNum/2;
+  } else {
+    ii = 0;
+    jj = refNum;
+    while (ii < jj) {
+      if (_echoBVHBin(ref[ii].mid[bestAx], cmin[bestAx], cmax[bestAx])
+          < bestBin) {
+        ii++;
+      } else {
+        jj--;
+        tmp = ref[ii];
+        ref[ii] = ref[jj];
+        ref[jj] = tmp;
+      }
+    }
+    leftNum = ii;
+    node->axis = bestAx;
+  }
+  node->objIdx = 0;
+  node->objNum = 0;
+  node->kid = nodeIdx + 2*AIR_CAST(int, leftNum);
+  if (depth+1 == taskDepth) {
+    _echoBVHTask *task;
+    task = job->task + job->taskNum++;
+    task->nodeIdx = nodeIdx + 1;
+    task->refIdx = refIdx;
+    task->refNum = leftNum;
+    task->depth = depth + 1;
+    task = job->task + job->taskNum++;
+    task->nodeIdx = node->kid;
+    task->refIdx = refIdx + leftNum;
+    task->refNum = refNum - leftNum;
+    task->depth = depth + 1;
+  } else {
+    _echoBVHNodeBuild(job, nodeIdx + 1, refIdx, leftNum,
+                      depth + 1, taskDepth);
+    _echoBVHNodeBuild(job, node->kid, refIdx + leftNum, refNum - leftNum,
+                      depth + 1, taskDepth);
+  }
+  return;
+}
+
+static void *
+_echoBVHWorker(void *_job) {
+  _echoBVHJob *job;
+  _echoBVHTask *task;
+
+  job = AIR_CAST(_echoBVHJob *, _job);
+  while (1) {
+    airThreadMutexLock(job->mutex);
+    if (job->taskNext == job->taskNum) {
+      airThreadMutexUnlock(job->mutex);
+      break;
+    }
+    task = job->task + job->taskNext++;
+    airThreadMutexUnlock(job->mutex);
+    _echoBVHNodeBuild(job, task->nodeIdx, task->refIdx, task->refNum,
+                      task->depth, -1);
+  }
+  return _job;
+}
+
+/* biggest tasks first, so that no thread is left with a big one at the end */
+static int
+_echoBVHTaskCompare(const void *_a, const void *_b) {
+  const _echoBVHTask *a, *b;
+
+  a = AIR_CAST(const _echoBVHTask *, _a);
+  b = AIR_CAST(const _echoBVHTask *, _b);
+  return (a->refNum > b->refNum
+          ? -1
+          : (a->refNum < b->refNum
+             ? 1
+             : a->nodeIdx - b->nodeIdx));
+}
+
+static int
+_echoBVHNodeCount(const echoBVHNode *node, int idx) {
+
+  return (node[idx].objNum
+          ? 1
+          : (1 + _echoBVHNodeCount(node, idx+1)
+             + _echoBVHNodeCount(node, node[idx].kid)));
+}
+
+/* copies subtree at src[si] to dst, in depth-first order */
+static int
+_echoBVHNodeCopy(echoBVHNode *dst, int *nextP,
+                 const echoBVHNode *src, int si) {
+  int di;
+
+  di = (*nextP)++;
+  dst[di] = src[si];
+  if (!src[si].objNum) {
+    _echoBVHNodeCopy(dst, nextP, src, si+1);
+    dst[di].kid = _echoBVHNodeCopy(dst, nextP, src, src[si].kid);
+  }
+  return di;
+}
+
+/*
+** _echoBVHBuild
+**
+** (re-)builds given bvh over all the objects in obj[0] through obj[num-1]
+** (and in anything they contain), using numThreads threads
+*/
+int
+_echoBVHBuild(echoBVH *bvh, echoObject **obj, unsigned int num,
+              int numThreads) {
+  static const char me[]="_echoBVHBuild";
+  _echoBVHJob job;
+  echoBVHNode *node;
+  echoObject **bobj;
+  airThread **thread;
+  airArray *mop;
+  unsigned int ii, refNum, taskMax;
+  int nodeNum, taskDepth, ti;
+
+  if (!( bvh && (num ? !!obj : 1) )) {
+    biffAddf(ECHO, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!( numThreads >= 1 )) {
+    biffAddf(ECHO, "%s: numThreads %d not >= 1", me, numThreads);
+    return 1;
+  }
+  if (numThreads > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: no multi-threading here; will use 1 "
+            "thread instead of %d\n", me, numThreads);
+    numThreads = 1;
+  }
+  mop = airMopNew();
+  refNum = 0;
+  for (ii=0; ii<num; ii++) {
+    refNum += _echoBVHRefNum(obj[ii]);
+  }
+  job.ref = NULL;
+  if (refNum) {
+    job.ref = AIR_CALLOC(refNum, _echoBVHRef);
+    if (!job.ref) {
+      biffAddf(ECHO, "%s: couldn't allocate %u object refs", me, refNum);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, job.ref, airFree, airMopAlways);
+    refNum = 0;
+    for (ii=0; ii<num; ii++) {
+      _echoBVHRefFill(job.ref, &refNum, obj[ii]);
+    }
+  }
+  if (!refNum) {
+    /* an empty BVH is fine */
+    bvh->node = AIR_CAST(echoBVHNode *, airFree(bvh->node));
+    bvh->obj = AIR_CAST(echoObject **, airFree(bvh->obj));
+    bvh->nodeNum = bvh->objNum = 0;
+    airMopOkay(mop);
+    return 0;
+  }
+  job.node = AIR_CALLOC(2*refNum-1, echoBVHNode);
+  if (!job.node) {
+    biffAddf(ECHO, "%s: couldn't allocate %u nodes", me, 2*refNum-1);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, job.node, airFree, airMopAlways);
+
+  /* with multiple threads, the top of the tree is built first, down to
+     the depth at which there are (at most) 4*numThreads subtrees, and
+     then those subtrees are built in parallel */
+  taskDepth = -1;
+  taskMax = 0;
+  job.task = NULL;
+  job.taskNum = job.taskNext = 0;
+  job.mutex = NULL;
+  if (numThreads > 1) {
+    taskDepth = 1;
+    while ((1 << taskDepth) < 4*numThreads) {
+      taskDepth++;
+    }
+    taskMax = 1u << taskDepth;
+    job.task = AIR_CALLOC(taskMax, _echoBVHTask);
+    if (!job.task) {
+      biffAddf(ECHO, "%s: couldn't allocate %u tasks", me, taskMax);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, job.task, airFree, airMopAlways);
+  }
+  _echoBVHNodeBuild(&job, 0, 0, refNum, 0, taskDepth);
+  if (job.taskNum) {
+    qsort(job.task, job.taskNum, sizeof(_echoBVHTask), _echoBVHTaskCompare);
+    job.mutex = airThreadMutexNew();
+    airMopAdd(mop, job.mutex, (airMopper)airThreadMutexNix, airMopAlways);
+    thread = AIR_CALLOC(numThreads, airThread *);
+    if (!thread) {
+      biffAddf(ECHO, "%s: couldn't allocate %d threads", me, numThreads);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, thread, airFree, airMopAlways);
+    for (ti=0; ti<numThreads; ti++) {
+      int ret;
+      thread[ti] = airThreadNew();
+      airMopAdd(mop, thread[ti], (airMopper)airThreadNix, airMopAlways);
+      if (( ret = airThreadStart(thread[ti], _echoBVHWorker,
+                                 AIR_CAST(void *, &job)) )) {
+        void *retval;
+        biffAddf(ECHO, "%s: thread[%d] failed to start: %d", me, ti, ret);
+        /* let the threads already started finish, before quitting */
+        while (ti) {
+          airThreadJoin(thread[--ti], &retval);
+        }
+        airMopError(mop); return 1;
+      }
+    }
+    for (ti=0; ti<numThreads; ti++) {
+      void *retval;
+      airThreadJoin(thread[ti], &retval);
+    }
+  }
+
+  nodeNum = _echoBVHNodeCount(job.node, 0);
+  node = AIR_CALLOC(nodeNum, echoBVHNode);
+  bobj = AIR_CALLOC(refNum, echoObject *);
+  if (!( node && bobj )) {
+    biffAddf(ECHO, "%s: couldn't allocate %d nodes and %u objects", me,
+             nodeNum, refNum);
+    airFree(node);
+    airFree(bobj);
+    airMopError(mop); return 1;
+  }
+  ti = 0;
+  _echoBVHNodeCopy(node, &ti, job.node, 0);
+  for (ii=0; ii<refNum; ii++) {
+    bobj[ii] = job.ref[ii].obj;
+  }
+  airFree(bvh->node);
+  airFree(bvh->obj);
+  bvh->node = node;
+  bvh->nodeNum = nodeNum;
+  bvh->obj = bobj;
+  bvh->objNum = AIR_CAST(int, refNum);
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+******** echoBVHSet
+**
+** sets the given echoBVH object to be a bounding volume hierarchy over
+** everything in obj (typically a List), using numThreads threads to
+** build it.  The BVH does not own the objects in it; it can be added to
+** a scene with echoObjectAdd in place of obj
+*/
+int
+echoBVHSet(echoObject *bvh, echoObject *obj, int numThreads) {
+  static const char me[]="echoBVHSet";
+
+  if (!( bvh && obj )) {
+    biffAddf(ECHO, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (echoTypeBVH != bvh->type) {
+    biffAddf(ECHO, "%s: got %s object, not %s", me,
+             airEnumStr(echoType, bvh->type),
+             airEnumStr(echoType, echoTypeBVH));
+    return 1;
+  }
+  if (_echoBVHBuild(BVH(bvh), &obj, 1, numThreads)) {
+    biffAddf(ECHO, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
@@ -83,6 +83,13 @@ typedef double echoCol_t;
 #define ECHO_EPSILON 0.00005      /* used for adjusting ray positions */
 #define ECHO_NEAR0 0.004          /* used for comparing transparency to zero */
 #define ECHO_LEN_SMALL_ENOUGH 5   /* to control splitting for split objects */
+#define ECHO_BVH_LEAF_MAX 4       /* most objects in a leaf of a BVH, unless
+                                     they can't be told apart */
+#define ECHO_BVH_DEPTH_MAX 64     /* deepest a BVH is allowed to be */
+#define ECHO_PACKET_SIZE 8        /* number of primary rays traced together
+                                     through a BVH in one packet */
+#define ECHO_PACKET_SAMPLES_MIN 16 /* fewest samples per pixel for which
+                                      packets are used */
 
 #define ECHO_THREAD_MAX 512       /* max number of threads */
 
@@ -100,6 +107,14 @@ typedef struct {
     seedRand,          /* call airSrandMT() (don't if repeatability wanted) */
     sqNRI,             /* how many iterations of newton-raphson we allow for
                           finding superquadric root (within tolorance sqTol) */
+    bvh,               /* at the start of echoRTRender, build a bounding
+                          volume hierarchy (with numThreads threads) over
+                          all the objects in the scene, and trace rays
+                          through that instead of the scene's objects */
+    packet,            /* with bvh, and at least ECHO_PACKET_SAMPLES_MIN
+                          samples per pixel: trace the primary rays of each
+                          pixel through the BVH together, in packets of
+                          ECHO_PACKET_SIZE rays */
     numThreads;        /* number of threads to spawn per rendering */
   echoPos_t
     sqTol;             /* how close newtwon-raphson must get to zero */
@@ -256,10 +271,11 @@ enum {
   echoTypeSplit,          /*  9 */
   echoTypeList,           /* 10 */
   echoTypeInstance,       /* 11 */
+  echoTypeBVH,            /* 12 */
   echoTypeLast
 };
 
-#define ECHO_TYPE_NUM        12
+#define ECHO_TYPE_NUM        13
 
 /*
 ******** echoObject (generic) and all other object structs
@@ -366,6 +382,36 @@ typedef struct {
   echoObject *obj;
 } echoInstance;
 
+/*
+******** echoBVHNode
+**
+** one node of a bounding volume hierarchy (BVH).  The nodes are stored in
+** depth-first order, so that the first child of an inner node is the node
+** right after it.  At 64 bytes (with double echoPos_t), one node fits in
+** a typical cache line.
+*/
+typedef struct {
+  echoPos_t min[3], max[3];    /* bbox of everything below this node */
+  int kid,                     /* inner node: index of second child */
+    objIdx,                    /* leaf: index of first object in obj[] */
+    objNum,                    /* leaf: number of objects; 0 for inner */
+    axis;                      /* inner node: axis along which split */
+} echoBVHNode;
+
+/*
+******** echoBVH
+**
+** a bounding volume hierarchy built by echoBVHSet, using the surface area
+** heuristic, over some other objects (which it doesn't own)
+*/
+typedef struct {
+  ECHO_OBJECT_COMMON;
+  echoBVHNode *node;           /* nodeNum nodes; node[0] is the root */
+  echoObject **obj;            /* objNum objects, ordered so that those of
+                                  each leaf are contiguous */
+  int nodeNum, objNum;
+} echoBVH;
+
 /*
 ******** echoScene
 **
@@ -385,6 +431,9 @@ typedef struct echoScene_t {
   airArray *nrrdArr;
   Nrrd *envmap;        /* 16checker-based diffuse environment map,
                           not touched by echoSceneNix() */
+  echoObject *bvh;     /* if non-NULL: the echoBVH (in cat[]) over all of
+                          rend[], (re-)built by echoRTRender for each
+                          rendering with parm->bvh */
   echoCol_t ambi[3],   /* color of ambient light */
     bkgr[3];           /* color of background */
 } echoScene;
@@ -464,6 +513,9 @@ ECHO_EXPORT echoObject *echoListSplit(echoScene *scene,
 ECHO_EXPORT echoObject *echoListSplit3(echoScene *scene,
                                        echoObject *list, int depth);
 
+/* bvh.c --------------------------------------- */
+ECHO_EXPORT int echoBVHSet(echoObject *bvh, echoObject *obj, int numThreads);
+
 /* set.c --------------------------------------- */
 ECHO_EXPORT void echoSphereSet(echoObject *sphere,
                                echoPos_t x, echoPos_t y,
@@ -97,7 +97,8 @@ _echoTypeStr[ECHO_TYPE_NUM+1] = {
   "AABoundingBox",
   "split",
   "list",
-  "instance"
+  "instance",
+  "bvh"
 };
 
 const int
@@ -114,7 +115,8 @@ _echoTypeVal[ECHO_TYPE_NUM+1] = {
   echoTypeAABBox,
   echoTypeSplit,
   echoTypeList,
-  echoTypeInstance
+  echoTypeInstance,
+  echoTypeBVH
 };
 
 const char *
@@ -131,7 +133,8 @@ _echoTypeDesc[ECHO_TYPE_NUM+1] = {
   "axis-aligned bounding box",
   "split",
   "list",
-  "instance"
+  "instance",
+  "bounding volume hierarchy"
 };
 
 const char *
@@ -148,6 +151,7 @@ _echoTypeStrEqv[] = {
   "split",
   "list",
   "instance",
+  "bvh",
   ""
 };
 
@@ -164,7 +168,8 @@ _echoTypeValEqv[] = {
   echoTypeAABBox, echoTypeAABBox,
   echoTypeSplit,
   echoTypeList,
-  echoTypeInstance
+  echoTypeInstance,
+  echoTypeBVH
 };
 
 const airEnum
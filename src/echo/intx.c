@@ -369,40 +369,6 @@ _echoRayIntxUV_Cube(echoIntx *intx) {
   }
 }
 
-/*
-** TRI_INTX
-**
-** given a triangle in terms of origin, edge0, edge1, this will
-** begin the intersection calculation:
-** - sets pvec, tvec, qvec (all of them if intx is not ruled out )
-** - sets u, and rules out intx based on (u < 0.0 || u > 1.0)
-** - sets v, and rules out intx based on COND
-** - sets t, and rules out intx based on (t < neer || t > faar)
-*/
-#define TRI_INTX(ray, origin, edge0, edge1, pvec, qvec, tvec,                \
-                 det, t, u, v, COND, NOPE)                                   \
-  ELL_3V_CROSS(pvec, ray->dir, edge1);                                       \
-  det = ELL_3V_DOT(pvec, edge0);                                             \
-  if (det > -ECHO_EPSILON && det < ECHO_EPSILON) {                           \
-    NOPE;                                                                    \
-  }                                                                          \
-  /* now det is the reciprocal of the determinant */                         \
-  det = 1.0/det;                                                             \
-  ELL_3V_SUB(tvec, ray->from, origin);                                       \
-  u = det * ELL_3V_DOT(pvec, tvec);                                          \
-  if (u < 0.0 || u > 1.0) {                                                  \
-    NOPE;                                                                    \
-  }                                                                          \
-  ELL_3V_CROSS(qvec, tvec, edge0);                                           \
-  v = det * ELL_3V_DOT(qvec, ray->dir);                                      \
-  if (COND) {                                                                \
-    NOPE;                                                                    \
-  }                                                                          \
-  t = det * ELL_3V_DOT(qvec, edge1);                                         \
-  if (t < ray->neer || t > ray->faar) {                                      \
-    NOPE;                                                                    \
-  }
-
 int
 _echoRayIntx_Rectangle(RAYINTX_ARGS(Rectangle)) {
   echoPos_t pvec[3], qvec[3], tvec[3], det, t, u, v, *edge0, *edge1, tmp;
@@ -668,6 +634,86 @@ _echoRayIntx_Instance(RAYINTX_ARGS(Instance)) {
   return AIR_FALSE;
 }
 
+/*
+** the nodes are visited nearest-first (as judged by where the ray enters
+** their bounding boxes), and the farther child is saved on a stack, to be
+** skipped if by the time it is popped, something closer has been hit
+*/
+int
+_echoRayIntx_BVH(RAYINTX_ARGS(BVH)) {
+  echoBVHNode *node, *node0, *node1;
+  echoObject *kid;
+  echoPos_t t0, t1, tmax, stackT[ECHO_BVH_DEPTH_MAX+1];
+  int stackIdx[ECHO_BVH_DEPTH_MAX+1], sp, ni, ii, hit0, hit1, ret;
+
+  if (!obj->nodeNum) {
+    return AIR_FALSE;
+  }
+  node = obj->node;
+  if (!_echoRayIntx_CubeSolid(&t0, &tmax,
+                              node->min[0], node->max[0],
+                              node->min[1], node->max[1],
+                              node->min[2], node->max[2], ray)) {
+    return AIR_FALSE;
+  }
+  intx->boxhits++;
+  ret = AIR_FALSE;
+  sp = 0;
+  ni = 0;
+  while (-1 != ni) {
+    node = obj->node + ni;
+    if (node->objNum) {
+      for (ii=0; ii<node->objNum; ii++) {
+        kid = obj->obj[node->objIdx + ii];
+        if (_echoRayIntx[kid->type](intx, ray, kid, parm, tstate)) {
+          if (ray->shadow) {
+            return AIR_TRUE;
+          }
+          ray->faar = intx->t;
+          ret = AIR_TRUE;
+        }
+      }
+      ni = -1;
+    } else {
+      node0 = obj->node + ni + 1;
+      node1 = obj->node + node->kid;
+      hit0 = _echoRayIntx_CubeSolid(&t0, &tmax,
+                                    node0->min[0], node0->max[0],
+                                    node0->min[1], node0->max[1],
+                                    node0->min[2], node0->max[2], ray);
+      hit1 = _echoRayIntx_CubeSolid(&t1, &tmax,
+                                    node1->min[0], node1->max[0],
+                                    node1->min[1], node1->max[1],
+                                    node1->min[2], node1->max[2], ray);
+      intx->boxhits += hit0 + hit1;
+      if (hit0 && hit1) {
+        if (t1 < t0) {
+          stackIdx[sp] = ni + 1;
+          stackT[sp++] = t0;
+          ni = node->kid;
+        } else {
+          stackIdx[sp] = node->kid;
+          stackT[sp++] = t1;
+          ni = ni + 1;
+        }
+      } else if (hit0) {
+        ni = ni + 1;
+      } else if (hit1) {
+        ni = node->kid;
+      } else {
+        ni = -1;
+      }
+    }
+    while (-1 == ni && sp) {
+      sp--;
+      if (stackT[sp] <= ray->faar) {
+        ni = stackIdx[sp];
+      }
+    }
+  }
+  return ret;
+}
+
 void
 _echoRayIntxUV_Noop(echoIntx *intx) {
 
@@ -692,6 +738,7 @@ _echoRayIntx[ECHO_TYPE_NUM] = {
   (_echoRayIntx_t)_echoRayIntx_Split,
   (_echoRayIntx_t)_echoRayIntx_List,
   (_echoRayIntx_t)_echoRayIntx_Instance,
+  (_echoRayIntx_t)_echoRayIntx_BVH,
 };
 
 _echoRayIntxUV_t
@@ -707,39 +754,60 @@ _echoRayIntxUV[ECHO_TYPE_NUM] = {
   _echoRayIntxUV_Noop,    /* echoTypeAABBox */
   _echoRayIntxUV_Noop,    /* echoTypeSplit */
   _echoRayIntxUV_Noop,    /* echoTypeList */
-  _echoRayIntxUV_Noop     /* echoTypeInstance */
+  _echoRayIntxUV_Noop,    /* echoTypeInstance */
+  _echoRayIntxUV_Noop     /* echoTypeBVH */
 };
 
+/*
+** _echoRayIntxFinish
+**
+** sets the things in intx, after a (non-shadow) ray hit something,
+** that the coloring needs
+*/
+void
+_echoRayIntxFinish(echoIntx *intx, echoRay *ray) {
+  echoPos_t tmp;
+
+  ELL_3V_SCALE_ADD2(intx->pos, 1, ray->from, intx->t, ray->dir);
+  ELL_3V_SCALE(intx->view, -1, ray->dir);
+  ELL_3V_NORM(intx->view, intx->view, tmp);
+  /* this is needed for phong materials; for glass and metal,
+     it is either used directly, or as a reference in fuzzification */
+  _ECHO_REFLECT(intx->refl, intx->norm, intx->view, tmp);
+}
+
 int
 echoRayIntx(echoIntx *intx, echoRay *ray, echoScene *scene,
             echoRTParm *parm, echoThreadState *tstate) {
   unsigned int idx;
   int ret;
   echoObject *kid;
-  echoPos_t tmp;
 
   _echoVerbose = tstate->verbose;
 
   ret = AIR_FALSE;
-  for (idx=0; idx<scene->rendArr->len; idx++) {
-    kid = scene->rend[idx];
-    if (_echoRayIntx[kid->type](intx, ray, kid, parm, tstate)) {
-      ray->faar = intx->t;
-      ret = AIR_TRUE;
-      if (ray->shadow) {
-        /* no point in testing any further */
-        return ret;
+  if (parm->bvh && scene->bvh) {
+    /* the BVH holds everything in scene->rend */
+    ret = _echoRayIntx_BVH(intx, ray, BVH(scene->bvh), parm, tstate);
+    if (ray->shadow) {
+      return ret;
+    }
+  } else {
+    for (idx=0; idx<scene->rendArr->len; idx++) {
+      kid = scene->rend[idx];
+      if (_echoRayIntx[kid->type](intx, ray, kid, parm, tstate)) {
+        ray->faar = intx->t;
+        ret = AIR_TRUE;
+        if (ray->shadow) {
+          /* no point in testing any further */
+          return ret;
+        }
       }
     }
   }
   if (ret) {
     /* being here means we're not a shadow ray */
-    ELL_3V_SCALE_ADD2(intx->pos, 1, ray->from, intx->t, ray->dir);
-    ELL_3V_SCALE(intx->view, -1, ray->dir);
-    ELL_3V_NORM(intx->view, intx->view, tmp);
-    /* this is needed for phong materials; for glass and metal,
-       it is either used directly, or as a reference in fuzzification */
-    _ECHO_REFLECT(intx->refl, intx->norm, intx->view, tmp);
+    _echoRayIntxFinish(intx, ray);
   }
 
   return ret;
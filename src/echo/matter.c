@@ -38,6 +38,7 @@ echoObjectHasMatter[ECHO_TYPE_NUM] = {
   0, /* echoTypeSplit */
   0, /* echoTypeList */
   0, /* echoTypeInstance */
+  0, /* echoTypeBVH */
 };
 
 void
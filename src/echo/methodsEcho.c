@@ -47,6 +47,8 @@ echoRTParmNew(void) {
     parm->renderBoxes = AIR_FALSE;
     parm->seedRand = AIR_TRUE;
     parm->sqNRI = 15;
+    parm->bvh = AIR_FALSE;
+    parm->packet = AIR_TRUE;
     parm->numThreads = 1;
     parm->sqTol = 0.0001;
     parm->aperture = 0.0;     /* pinhole camera by default */
@@ -159,6 +161,7 @@ echoSceneNew(void) {
                       airNull,
                       (void *(*)(void *))nrrdNuke);
     ret->envmap = NULL;
+    ret->bvh = NULL;
     ELL_3V_SET(ret->ambi, 1.0, 1.0, 1.0);
     ELL_3V_SET(ret->bkgr, 0.0, 0.0, 0.0);
   }
@@ -144,6 +144,16 @@ NEW_TMPL(Instance,
          obj->obj = NULL;
          )
 
+NEW_TMPL(BVH,
+         obj->node = NULL;
+         obj->obj = NULL;
+         obj->nodeNum = obj->objNum = 0;
+         )
+NIX_TMPL(BVH,
+         airFree(obj->node);
+         airFree(obj->obj);
+         )
+
 echoObject *(*
 _echoObjectNew[ECHO_TYPE_NUM])(void) = {
   (echoObject *(*)(void))_echoSphere_new,
@@ -157,7 +167,8 @@ _echoObjectNew[ECHO_TYPE_NUM])(void) = {
   (echoObject *(*)(void))_echoAABBox_new,
   (echoObject *(*)(void))_echoSplit_new,
   (echoObject *(*)(void))_echoList_new,
-  (echoObject *(*)(void))_echoInstance_new
+  (echoObject *(*)(void))_echoInstance_new,
+  (echoObject *(*)(void))_echoBVH_new
 };
 
 echoObject *
@@ -197,7 +208,8 @@ _echoObjectNix[ECHO_TYPE_NUM])(echoObject *) = {
   (echoObject *(*)(echoObject *))airFree,          /* echoTypeAABBox */
   (echoObject *(*)(echoObject *))airFree,          /* echoTypeSplit */
   (echoObject *(*)(echoObject *))_echoList_nix,    /* echoTypeList */
-  (echoObject *(*)(echoObject *))airFree           /* echoTypeInstance */
+  (echoObject *(*)(echoObject *))airFree,          /* echoTypeInstance */
+  (echoObject *(*)(echoObject *))_echoBVH_nix      /* echoTypeBVH */
 };
 
 echoObject *
@@ -0,0 +1,405 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "echo.h"
+#include "privateEcho.h"
+
+/*
+** Tracing the primary rays of a pixel together amortizes, over all the
+** rays in a packet, walking the BVH, loading its nodes and objects, and
+** setting up the per-object parts of the intersection tests.  The tests
+** that rule out most rays (against boxes, spheres, and triangles) are done
+** for the whole packet in simple loops over the rays; whatever survives
+** those is finished with the usual single-ray code, so that the packet
+** hits the same things as the rays would on their own.  Objects that have
+** no packet test are intersected with one ray at a time.
+*/
+
+#define PACKETINTX_ARGS(TYPE) _echoPacket *pkt,                            \
+                              const int mask[ECHO_PACKET_SIZE],            \
+                              echo##TYPE *obj, echoRTParm *parm,           \
+                              echoThreadState *tstate
+
+typedef void (*_echoPacketIntx_t)(PACKETINTX_ARGS(Object));
+static _echoPacketIntx_t _echoPacketIntx[ECHO_TYPE_NUM];
+
+static void
+_echoPacketHit(_echoPacket *pkt, int ri) {
+  int rj;
+
+  pkt->hit[ri] = AIR_TRUE;
+  pkt->faar[ri] = pkt->ray[ri].faar = pkt->intx[ri].t;
+  pkt->faarHi = pkt->faar[0];
+  for (rj=1; rj<pkt->num; rj++) {
+    pkt->faarHi = AIR_MAX(pkt->faarHi, pkt->faar[rj]);
+  }
+}
+
+/* the smallest and biggest of the products of [alo,ahi] and [blo,bhi] */
+#define INTERVAL_MUL(lo, hi, alo, ahi, blo, bhi, tmp)                      \
+  (lo) = (hi) = (alo)*(blo);                                              \
+  (tmp) = (alo)*(bhi);                                                    \
+  (lo) = AIR_MIN((lo), (tmp)); (hi) = AIR_MAX((hi), (tmp));               \
+  (tmp) = (ahi)*(blo);                                                    \
+  (lo) = AIR_MIN((lo), (tmp)); (hi) = AIR_MAX((hi), (tmp));               \
+  (tmp) = (ahi)*(bhi);                                                    \
+  (lo) = AIR_MIN((lo), (tmp)); (hi) = AIR_MAX((hi), (tmp))
+
+/*
+** for a coherent packet: whether any ray in the packet might hit the box,
+** as determined with interval arithmetic (for the whole packet at once)
+** on the rays' entry and exit points.  This can say that a box is hit
+** when in fact no ray hits it, but not the other way around.
+*/
+static int
+_echoPacketBoxAny(const _echoPacket *pkt,
+                  const echoPos_t min[3], const echoPos_t max[3]) {
+  echoPos_t lo0, hi0, lo1, hi1, tmp, inLo, outHi;
+  int ai;
+
+  inLo = pkt->neerLo;
+  outHi = pkt->faarHi;
+  for (ai=0; ai<3; ai++) {
+    INTERVAL_MUL(lo0, hi0,
+                 min[ai] - pkt->fromHi[ai], min[ai] - pkt->fromLo[ai],
+                 pkt->idirLo[ai], pkt->idirHi[ai], tmp);
+    INTERVAL_MUL(lo1, hi1,
+                 max[ai] - pkt->fromHi[ai], max[ai] - pkt->fromLo[ai],
+                 pkt->idirLo[ai], pkt->idirHi[ai], tmp);
+    if (pkt->idirLo[ai] > 0) {
+      /* rays enter through min[ai] and leave through max[ai] */
+      inLo = AIR_MAX(inLo, lo0);
+      outHi = AIR_MIN(outHi, hi1);
+    } else {
+      inLo = AIR_MAX(inLo, lo1);
+      outHi = AIR_MIN(outHi, hi0);
+    }
+  }
+  return inLo <= outHi;
+}
+
+/*
+** sets live[i] to whether ray i (if set in mask) hits the given box, and
+** returns the number of such rays
+*/
+static int
+_echoPacketBox(int live[ECHO_PACKET_SIZE], const _echoPacket *pkt,
+               const int mask[ECHO_PACKET_SIZE],
+               const echoPos_t min[3], const echoPos_t max[3]) {
+  echoPos_t t0, t1, tmp, tmin, tmax;
+  int ri, ai, num;
+
+  num = 0;
+  for (ri=0; ri<pkt->num; ri++) {
+    tmin = pkt->neer[ri];
+    tmax = pkt->faar[ri];
+    for (ai=0; ai<3; ai++) {
+      t0 = (min[ai] - pkt->from[ai][ri])*pkt->idir[ai][ri];
+      t1 = (max[ai] - pkt->from[ai][ri])*pkt->idir[ai][ri];
+      if (t0 > t1) {
+        tmp = t0; t0 = t1; t1 = tmp;
+      }
+      tmin = t0 > tmin ? t0 : tmin;
+      tmax = t1 < tmax ? t1 : tmax;
+    }
+    live[ri] = mask[ri] && tmin <= tmax;
+    num += live[ri];
+  }
+  return num;
+}
+
+static void
+_echoPacketIntx_Other(PACKETINTX_ARGS(Object)) {
+  int ri;
+
+  for (ri=0; ri<pkt->num; ri++) {
+    if (mask[ri]
+        && _echoRayIntx[obj->type](pkt->intx + ri, pkt->ray + ri,
+                                   obj, parm, tstate)) {
+      _echoPacketHit(pkt, ri);
+    }
+  }
+}
+
+static void
+_echoPacketIntx_Sphere(PACKETINTX_ARGS(Sphere)) {
+  echoPos_t r[3], A, B, C, rad2, dscr[ECHO_PACKET_SIZE];
+  int ri;
+
+  /* the discriminant, which is enough to rule out most rays ... */
+  rad2 = obj->rad*obj->rad;
+  for (ri=0; ri<pkt->num; ri++) {
+    r[0] = pkt->from[0][ri] - obj->pos[0];
+    r[1] = pkt->from[1][ri] - obj->pos[1];
+    r[2] = pkt->from[2][ri] - obj->pos[2];
+    A = (pkt->dir[0][ri]*pkt->dir[0][ri] + pkt->dir[1][ri]*pkt->dir[1][ri]
+         + pkt->dir[2][ri]*pkt->dir[2][ri]);
+    B = 2*(pkt->dir[0][ri]*r[0] + pkt->dir[1][ri]*r[1]
+           + pkt->dir[2][ri]*r[2]);
+    C = r[0]*r[0] + r[1]*r[1] + r[2]*r[2] - rad2;
+    dscr[ri] = B*B - 4*A*C;
+  }
+  /* ... and then the real intersection for the rest */
+  for (ri=0; ri<pkt->num; ri++) {
+    if (mask[ri] && dscr[ri] > 0
+        && _echoRayIntx_Sphere(pkt->intx + ri, pkt->ray + ri,
+                               obj, parm, tstate)) {
+      _echoPacketHit(pkt, ri);
+    }
+  }
+}
+
+/*
+** sets ok[i] to whether ray i may hit the triangle (vert0, edge0, edge1),
+** based on the same tests (except for t >= neer) as TRI_INTX, and returns
+** the number of rays that may
+*/
+static int
+_echoPacketTri(int ok[ECHO_PACKET_SIZE], const _echoPacket *pkt,
+               const int mask[ECHO_PACKET_SIZE], const echoPos_t vert0[3],
+               const echoPos_t edge0[3], const echoPos_t edge1[3]) {
+  echoPos_t pvec[3], qvec[3], tvec[3], dir[3], det, t, u, v;
+  int ri, num;
+
+  num = 0;
+  for (ri=0; ri<pkt->num; ri++) {
+    ELL_3V_SET(dir, pkt->dir[0][ri], pkt->dir[1][ri], pkt->dir[2][ri]);
+    ELL_3V_CROSS(pvec, dir, edge1);
+    det = ELL_3V_DOT(pvec, edge0);
+    ok[ri] = mask[ri] && (det <= -ECHO_EPSILON || det >= ECHO_EPSILON);
+    det = ok[ri] ? 1.0/det : 0.0;
+    tvec[0] = pkt->from[0][ri] - vert0[0];
+    tvec[1] = pkt->from[1][ri] - vert0[1];
+    tvec[2] = pkt->from[2][ri] - vert0[2];
+    u = det * ELL_3V_DOT(pvec, tvec);
+    ELL_3V_CROSS(qvec, tvec, edge0);
+    v = det * ELL_3V_DOT(qvec, dir);
+    t = det * ELL_3V_DOT(qvec, edge1);
+    ok[ri] = (ok[ri] && u >= 0.0 && v >= 0.0 && u + v <= 1.0
+              && t <= pkt->faar[ri]);
+    num += ok[ri];
+  }
+  return num;
+}
+
+static void
+_echoPacketIntx_Triangle(PACKETINTX_ARGS(Triangle)) {
+  echoPos_t edge0[3], edge1[3];
+  int ri, ok[ECHO_PACKET_SIZE];
+
+  ELL_3V_SUB(edge0, obj->vert[1], obj->vert[0]);
+  ELL_3V_SUB(edge1, obj->vert[2], obj->vert[0]);
+  if (!_echoPacketTri(ok, pkt, mask, obj->vert[0], edge0, edge1)) {
+    return;
+  }
+  for (ri=0; ri<pkt->num; ri++) {
+    if (ok[ri]
+        && _echoRayIntx_Triangle(pkt->intx + ri, pkt->ray + ri,
+                                 obj, parm, tstate)) {
+      _echoPacketHit(pkt, ri);
+    }
+  }
+}
+
+/* same as _echoRayIntx_TriMesh, but with the faces in the outer loop */
+static void
+_echoPacketIntx_TriMesh(PACKETINTX_ARGS(TriMesh)) {
+  echoPos_t *pos, vert0[3], edge0[3], edge1[3], pvec[3], qvec[3], tvec[3],
+    det, t, u, v, tmp;
+  echoRay *ray;
+  echoIntx *intx;
+  int fi, ri, live[ECHO_PACKET_SIZE], ok[ECHO_PACKET_SIZE];
+
+  AIR_UNUSED(parm);
+  AIR_UNUSED(tstate);
+  if (!_echoPacketBox(live, pkt, mask, obj->min, obj->max)) {
+    return;
+  }
+  for (fi=0; fi<obj->numF; fi++) {
+    pos = obj->pos + 3*obj->vert[0 + 3*fi];
+    ELL_3V_COPY(vert0, pos);
+    pos = obj->pos + 3*obj->vert[1 + 3*fi];
+    ELL_3V_SUB(edge0, pos, vert0);
+    pos = obj->pos + 3*obj->vert[2 + 3*fi];
+    ELL_3V_SUB(edge1, pos, vert0);
+    if (!_echoPacketTri(ok, pkt, live, vert0, edge0, edge1)) {
+      continue;
+    }
+    for (ri=0; ri<pkt->num; ri++) {
+      if (!ok[ri]) {
+        continue;
+      }
+      ray = pkt->ray + ri;
+      intx = pkt->intx + ri;
+      TRI_INTX(ray, vert0, edge0, edge1,
+               pvec, qvec, tvec, det, t, u, v,
+               (v < 0.0 || u + v > 1.0), continue);
+      intx->t = t;
+      ELL_3V_CROSS(intx->norm, edge0, edge1);
+      ELL_3V_NORM(intx->norm, intx->norm, tmp);
+      intx->obj = OBJECT(obj);
+      intx->face = fi;
+      _echoPacketHit(pkt, ri);
+    }
+  }
+}
+
+static void
+_echoPacketIntx_AABBox(PACKETINTX_ARGS(AABBox)) {
+  int live[ECHO_PACKET_SIZE];
+
+  if (_echoPacketBox(live, pkt, mask, obj->min, obj->max)) {
+    _echoPacketIntx[obj->obj->type](pkt, live, obj->obj, parm, tstate);
+  }
+}
+
+static void
+_echoPacketIntx_List(PACKETINTX_ARGS(List)) {
+  unsigned int ii;
+  echoObject *kid;
+
+  for (ii=0; ii<obj->objArr->len; ii++) {
+    kid = obj->obj[ii];
+    _echoPacketIntx[kid->type](pkt, mask, kid, parm, tstate);
+  }
+}
+
+/*
+** visits the nodes of the BVH that any ray in the packet hits, in the
+** order given by the direction of the first such ray
+*/
+static void
+_echoPacketIntx_BVH(PACKETINTX_ARGS(BVH)) {
+  echoBVHNode *node;
+  echoObject *kid;
+  int stack[ECHO_BVH_DEPTH_MAX+2], sp, ni, ii, first,
+    live[ECHO_PACKET_SIZE];
+
+  if (!obj->nodeNum) {
+    return;
+  }
+  sp = 0;
+  stack[sp++] = 0;
+  while (sp) {
+    ni = stack[--sp];
+    node = obj->node + ni;
+    if (pkt->coherent) {
+      /* one test for the packet, instead of one per ray; the objects
+         in the leaves will be tested with every ray in mask */
+      if (!_echoPacketBoxAny(pkt, node->min, node->max)) {
+        continue;
+      }
+      for (ii=0; ii<pkt->num; ii++) {
+        live[ii] = mask[ii];
+      }
+    } else if (!_echoPacketBox(live, pkt, mask, node->min, node->max)) {
+      continue;
+    }
+    if (node->objNum) {
+      for (ii=0; ii<node->objNum; ii++) {
+        kid = obj->obj[node->objIdx + ii];
+        _echoPacketIntx[kid->type](pkt, live, kid, parm, tstate);
+      }
+    } else {
+      for (first=0; !live[first]; first++)
+        ;
+      if (pkt->dir[node->axis][first] > 0) {
+        stack[sp++] = node->kid;
+        stack[sp++] = ni + 1;
+      } else {
+        stack[sp++] = ni + 1;
+        stack[sp++] = node->kid;
+      }
+    }
+  }
+}
+
+static _echoPacketIntx_t
+_echoPacketIntx[ECHO_TYPE_NUM] = {
+  (_echoPacketIntx_t)_echoPacketIntx_Sphere,
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeCylinder */
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeSuperquad */
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeCube */
+  (_echoPacketIntx_t)_echoPacketIntx_Triangle,
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeRectangle */
+  (_echoPacketIntx_t)_echoPacketIntx_TriMesh,
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeIsosurface */
+  (_echoPacketIntx_t)_echoPacketIntx_AABBox,
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeSplit */
+  (_echoPacketIntx_t)_echoPacketIntx_List,
+  (_echoPacketIntx_t)_echoPacketIntx_Other,    /* echoTypeInstance */
+  (_echoPacketIntx_t)_echoPacketIntx_BVH
+};
+
+/*
+** _echoRayPacketIntx
+**
+** the packet version of echoRayIntx, for the pkt->num (non-shadow) rays
+** in pkt->ray[], when the scene has a BVH.  Sets pkt->hit[] and
+** pkt->intx[], which is set up for coloring as by echoRayIntx.
+*/
+void
+_echoRayPacketIntx(_echoPacket *pkt, echoScene *scene,
+                   echoRTParm *parm, echoThreadState *tstate) {
+  int ri, ai, mask[ECHO_PACKET_SIZE];
+
+  for (ri=0; ri<pkt->num; ri++) {
+    for (ai=0; ai<3; ai++) {
+      pkt->from[ai][ri] = pkt->ray[ri].from[ai];
+      pkt->dir[ai][ri] = pkt->ray[ri].dir[ai];
+      pkt->idir[ai][ri] = (pkt->ray[ri].dir[ai]
+                           ? 1.0/pkt->ray[ri].dir[ai]
+                           : ECHO_POS_MAX);
+    }
+    pkt->neer[ri] = pkt->ray[ri].neer;
+    pkt->faar[ri] = pkt->ray[ri].faar;
+    pkt->intx[ri].boxhits = 0;
+    pkt->hit[ri] = AIR_FALSE;
+    mask[ri] = AIR_TRUE;
+  }
+  pkt->coherent = AIR_TRUE;
+  for (ai=0; ai<3; ai++) {
+    pkt->fromLo[ai] = pkt->fromHi[ai] = pkt->from[ai][0];
+    pkt->idirLo[ai] = pkt->idirHi[ai] = pkt->idir[ai][0];
+    for (ri=0; ri<pkt->num; ri++) {
+      pkt->fromLo[ai] = AIR_MIN(pkt->fromLo[ai], pkt->from[ai][ri]);
+      pkt->fromHi[ai] = AIR_MAX(pkt->fromHi[ai], pkt->from[ai][ri]);
+      pkt->idirLo[ai] = AIR_MIN(pkt->idirLo[ai], pkt->idir[ai][ri]);
+      pkt->idirHi[ai] = AIR_MAX(pkt->idirHi[ai], pkt->idir[ai][ri]);
+      pkt->coherent &= !!pkt->dir[ai][ri];
+    }
+    pkt->coherent &= (pkt->idirLo[ai] > 0 || pkt->idirHi[ai] < 0);
+  }
+  pkt->neerLo = pkt->neer[0];
+  pkt->faarHi = pkt->faar[0];
+  for (ri=1; ri<pkt->num; ri++) {
+    pkt->neerLo = AIR_MIN(pkt->neerLo, pkt->neer[ri]);
+    pkt->faarHi = AIR_MAX(pkt->faarHi, pkt->faar[ri]);
+  }
+  _echoPacketIntx_BVH(pkt, mask, BVH(scene->bvh), parm, tstate);
+  for (ri=0; ri<pkt->num; ri++) {
+    if (pkt->hit[ri]) {
+      _echoRayIntxFinish(pkt->intx + ri, pkt->ray + ri);
+    }
+  }
+}
@@ -63,6 +63,7 @@ extern "C" {
 #define TRIMESH(obj)   ((echoTriMesh*)obj)
 #define TRIANGLE(obj)  ((echoTriangle*)obj)
 #define INSTANCE(obj)  ((echoInstance*)obj)
+#define BVH(obj)       ((echoBVH*)obj)
 
 #define _ECHO_REFLECT(refl, norm, view, tmp) \
   (tmp) = 2*ELL_3V_DOT((view), (norm)); \
@@ -83,12 +84,83 @@ typedef int (*_echoRayIntx_t)(RAYINTX_ARGS(Object));
 extern _echoRayIntx_t _echoRayIntx[/* object type idx */];
 typedef void (*_echoRayIntxUV_t)(echoIntx *intx);
 extern _echoRayIntxUV_t _echoRayIntxUV[/* object type idx */];
+
+/*
+** TRI_INTX
+**
+** given a triangle in terms of origin, edge0, edge1, this will
+** begin the intersection calculation:
+** - sets pvec, tvec, qvec (all of them if intx is not ruled out )
+** - sets u, and rules out intx based on (u < 0.0 || u > 1.0)
+** - sets v, and rules out intx based on COND
+** - sets t, and rules out intx based on (t < neer || t > faar)
+*/
+#define TRI_INTX(ray, origin, edge0, edge1, pvec, qvec, tvec,                \
+                 det, t, u, v, COND, NOPE)                                   \
+  ELL_3V_CROSS(pvec, ray->dir, edge1);                                       \
+  det = ELL_3V_DOT(pvec, edge0);                                             \
+  if (det > -ECHO_EPSILON && det < ECHO_EPSILON) {                           \
+    NOPE;                                                                    \
+  }                                                                          \
+  /* now det is the reciprocal of the determinant */                         \
+  det = 1.0/det;                                                             \
+  ELL_3V_SUB(tvec, ray->from, origin);                                       \
+  u = det * ELL_3V_DOT(pvec, tvec);                                          \
+  if (u < 0.0 || u > 1.0) {                                                  \
+    NOPE;                                                                    \
+  }                                                                          \
+  ELL_3V_CROSS(qvec, tvec, edge0);                                           \
+  v = det * ELL_3V_DOT(qvec, ray->dir);                                      \
+  if (COND) {                                                                \
+    NOPE;                                                                    \
+  }                                                                          \
+  t = det * ELL_3V_DOT(qvec, edge1);                                         \
+  if (t < ray->neer || t > ray->faar) {                                      \
+    NOPE;                                                                    \
+  }
+
+extern void _echoRayIntxFinish(echoIntx *intx, echoRay *ray);
+extern int _echoRayIntx_Sphere(RAYINTX_ARGS(Sphere));
+extern int _echoRayIntx_Triangle(RAYINTX_ARGS(Triangle));
 extern int _echoRayIntx_CubeSolid(echoPos_t *tminP, echoPos_t *tmaxP,
                                   echoPos_t xmin, echoPos_t xmax,
                                   echoPos_t ymin, echoPos_t ymax,
                                   echoPos_t zmin, echoPos_t zmax,
                                   echoRay *ray);
 
+/* bvh.c */
+extern int _echoBVHBuild(echoBVH *bvh, echoObject **obj, unsigned int num,
+                         int numThreads);
+
+/* packet.c */
+/*
+** _echoPacket
+**
+** the primary rays traced together by _echoRayPacketIntx, and what they
+** hit.  The ray origins and directions are also stored one coordinate at
+** a time, for the loops over all the rays in the packet.
+*/
+typedef struct {
+  int num;                             /* number of rays in packet */
+  echoRay ray[ECHO_PACKET_SIZE];
+  echoIntx intx[ECHO_PACKET_SIZE];
+  int hit[ECHO_PACKET_SIZE];           /* ray[i] hit something (intx[i]) */
+  echoPos_t from[3][ECHO_PACKET_SIZE],
+    dir[3][ECHO_PACKET_SIZE],
+    idir[3][ECHO_PACKET_SIZE],         /* 1/dir (or huge, if dir is 0) */
+    neer[ECHO_PACKET_SIZE],
+    faar[ECHO_PACKET_SIZE];            /* kept same as ray[i].faar */
+  int coherent;                        /* along each axis, all the dir[]
+                                          are non-zero with the same sign,
+                                          so that the intervals below can
+                                          be used to test boxes */
+  echoPos_t fromLo[3], fromHi[3],      /* intervals spanned by from[] */
+    idirLo[3], idirHi[3],              /* and by idir[] */
+    neerLo, faarHi;                    /* smallest neer[], biggest faar[] */
+} _echoPacket;
+extern void _echoRayPacketIntx(_echoPacket *pkt, echoScene *scene,
+                               echoRTParm *parm, echoThreadState *tstate);
+
 /* sqd.c */
 extern int _echoRayIntx_Superquad(RAYINTX_ARGS(Superquad));
 
@@ -229,6 +229,44 @@ echoChannelAverage(echoCol_t *img,
   return;
 }
 
+/*
+** _echoRayColorIntx
+**
+** the part of echoRayColor after the ray has been intersected with
+** the scene (with result hit and intx)
+*/
+static void
+_echoRayColorIntx(echoCol_t *chan, int hit, echoIntx *intx, echoRay *ray,
+                  echoScene *scene, echoRTParm *parm,
+                  echoThreadState *tstate) {
+  static const char me[]="echoRayColor";
+  echoCol_t rgba[4];
+
+  if (!hit) {
+    if (tstate->verbose) {
+      fprintf(stderr, "%s%s: (nothing was hit)\n",_echoDot(tstate->depth), me);
+    }
+    /* ray hits nothing in scene */
+    ELL_4V_SET_TT(chan, echoCol_t,
+                  scene->bkgr[0], scene->bkgr[1], scene->bkgr[2],
+                  (parm->renderBoxes
+                   ? 1.0 - pow(1.0 - parm->boxOpac, intx->boxhits)
+                   : 0.0));
+    return;
+  }
+
+  if (tstate->verbose) {
+    fprintf(stderr, "%s%s: hit a %d (%p) at (%g,%g,%g)\n"
+            "%s    = %g along (%g,%g,%g)\n", _echoDot(tstate->depth), me,
+            intx->obj->type, AIR_CAST(void*, intx->obj),
+            intx->pos[0], intx->pos[1], intx->pos[2], _echoDot(tstate->depth),
+            intx->t, ray->dir[0], ray->dir[1], ray->dir[2]);
+  }
+  echoIntxColor(rgba, intx, scene, parm, tstate);
+  ELL_4V_COPY(chan, rgba);
+  return;
+}
+
 /*
 ******** echoRayColor
 **
@@ -240,9 +278,8 @@ echoChannelAverage(echoCol_t *img,
 void
 echoRayColor(echoCol_t *chan, echoRay *ray,
              echoScene *scene, echoRTParm *parm, echoThreadState *tstate) {
-  static const char me[]="echoRayColor";
-  echoCol_t rgba[4];
   echoIntx intx;
+  int hit;
 
   tstate->depth++;
   if (tstate->depth > parm->maxRecDepth) {
@@ -253,38 +290,54 @@ echoRayColor(echoCol_t *chan, echoRay *ray,
   }
 
   intx.boxhits = 0;
-  if (!echoRayIntx(&intx, ray, scene, parm, tstate)) {
-    if (tstate->verbose) {
-      fprintf(stderr, "%s%s: (nothing was hit)\n",_echoDot(tstate->depth), me);
-    }
-    /* ray hits nothing in scene */
-    ELL_4V_SET_TT(chan, echoCol_t,
-                  scene->bkgr[0], scene->bkgr[1], scene->bkgr[2],
-                  (parm->renderBoxes
-                   ? 1.0 - pow(1.0 - parm->boxOpac, intx.boxhits)
-                   : 0.0));
-    goto done;
-  }
-
-  if (tstate->verbose) {
-    fprintf(stderr, "%s%s: hit a %d (%p) at (%g,%g,%g)\n"
-            "%s    = %g along (%g,%g,%g)\n", _echoDot(tstate->depth), me,
-            intx.obj->type, AIR_CAST(void*, intx.obj),
-            intx.pos[0], intx.pos[1], intx.pos[2], _echoDot(tstate->depth),
-            intx.t, ray->dir[0], ray->dir[1], ray->dir[2]);
-  }
-  echoIntxColor(rgba, &intx, scene, parm, tstate);
-  ELL_4V_COPY(chan, rgba);
+  hit = echoRayIntx(&intx, ray, scene, parm, tstate);
+  _echoRayColorIntx(chan, hit, &intx, ray, scene, parm, tstate);
  done:
   tstate->depth--;
   return;
 }
 
+/*
+** _echoRayPacketColor
+**
+** like echoRayColor, but for the primary rays in a packet, which are
+** traced through the scene's BVH together.  chan is for the first ray,
+** and tstate->jitt is for the last ray (the rays are consecutive samples
+** of a pixel); the render time is divided evenly among the rays.
+*/
+static void
+_echoRayPacketColor(echoCol_t *chan, _echoPacket *pkt, echoScene *scene,
+                    echoRTParm *parm, echoThreadState *tstate) {
+  double time0;
+  echoCol_t dt;
+  echoPos_t *jitt;
+  int ri;
+
+  time0 = airTime();
+  _echoRayPacketIntx(pkt, scene, parm, tstate);
+  /* shading uses the jitter (e.g. for area lights) of each ray's sample */
+  jitt = tstate->jitt;
+  for (ri=0; ri<pkt->num; ri++) {
+    tstate->jitt = jitt - 2*ECHO_JITTABLE_NUM*(pkt->num-1-ri);
+    tstate->depth++;
+    _echoRayColorIntx(chan + ECHO_IMG_CHANNELS*ri, pkt->hit[ri],
+                      pkt->intx + ri, pkt->ray + ri, scene, parm, tstate);
+    tstate->depth--;
+  }
+  tstate->jitt = jitt;
+  dt = AIR_CAST(echoCol_t, (airTime() - time0)/pkt->num);
+  for (ri=0; ri<pkt->num; ri++) {
+    chan[4 + ECHO_IMG_CHANNELS*ri] = dt;
+  }
+  return;
+}
+
 void *
 _echoRTRenderThreadBody(void *_arg) {
   char done[20];
   int imgUi, imgVi,         /* integral pixel indices */
-    samp;                   /* which sample are we doing */
+    samp,                   /* which sample are we doing */
+    packet;                 /* trace primary rays in packets */
   echoPos_t tmp0, tmp1,
     pixUsz, pixVsz,         /* U and V dimensions of a pixel */
     U[4], V[4], N[4],       /* view space basis (only first 3 elements used) */
@@ -294,6 +347,7 @@ _echoRTRenderThreadBody(void *_arg) {
     imgOrig[3];             /* image origin */
   double time0;
   echoRay ray;              /* (not a pointer) */
+  _echoPacket pkt;          /* primary rays not yet traced, with packet */
   echoThreadState *arg;
   echoCol_t *img, *chan;    /* current scanline of channel buffer array */
   Nrrd *nraw;               /* copies of arguments to echoRTRender . . . */
@@ -307,6 +361,14 @@ _echoRTRenderThreadBody(void *_arg) {
   scene = arg->gstate->scene;
   parm = arg->gstate->parm;
 
+  /* packets need the BVH, only pay off with enough coherent rays per
+     pixel, and don't count the box hits needed for renderBoxes */
+  packet = (parm->packet && parm->bvh && scene->bvh
+            && parm->numSamples >= ECHO_PACKET_SAMPLES_MIN
+            && parm->maxRecDepth >= 1
+            && !parm->renderBoxes);
+  pkt.num = 0;
+
   echoJitterCompute(arg->gstate->parm, arg);
   if (arg->gstate->verbose > 2) {
     nrrdSave("jitt.nrrd", arg->njitt, NULL);
@@ -392,13 +454,23 @@ _echoRTRenderThreadBody(void *_arg) {
         ELL_3V_NORM(ray.dir, ray.dir, tmp0);
         ray.neer = 0.0;
         ray.faar = ECHO_POS_MAX;
-        time0 = airTime();
-        if (0) {
-          memset(chan, 0, ECHO_IMG_CHANNELS*sizeof(echoCol_t));
+        if (packet && !arg->verbose) {
+          /* trace the packet once it's full, or at the last sample */
+          pkt.ray[pkt.num++] = ray;
+          if (ECHO_PACKET_SIZE == pkt.num || parm->numSamples-1 == samp) {
+            _echoRayPacketColor(chan - ECHO_IMG_CHANNELS*(pkt.num-1), &pkt,
+                                scene, parm, arg);
+            pkt.num = 0;
+          }
         } else {
-          echoRayColor(chan, &ray, scene, parm, arg);
+          time0 = airTime();
+          if (0) {
+            memset(chan, 0, ECHO_IMG_CHANNELS*sizeof(echoCol_t));
+          } else {
+            echoRayColor(chan, &ray, scene, parm, arg);
+          }
+          chan[4] = AIR_CAST(echoCol_t, airTime() - time0);
         }
-        chan[4] = AIR_CAST(echoCol_t, airTime() - time0);
 
         /* move to next "scanline" */
         arg->jitt += 2*ECHO_JITTABLE_NUM;
@@ -454,6 +526,23 @@ echoRTRender(Nrrd *nraw, limnCamera *cam, echoScene *scene,
                      AIR_NAN, cam->uRange[0], cam->vRange[0]);
   nrrdAxisInfoSet_va(nraw, nrrdAxisInfoMax,
                      AIR_NAN, cam->uRange[1], cam->vRange[1]);
+  if (parm->bvh) {
+    double bvhTime;
+    bvhTime = airTime();
+    if (!scene->bvh) {
+      scene->bvh = echoObjectNew(scene, echoTypeBVH);
+    }
+    if (_echoBVHBuild(BVH(scene->bvh), scene->rend, scene->rendArr->len,
+                      parm->numThreads)) {
+      biffAddf(ECHO, "%s: couldn't build BVH", me);
+      airMopError(mop); return 1;
+    }
+    if (gstate->verbose) {
+      fprintf(stderr, "%s: BVH of %d nodes over %d objects in %g sec\n",
+              me, BVH(scene->bvh)->nodeNum, BVH(scene->bvh)->objNum,
+              airTime() - bvhTime);
+    }
+  }
   gstate->time = airTime();
 
   if (parm->numThreads > 1) {
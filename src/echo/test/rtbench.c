@@ -0,0 +1,208 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "../echo.h"
+
+/*
+** benchmarks echoRTRender on a fixed scene of glyphs: an N^3 grid of
+** glyphs, which are spheres where a made-up tensor field is isotropic,
+** and boxes (triangle meshes) aligned with a helical direction where it
+** isn't, on top of a floor of triangles.  The same image is rendered
+** without a BVH (with the list of glyphs split, like "tend glyph" does),
+** with a BVH, and with a BVH and ray packets, and the speed is reported
+** as millions of primary rays per second.  For example:
+** rtbench 20 300 16 1
+*/
+
+void
+usage(char *me) {
+  /*                      0    1       2        3          4 */
+  fprintf(stderr, "usage: %s <N> <imgSize> <samples> <threads>\n", me);
+  exit(1);
+}
+
+/* a box with given center, half-widths, and rotation about Z by angle */
+static echoObject *
+boxGlyph(echoScene *scene, echoPos_t cent[3], echoPos_t hw[3],
+         echoPos_t angle) {
+  static const int face[3*12] = {0, 2, 1,  1, 2, 3,  4, 5, 6,  5, 7, 6,
+                                 0, 1, 4,  1, 5, 4,  2, 6, 3,  3, 6, 7,
+                                 0, 4, 2,  2, 4, 6,  1, 3, 5,  3, 7, 5};
+  echoObject *trim;
+  echoPos_t *pos, xx, yy, cc, ss;
+  int *vert, vi;
+
+  pos = AIR_CALLOC(3*8, echoPos_t);
+  vert = AIR_CALLOC(3*12, int);
+  if (!( pos && vert )) {
+    airFree(pos);
+    airFree(vert);
+    return NULL;
+  }
+  cc = cos(angle);
+  ss = sin(angle);
+  for (vi=0; vi<8; vi++) {
+    xx = (vi & 1 ? 1 : -1)*hw[0];
+    yy = (vi & 2 ? 1 : -1)*hw[1];
+    pos[0 + 3*vi] = cent[0] + cc*xx - ss*yy;
+    pos[1 + 3*vi] = cent[1] + ss*xx + cc*yy;
+    pos[2 + 3*vi] = cent[2] + (vi & 4 ? 1 : -1)*hw[2];
+  }
+  for (vi=0; vi<3*12; vi++) {
+    vert[vi] = face[vi];
+  }
+  trim = echoObjectNew(scene, echoTypeTriMesh);
+  echoTriMeshSet(trim, 8, pos, 12, vert);
+  return trim;
+}
+
+static int
+makeScene(echoScene *scene, int N) {
+  echoObject *list, *obj;
+  echoPos_t cent[3], hw[3], rr, an;
+  int xi, yi, zi;
+
+  list = echoObjectNew(scene, echoTypeList);
+  for (zi=0; zi<N; zi++) {
+    for (yi=0; yi<N; yi++) {
+      for (xi=0; xi<N; xi++) {
+        ELL_3V_SET(cent,
+                   AIR_AFFINE(-0.5, xi, N-0.5, -1, 1),
+                   AIR_AFFINE(-0.5, yi, N-0.5, -1, 1),
+                   AIR_AFFINE(-0.5, zi, N-0.5, -1, 1));
+        /* anisotropy grows with distance from the Z axis */
+        rr = sqrt(cent[0]*cent[0] + cent[1]*cent[1]);
+        an = AIR_MIN(rr, 1.0);
+        if (an < 0.4) {
+          obj = echoObjectNew(scene, echoTypeSphere);
+          echoSphereSet(obj, cent[0], cent[1], cent[2], 0.8/N);
+        } else {
+          ELL_3V_SET(hw, (0.4 + 0.5*an)/N, 0.4/N, (0.5 - 0.2*an)/N);
+          if (!(obj = boxGlyph(scene, cent, hw,
+                               atan2(cent[1], cent[0]) + AIR_PI/2
+                               + 2*cent[2]))) {
+            biffAddf(ECHO, "rtbench: couldn't allocate glyph");
+            return 1;
+          }
+        }
+        echoColorSet(obj, AIR_CAST(echoCol_t, 0.5 + 0.5*an),
+                     0.5, AIR_CAST(echoCol_t, 1 - 0.5*an), 1);
+        echoMatterPhongSet(scene, obj, 0.1f, 0.6f, 0.3f, 40);
+        echoListAdd(list, obj);
+      }
+    }
+  }
+  echoObjectAdd(scene, echoListSplit3(scene, list, 10));
+
+  /* floor of two triangles */
+  obj = echoObjectNew(scene, echoTypeTriangle);
+  echoTriangleSet(obj, -3, -3, -1.2,  3, -3, -1.2,  3, 3, -1.2);
+  echoColorSet(obj, 1, 1, 1, 1);
+  echoMatterPhongSet(scene, obj, 0.1f, 0.6f, 0.3f, 40);
+  echoObjectAdd(scene, obj);
+  obj = echoObjectNew(scene, echoTypeTriangle);
+  echoTriangleSet(obj, -3, -3, -1.2,  3, 3, -1.2,  -3, 3, -1.2);
+  echoColorSet(obj, 1, 1, 1, 1);
+  echoMatterPhongSet(scene, obj, 0.1f, 0.6f, 0.3f, 40);
+  echoObjectAdd(scene, obj);
+  return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+  static const char *what[3] = {"split list", "BVH", "BVH + packets"};
+  char *me, *err;
+  int N, size, samples, threads, wi;
+  limnCamera *cam;
+  echoRTParm *parm;
+  echoGlobalState *gstate;
+  echoScene *scene;
+  Nrrd *nraw;
+  airArray *mop;
+  double rays;
+
+  me = argv[0];
+  if (5 != argc) {
+    usage(me);
+  }
+  if (4 != (sscanf(argv[1], "%d", &N)
+            + sscanf(argv[2], "%d", &size)
+            + sscanf(argv[3], "%d", &samples)
+            + sscanf(argv[4], "%d", &threads))) {
+    fprintf(stderr, "%s: couldn't parse \"%s\", \"%s\", \"%s\", \"%s\" as "
+            "ints\n", me, argv[1], argv[2], argv[3], argv[4]);
+    exit(1);
+  }
+
+  mop = airMopNew();
+  cam = limnCameraNew();
+  airMopAdd(mop, cam, (airMopper)limnCameraNix, airMopAlways);
+  parm = echoRTParmNew();
+  airMopAdd(mop, parm, (airMopper)echoRTParmNix, airMopAlways);
+  gstate = echoGlobalStateNew();
+  airMopAdd(mop, gstate, (airMopper)echoGlobalStateNix, airMopAlways);
+  scene = echoSceneNew();
+  airMopAdd(mop, scene, (airMopper)echoSceneNix, airMopAlways);
+  nraw = nrrdNew();
+  airMopAdd(mop, nraw, (airMopper)nrrdNuke, airMopAlways);
+  if (makeScene(scene, N)) {
+    airMopAdd(mop, err = biffGetDone(ECHO), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble:\n%s", me, err);
+    airMopError(mop); exit(1);
+  }
+
+  ELL_3V_SET(cam->from, 4, 3, 5);
+  ELL_3V_SET(cam->at, 0, 0, 0);
+  ELL_3V_SET(cam->up, 0, 0, 1);
+  cam->neer = cam->dist = cam->faar = 0;
+  cam->atRelative = AIR_TRUE;
+  cam->rightHanded = AIR_TRUE;
+  cam->uRange[0] = -1.6;
+  cam->uRange[1] = 1.6;
+  cam->vRange[0] = -1.6;
+  cam->vRange[1] = 1.6;
+  parm->jitterType = (samples > 1 ? echoJitterJitter : echoJitterNone);
+  parm->numSamples = samples;
+  parm->imgResU = size;
+  parm->imgResV = size;
+  parm->numThreads = threads;
+  parm->shadow = 0.0;
+  rays = AIR_CAST(double, size)*size*samples;
+
+  printf("%s: %d^3 glyphs, %dx%d image, %d samples, %d thread%s\n", me,
+         N, size, size, samples, threads, 1 == threads ? "" : "s");
+  for (wi=0; wi<3; wi++) {
+    parm->bvh = wi > 0;
+    parm->packet = wi > 1;
+    if (echoRTRender(nraw, cam, scene, parm, gstate)) {
+      airMopAdd(mop, err = biffGetDone(ECHO), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble:\n%s", me, err);
+      airMopError(mop); exit(1);
+    }
+    printf("%16s: %8.3f Mrays/sec (%g primary rays in %g sec)\n", what[wi],
+           rays/(gstate->time*1000000), rays, gstate->time);
+  }
+
+  airMopOkay(mop);
+  exit(0);
+}
@@ -67,6 +67,7 @@ gageContextNew() {
     }
     for (ii=gageKernelUnknown+1; ii<gageKernelLast; ii++) {
       ctx->needK[ii] = AIR_FALSE;
+      ctx->fwFast[ii] = NULL;
     }
     ctx->radius = 0;
     ctx->fsl = ctx->fw = NULL;
@@ -692,6 +693,105 @@ gageIv3Fill(gageContext *ctx, gagePerVolume *pvl) {
   return;
 }
 
+/*
+** _gageIv3Inside
+**
+** whether all the samples needed for the iv3 cache at (integral)
+** location idx are inside the volume, the same test that gageIv3Fill
+** uses to pick its fast path.  For the idx set by gagePointReset, this
+** is false.
+*/
+static int
+_gageIv3Inside(const gageContext *ctx, const unsigned int *idx) {
+  unsigned int ai;
+  int lo, hi;
+
+  for (ai=0; ai<3; ai++) {
+    /* idx[0]-1: see Thu Jan 14 comment in filter.c */
+    lo = AIR_CAST(int, idx[ai]) - 1 - (AIR_CAST(int, ctx->radius) - 1);
+    hi = lo + 2*AIR_CAST(int, ctx->radius) - 1;
+    if (!( lo >= 0 && hi < AIR_CAST(int, ctx->shape->size[ai]) )) {
+      return AIR_FALSE;
+    }
+  }
+  return AIR_TRUE;
+}
+
+/*
+** _gageIv3Slide
+**
+** when the probe has moved by one voxel along some axes, and the iv3
+** cache at both the old and the new location is inside the volume,
+** there's no need for gageIv3Fill to look up all fd^3 values again:
+** 2*radius-1 of the 2*radius slices along each moved axis are already
+** in the cache, just in the wrong place.  This shifts them in place
+** (the layout of iv3 is unchanged, so the kind filters need not know)
+** and looks up only the one new slice per moved axis.  Because the same
+** values are looked up, the result is identical to gageIv3Fill.
+**
+** dd[ai] is the (-1, 0, or +1) change in ctx->point.idx[ai]; the caller
+** is responsible for the conditions above.
+*/
+static void
+_gageIv3Slide(gageContext *ctx, gagePerVolume *pvl, const int *dd) {
+  unsigned int ai, fd, fddd, stride, blockNum, bi, tup, valLen,
+    cacheIdx, slen, vi;
+  int corner[3];
+  char *here;
+  double *iv3;
+
+  fd = 2*ctx->radius;
+  fddd = fd*fd*fd;
+  valLen = pvl->kind->valLen;
+  /* the low corner of the neighborhood at the OLD location; it is moved
+     one axis at a time, so that each new slice is looked up relative to
+     where the cache actually is at that point */
+  for (ai=0; ai<3; ai++) {
+    corner[ai] = AIR_CAST(int, ctx->point.idx[ai]) - dd[ai]
+      - 1 - (AIR_CAST(int, ctx->radius) - 1);
+  }
+  for (ai=0; ai<3; ai++) {
+    if (!dd[ai]) {
+      continue;
+    }
+    corner[ai] += dd[ai];
+    here = (AIR_CAST(char *, pvl->nin->data)
+            + ((corner[0] + ctx->shape->size[0]
+                *(corner[1] + ctx->shape->size[1]*corner[2]))
+               *valLen*nrrdTypeSize[pvl->nin->type]));
+    /* per tuple component, the cache is blockNum blocks of fd slices
+       along axis ai, each slice being stride values.  Within each
+       block, fd-1 slices are shifted over (with loops written out,
+       since memmove() of such short runs is slower than the lup()s
+       being avoided) and the new slice is looked up */
+    stride = (0 == ai ? 1 : (1 == ai ? fd : fd*fd));
+    blockNum = fddd/(fd*stride);
+    slen = (fd-1)*stride;
+    for (tup=0; tup<valLen; tup++) {
+      for (bi=0; bi<blockNum; bi++) {
+        iv3 = pvl->iv3 + fddd*tup + bi*fd*stride;
+        cacheIdx = bi*fd*stride;
+        if (dd[ai] > 0) {
+          for (vi=0; vi<slen; vi++) {
+            iv3[vi] = iv3[vi + stride];
+          }
+          iv3 += slen;
+          cacheIdx += slen;
+        } else {
+          for (vi=slen; vi>0; vi--) {
+            iv3[vi - 1 + stride] = iv3[vi - 1];
+          }
+        }
+        for (vi=0; vi<stride; vi++) {
+          iv3[vi] = pvl->lup(here, tup + valLen*ctx->off[cacheIdx + vi]);
+        }
+      }
+    }
+  }
+  ctx->edgeFrac = 0;
+  return;
+}
+
 /*
 ** _gageProbe
 **
@@ -754,12 +854,40 @@ _gageProbe(gageContext *ctx, double _xi, double _yi, double _zi, double _si) {
   }
   if (idxChanged) {
     if (!ctx->parm.stackUse) {
-      for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+      int dd[3];
+      unsigned int ai, moveNum;
+      /* see if we can slide the iv3 caches instead of refilling them;
+         sliding along moveNum axes looks up moveNum*fd^2 values instead
+         of fd^3, but the shifting isn't free, so we only slide when
+         that at most halves the lookups (never with radius 1) */
+      moveNum = 0;
+      for (ai=0; ai<3; ai++) {
+        dd[ai] = (ctx->point.idx[ai] == oldIdx[ai] + 1
+                  ? 1
+                  : (ctx->point.idx[ai] + 1 == oldIdx[ai]
+                     ? -1
+                     : (ctx->point.idx[ai] == oldIdx[ai] ? 0 : 2)));
+        moveNum += !!dd[ai];
+      }
+      if (AIR_ABS(dd[0]) < 2 && AIR_ABS(dd[1]) < 2 && AIR_ABS(dd[2]) < 2
+          && moveNum < ctx->radius
+          && _gageIv3Inside(ctx, oldIdx)
+          && _gageIv3Inside(ctx, ctx->point.idx)) {
         if (ctx->verbose > 3) {
-          fprintf(stderr, "%s: gageIv3Fill(pvl[%u/%u] %s): .......\n", me,
-                  pvlIdx, ctx->pvlNum, ctx->pvl[pvlIdx]->kind->name);
+          fprintf(stderr, "%s: sliding iv3s by %d %d %d\n", me,
+                  dd[0], dd[1], dd[2]);
+        }
+        for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+          _gageIv3Slide(ctx, ctx->pvl[pvlIdx], dd);
+        }
+      } else {
+        for (pvlIdx=0; pvlIdx<ctx->pvlNum; pvlIdx++) {
+          if (ctx->verbose > 3) {
+            fprintf(stderr, "%s: gageIv3Fill(pvl[%u/%u] %s): .......\n", me,
+                    pvlIdx, ctx->pvlNum, ctx->pvl[pvlIdx]->kind->name);
+          }
+          gageIv3Fill(ctx, ctx->pvl[pvlIdx]);
         }
-        gageIv3Fill(ctx, ctx->pvl[pvlIdx]);
       }
     } else {
       for (pvlIdx=0; pvlIdx<ctx->pvlNum-1; pvlIdx++) {
@@ -943,3 +1071,204 @@ gageProbeSpace(gageContext *ctx, double xx, double yy, double zz,
 
   return _gageProbeSpace(ctx, xx, yy, zz, AIR_NAN, indexSpace, clamp);
 }
+
+typedef struct {
+  size_t key,      /* which voxel (and stack sample) position is in */
+    idx;           /* index of position in the batch */
+} _gageBatchOrder;
+
+static int
+_gageBatchOrderCompare(const void *_aa, const void *_bb) {
+  const _gageBatchOrder *aa, *bb;
+
+  aa = AIR_CAST(const _gageBatchOrder *, _aa);
+  bb = AIR_CAST(const _gageBatchOrder *, _bb);
+  /* falling back on idx keeps the order deterministic with qsort() */
+  return (aa->key < bb->key
+          ? -1
+          : (aa->key > bb->key
+             ? 1
+             : (aa->idx < bb->idx
+                ? -1
+                : (aa->idx > bb->idx ? 1 : 0))));
+}
+
+/*
+** the sort key for a position: the voxel containing it, with the slow
+** axes most significant, so that positions in the same voxel are
+** probed one after the other, re-using the iv3 caches.  This only has
+** to be approximately right (it has no effect on the answers), so it
+** doesn't bother with the fine points of _gageLocationSet().
+*/
+static size_t
+_gageBatchKey(gageContext *ctx, const double *pos, unsigned int posLen,
+              int indexSpace) {
+  double ipos[4];
+  size_t key, len;
+  unsigned int ii;
+  int outside;
+
+  if (indexSpace) {
+    ELL_3V_COPY(ipos, pos);
+  } else {
+    double wpos[4];
+    ELL_4V_SET(wpos, pos[0], pos[1], pos[2], 1);
+    ELL_4MV_MUL(ipos, ctx->shape->WtoI, wpos);
+    ELL_4V_HOMOG(ipos, ipos);
+  }
+  ipos[3] = 0;
+  if (4 == posLen) {
+    ipos[3] = indexSpace ? pos[3] : gageStackWtoI(ctx, pos[3], &outside);
+  }
+  key = 0;
+  for (ii=4; ii>0; ii--) {
+    len = (ii < 4 ? ctx->shape->size[ii-1] : ctx->pvlNum) + 2;
+    key *= len;
+    if (!AIR_EXISTS(ipos[ii-1])) {
+      /* probing will fail anyway */
+      key += len-1;
+    } else {
+      key += AIR_CAST(size_t, AIR_CLAMP(0, ipos[ii-1] + 1, len-1));
+    }
+  }
+  return key;
+}
+
+/*
+******** gageProbeBatch()
+**
+** probes at the "num" positions in pos[], which has posLen coordinates
+** per position: 3, or 4 for probing the scale-space stack (the 4th
+** coordinate is as for gageStackProbeSpace).  indexSpace and clamp are
+** as for gageProbeSpace().
+**
+** For each of the ansNum answers requested, the answer for item[ai] of
+** pvl[ai] (which must be attached to ctx, with item[ai] in its query)
+** is copied to ans[ai] + ii*ansStride[ai] for position ii. A zero
+** ansStride[ai] means the answer length. If non-NULL, errNum[ii] is
+** set to the ctx->errNum of the probe at position ii (gageErrNone when
+** it succeeded); the answers for failed probes are set to AIR_NAN.
+**
+** The answers are the same as from calling gageProbeSpace() or
+** gageStackProbeSpace() on each position in turn, but the positions
+** are probed in an order sorted according to which voxel they are in,
+** so that the iv3 caches can be re-used as much as possible.
+**
+** biff errors (and return 1) only for problems with the arguments;
+** failed probes are only recorded in errNum (and in NaN answers)
+*/
+int
+gageProbeBatch(gageContext *ctx, double *const *ans, const size_t *ansStride,
+               const gagePerVolume *const *pvl, const int *item,
+               unsigned int ansNum, int *errNum,
+               const double *pos, unsigned int posLen, size_t num,
+               int indexSpace, int clamp) {
+  static const char me[]="gageProbeBatch";
+  _gageBatchOrder *order;
+  const double **ansPtr;
+  unsigned int ai, *ansLen;
+  size_t ii, *stride;
+  airArray *mop;
+  int sorted;
+
+  if (!( ctx && pos )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (ansNum && !( ans && pvl && item )) {
+    biffAddf(GAGE, "%s: got NULL pointer for %u answers", me, ansNum);
+    return 1;
+  }
+  if (!( 3 == posLen || 4 == posLen )) {
+    biffAddf(GAGE, "%s: posLen %u not 3 or 4", me, posLen);
+    return 1;
+  }
+  if (4 == posLen && !ctx->parm.stackUse) {
+    biffAddf(GAGE, "%s: can't probe stack (posLen 4) without "
+             "parm.stackUse", me);
+    return 1;
+  }
+  if (!num) {
+    /* nothing to do */
+    return 0;
+  }
+
+  mop = airMopNew();
+  ansPtr = AIR_CALLOC(ansNum + 1, const double *);
+  airMopAdd(mop, AIR_VOIDP(ansPtr), airFree, airMopAlways);
+  ansLen = AIR_CALLOC(ansNum + 1, unsigned int);
+  airMopAdd(mop, ansLen, airFree, airMopAlways);
+  stride = AIR_CALLOC(ansNum + 1, size_t);
+  airMopAdd(mop, stride, airFree, airMopAlways);
+  order = AIR_CALLOC(num, _gageBatchOrder);
+  airMopAdd(mop, order, airFree, airMopAlways);
+  if (!( ansPtr && ansLen && stride && order )) {
+    biffAddf(GAGE, "%s: couldn't allocate buffers", me);
+    airMopError(mop); return 1;
+  }
+  /* look up the answer pointers once, rather than per position */
+  for (ai=0; ai<ansNum; ai++) {
+    if (!( ans[ai] && pvl[ai] )) {
+      biffAddf(GAGE, "%s: got NULL ans[%u] or pvl[%u]", me, ai, ai);
+      airMopError(mop); return 1;
+    }
+    if (!gagePerVolumeIsAttached(ctx, pvl[ai])) {
+      biffAddf(GAGE, "%s: pvl[%u] not attached to context", me, ai);
+      airMopError(mop); return 1;
+    }
+    if (!( ansPtr[ai] = gageAnswerPointer(ctx, pvl[ai], item[ai]) )) {
+      biffAddf(GAGE, "%s: item[%u] %d not valid for %s kind", me,
+               ai, item[ai], pvl[ai]->kind->name);
+      airMopError(mop); return 1;
+    }
+    if (!GAGE_QUERY_ITEM_TEST(pvl[ai]->query, item[ai])) {
+      biffAddf(GAGE, "%s: item[%u] %s not in query of pvl[%u]", me,
+               ai, airEnumStr(pvl[ai]->kind->enm, item[ai]), ai);
+      airMopError(mop); return 1;
+    }
+    ansLen[ai] = gageAnswerLength(ctx, pvl[ai], item[ai]);
+    stride[ai] = (ansStride && ansStride[ai]) ? ansStride[ai] : ansLen[ai];
+  }
+
+  /* find probing order */
+  sorted = AIR_TRUE;
+  for (ii=0; ii<num; ii++) {
+    order[ii].key = _gageBatchKey(ctx, pos + posLen*ii, posLen, indexSpace);
+    order[ii].idx = ii;
+    sorted &= !ii || order[ii-1].key <= order[ii].key;
+  }
+  if (!sorted) {
+    qsort(order, num, sizeof(_gageBatchOrder), _gageBatchOrderCompare);
+  }
+
+  for (ii=0; ii<num; ii++) {
+    const double *pp;
+    size_t pi;
+    unsigned int vi;
+    int ret;
+    pi = order[ii].idx;
+    pp = pos + posLen*pi;
+    ret = _gageProbeSpace(ctx, pp[0], pp[1], pp[2],
+                          4 == posLen ? pp[3] : AIR_NAN,
+                          indexSpace, clamp);
+    if (errNum) {
+      errNum[pi] = ret ? ctx->errNum : gageErrNone;
+    }
+    for (ai=0; ai<ansNum; ai++) {
+      double *dst;
+      dst = ans[ai] + pi*stride[ai];
+      if (ret) {
+        for (vi=0; vi<ansLen[ai]; vi++) {
+          dst[vi] = AIR_NAN;
+        }
+      } else {
+        for (vi=0; vi<ansLen[ai]; vi++) {
+          dst[vi] = ansPtr[ai][vi];
+        }
+      }
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
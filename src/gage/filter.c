@@ -140,20 +140,203 @@ _gageFwDerivRenormalize(gageContext *ctx, int wch) {
   return;
 }
 
+/*
+** Specialized filter weight evaluation
+**
+** _gageFwSet() normally gets the weights for a kernel with one call to
+** its evalN_d, which, for every weight, takes the absolute value of the
+** sample location, divides by the kernel scale, and (for odd kernels)
+** remembers the sign.  For the kernels most often used with gage, and
+** at unit scale, we know all that in advance: with fractional position
+** xf in [0,1] and radius R, the sample locations set by _gageFslSet()
+** are xf+R-1, ..., xf+1, xf (all non-negative) and then xf-1, ..., xf-R
+** (all non-positive).  The macros below generate functions that compute
+** the weights straight from xf with the kernels' own formulae (copied
+** from nrrd/kernel.c and nrrd/bsplKernel.c, minus the division by a unit
+** scale), so the weights are exactly the same as from evalN_d.
+*/
+
+#define _GAGE_TENT(x) (x >= 1 ? 0 : 1 - x)
+
+#define _GAGE_BCCUBIC(x, B, C)                                \
+  (x >= 2.0 ? 0 :                                             \
+  (x >= 1.0                                                   \
+   ? (((-B/6 - C)*x + B + 5*C)*x -2*B - 8*C)*x + 4*B/3 + 4*C  \
+   : ((2 - 3*B/2 - C)*x - 3 + 2*B + C)*x*x + 1 - B/3))
+
+#define _GAGE_DBCCUBIC(x, B, C)                   \
+   (x >= 2.0 ? 0.0 :                              \
+   (x >= 1.0                                      \
+    ? ((-B/2 - 3*C)*x + 2*B + 10*C)*x -2*B - 8*C  \
+    : ((6 - 9*B/2 - 3*C)*x - 6 + 4*B + 2*C)*x))
+
+#define _GAGE_DDBCCUBIC(x, B, C)               \
+   (x >= 2.0 ? 0 :                             \
+   (x >= 1.0                                   \
+    ? (-B - 6*C)*x + 2*B + 10*C                \
+    : (12 - 9*B - 6*C)*x - 6 + 4*B + 2*C  ))
+
+#define _GAGE_BSPL3(x)                                  \
+  (x < 1                                                \
+   ? (4 + 3*(-2 + x)*x*x)/6                             \
+   : (x < 2 ? -(-2 + x)*(-2 + x)*(-2 + x)/6 : 0))
+
+#define _GAGE_DBSPL3(x)                                 \
+  (x < 1                                                \
+   ? (-4 + 3*x)*x/2                                     \
+   : (x < 2 ? -(-2 + x)*(-2 + x)/2 : 0))
+
+#define _GAGE_DDBSPL3(x)                                \
+  (x < 1 ? -2 + 3*x : (x < 2 ? 2 - x : 0))
+
+#define _GAGE_C4HEXIC(x) \
+  (x >= 3.0 \
+   ? 0 \
+   : (x >= 2.0 \
+      ? 1539.0/160.0 + x*(-189.0/8.0 + x*(747.0/32.0 + x*(-12.0 + x*(109.0/32.0 + x*(-61.0/120.0 + x/32.0))))) \
+      : (x >= 1.0 \
+         ? 3.0/160.0 + x*(35.0/8.0 + x*(-341.0/32.0 + x*(10.0 + x*(-147.0/32.0 + x*(25.0/24.0 - x*3.0/32.0))))) \
+         : 69.0/80.0 + x*x*(-23.0/16.0 + x*x*(19.0/16.0 + x*(-7.0/12.0 + x/16.0)))  )))
+
+#define _GAGE_DC4HEXIC(x) \
+  (x >= 3.0 \
+   ? 0 \
+   : (x >= 2.0 \
+      ? -189.0/8.0 + x*(747.0/16.0 + x*(-36.0 + x*(109.0/8.0 + x*(-61.0/24.0 + x*(3.0/16.0))))) \
+      : (x >= 1.0 \
+         ? 35.0/8.0 + x*(-341.0/16.0 + x*(30 + x*(-147.0/8.0 + x*(125.0/24.0 + x*(-9.0/16.0))))) \
+         : x*(-23.0/8.0 + x*x*(19.0/4.0 + x*(-35.0/12.0 + x*(3.0/8.0))))  )))
+
+#define _GAGE_DDC4HEXIC(x) \
+  (x >= 3.0 \
+   ? 0 \
+   : (x >= 2.0 \
+      ? 747.0/16.0 + x*(-72.0 + x*(327.0/8.0 + x*(-61.0/6.0 + x*15.0/16.0))) \
+      : (x >= 1.0 \
+         ? -341.0/16.0 + x*(60 + x*(-441.0/8.0 + x*(125.0/6.0 - x*45.0/16.0))) \
+         : -23.0/8.0 + x*x*(57.0/4.0 + x*(-35.0/3.0 + x*(15.0/8.0)))  )))
+
+/*
+** ODD: the kernel is odd, so the weights at negative sample locations
+** are negated, just as evalN_d would (its sign is positive at zero).
+** DECL: declarations of any kernel parameters used by EVAL
+*/
+#define _GAGE_FW_FAST(NAME, ODD, DECL, EVAL)                            \
+static void                                                             \
+NAME(double *fw, const double *frac, unsigned int radius,               \
+     const double *parm) {                                              \
+  unsigned int ai, ii, fd;                                              \
+  double xf, t;                                                         \
+  DECL                                                                  \
+                                                                        \
+  AIR_UNUSED(parm);                                                     \
+  fd = 2*radius;                                                        \
+  for (ai=0; ai<3; ai++) {                                              \
+    xf = frac[ai];                                                      \
+    for (ii=0; ii<radius; ii++) {                                       \
+      t = xf + (radius - 1 - ii);                                       \
+      fw[ii] = EVAL(t);                                                 \
+    }                                                                   \
+    for (ii=radius; ii<fd; ii++) {                                      \
+      t = (ii - radius + 1) - xf;                                       \
+      fw[ii] = (ODD && t > 0) ? -EVAL(t) : EVAL(t);                     \
+    }                                                                   \
+    fw += fd;                                                           \
+  }                                                                     \
+}
+
+#define _GAGE_NO_DECL
+#define _GAGE_BC_DECL double B = parm[1], C = parm[2];
+#define _GAGE_BC(x) _GAGE_BCCUBIC(x, B, C)
+#define _GAGE_DBC(x) _GAGE_DBCCUBIC(x, B, C)
+#define _GAGE_DDBC(x) _GAGE_DDBCCUBIC(x, B, C)
+
+_GAGE_FW_FAST(_gageFwTent, 0, _GAGE_NO_DECL, _GAGE_TENT)
+_GAGE_FW_FAST(_gageFwBC, 0, _GAGE_BC_DECL, _GAGE_BC)
+_GAGE_FW_FAST(_gageFwDBC, 1, _GAGE_BC_DECL, _GAGE_DBC)
+_GAGE_FW_FAST(_gageFwDDBC, 0, _GAGE_BC_DECL, _GAGE_DDBC)
+_GAGE_FW_FAST(_gageFwBspl3, 0, _GAGE_NO_DECL, _GAGE_BSPL3)
+_GAGE_FW_FAST(_gageFwDBspl3, 1, _GAGE_NO_DECL, _GAGE_DBSPL3)
+_GAGE_FW_FAST(_gageFwDDBspl3, 0, _GAGE_NO_DECL, _GAGE_DDBSPL3)
+_GAGE_FW_FAST(_gageFwC4hexic, 0, _GAGE_NO_DECL, _GAGE_C4HEXIC)
+_GAGE_FW_FAST(_gageFwDC4hexic, 1, _GAGE_NO_DECL, _GAGE_DC4HEXIC)
+_GAGE_FW_FAST(_gageFwDDC4hexic, 0, _GAGE_NO_DECL, _GAGE_DDC4HEXIC)
+
+/*
+** _gageFwFastUpdate
+**
+** ctx's ksp[] --> fwFast[]
+**
+** called by gageUpdate() whenever the kernels may have changed
+*/
+void
+_gageFwFastUpdate(gageContext *ctx) {
+  static const char me[]="_gageFwFastUpdate";
+  const NrrdKernel *kern;
+  int kidx, unitScale;
+
+  for (kidx=gageKernelUnknown+1; kidx<gageKernelLast; kidx++) {
+    ctx->fwFast[kidx] = NULL;
+    if (!ctx->ksp[kidx] || kidx==gageKernelStack) {
+      continue;
+    }
+    kern = ctx->ksp[kidx]->kernel;
+    /* for the kernels with a scale parameter, it is parm[0] */
+    unitScale = (1.0 == ctx->ksp[kidx]->parm[0]);
+    if (nrrdKernelTent == kern && unitScale) {
+      ctx->fwFast[kidx] = _gageFwTent;
+    } else if (nrrdKernelBCCubic == kern && unitScale) {
+      ctx->fwFast[kidx] = _gageFwBC;
+    } else if (nrrdKernelBCCubicD == kern && unitScale) {
+      ctx->fwFast[kidx] = _gageFwDBC;
+    } else if (nrrdKernelBCCubicDD == kern && unitScale) {
+      ctx->fwFast[kidx] = _gageFwDDBC;
+    } else if (nrrdKernelBSpline3 == kern) {
+      ctx->fwFast[kidx] = _gageFwBspl3;
+    } else if (nrrdKernelBSpline3D == kern) {
+      ctx->fwFast[kidx] = _gageFwDBspl3;
+    } else if (nrrdKernelBSpline3DD == kern) {
+      ctx->fwFast[kidx] = _gageFwDDBspl3;
+    } else if (nrrdKernelC4Hexic == kern) {
+      ctx->fwFast[kidx] = _gageFwC4hexic;
+    } else if (nrrdKernelC4HexicD == kern) {
+      ctx->fwFast[kidx] = _gageFwDC4hexic;
+    } else if (nrrdKernelC4HexicDD == kern) {
+      ctx->fwFast[kidx] = _gageFwDDC4hexic;
+    }
+    if (ctx->verbose) {
+      fprintf(stderr, "%s: k[%s]=%s: %s weights\n", me,
+              airEnumStr(gageKernel, kidx), kern->name,
+              ctx->fwFast[kidx] ? "specialized" : "evalN_d");
+    }
+  }
+  return;
+}
+
 void
 _gageFwSet(gageContext *ctx, unsigned int sidx, double sfrac) {
   char me[]="_gageFwSet";
-  int kidx;
+  int kidx, fast;
   unsigned int fd;
 
   fd = 2*ctx->radius;
+  /* the specialized weights rely on the fractional position being in
+     [0,1], which it should always be */
+  fast = (AIR_IN_CL(0, ctx->point.frac[0], 1)
+          && AIR_IN_CL(0, ctx->point.frac[1], 1)
+          && AIR_IN_CL(0, ctx->point.frac[2], 1));
   for (kidx=gageKernelUnknown+1; kidx<gageKernelLast; kidx++) {
     if (!ctx->needK[kidx] || kidx==gageKernelStack) {
       continue;
     }
-    /* we evaluate weights for all three axes with one call */
-    ctx->ksp[kidx]->kernel->evalN_d(ctx->fw + fd*3*kidx, ctx->fsl,
-                                    fd*3, ctx->ksp[kidx]->parm);
+    if (fast && ctx->fwFast[kidx]) {
+      ctx->fwFast[kidx](ctx->fw + fd*3*kidx, ctx->point.frac,
+                        ctx->radius, ctx->ksp[kidx]->parm);
+    } else {
+      /* we evaluate weights for all three axes with one call */
+      ctx->ksp[kidx]->kernel->evalN_d(ctx->fw + fd*3*kidx, ctx->fsl,
+                                      fd*3, ctx->ksp[kidx]->parm);
+    }
   }
 
   if (ctx->verbose > 2) {
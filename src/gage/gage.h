@@ -768,6 +768,13 @@ typedef struct gageContext_t {
      fd x 3 x GAGE_KERNEL_MAX+1 (fast-to-slow) array */
   double *fw;
 
+  /* for each kernel, either NULL, or a function (chosen by gageUpdate)
+     that computes the same filter weights as the kernel's evalN_d, but
+     more quickly, given the fractional probe position and radius */
+  void (*fwFast[GAGE_KERNEL_MAX+1])(double *fw, const double *frac,
+                                    unsigned int radius,
+                                    const double *parm);
+
   /* offsets to other fd^3 samples needed to fill 3D intermediate
      value cache. Allocated size is dependent on kernels, values
      inside are dependent on the dimensions of the volume. It may be
@@ -1049,6 +1056,39 @@ typedef struct {
   double finalErr;         /* error of converged points */
 } gageOptimSigContext;
 
+/*
+******** gageProbePool struct
+**
+** for probing many positions with multiple threads: a gageContext holds
+** state (the iv3 caches, filter weights, answers) that changes with
+** every probe, so each thread needs its own copy.  The pool owns those
+** copies, and hands out chunks of positions to threads as they finish
+** the previous chunk.  The pool must be created after gageUpdate() on
+** the context, and the context (or anything attached to it) should not
+** be changed while the pool exists.
+*/
+typedef struct {
+  /* INPUT ------------------------- */
+  gageContext *ctx;        /* context that was copied for each thread;
+                              (the first thread probes with ctx itself) */
+  unsigned int threadNum;  /* number of threads */
+  size_t chunkSize;        /* number of positions a thread takes at once */
+  double edgeFracMax,      /* if not NaN, and ctx->edgeFrac exceeds this
+                              after a probe, then ... */
+    edgeFracVal;           /* ... this value is saved instead of answer */
+  int scaleIsTau;          /* with the scale-space stack, the 4th position
+                              coordinate is tau, rather than sigma */
+  /* INTERNAL ------------------------- */
+  gageContext **tctx;      /* threadNum contexts, tctx[0] == ctx */
+  airThread **thread;      /* threadNum threads */
+  airThreadMutex *mutex;   /* for claiming chunks; only if threadNum > 1 */
+  /* OUTPUT ------------------------- */
+  size_t failNum,          /* number of probes that failed */
+    failIdx;               /* index of first (lowest index) failed probe */
+  int failErrNum;          /* errNum of probe at failIdx */
+  double time;             /* seconds taken by last probing */
+} gageProbePool;
+
 /* defaultsGage.c */
 GAGE_EXPORT const char *gageBiffKey;
 GAGE_EXPORT int gageDefVerbose;
@@ -1300,6 +1340,30 @@ GAGE_EXPORT void gageKernelReset(gageContext *ctx);
 GAGE_EXPORT int gageProbe(gageContext *ctx, double xi, double yi, double zi);
 GAGE_EXPORT int gageProbeSpace(gageContext *ctx, double x, double y, double z,
                                int indexSpace, int clamp);
+GAGE_EXPORT int gageProbeBatch(gageContext *ctx, double *const *ans,
+                               const size_t *ansStride,
+                               const gagePerVolume *const *pvl,
+                               const int *item, unsigned int ansNum,
+                               int *errNum,
+                               const double *pos, unsigned int posLen,
+                               size_t num, int indexSpace, int clamp);
+
+/* pool.c */
+GAGE_EXPORT gageProbePool *gageProbePoolNew(gageContext *ctx,
+                                            unsigned int threadNum);
+GAGE_EXPORT gageProbePool *gageProbePoolNix(gageProbePool *pool);
+GAGE_EXPORT int gageProbePoolPos(gageProbePool *pool, Nrrd *nout,
+                                 int typeOut,
+                                 const gagePerVolume *pvl, int item,
+                                 const double *pos, unsigned int posLen,
+                                 size_t num, int indexSpace, int clamp);
+GAGE_EXPORT int gageProbePoolGrid(gageProbePool *pool, Nrrd *nout,
+                                  int typeOut,
+                                  const gagePerVolume *pvl, int item,
+                                  const double *orig, const double *edge,
+                                  const size_t *size, unsigned int gridDim,
+                                  unsigned int posLen,
+                                  int indexSpace, int clamp);
 
 /* update.c */
 GAGE_EXPORT int gageUpdate(gageContext *ctx);
@@ -0,0 +1,482 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "gage.h"
+#include "privateGage.h"
+
+/*
+** everything about one call to gageProbePoolPos or gageProbePoolGrid,
+** shared (read-only, except for the "next" position) by all threads
+*/
+typedef struct {
+  gageProbePool *pool;
+  unsigned int pvlIdx,      /* index into ctx->pvl of pvl of interest */
+    ansLen, posLen, gridDim;
+  int item, indexSpace, clamp;
+  void *data;               /* output data */
+  double (*ins)(void *v, size_t I, double d);
+  const double *pos,        /* position list, or ... */
+    *orig, *edge;           /* ... grid origin and edge vectors */
+  const size_t *size;       /* grid size */
+  size_t num,               /* total number of positions */
+    next;                   /* next position not yet claimed by a thread */
+} _gageProbePoolJob;
+
+typedef struct {
+  _gageProbePoolJob *job;
+  gageContext *gctx;        /* this thread's context */
+  size_t failNum, failIdx;  /* this thread's failures */
+  int failErrNum;
+} _gageProbePoolTask;
+
+/*
+******** gageProbePoolNew
+**
+** makes a pool of threadNum contexts for probing with threadNum
+** threads.  ctx should be ready for probing (via gageUpdate); the pool
+** is made from copies of it.
+*/
+gageProbePool * /*Teem: biff if (!ret) */
+gageProbePoolNew(gageContext *ctx, unsigned int threadNum) {
+  static const char me[]="gageProbePoolNew";
+  gageProbePool *pool;
+  unsigned int ti;
+
+  if (!ctx) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return NULL;
+  }
+  if (!threadNum) {
+    biffAddf(GAGE, "%s: need threadNum >= 1", me);
+    return NULL;
+  }
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
+  pool = AIR_CALLOC(1, gageProbePool);
+  if (!pool) {
+    biffAddf(GAGE, "%s: couldn't allocate pool", me);
+    return NULL;
+  }
+  pool->ctx = ctx;
+  pool->threadNum = threadNum;
+  /* big enough to make claiming chunks rare, small enough to keep the
+     threads equally busy until the end */
+  pool->chunkSize = 256;
+  pool->edgeFracMax = AIR_NAN;
+  pool->edgeFracVal = AIR_NAN;
+  pool->scaleIsTau = AIR_FALSE;
+  pool->tctx = AIR_CALLOC(threadNum, gageContext *);
+  pool->thread = AIR_CALLOC(threadNum, airThread *);
+  if (!( pool->tctx && pool->thread )) {
+    biffAddf(GAGE, "%s: couldn't allocate %u contexts and threads", me,
+             threadNum);
+    return gageProbePoolNix(pool);
+  }
+  pool->tctx[0] = ctx;
+  for (ti=1; ti<threadNum; ti++) {
+    if (!( pool->tctx[ti] = gageContextCopy(ctx) )) {
+      biffAddf(GAGE, "%s: couldn't copy context for thread %u", me, ti);
+      return gageProbePoolNix(pool);
+    }
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    pool->thread[ti] = airThreadNew();
+  }
+  pool->mutex = threadNum > 1 ? airThreadMutexNew() : NULL;
+  pool->failNum = 0;
+  pool->failIdx = 0;
+  pool->failErrNum = gageErrNone;
+  pool->time = 0;
+  return pool;
+}
+
+gageProbePool * /*Teem: no error */
+gageProbePoolNix(gageProbePool *pool) {
+  unsigned int ti;
+
+  if (pool) {
+    if (pool->tctx) {
+      /* tctx[0] is the caller's context */
+      for (ti=1; ti<pool->threadNum; ti++) {
+        gageContextNix(pool->tctx[ti]);
+      }
+      airFree(pool->tctx);
+    }
+    if (pool->thread) {
+      for (ti=0; ti<pool->threadNum; ti++) {
+        airThreadNix(pool->thread[ti]);
+      }
+      airFree(pool->thread);
+    }
+    airThreadMutexNix(pool->mutex);
+    airFree(pool);
+  }
+  return NULL;
+}
+
+static void *
+_gageProbePoolWorker(void *_task) {
+  _gageProbePoolTask *task;
+  _gageProbePoolJob *job;
+  gageProbePool *pool;
+  gageContext *gctx;
+  const double *answer;
+  double ppos[4];
+  size_t lo, hi, ii, coord[NRRD_DIM_MAX];
+  unsigned int ai, vi, stride;
+  int ret;
+
+  task = AIR_CAST(_gageProbePoolTask *, _task);
+  job = task->job;
+  pool = job->pool;
+  gctx = task->gctx;
+  answer = gageAnswerPointer(gctx, gctx->pvl[job->pvlIdx], job->item);
+  stride = job->posLen;
+  ppos[3] = AIR_NAN;
+  while (1) {
+    /* claim the next chunk of positions */
+    if (pool->mutex) {
+      airThreadMutexLock(pool->mutex);
+    }
+    lo = job->next;
+    job->next = AIR_MIN(job->num, lo + pool->chunkSize);
+    hi = job->next;
+    if (pool->mutex) {
+      airThreadMutexUnlock(pool->mutex);
+    }
+    if (lo == hi) {
+      break;
+    }
+    if (job->pos) {
+      memcpy(ppos, job->pos + stride*lo, stride*sizeof(double));
+    } else {
+      /* coordinates of position lo in grid */
+      ii = lo;
+      for (ai=0; ai<job->gridDim; ai++) {
+        coord[ai] = ii % job->size[ai];
+        ii /= job->size[ai];
+      }
+    }
+    for (ii=lo; ii<hi; ii++) {
+      if (job->pos) {
+        if (ii > lo) {
+          memcpy(ppos, job->pos + stride*ii, stride*sizeof(double));
+        }
+      } else {
+        /* summing in the same order as gprobe's original gridProbe */
+        for (vi=0; vi<stride; vi++) {
+          ppos[vi] = job->orig[vi];
+        }
+        for (ai=0; ai<job->gridDim; ai++) {
+          for (vi=0; vi<stride; vi++) {
+            ppos[vi] += AIR_CAST(double, coord[ai])*job->edge[vi + stride*ai];
+          }
+        }
+        NRRD_COORD_INCR(coord, job->size, job->gridDim, 0);
+      }
+      if (4 == stride && pool->scaleIsTau) {
+        ppos[3] = airSigmaOfTau(ppos[3]);
+      }
+      ret = _gageProbeSpace(gctx, ppos[0], ppos[1], ppos[2],
+                            4 == stride ? ppos[3] : AIR_NAN,
+                            job->indexSpace, job->clamp);
+      if (ret) {
+        if (!task->failNum || ii < task->failIdx) {
+          task->failIdx = ii;
+          task->failErrNum = gctx->errNum;
+        }
+        task->failNum++;
+        for (vi=0; vi<job->ansLen; vi++) {
+          job->ins(job->data, vi + job->ansLen*ii, AIR_NAN);
+        }
+      } else if (gctx->edgeFrac > pool->edgeFracMax) {
+        /* (never true if edgeFracMax is NaN) */
+        for (vi=0; vi<job->ansLen; vi++) {
+          job->ins(job->data, vi + job->ansLen*ii, pool->edgeFracVal);
+        }
+      } else {
+        for (vi=0; vi<job->ansLen; vi++) {
+          job->ins(job->data, vi + job->ansLen*ii, answer[vi]);
+        }
+      }
+    }
+  }
+  return _task;
+}
+
+/*
+** runs the job (already set up, except for data and ins) on all the
+** threads in the pool, and records the results
+*/
+static int
+_gageProbePoolRun(_gageProbePoolJob *job, Nrrd *nout) {
+  static const char me[]="_gageProbePoolRun";
+  gageProbePool *pool;
+  _gageProbePoolTask *task;
+  unsigned int ti;
+  double time0;
+  char stmp[2][AIR_STRLEN_SMALL];
+
+  pool = job->pool;
+  if (!( 3 == job->posLen || 4 == job->posLen )) {
+    biffAddf(GAGE, "%s: posLen %u not 3 or 4", me, job->posLen);
+    return 1;
+  }
+  if (4 == job->posLen && !pool->ctx->parm.stackUse) {
+    biffAddf(GAGE, "%s: can't probe stack (posLen 4) without "
+             "parm.stackUse", me);
+    return 1;
+  }
+  if (!GAGE_QUERY_ITEM_TEST(pool->ctx->pvl[job->pvlIdx]->query, job->item)) {
+    biffAddf(GAGE, "%s: item %s not in query", me,
+             airEnumStr(pool->ctx->pvl[job->pvlIdx]->kind->enm, job->item));
+    return 1;
+  }
+  if (!pool->chunkSize) {
+    biffAddf(GAGE, "%s: chunkSize can't be 0", me);
+    return 1;
+  }
+  task = AIR_CALLOC(pool->threadNum, _gageProbePoolTask);
+  if (!task) {
+    biffAddf(GAGE, "%s: couldn't allocate tasks", me);
+    return 1;
+  }
+  job->data = nout->data;
+  job->ins = nrrdDInsert[nout->type];
+  job->next = 0;
+  for (ti=0; ti<pool->threadNum; ti++) {
+    task[ti].job = job;
+    task[ti].gctx = pool->tctx[ti];
+    task[ti].failNum = 0;
+    task[ti].failIdx = 0;
+    task[ti].failErrNum = gageErrNone;
+  }
+  time0 = airTime();
+  if (1 == pool->threadNum) {
+    _gageProbePoolWorker(task + 0);
+  } else {
+    int ret, E;
+    for (ti=0; ti<pool->threadNum; ti++) {
+      if ((ret = airThreadStart(pool->thread[ti], _gageProbePoolWorker,
+                                AIR_VOIDP(task + ti)))) {
+        biffAddf(GAGE, "%s: thread %u failed to start: %d", me, ti, ret);
+        /* claim all remaining work, and wait for the threads that did
+           start, so that they are done with job and task */
+        airThreadMutexLock(pool->mutex);
+        job->next = job->num;
+        airThreadMutexUnlock(pool->mutex);
+        while (ti) {
+          airThreadJoin(pool->thread[--ti], NULL);
+        }
+        airFree(task);
+        return 1;
+      }
+    }
+    E = 0;
+    for (ti=0; ti<pool->threadNum; ti++) {
+      if ((ret = airThreadJoin(pool->thread[ti], NULL))) {
+        biffAddf(GAGE, "%s: thread %u failed to join: %d", me, ti, ret);
+        E = 1;
+      }
+    }
+    if (E) {
+      airFree(task);
+      return 1;
+    }
+  }
+  pool->time = airTime() - time0;
+  pool->failNum = 0;
+  pool->failIdx = 0;
+  pool->failErrNum = gageErrNone;
+  for (ti=0; ti<pool->threadNum; ti++) {
+    if (task[ti].failNum
+        && (!pool->failNum || task[ti].failIdx < pool->failIdx)) {
+      pool->failIdx = task[ti].failIdx;
+      pool->failErrNum = task[ti].failErrNum;
+    }
+    pool->failNum += task[ti].failNum;
+  }
+  if (pool->ctx->verbose) {
+    fprintf(stderr, "%s: %s probes with %u threads in %g sec; %s failed\n",
+            me, airSprintSize_t(stmp[0], job->num), pool->threadNum,
+            pool->time, airSprintSize_t(stmp[1], pool->failNum));
+  }
+  airFree(task);
+  return 0;
+}
+
+/*
+** finds the index of pvl in ctx->pvl
+*/
+static int
+_gageProbePoolPvlIdx(unsigned int *pvlIdx, const gageContext *ctx,
+                     const gagePerVolume *pvl) {
+  static const char me[]="_gageProbePoolPvlIdx";
+  unsigned int pi;
+
+  for (pi=0; pi<ctx->pvlNum; pi++) {
+    if (pvl == ctx->pvl[pi]) {
+      break;
+    }
+  }
+  if (pi == ctx->pvlNum) {
+    biffAddf(GAGE, "%s: given pvl not attached to context", me);
+    return 1;
+  }
+  *pvlIdx = pi;
+  return 0;
+}
+
+/*
+******** gageProbePoolPos
+**
+** probes item of pvl (attached to pool->ctx) at the num positions in
+** pos, which has posLen (3, or 4 with the scale-space stack) values
+** per position, with the same indexSpace and clamp semantics as
+** gageProbeSpace().  The answers are saved in nout, which will be 2-D
+** answer-length by num, of type typeOut.  Failed probes (recorded in
+** pool->failNum, failIdx, failErrNum) don't cause a biff error; their
+** answers are saved as NaN.
+*/
+int /*Teem: biff if (ret) */
+gageProbePoolPos(gageProbePool *pool, Nrrd *nout, int typeOut,
+                 const gagePerVolume *pvl, int item,
+                 const double *pos, unsigned int posLen, size_t num,
+                 int indexSpace, int clamp) {
+  static const char me[]="gageProbePoolPos";
+  _gageProbePoolJob job;
+
+  if (!( pool && nout && pvl && pos )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (airEnumValCheck(nrrdType, typeOut) || nrrdTypeBlock == typeOut) {
+    biffAddf(GAGE, "%s: type %d not valid", me, typeOut);
+    return 1;
+  }
+  if (airEnumValCheck(pvl->kind->enm, item)) {
+    biffAddf(GAGE, "%s: item %d not valid for %s kind", me, item,
+             pvl->kind->name);
+    return 1;
+  }
+  job.pool = pool;
+  if (_gageProbePoolPvlIdx(&job.pvlIdx, pool->ctx, pvl)) {
+    biffAddf(GAGE, "%s: problem", me);
+    return 1;
+  }
+  job.ansLen = gageAnswerLength(pool->ctx, pvl, item);
+  job.posLen = posLen;
+  job.gridDim = 0;
+  job.item = item;
+  job.indexSpace = indexSpace;
+  job.clamp = clamp;
+  job.pos = pos;
+  job.orig = job.edge = NULL;
+  job.size = NULL;
+  job.num = num;
+  if (nrrdMaybeAlloc_va(nout, typeOut, 2, AIR_CAST(size_t, job.ansLen),
+                        num)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  if (_gageProbePoolRun(&job, nout)) {
+    biffAddf(GAGE, "%s: problem probing", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** gageProbePoolGrid
+**
+** like gageProbePoolPos, but probes on a gridDim-dimensional grid of
+** size[0] by size[1] ..., with the (posLen-vector) position at grid
+** coordinates (c0, c1, ...) being orig + c0*edge[0] + c1*edge[1] ...,
+** where edge[i] starts at edge + posLen*i.  The output is gridDim-D
+** (for scalar answers), or (1+gridDim)-D with the answer on the
+** fastest axis.
+*/
+int /*Teem: biff if (ret) */
+gageProbePoolGrid(gageProbePool *pool, Nrrd *nout, int typeOut,
+                  const gagePerVolume *pvl, int item,
+                  const double *orig, const double *edge,
+                  const size_t *size, unsigned int gridDim,
+                  unsigned int posLen, int indexSpace, int clamp) {
+  static const char me[]="gageProbePoolGrid";
+  _gageProbePoolJob job;
+  size_t sizeOut[NRRD_DIM_MAX];
+  unsigned int ai, baseDim;
+
+  if (!( pool && nout && pvl && orig && edge && size )) {
+    biffAddf(GAGE, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (airEnumValCheck(nrrdType, typeOut) || nrrdTypeBlock == typeOut) {
+    biffAddf(GAGE, "%s: type %d not valid", me, typeOut);
+    return 1;
+  }
+  if (airEnumValCheck(pvl->kind->enm, item)) {
+    biffAddf(GAGE, "%s: item %d not valid for %s kind", me, item,
+             pvl->kind->name);
+    return 1;
+  }
+  job.pool = pool;
+  if (_gageProbePoolPvlIdx(&job.pvlIdx, pool->ctx, pvl)) {
+    biffAddf(GAGE, "%s: problem", me);
+    return 1;
+  }
+  job.ansLen = gageAnswerLength(pool->ctx, pvl, item);
+  baseDim = 1 == job.ansLen ? 0 : 1;
+  if (!( gridDim && baseDim + gridDim <= NRRD_DIM_MAX )) {
+    biffAddf(GAGE, "%s: grid dimension %u (+ %u) not in [1,%u]", me,
+             gridDim, baseDim, NRRD_DIM_MAX);
+    return 1;
+  }
+  sizeOut[0] = job.ansLen;
+  job.num = 1;
+  for (ai=0; ai<gridDim; ai++) {
+    sizeOut[baseDim + ai] = size[ai];
+    job.num *= size[ai];
+  }
+  job.posLen = posLen;
+  job.gridDim = gridDim;
+  job.item = item;
+  job.indexSpace = indexSpace;
+  job.clamp = clamp;
+  job.pos = NULL;
+  job.orig = orig;
+  job.edge = edge;
+  job.size = size;
+  if (nrrdMaybeAlloc_nva(nout, typeOut, baseDim + gridDim, sizeOut)) {
+    biffMovef(GAGE, NRRD, "%s: couldn't allocate output", me);
+    return 1;
+  }
+  if (_gageProbePoolRun(&job, nout)) {
+    biffAddf(GAGE, "%s: problem probing", me);
+    return 1;
+  }
+  return 0;
+}
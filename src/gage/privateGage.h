@@ -59,6 +59,7 @@ extern void _gagePrint_off(FILE *, gageContext *ctx);
 extern void _gagePrint_fslw(FILE *, gageContext *ctx);
 
 /* filter.c */
+extern void _gageFwFastUpdate(gageContext *ctx);
 extern int _gageLocationSet(gageContext *ctx,
                             double x, double y, double z, double s);
 
@@ -0,0 +1,109 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*********** LIKE scl3pfilterbody.c, THIS ISN'T REALLY A SOURCE FILE !!!
+ *********** ITS JUST A MACRO, included with fd #define'd */
+
+  /* unlike scl3pfilterbody.c, which makes one pass over ivX (and over
+     ivY) for each derivative, here each scanline is read once and
+     filtered with all the needed kernels together, with separate
+     caches for the intermediate results of each:
+
+     ivY<x>: 2D caches of results along X with kernel <x>
+     ivZ<x><y>: 1D caches of results along X with <x>, then Y with <y>
+  */
+  double ivY0[fd*fd], ivY1[fd*fd], ivY2[fd*fd],
+    ivZ00[fd], ivZ01[fd], ivZ02[fd], ivZ10[fd], ivZ11[fd], ivZ20[fd],
+    T, *iv;
+  unsigned int i, j;
+  int doV, doD1, doD2;
+  doV = needD[0];
+  doD1 = needD[1];
+  doD2 = needD[2];
+
+#define DOT_F(ANS, a, b) \
+  for (T=(a)[0]*(b)[0],i=1; i<fd; i++) { T += (a)[i]*(b)[i]; } \
+  ANS = T
+
+  /* x0, x1, and (if needed) x2 */
+  if (doD2) {
+    for (j=0; j<fd*fd; j++) {
+      iv = ivX + j*fd;
+      DOT_F(ivY0[j], fw0 + X*fd, iv);
+      DOT_F(ivY1[j], fw1 + X*fd, iv);
+      DOT_F(ivY2[j], fw2 + X*fd, iv);
+    }
+  } else {
+    for (j=0; j<fd*fd; j++) {
+      iv = ivX + j*fd;
+      DOT_F(ivY0[j], fw0 + X*fd, iv);
+      DOT_F(ivY1[j], fw1 + X*fd, iv);
+    }
+  }
+  /* x0y0, x0y1, and (if needed) x0y2, x1y0, x1y1, x2y0 */
+  if (doD2) {
+    for (j=0; j<fd; j++) {
+      iv = ivY0 + j*fd;
+      DOT_F(ivZ00[j], fw0 + Y*fd, iv);
+      DOT_F(ivZ01[j], fw1 + Y*fd, iv);
+      DOT_F(ivZ02[j], fw2 + Y*fd, iv);
+      iv = ivY1 + j*fd;
+      DOT_F(ivZ10[j], fw0 + Y*fd, iv);
+      DOT_F(ivZ11[j], fw1 + Y*fd, iv);
+      iv = ivY2 + j*fd;
+      DOT_F(ivZ20[j], fw0 + Y*fd, iv);
+    }
+  } else {
+    for (j=0; j<fd; j++) {
+      iv = ivY0 + j*fd;
+      DOT_F(ivZ00[j], fw0 + Y*fd, iv);
+      DOT_F(ivZ01[j], fw1 + Y*fd, iv);
+      iv = ivY1 + j*fd;
+      DOT_F(ivZ10[j], fw0 + Y*fd, iv);
+    }
+  }
+  if (doV) {
+    DOT_F(*val, fw0 + Z*fd, ivZ00);             /* f */
+  }
+  if (doD1) {
+    DOT_F(gvec[2], fw1 + Z*fd, ivZ00);          /* g_z */
+    DOT_F(gvec[1], fw0 + Z*fd, ivZ01);          /* g_y */
+    DOT_F(gvec[0], fw0 + Z*fd, ivZ10);          /* g_x */
+  }
+  ell_3mv_mul_d(gvec, shape->ItoWSubInvTransp, gvec);
+  if (doD2) {
+    double matA[9];
+    DOT_F(hess[8], fw2 + Z*fd, ivZ00);          /* h_zz */
+    DOT_F(hess[5], fw1 + Z*fd, ivZ01);          /* h_yz */
+    hess[7] = hess[5];
+    DOT_F(hess[4], fw0 + Z*fd, ivZ02);          /* h_yy */
+    DOT_F(hess[2], fw1 + Z*fd, ivZ10);          /* h_xz */
+    hess[6] = hess[2];
+    DOT_F(hess[1], fw0 + Z*fd, ivZ11);          /* h_xy */
+    hess[3] = hess[1];
+    DOT_F(hess[0], fw0 + Z*fd, ivZ20);          /* h_xx */
+    ELL_3M_MUL(matA, shape->ItoWSubInvTransp, hess);
+    ELL_3M_MUL(hess, matA, shape->ItoWSubInv);
+  }
+
+#undef DOT_F
@@ -389,6 +389,49 @@ gageScl3PFilterN(gageShape *shape, int fd,
   return;
 }
 
+/*
+** _gageScl3PFused2, 4, 6, 8: for when derivatives are needed, the same
+** filtering as gageScl3PFilter2, 4, 6, 8, but with one pass over the
+** iv3 instead of one pass per derivative (see scl3pfusedbody.c), and a
+** compile-time fd.  Each dot-product is summed in the same order, so
+** the results are the same.  These need their own intermediate caches,
+** so they don't use the pvl's iv2 and iv1
+*/
+#define _GAGE_SCL3PFUSED(NAME)                                          \
+static void                                                             \
+NAME(gageShape *shape, double *ivX,                                     \
+     double *fw0, double *fw1, double *fw2,                             \
+     double *val, double *gvec, double *hess,                           \
+     const int *needD)
+
+#define fd 2
+_GAGE_SCL3PFUSED(_gageScl3PFused2) {
+#include "scl3pfusedbody.c"
+  return;
+}
+#undef fd
+
+#define fd 4
+_GAGE_SCL3PFUSED(_gageScl3PFused4) {
+#include "scl3pfusedbody.c"
+  return;
+}
+#undef fd
+
+#define fd 6
+_GAGE_SCL3PFUSED(_gageScl3PFused6) {
+#include "scl3pfusedbody.c"
+  return;
+}
+#undef fd
+
+#define fd 8
+_GAGE_SCL3PFUSED(_gageScl3PFused8) {
+#include "scl3pfusedbody.c"
+  return;
+}
+#undef fd
+
 void
 _gageSclFilter(gageContext *ctx, gagePerVolume *pvl) {
   char me[]="_gageSclFilter";
@@ -396,6 +439,10 @@ _gageSclFilter(gageContext *ctx, gagePerVolume *pvl) {
   double *fw00, *fw11, *fw22;
   gageScl3PFilter_t *filter[5] = {NULL, gageScl3PFilter2, gageScl3PFilter4,
                                   gageScl3PFilter6, gageScl3PFilter8};
+  void (*fused[5])(gageShape *, double *, double *, double *, double *,
+                   double *, double *, double *, const int *) = {
+    NULL, _gageScl3PFused2, _gageScl3PFused4,
+    _gageScl3PFused6, _gageScl3PFused8};
 
   fd = 2*ctx->radius;
   if (!ctx->parm.k3pack) {
@@ -406,7 +453,13 @@ _gageSclFilter(gageContext *ctx, gagePerVolume *pvl) {
   fw11 = ctx->fw + fd*3*gageKernel11;
   fw22 = ctx->fw + fd*3*gageKernel22;
   /* perform the filtering */
-  if (fd <= 8) {
+  if (fd <= 8 && (pvl->needD[1] || pvl->needD[2])) {
+    fused[ctx->radius](ctx->shape, pvl->iv3, fw00, fw11, fw22,
+                       pvl->directAnswer[gageSclValue],
+                       pvl->directAnswer[gageSclGradVec],
+                       pvl->directAnswer[gageSclHessian],
+                       pvl->needD);
+  } else if (fd <= 8) {
     filter[ctx->radius](ctx->shape, pvl->iv3, pvl->iv2, pvl->iv1,
                         fw00, fw11, fw22,
                         pvl->directAnswer[gageSclValue],
@@ -394,6 +394,7 @@ gageUpdate(gageContext *ctx) {
     if (_gageRadiusUpdate(ctx)) {
       biffAddf(GAGE, "%s: trouble", me); return 1;
     }
+    _gageFwFastUpdate(ctx);
     ctx->flag[gageCtxFlagKernel] = AIR_FALSE;
     ctx->flag[gageCtxFlagNeedK] = AIR_FALSE;
   }
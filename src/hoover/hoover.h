@@ -89,6 +89,22 @@ typedef int (hooverThreadEnd_t)(void *thread,
                                 void *user);
 typedef int (hooverRenderEnd_t)(void *rend, void *user);
 
+/*
+******** hooverThreadStats struct
+**
+** What one thread did during the last call to hooverRender(), which
+** sets these; they are output only.
+*/
+typedef struct {
+  unsigned int tileNum;      /* number of work assignments (tiles) done */
+  size_t rayNum,             /* number of rays cast */
+    sampleNum,               /* number of calls to sample() */
+    skipNum;                 /* estimated number of samples not taken
+                                because sample() finished the ray before
+                                it reached the far clipping plane */
+  double time;               /* seconds from threadBegin to threadEnd */
+} hooverThreadStats;
+
 /*
 ******** hooverContext struct
 **
@@ -100,6 +116,7 @@ typedef int (hooverRenderEnd_t)(void *rend, void *user);
 ** 5) opaque "user information" pointer
 ** 6) stuff about multi-threading
 ** 7) the callbacks
+** 8) per-thread statistics (output)
 */
 typedef struct {
 
@@ -124,7 +141,12 @@ typedef struct {
 
   /******** 5) stuff about multi-threading */
   unsigned int numThreads;   /* number of threads to spawn per rendering */
-  int workIdx;               /* next work assignment (such as a scanline) */
+  int tileSize;              /* work assignments are tileSize-by-tileSize
+                                tiles of the image, within which rays are
+                                cast in Morton (Z-curve) order, so that
+                                nearby rays (which share voxels) are done
+                                together. 0 means whole scanlines */
+  int workIdx;               /* next work assignment (such as a tile) */
   airThreadMutex *workMutex; /* mutex around work assignment */
 
   /*
@@ -240,6 +262,10 @@ typedef struct {
   */
   hooverRenderEnd_t *renderEnd;
 
+  /******** 8) per-thread statistics, set by hooverRender() for threads
+            0 through numThreads-1 (see hooverThreadStatsPrint) */
+  hooverThreadStats threadStats[HOOVER_THREAD_MAX];
+
 } hooverContext;
 
 /*
@@ -271,12 +297,15 @@ HOOVER_EXPORT const int hooverPresent;
 HOOVER_EXPORT const char *hooverBiffKey;
 HOOVER_EXPORT int hooverDefVolCentering;
 HOOVER_EXPORT int hooverDefImgCentering;
+HOOVER_EXPORT int hooverDefTileSize;
 HOOVER_EXPORT const airEnum *const hooverErr;
 
 /* methodsHoover.c */
 HOOVER_EXPORT hooverContext *hooverContextNew(void);
 HOOVER_EXPORT int hooverContextCheck(hooverContext *ctx);
 HOOVER_EXPORT void hooverContextNix(hooverContext *ctx);
+HOOVER_EXPORT void hooverThreadStatsPrint(FILE *file,
+                                          const hooverContext *ctx);
 
 /* rays.c */
 HOOVER_EXPORT int hooverRender(hooverContext *ctx,
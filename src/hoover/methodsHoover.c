@@ -38,6 +38,7 @@ hooverContextNew() {
     ctx->imgCentering = hooverDefImgCentering;
     ctx->user = NULL;
     ctx->numThreads = 1;
+    ctx->tileSize = hooverDefTileSize;
     ctx->workIdx = 0;
     ctx->workMutex = NULL;
     ctx->renderBegin = hooverStubRenderBegin;
@@ -133,6 +134,10 @@ hooverContextCheck(hooverContext *ctx) {
              ctx->numThreads, HOOVER_THREAD_MAX);
     return 1;
   }
+  if (!(ctx->tileSize >= 0)) {
+    biffAddf(HOOVER, "%s: tile size (%d) invalid", me, ctx->tileSize);
+    return 1;
+  }
   if (!ctx->renderBegin) {
     biffAddf(HOOVER, "%s: need a non-NULL begin rendering callback", me);
     return 1;
@@ -175,3 +180,46 @@ hooverContextNix(hooverContext *ctx) {
   }
 }
 
+
+/*
+******** hooverThreadStatsPrint
+**
+** prints a table of the per-thread statistics from the last
+** hooverRender(), and their totals
+*/
+void
+hooverThreadStatsPrint(FILE *file, const hooverContext *ctx) {
+  char stmp[4][AIR_STRLEN_SMALL];
+  hooverThreadStats total;
+  const hooverThreadStats *hts;
+  unsigned int thr;
+
+  if (!(file && ctx)) {
+    return;
+  }
+  fprintf(file, "%7s %7s %12s %14s %14s %9s\n", "thread", "tiles",
+          "rays", "samples", "skipped", "secs");
+  memset(&total, 0, sizeof(total));
+  for (thr=0; thr<=ctx->numThreads; thr++) {
+    if (thr < ctx->numThreads) {
+      hts = ctx->threadStats + thr;
+      total.tileNum += hts->tileNum;
+      total.rayNum += hts->rayNum;
+      total.sampleNum += hts->sampleNum;
+      total.skipNum += hts->skipNum;
+      total.time = AIR_MAX(total.time, hts->time);
+      if (1 == ctx->numThreads) {
+        continue;
+      }
+      sprintf(stmp[0], "%u", thr);
+    } else {
+      hts = &total;
+      strcpy(stmp[0], "all");
+    }
+    fprintf(file, "%7s %7u %12s %14s %14s %9.3f\n", stmp[0], hts->tileNum,
+            airSprintSize_t(stmp[1], hts->rayNum),
+            airSprintSize_t(stmp[2], hts->sampleNum),
+            airSprintSize_t(stmp[3], hts->skipNum), hts->time);
+  }
+  return;
+}
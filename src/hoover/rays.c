@@ -86,8 +86,78 @@ typedef struct {
     uBase, uCap,         /* uMin and uMax as seen on the near cutting plane */
     vBase, vCap,         /* analogous to uBase and uCap */
     rayZero[3];          /* location of near plane, line of sight interxion */
+  int tileSizeU,         /* # pixels along U in one work assignment (tile) */
+    tileSizeV,           /* # pixels along V in one tile */
+    tileNumU,            /* # tiles needed to cover image along U */
+    tileNum,             /* total # tiles in image */
+    tileRayNum,          /* # rays (pixels) in a tile */
+    *tileRayOff;         /* for each ray in a tile, in the order they are
+                            cast, the (U,V) offset from the tile's corner */
 } _hooverExtraContext;
 
+_hooverExtraContext *
+_hooverExtraContextNix(_hooverExtraContext *ec) {
+
+  if (ec) {
+    airFree(ec->tileRayOff);
+    free(ec);
+  }
+  return NULL;
+}
+
+/*
+** sets up the division of the image into tiles, and the order of rays
+** within a tile.  With a tile size of 0, a tile is a scanline.  Otherwise
+** the rays in the tile are ordered along a Morton (Z-order) curve, found
+** by de-interleaving the bits of the index along the curve; the curve
+** covers the smallest power-of-2 square containing the tile, and its
+** points that fall outside the tile are skipped.  A tile is never made
+** bigger than needed to cover the whole image.
+*/
+static int
+_hooverTileSet(_hooverExtraContext *ec, hooverContext *ctx) {
+  int ri, pow2, bit, mi, uu, vv, size;
+
+  size = AIR_MIN(ctx->tileSize, AIR_MAX(ctx->imgSize[0], ctx->imgSize[1]));
+  if (size) {
+    ec->tileSizeU = ec->tileSizeV = size;
+  } else {
+    ec->tileSizeU = ctx->imgSize[0];
+    ec->tileSizeV = 1;
+  }
+  ec->tileNumU = (ctx->imgSize[0] + ec->tileSizeU - 1)/ec->tileSizeU;
+  ec->tileNum = ec->tileNumU*((ctx->imgSize[1] + ec->tileSizeV - 1)
+                              /ec->tileSizeV);
+  ec->tileRayNum = ec->tileSizeU*ec->tileSizeV;
+  ec->tileRayOff = AIR_CALLOC(2*ec->tileRayNum, int);
+  if (!ec->tileRayOff) {
+    return 1;
+  }
+  if (!size) {
+    for (ri=0; ri<ec->tileRayNum; ri++) {
+      ec->tileRayOff[0 + 2*ri] = ri;
+      ec->tileRayOff[1 + 2*ri] = 0;
+    }
+    return 0;
+  }
+  for (pow2=1; pow2<size; pow2 *= 2)
+    ;
+  ri = 0;
+  for (mi=0; mi<pow2*pow2; mi++) {
+    uu = vv = 0;
+    for (bit=0; (1 << bit) < pow2; bit++) {
+      uu |= ((mi >> (2*bit)) & 1) << bit;
+      vv |= ((mi >> (2*bit + 1)) & 1) << bit;
+    }
+    if (uu < size && vv < size) {
+      ec->tileRayOff[0 + 2*ri] = uu;
+      ec->tileRayOff[1 + 2*ri] = vv;
+      ri++;
+    }
+  }
+  return 0;
+}
+
 _hooverExtraContext *
 _hooverExtraContextNew(hooverContext *ctx) {
   _hooverExtraContext *ec;
@@ -103,19 +173,13 @@ _hooverExtraContextNew(hooverContext *ctx) {
     ELL_3V_SCALE_ADD2(ec->rayZero,
                       1.0, ctx->cam->from,
                       ctx->cam->vspNeer, ctx->cam->N);
+    if (_hooverTileSet(ec, ctx)) {
+      ec = _hooverExtraContextNix(ec);
+    }
   }
   return ec;
 }
 
-_hooverExtraContext *
-_hooverExtraContextNix(_hooverExtraContext *ec) {
-
-  if (ec) {
-    free(ec);
-  }
-  return NULL;
-}
-
 /*
 ** _hooverThreadArg struct
 **
@@ -143,9 +207,13 @@ void *
 _hooverThreadBody(void *_arg) {
   _hooverThreadArg *arg;
   void *thread;
+  hooverThreadStats *stats;
   int ret,               /* to catch return values from callbacks */
     sampleI,             /* which sample we're on */
     inside,              /* we're inside the volume */
+    tileIdx,             /* which tile we're on */
+    rayIdx,              /* which ray in the tile we're on */
+    tileU, tileV,        /* image coords of lowest corner of tile */
     vI, uI;              /* integral coords in image */
   double tmp,
     mm,                  /* lowest position in index space, for all axes */
@@ -167,10 +235,13 @@ _hooverThreadBody(void *_arg) {
     rayStartW[3],        /* ray start on near plane (world-space) */
     rayStartI[3],        /* ray start on near plane (index-space) */
     rayStep,             /* distance between samples (world-space) */
+    lastStep,            /* last non-zero rayStep on this ray */
     vOff[3], uOff[3];    /* offsets in arg->ec->wU and arg->ec->wV
                             directions towards start of ray */
 
   arg = (_hooverThreadArg *)_arg;
+  stats = arg->ctx->threadStats + arg->whichThread;
+  stats->time = airTime();
   if ( (ret = (arg->ctx->threadBegin)(&thread,
                                       arg->render,
                                       arg->ctx->user,
@@ -229,43 +300,49 @@ _hooverThreadBody(void *_arg) {
   }
 
   while (1) {
-    /* the work assignment is simply the next scanline to be rendered:
-       the result of all this is setting vI */
+    /* the work assignment is the next tile to be rendered:
+       the result of all this is setting tileIdx */
     if (arg->ctx->workMutex) {
       airThreadMutexLock(arg->ctx->workMutex);
     }
-    vI = arg->ctx->workIdx;
-    if (arg->ctx->workIdx < arg->ctx->imgSize[1]) {
+    tileIdx = arg->ctx->workIdx;
+    if (arg->ctx->workIdx < arg->ec->tileNum) {
       arg->ctx->workIdx += 1;
     }
     if (arg->ctx->workMutex) {
       airThreadMutexUnlock(arg->ctx->workMutex);
     }
-    if (vI == arg->ctx->imgSize[1]) {
+    if (tileIdx == arg->ec->tileNum) {
       /* we're done! */
       break;
     }
-
-    if (nrrdCenterCell == arg->ctx->imgCentering) {
-      v = uvScale*AIR_AFFINE(-0.5, vI, arg->ctx->imgSize[1]-0.5,
-                             arg->ctx->cam->vRange[0],
-                             arg->ctx->cam->vRange[1]);
-    } else {
-      v = uvScale*AIR_AFFINE(0.0, vI, arg->ctx->imgSize[1]-1.0,
-                             arg->ctx->cam->vRange[0],
-                             arg->ctx->cam->vRange[1]);
-    }
-    ELL_3V_SCALE(vOff, v, arg->ctx->cam->V);
-    for (uI=0; uI<arg->ctx->imgSize[0]; uI++) {
+    stats->tileNum++;
+    tileU = arg->ec->tileSizeU*(tileIdx % arg->ec->tileNumU);
+    tileV = arg->ec->tileSizeV*(tileIdx / arg->ec->tileNumU);
+
+    for (rayIdx=0; rayIdx<arg->ec->tileRayNum; rayIdx++) {
+      uI = tileU + arg->ec->tileRayOff[0 + 2*rayIdx];
+      vI = tileV + arg->ec->tileRayOff[1 + 2*rayIdx];
+      if (!(uI < arg->ctx->imgSize[0] && vI < arg->ctx->imgSize[1])) {
+        /* this part of the tile is off the edge of the image */
+        continue;
+      }
       if (nrrdCenterCell == arg->ctx->imgCentering) {
+        v = uvScale*AIR_AFFINE(-0.5, vI, arg->ctx->imgSize[1]-0.5,
+                               arg->ctx->cam->vRange[0],
+                               arg->ctx->cam->vRange[1]);
         u = uvScale*AIR_AFFINE(-0.5, uI, arg->ctx->imgSize[0]-0.5,
                                arg->ctx->cam->uRange[0],
                                arg->ctx->cam->uRange[1]);
       } else {
+        v = uvScale*AIR_AFFINE(0.0, vI, arg->ctx->imgSize[1]-1.0,
+                               arg->ctx->cam->vRange[0],
+                               arg->ctx->cam->vRange[1]);
         u = uvScale*AIR_AFFINE(0.0, uI, arg->ctx->imgSize[0]-1.0,
                                arg->ctx->cam->uRange[0],
                                arg->ctx->cam->uRange[1]);
       }
+      ELL_3V_SCALE(vOff, v, arg->ctx->cam->V);
       ELL_3V_SCALE(uOff, u, arg->ctx->cam->U);
       ELL_3V_ADD3(rayStartW, uOff, vOff, arg->ec->rayZero);
       if (arg->ctx->shape) {
@@ -302,9 +379,11 @@ _hooverThreadBody(void *_arg) {
         arg->whichErr = hooverErrRayBegin;
         return arg;
       }
+      stats->rayNum++;
 
       sampleI = 0;
       rayT = 0;
+      lastStep = 0;
       while (1) {
         ELL_3V_SCALE_ADD2(rayPosW, 1.0, rayStartW, rayT, rayDirW);
         if (arg->ctx->shape) {
@@ -321,6 +400,7 @@ _hooverThreadBody(void *_arg) {
                                      sampleI, rayT,
                                      inside,
                                      rayPosW, rayPosI);
+        stats->sampleNum++;
         if (!AIR_EXISTS(rayStep)) {
           /* sampling failed */
           arg->errCode = 0;
@@ -328,11 +408,16 @@ _hooverThreadBody(void *_arg) {
           return arg;
         }
         if (!rayStep) {
-          /* ray decided to finish itself */
+          /* ray decided to finish itself; estimate how many samples
+             it would have taken with its last step size */
+          if (lastStep > 0 && rayT < rayLen) {
+            stats->skipNum += AIR_CAST(size_t, (rayLen - rayT)/lastStep);
+          }
           break;
         }
         /* else we moved to a new location along the ray */
         rayT += rayStep;
+        lastStep = rayStep;
         if (!AIR_IN_CL(0, rayT, rayLen)) {
           /* ray stepped outside near-far clipping region, its done. */
           break;
@@ -347,8 +432,8 @@ _hooverThreadBody(void *_arg) {
         arg->whichErr = hooverErrRayEnd;
         return arg;
       }
-    }  /* end this scanline */
-  } /* end while(1) assignment of scanlines */
+    }  /* end this tile */
+  } /* end while(1) assignment of tiles */
 
   if ( (ret = (arg->ctx->threadEnd)(thread,
                                     arg->render,
@@ -357,6 +442,7 @@ _hooverThreadBody(void *_arg) {
     arg->whichErr = hooverErrThreadEnd;
     return arg;
   }
+  stats->time = airTime() - stats->time;
 
   /* returning NULL actually indicates that there was NOT an error */
   return NULL;
@@ -417,6 +503,7 @@ hooverRender(hooverContext *ctx, int *errCodeP, int *errThreadP) {
   }
 
   for (threadIdx=0; threadIdx<ctx->numThreads; threadIdx++) {
+    memset(ctx->threadStats + threadIdx, 0, sizeof(hooverThreadStats));
     args[threadIdx].ctx = ctx;
     args[threadIdx].ec = ec;
     args[threadIdx].render = render;
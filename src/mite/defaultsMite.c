@@ -44,3 +44,6 @@ miteDefOpacNear1 = 0.98;
 
 double
 miteDefOpacMatters = 0.05;
+
+int
+miteDefEmptySkip = AIR_FALSE;
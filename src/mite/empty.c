@@ -0,0 +1,370 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "mite.h"
+#include "privateMite.h"
+
+/*
+** _miteEmptyOp
+**
+** the miteStageOp of a txf, determined just as in _miteStageSet
+*/
+static int
+_miteEmptyOp(const Nrrd *ntxf) {
+  char *value;
+  int op;
+
+  value = nrrdKeyValueGet(ntxf, "miteStageOp");
+  if (value) {
+    op = airEnumVal(miteStageOp, value);
+    if (miteStageOpUnknown == op) {
+      op = miteStageOpMultiply;
+    }
+    if (!nrrdStateKeyValueReturnInternalPointers) {
+      free(value);
+    }
+  } else {
+    op = miteStageOpMultiply;
+  }
+  return op;
+}
+
+/*
+** _miteEmptyTxfUsable
+**
+** txf ni can tell us where opacity is surely zero if it is a univariate
+** function of gage(scalar:v) which multiplies the opacity, and none of the
+** following txfs can undo a zero opacity (by max or add)
+*/
+static int
+_miteEmptyTxfUsable(miteRender *mrr, int ni) {
+  gageItemSpec isp;
+  const Nrrd *ntxf;
+  int nj, op;
+
+  ntxf = mrr->ntxf[ni];
+  if (!( 2 == ntxf->dim
+         && strchr(ntxf->axis[0].label, miteRangeChar[miteRangeAlpha])
+         && miteStageOpMultiply == _miteEmptyOp(ntxf) )) {
+    return AIR_FALSE;
+  }
+  /* labels were already checked by _miteUserCheck */
+  miteVariableParse(&isp, ntxf->axis[1].label);
+  if (!( gageKindScl == isp.kind && gageSclValue == isp.item )) {
+    return AIR_FALSE;
+  }
+  for (nj=ni+1; nj<mrr->ntxfNum; nj++) {
+    if (!strchr(mrr->ntxf[nj]->axis[0].label,
+                miteRangeChar[miteRangeAlpha])) {
+      continue;
+    }
+    op = _miteEmptyOp(mrr->ntxf[nj]);
+    if (!( miteStageOpMultiply == op || miteStageOpMin == op )) {
+      return AIR_FALSE;
+    }
+  }
+  return AIR_TRUE;
+}
+
+/*
+** _miteEmptyKernel
+**
+** bounds on how far reconstruction with kernel00 can go outside the
+** range [min,max] of the values in its support.  With the data values
+** written as c + h*e (c the center and h the half-width of their range,
+** |e| <= 1), the reconstructed value is c*S + h*sum(w*e), where S is the
+** sum of the 3-D weights, and |sum(w*e)| <= A, the sum of the absolute
+** values of the 3-D weights.  Learns the range [*sminP,*smaxP] of S and
+** the maximum *aP of A by evaluating the 1-D weights at many fractional
+** positions.  Returns non-zero if the weight sums could be non-positive.
+*/
+static int
+_miteEmptyKernel(double *sminP, double *smaxP, double *aP,
+                 const gageContext *gctx) {
+  const NrrdKernelSpec *ksp;
+  double frac, ww, sum, asum, smin, smax, amax, integral;
+  int fi, ii, rad;
+
+  ksp = gctx->ksp[gageKernel00];
+  rad = AIR_CAST(int, gctx->radius);
+  integral = ksp->kernel->integral(ksp->parm);
+  smin = AIR_POS_INF;
+  smax = AIR_NEG_INF;
+  amax = 0;
+  for (fi=0; fi<=128; fi++) {
+    frac = fi/128.0;
+    sum = asum = 0;
+    for (ii=1-rad; ii<=rad; ii++) {
+      ww = ksp->kernel->eval1_d(frac - ii, ksp->parm);
+      sum += ww;
+      asum += AIR_ABS(ww);
+    }
+    if (!( sum > 0 )) {
+      return 1;
+    }
+    if (gctx->parm.renormalize) {
+      /* _gageFwValueRenormalize scales weights to sum to integral */
+      asum *= integral/sum;
+      sum = integral;
+    }
+    smin = AIR_MIN(smin, sum);
+    smax = AIR_MAX(smax, sum);
+    amax = AIR_MAX(amax, asum);
+  }
+  if (!( smin > 0 )) {
+    return 1;
+  }
+  /* a little slack, for the fractions not sampled above */
+  *sminP = 0.999*smin*smin*smin;
+  *smaxP = 1.001*smax*smax*smax;
+  *aP = 1.001*amax*amax*amax;
+  return 0;
+}
+
+/*
+** _miteEmptySet
+**
+** if muu->emptySkip, sets mrr->empty and mrr->emptySize[] to describe
+** which macrocells (of _MITE_EMPTY_CELL^3 voxels) of the scalar volume
+** are surely transparent, so that miteSample can leap rays over them.
+** A macrocell is empty when, for some usable opacity txf (see
+** _miteEmptyTxfUsable), the opacity is zero over the whole range of
+** values that can be reconstructed at positions (with index-space floor)
+** in the macrocell.  The data values contributing to such positions are
+** all in the 3x3x3 neighborhood of blocks around the macrocell, since
+** the kernel radius is required to be less than _MITE_EMPTY_CELL.
+**
+** When empty space skipping isn't possible with the given txfs and
+** kernels, this says why, and renders normally with mrr->empty NULL.
+** Assumes gageUpdate has been called on muu->gctx0.
+*/
+int
+_miteEmptySet(miteRender *mrr, miteUser *muu) {
+  static const char me[]="_miteEmptySet";
+  const char *why;
+  double (*lup)(const void *, size_t);
+  double *bmin, *bmax, smin, smax, aa, val, lo, hi, cc, hh, tol;
+  unsigned int *zcount, sx, sy, sz, xi, yi, zi, bx, by, bz, ci[3], bi[3],
+    blo[3], bhi[3], ilo, ihi, cellNum, emptyNum, ri, rnum, ei;
+  int ni, usable;
+  const Nrrd *nsin, *ntxf;
+  const mite_t *tdata;
+  size_t II;
+  airArray *mop;
+
+  mrr->empty = NULL;
+  ELL_3V_SET(mrr->emptySize, 0, 0, 0);
+  if (!muu->emptySkip) {
+    return 0;
+  }
+  why = NULL;
+  usable = 0;
+  for (ni=0; ni<mrr->ntxfNum; ni++) {
+    usable += _miteEmptyTxfUsable(mrr, ni);
+  }
+  if (-1 == mrr->sclPvlIdx) {
+    why = "no scalar volume";
+  } else if (!usable) {
+    why = ("no txf of gage(scalar:v) alone can make opacity zero "
+           "(txf must multiply opacity, and no later txf can max or "
+           "add it)");
+  } else if (GAGE_QUERY_ITEM_TEST(mrr->queryMite, miteValTi)) {
+    why = "txf depends on ray sample index \"Ti\"";
+  } else if (!( muu->gctx0->radius < _MITE_EMPTY_CELL )) {
+    why = "kernel support too big";
+  } else if (_miteEmptyKernel(&smin, &smax, &aa, muu->gctx0)) {
+    why = "kernel weights don't have positive sums";
+  }
+  if (why) {
+    fprintf(stderr, "%s: WARNING: can't skip empty space: %s\n", me, why);
+    return 0;
+  }
+
+  mop = airMopNew();
+  nsin = muu->nsin;
+  lup = nrrdDLookup[nsin->type];
+  sx = AIR_CAST(unsigned int, nsin->axis[0].size);
+  sy = AIR_CAST(unsigned int, nsin->axis[1].size);
+  sz = AIR_CAST(unsigned int, nsin->axis[2].size);
+  bx = (sx + _MITE_EMPTY_CELL - 1)/_MITE_EMPTY_CELL;
+  by = (sy + _MITE_EMPTY_CELL - 1)/_MITE_EMPTY_CELL;
+  bz = (sz + _MITE_EMPTY_CELL - 1)/_MITE_EMPTY_CELL;
+  cellNum = bx*by*bz;
+  bmin = AIR_CALLOC(cellNum, double);
+  airMopAdd(mop, bmin, airFree, airMopAlways);
+  bmax = AIR_CALLOC(cellNum, double);
+  airMopAdd(mop, bmax, airFree, airMopAlways);
+  mrr->empty = AIR_CALLOC(cellNum, unsigned char);
+  airMopAdd(mrr->rmop, mrr->empty, airFree, airMopAlways);
+  if (!( bmin && bmax && mrr->empty )) {
+    biffAddf(MITE, "%s: couldn't allocate %u macrocells", me, cellNum);
+    airMopError(mop); return 1;
+  }
+  ELL_3V_SET(mrr->emptySize, bx, by, bz);
+
+  /* range of values in each block; non-existent values make the
+     range infinite, so that the block is never empty */
+  for (ei=0; ei<cellNum; ei++) {
+    bmin[ei] = AIR_POS_INF;
+    bmax[ei] = AIR_NEG_INF;
+  }
+  II = 0;
+  for (zi=0; zi<sz; zi++) {
+    for (yi=0; yi<sy; yi++) {
+      for (xi=0; xi<sx; xi++) {
+        ei = (xi/_MITE_EMPTY_CELL
+              + bx*(yi/_MITE_EMPTY_CELL + by*(zi/_MITE_EMPTY_CELL)));
+        val = lup(nsin->data, II++);
+        if (AIR_EXISTS(val)) {
+          bmin[ei] = AIR_MIN(bmin[ei], val);
+          bmax[ei] = AIR_MAX(bmax[ei], val);
+        } else {
+          bmin[ei] = AIR_NEG_INF;
+          bmax[ei] = AIR_POS_INF;
+        }
+      }
+    }
+  }
+
+  /* for each usable txf, zcount[i] is the number of txf entries
+     before i with non-zero opacity, so that opacity is zero over txf
+     indices [ilo,ihi] iff zcount[ihi+1] == zcount[ilo] */
+  for (ni=0; ni<mrr->ntxfNum; ni++) {
+    if (!_miteEmptyTxfUsable(mrr, ni)) {
+      continue;
+    }
+    ntxf = mrr->ntxf[ni];
+    tdata = AIR_CAST(const mite_t *, ntxf->data);
+    rnum = AIR_CAST(unsigned int, ntxf->axis[0].size);
+    zcount = AIR_CALLOC(ntxf->axis[1].size + 1, unsigned int);
+    if (!zcount) {
+      biffAddf(MITE, "%s: couldn't allocate txf %d count", me, ni);
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, zcount, airFree, airMopAlways);
+    for (ei=0; ei<ntxf->axis[1].size; ei++) {
+      zcount[ei+1] = zcount[ei];
+      for (ri=0; ri<rnum; ri++) {
+        if (ntxf->axis[0].label[ri] == miteRangeChar[miteRangeAlpha]
+            && tdata[ri + rnum*ei]) {
+          zcount[ei+1] += 1;
+          break;
+        }
+      }
+    }
+    for (ci[2]=0; ci[2]<bz; ci[2]++) {
+      for (ci[1]=0; ci[1]<by; ci[1]++) {
+        for (ci[0]=0; ci[0]<bx; ci[0]++) {
+          ei = ci[0] + bx*(ci[1] + by*ci[2]);
+          if (mrr->empty[ei]) {
+            continue;
+          }
+          lo = AIR_POS_INF;
+          hi = AIR_NEG_INF;
+          blo[0] = ci[0] ? ci[0]-1 : 0; bhi[0] = AIR_MIN(ci[0]+1, bx-1);
+          blo[1] = ci[1] ? ci[1]-1 : 0; bhi[1] = AIR_MIN(ci[1]+1, by-1);
+          blo[2] = ci[2] ? ci[2]-1 : 0; bhi[2] = AIR_MIN(ci[2]+1, bz-1);
+          for (bi[2]=blo[2]; bi[2]<=bhi[2]; bi[2]++) {
+            for (bi[1]=blo[1]; bi[1]<=bhi[1]; bi[1]++) {
+              for (bi[0]=blo[0]; bi[0]<=bhi[0]; bi[0]++) {
+                II = bi[0] + bx*(bi[1] + by*bi[2]);
+                lo = AIR_MIN(lo, bmin[II]);
+                hi = AIR_MAX(hi, bmax[II]);
+              }
+            }
+          }
+          if (!( AIR_EXISTS(lo) && AIR_EXISTS(hi) )) {
+            continue;
+          }
+          cc = (lo + hi)/2;
+          hh = (hi - lo)/2;
+          lo = AIR_MIN(cc*smin, cc*smax) - hh*aa;
+          hi = AIR_MAX(cc*smin, cc*smax) + hh*aa;
+          tol = 1e-5*(hi - lo + AIR_ABS(lo) + AIR_ABS(hi));
+          ilo = airIndexClamp(ntxf->axis[1].min, lo - tol,
+                              ntxf->axis[1].max,
+                              AIR_CAST(unsigned int, ntxf->axis[1].size));
+          ihi = airIndexClamp(ntxf->axis[1].min, hi + tol,
+                              ntxf->axis[1].max,
+                              AIR_CAST(unsigned int, ntxf->axis[1].size));
+          mrr->empty[ei] = (zcount[ihi+1] == zcount[ilo]);
+        }
+      }
+    }
+  }
+  emptyNum = 0;
+  for (ei=0; ei<cellNum; ei++) {
+    emptyNum += !!mrr->empty[ei];
+  }
+  fprintf(stderr, "!%s: %u of %u macrocells (%g%%) are empty\n", me,
+          emptyNum, cellNum, 100.0*emptyNum/cellNum);
+
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** _miteEmptyLeap
+**
+** if the sample at index-space position pos is in an empty macrocell,
+** returns the (non-zero) distance to leap along the ray: the smallest
+** whole number of steps which will put the next sample at or beyond
+** where the ray leaves the macrocell, so that samples stay at the same
+** positions they'd have without leaping.  Otherwise returns 0.
+*/
+double
+_miteEmptyLeap(miteThread *mtt, miteRender *mrr, double rayT,
+               const double pos[3]) {
+  int ci[3], ii;
+  double tt, tmin, dd, num, left;
+
+  for (ii=0; ii<3; ii++) {
+    ci[ii] = AIR_CAST(int, floor(pos[ii]/_MITE_EMPTY_CELL));
+    ci[ii] = AIR_CLAMP(0, ci[ii], AIR_CAST(int, mrr->emptySize[ii]) - 1);
+  }
+  if (!mrr->empty[ci[0] + mrr->emptySize[0]*(ci[1]
+                                            + mrr->emptySize[1]*ci[2])]) {
+    return 0;
+  }
+  tmin = AIR_POS_INF;
+  for (ii=0; ii<3; ii++) {
+    dd = mtt->rayDirIndex[ii];
+    if (dd > 0) {
+      tt = ((ci[ii] + 1)*_MITE_EMPTY_CELL - pos[ii])/dd;
+    } else if (dd < 0) {
+      tt = (ci[ii]*_MITE_EMPTY_CELL - pos[ii])/dd;
+    } else {
+      continue;
+    }
+    tmin = AIR_MIN(tmin, tt);
+  }
+  /* samples at rayT + j*rayStep, for j = 0 .. num-1, are in the cell;
+     the last one may be right on its boundary, but its value is still
+     determined by blocks in the cell's neighborhood */
+  num = 1 + floor(AIR_MAX(0, tmin)/mtt->rayStep);
+  /* don't count samples the ray wouldn't have taken anyway */
+  left = 1 + floor((mtt->rayLen - rayT)/mtt->rayStep);
+  mtt->emptyNum += AIR_CAST(int, AIR_MAX(0, AIR_MIN(num, left)));
+  return num*mtt->rayStep;
+}
@@ -165,6 +165,12 @@ typedef struct {
                             ray */
     opacNear1;           /* opacity close enough to unity for the sake of
                             doing early ray termination */
+  int emptySkip;         /* if non-zero, find (at miteRenderBegin) the
+                            macrocells of the scalar volume in which the
+                            opacity is surely zero, and leap rays over
+                            them without probing.  Only possible when
+                            some txf of gage(scalar:v) alone can zero
+                            the opacity (see _miteEmptySet) */
   hooverContext *hctx;   /* context and input for all hoover-related things,
                             including camera and image parameters */
   double fakeFrom[3],    /* if non-NaN, then the "V"-dependent miteVal's will
@@ -195,7 +201,9 @@ typedef struct {
                             multiple renderings */
   /* output information from last rendering */
   double rendTime,       /* rendering time, in seconds */
-    sampRate;            /* rate (KHz) at which samples were rendered */
+    sampRate,            /* rate (KHz) at which samples were rendered */
+    sampNum,             /* number of samples rendered */
+    emptyNum;            /* number of samples leapt over as empty space */
 } miteUser;
 
 struct miteThread_t;
@@ -262,6 +270,11 @@ typedef struct {
   gageQuery queryMite;        /* record of the miteVal quantities which
                                  we'll need to compute per-sample */
   int queryMiteNonzero;       /* shortcut miteVal computation if possible */
+  unsigned char *empty;       /* if non-NULL: one flag per macrocell of the
+                                 scalar volume, non-zero if the opacity is
+                                 surely zero at every sample position with
+                                 index-space floor inside the macrocell */
+  unsigned int emptySize[3];  /* number of macrocells along each axis */
 
   /* as long as there's no mutex around how the miteThreads are
      airMopAdded to the miteUser's mop, these have to be _allocated_ in
@@ -409,8 +422,10 @@ typedef struct miteThread_t {
     thrid,                      /* thread ID */
     ui, vi,                     /* image coords of current ray */
     raySample,                  /* number of samples finished in this ray */
-    samples;                    /* number of samples handled so far by
+    samples,                    /* number of samples handled so far by
                                    this thread */
+    emptyNum;                   /* number of samples leapt over so far by
+                                   this thread, as empty space */
   miteStage *stage;             /* array of stages for txf computation */
   int stageNum;                 /* number of stages == length of stage[] */
   mite_t range[MITE_RANGE_NUM], /* rendering variables, which are either
@@ -419,6 +434,9 @@ typedef struct miteThread_t {
     rayStep,                    /* per-ray step (may need to be different for
                                    each ray to enable sampling on planes) */
     V[3],                       /* per-ray view direction */
+    rayLen,                     /* per-ray length */
+    rayDirIndex[3],             /* per-ray index-space direction, for
+                                   finding where ray leaves a macrocell */
     RR, GG, BB, TT,             /* per-ray composited values */
     ZZ;                         /* for storing ray-depth when opacity passed
                                    muu->opacMatters */
@@ -435,6 +453,7 @@ MITE_EXPORT int miteDefRenorm;
 MITE_EXPORT int miteDefNormalSide;
 MITE_EXPORT double miteDefOpacNear1;
 MITE_EXPORT double miteDefOpacMatters;
+MITE_EXPORT int miteDefEmptySkip;
 
 /* kindnot.c */
 MITE_EXPORT const airEnum *const miteVal;
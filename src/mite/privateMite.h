@@ -36,6 +36,15 @@ extern "C" {
  # endif
 */
 
+/* number of voxels along each edge of the macrocells used for
+   empty space skipping */
+#define _MITE_EMPTY_CELL 8
+
+/* empty.c */
+extern int _miteEmptySet(miteRender *mrr, miteUser *muu);
+extern double _miteEmptyLeap(miteThread *mtt, miteRender *mrr, double rayT,
+                             const double pos[3]);
+
 /* txf.c */
 extern double *_miteAnswerPointer(miteThread *mtt, gageItemSpec *isp);
 extern int _miteNtxfAlphaAdjust(miteRender *mrr, miteUser *muu);
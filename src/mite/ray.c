@@ -34,7 +34,6 @@ miteRayBegin(miteThread *mtt, miteRender *mrr, miteUser *muu,
   AIR_UNUSED(mrr);
   AIR_UNUSED(rayStartWorld);
   AIR_UNUSED(rayStartIndex);
-  AIR_UNUSED(rayDirIndex);
 
   mtt->ui = uIndex;
   mtt->vi = vIndex;
@@ -66,6 +65,8 @@ miteRayBegin(miteThread *mtt, miteRender *mrr, miteUser *muu,
   mtt->TT = 1.0;
   mtt->ZZ = AIR_NAN;
   ELL_3V_SCALE(mtt->V, -1, rayDirWorld);
+  mtt->rayLen = rayLen;
+  ELL_3V_COPY(mtt->rayDirIndex, rayDirIndex);
 
   return 0;
 }
@@ -160,7 +161,7 @@ miteSample(miteThread *mtt, miteRender *mrr, miteUser *muu,
   static const char me[]="miteSample";
   mite_t R, G, B, A;
   double *NN;
-  double NdotV, kn[3], knd[3], ref[3], len, *dbg=NULL;
+  double NdotV, kn[3], knd[3], ref[3], len, leap, *dbg=NULL;
 
   if (!inside) {
     return mtt->rayStep;
@@ -177,6 +178,15 @@ miteSample(miteThread *mtt, miteRender *mrr, miteUser *muu,
     return 0.0;
   }
 
+  /* leap over empty space, unless every sample of this ray is needed
+     for debugging */
+  if (mrr->empty && !mtt->verbose) {
+    leap = _miteEmptyLeap(mtt, mrr, rayT, samplePosIndex);
+    if (leap) {
+      return leap;
+    }
+  }
+
   /* set (fake) view based on fake from */
   if (AIR_EXISTS(muu->fakeFrom[0])) {
     ELL_3V_SUB(mtt->V, samplePosWorld, muu->fakeFrom);
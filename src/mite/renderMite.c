@@ -49,6 +49,8 @@ _miteRenderNew(void) {
     mrr->time0 = AIR_NAN;
     GAGE_QUERY_RESET(mrr->queryMite);
     mrr->queryMiteNonzero = AIR_FALSE;
+    mrr->empty = NULL;
+    ELL_3V_SET(mrr->emptySize, 0, 0, 0);
   }
   return mrr;
 }
@@ -143,6 +145,10 @@ miteRenderBegin(miteRender **mrrP, miteUser *muu) {
   }
   fprintf(stderr, "!%s: kernel support = %d^3 samples\n",
           me, 2*muu->gctx0->radius);
+  if (_miteEmptySet(*mrrP, muu)) {
+    biffAddf(MITE, "%s: trouble finding empty space", me);
+    return 1;
+  }
 
   if (nrrdMaybeAlloc_va(muu->nout, mite_nt, 3,
                         AIR_CAST(size_t, 5) /* RGBAZ */ ,
@@ -175,14 +181,17 @@ miteRenderBegin(miteRender **mrrP, miteUser *muu) {
 int
 miteRenderEnd(miteRender *mrr, miteUser *muu) {
   unsigned int thr;
-  double samples;
+  double samples, empties;
 
   muu->rendTime = airTime() - mrr->time0;
-  samples = 0;
+  samples = empties = 0;
   for (thr=0; thr<muu->hctx->numThreads; thr++) {
     samples += mrr->tt[thr]->samples;
+    empties += mrr->tt[thr]->emptyNum;
   }
   muu->sampRate = samples/(1000.0*muu->rendTime);
+  muu->sampNum = samples;
+  muu->emptyNum = empties;
   _miteRenderNix(mrr);
   return 0;
 }
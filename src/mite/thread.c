@@ -68,9 +68,10 @@ miteThreadNew() {
   mtt->ui = mtt->vi = -1;
   mtt->raySample = 0;
   mtt->samples = 0;
+  mtt->emptyNum = 0;
   mtt->stage = NULL;
-  /* mtt->range[], rayStep, V, RR, GG, BB, TT  initialized in
-     miteRayBegin or in miteSample */
+  /* mtt->range[], rayStep, V, rayLen, rayDirIndex, RR, GG, BB, TT
+     initialized in miteRayBegin or in miteSample */
 
   return mtt;
 }
@@ -132,6 +133,7 @@ miteThreadBegin(miteThread **mttP, miteRender *mrr,
   (*mttP)->thrid = whichThread;
   (*mttP)->raySample = 0;
   (*mttP)->samples = 0;
+  (*mttP)->emptyNum = 0;
   (*mttP)->verbose = 0;
   (*mttP)->skip = 0;
   (*mttP)->_normal = _miteAnswerPointer(*mttP, mrr->normalSpec);
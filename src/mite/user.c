@@ -54,6 +54,7 @@ miteUserNew() {
   muu->rayStep = AIR_NAN;
   muu->opacMatters = miteDefOpacMatters;
   muu->opacNear1 = miteDefOpacNear1;
+  muu->emptySkip = miteDefEmptySkip;
   muu->hctx = hooverContextNew();
   ELL_3V_SET(muu->fakeFrom, AIR_NAN, AIR_NAN, AIR_NAN);
   ELL_3V_SET(muu->vectorD, 0, 0, 0);
@@ -72,6 +73,8 @@ miteUserNew() {
   muu->verbUi = muu->verbVi = -1;
   muu->rendTime = 0;
   muu->sampRate = 0;
+  muu->sampNum = 0;
+  muu->emptyNum = 0;
   return muu;
 }
 
@@ -205,6 +205,448 @@ nrrdArithSRGBGamma(Nrrd *nout, const Nrrd *nin,
   return 0;
 }
 
+/* ---------------------------- engine -------------- */
+
+/*
+** The element-wise operations below (unary, binary, ternary, and their
+** NrrdIter versions) all describe their work with an _nrrdArithJob,
+** which is done by _nrrdArithRun(), with nrrdDefaultThreadNum threads,
+** each of which handles a contiguous range of output values.
+**
+** When all the nrrd inputs have the same type as the output, and that
+** type is uchar, short, float, or double, the values are processed
+** directly in that type ("fast"), instead of going through the
+** nrrdDLookup and nrrdDInsert function pointers.  The common operations
+** are done inline (in integer arithmetic for the integral types), and
+** the rest call the per-value operation function.  The results are
+** exactly the same as with the generic ("slow") path, which is why some
+** operations (like integer division) are never done inline.
+*/
+
+typedef struct {
+  const void *data;          /* NULL if this is a fixed value */
+  int type;
+  size_t num,                /* number of values in data */
+    start;                   /* index into data of value for output 0;
+                                indices wrap around at num */
+  double val;                /* fixed value, if data is NULL */
+} _nrrdArithArg;
+
+typedef struct {
+  unsigned int argNum;       /* 1, 2, or 3 */
+  int op,                    /* from nrrdUnaryOp, nrrdBinaryOp, or
+                                nrrdTernaryOp (according to argNum) */
+    fast;                    /* can use _nrrdArithFast[outType] */
+  double (*uop)(double);
+  double (*bop)(double, double);
+  double (*top)(double, double, double);
+  double (*clmp)(double);    /* non-NULL for the clamping binary ops */
+  _nrrdArithArg arg[3];
+  void *out;
+  int outType;
+} _nrrdArithJob;
+
+typedef struct {
+  const _nrrdArithJob *job;
+  size_t lo, hi;             /* range of output values to compute */
+} _nrrdArithTask;
+
+static void
+_nrrdArithSlow(const _nrrdArithJob *job, size_t lo, size_t hi) {
+  double (*lup[3])(const void *v, size_t I),
+    (*ins)(void *v, size_t I, double d), val[3], ret;
+  size_t idx[3], II;
+  unsigned int ai;
+
+  for (ai=0; ai<job->argNum; ai++) {
+    if (job->arg[ai].data) {
+      lup[ai] = nrrdDLookup[job->arg[ai].type];
+      idx[ai] = (job->arg[ai].start + lo) % job->arg[ai].num;
+    } else {
+      lup[ai] = NULL;
+      idx[ai] = 0;
+      val[ai] = job->arg[ai].val;
+    }
+  }
+  ins = nrrdDInsert[job->outType];
+  for (II=lo; II<hi; II++) {
+    for (ai=0; ai<job->argNum; ai++) {
+      if (lup[ai]) {
+        /* HEY: there is a loss of precision issue here with 64-bit ints */
+        val[ai] = lup[ai](job->arg[ai].data, idx[ai]);
+        if (++idx[ai] == job->arg[ai].num) {
+          idx[ai] = 0;
+        }
+      }
+    }
+    switch (job->argNum) {
+    case 1:
+      ret = job->uop(val[0]);
+      break;
+    case 2:
+      ret = job->bop(val[0], val[1]);
+      break;
+    default:
+      ret = job->top(val[0], val[1], val[2]);
+      break;
+    }
+    if (job->clmp) {
+      ret = job->clmp(ret);
+    }
+    ins(job->out, II, ret);
+  }
+  return;
+}
+
+/*
+** Helper macros for _nrrdArithFast: the ARITH_LOOP's set the output
+** from EXPR in terms of input values A, B, C, with a separate loop for
+** when all inputs are nrrds (the common case, which compilers can
+** vectorize), and for when some are fixed values.  ARITH_FAST defines
+** _nrrdArithFast<TT>, for values of type T; FLOATY is non-zero for
+** floating point types, and CLAMPOK is non-zero when CLAMP(v) (applied
+** to the result of arithmetic on T) matches nrrdDClamp; for float it
+** doesn't, since float arithmetic can overflow to infinity.
+*/
+#define ARITH_LOOP1(EXPR)                                        \
+  for (II=0; II<NN; II++) {                                      \
+    A = p0[II];                                                  \
+    out[II] = (EXPR);                                            \
+  }
+
+#define ARITH_LOOP2(EXPR)                                        \
+  if (i0 && i1) {                                                \
+    for (II=0; II<NN; II++) {                                    \
+      A = p0[II]; B = p1[II];                                    \
+      out[II] = (EXPR);                                          \
+    }                                                            \
+  } else {                                                       \
+    for (II=0; II<NN; II++) {                                    \
+      A = p0[II*i0]; B = p1[II*i1];                              \
+      out[II] = (EXPR);                                          \
+    }                                                            \
+  }
+
+#define ARITH_LOOP3(EXPR)                                        \
+  if (i0 && i1 && i2) {                                          \
+    for (II=0; II<NN; II++) {                                    \
+      A = p0[II]; B = p1[II]; C = p2[II];                        \
+      out[II] = (EXPR);                                          \
+    }                                                            \
+  } else {                                                       \
+    for (II=0; II<NN; II++) {                                    \
+      A = p0[II*i0]; B = p1[II*i1]; C = p2[II*i2];               \
+      out[II] = (EXPR);                                          \
+    }                                                            \
+  }
+
+#define ARITH_ARG(T, AI, P, INC)                                 \
+  if (job->arg[AI].data) {                                       \
+    P = (const T *)(job->arg[AI].data) + job->arg[AI].start + lo; \
+    INC = 1;                                                     \
+  } else {                                                       \
+    fix[AI] = (T)(job->arg[AI].val);                             \
+    P = fix + AI;                                                \
+    INC = 0;                                                     \
+  }
+
+#define ARITH_FAST(TT, T, FLOATY, CLAMPOK, CLAMP)                \
+static void                                                      \
+_nrrdArithFast##TT(const _nrrdArithJob *job, size_t lo, size_t hi) { \
+  T *out, fix[3], A, B, C;                                       \
+  const T *p0, *p1, *p2;                                         \
+  size_t II, NN, i0, i1, i2;                                     \
+                                                                 \
+  out = (T *)(job->out) + lo;                                    \
+  NN = hi - lo;                                                  \
+  p0 = p1 = p2 = NULL;                                           \
+  i0 = i1 = i2 = 0;                                              \
+  ARITH_ARG(T, 0, p0, i0);                                       \
+  if (job->argNum > 1) { ARITH_ARG(T, 1, p1, i1); }              \
+  if (job->argNum > 2) { ARITH_ARG(T, 2, p2, i2); }              \
+  switch (job->argNum) {                                         \
+  case 1:                                                        \
+    switch (job->op) {                                           \
+    case nrrdUnaryOpNegative:                                    \
+      if (FLOATY) { ARITH_LOOP1((T)(-A)); return; }              \
+      break;                                                     \
+    case nrrdUnaryOpAbs:                                         \
+      if (FLOATY) { ARITH_LOOP1((T)AIR_ABS(A)); return; }        \
+      break;                                                     \
+    case nrrdUnaryOpSqrt:                                        \
+      if (FLOATY) { ARITH_LOOP1((T)sqrt(A)); return; }           \
+      break;                                                     \
+    }                                                            \
+    ARITH_LOOP1((T)(job->uop(A)));                               \
+    break;                                                       \
+  case 2:                                                        \
+    switch (job->op) {                                           \
+    case nrrdBinaryOpAdd:                                        \
+      ARITH_LOOP2((T)(A + B)); return;                           \
+    case nrrdBinaryOpSubtract:                                   \
+      ARITH_LOOP2((T)(A - B)); return;                           \
+    case nrrdBinaryOpMultiply:                                   \
+      ARITH_LOOP2((T)(A * B)); return;                           \
+    case nrrdBinaryOpDivide:                                     \
+      if (FLOATY) { ARITH_LOOP2((T)(A / B)); return; }           \
+      break;                                                     \
+    case nrrdBinaryOpMin:                                        \
+      ARITH_LOOP2(AIR_MIN(A, B)); return;                        \
+    case nrrdBinaryOpMax:                                        \
+      ARITH_LOOP2(AIR_MAX(A, B)); return;                        \
+    case nrrdBinaryOpLT:                                         \
+      ARITH_LOOP2((T)(A < B)); return;                           \
+    case nrrdBinaryOpLTE:                                        \
+      ARITH_LOOP2((T)(A <= B)); return;                          \
+    case nrrdBinaryOpGT:                                         \
+      ARITH_LOOP2((T)(A > B)); return;                           \
+    case nrrdBinaryOpGTE:                                        \
+      ARITH_LOOP2((T)(A >= B)); return;                          \
+    case nrrdBinaryOpEqual:                                      \
+      ARITH_LOOP2((T)(A == B)); return;                          \
+    case nrrdBinaryOpNotEqual:                                   \
+      ARITH_LOOP2((T)(A != B)); return;                          \
+    case nrrdBinaryOpAddClamp:                                   \
+      if (CLAMPOK) { ARITH_LOOP2((T)CLAMP(A + B)); return; }     \
+      break;                                                     \
+    case nrrdBinaryOpSubtractClamp:                              \
+      if (CLAMPOK) { ARITH_LOOP2((T)CLAMP(A - B)); return; }     \
+      break;                                                     \
+    case nrrdBinaryOpMultiplyClamp:                              \
+      if (CLAMPOK) { ARITH_LOOP2((T)CLAMP(A * B)); return; }     \
+      break;                                                     \
+    }                                                            \
+    if (job->clmp) {                                             \
+      ARITH_LOOP2((T)(job->clmp(job->bop(A, B))));               \
+    } else {                                                     \
+      ARITH_LOOP2((T)(job->bop(A, B)));                          \
+    }                                                            \
+    break;                                                       \
+  default:                                                       \
+    switch (job->op) {                                           \
+    case nrrdTernaryOpMin:                                       \
+      ARITH_LOOP3((B = AIR_MIN(B, C), AIR_MIN(A, B))); return;   \
+    case nrrdTernaryOpMax:                                       \
+      ARITH_LOOP3((B = AIR_MAX(B, C), AIR_MAX(A, B))); return;   \
+    case nrrdTernaryOpClamp:                                     \
+      ARITH_LOOP3(AIR_CLAMP(A, B, C)); return;                   \
+    case nrrdTernaryOpIfElse:                                    \
+      ARITH_LOOP3(A ? B : C); return;                            \
+    }                                                            \
+    ARITH_LOOP3((T)(job->top(A, B, C)));                         \
+    break;                                                       \
+  }                                                              \
+  return;                                                        \
+}
+
+#define ARITH_CLAMP_UC(v) AIR_CLAMP(0, (v), UCHAR_MAX)
+#define ARITH_CLAMP_SH(v) AIR_CLAMP(SHRT_MIN, (v), SHRT_MAX)
+#define ARITH_CLAMP_NOOP(v) (v)
+
+ARITH_FAST(UC, unsigned char, 0, 1, ARITH_CLAMP_UC)
+ARITH_FAST(SH, signed short, 0, 1, ARITH_CLAMP_SH)
+ARITH_FAST(FL, float, 1, 0, ARITH_CLAMP_NOOP)
+ARITH_FAST(DB, double, 1, 1, ARITH_CLAMP_NOOP)
+
+/*
+** _nrrdArithFixedOk
+**
+** whether fixed value val can be used as a value of the given type
+** (exactly) by _nrrdArithFast
+*/
+static int
+_nrrdArithFixedOk(int type, double val) {
+  int ret;
+
+  switch (type) {
+  case nrrdTypeUChar:
+    ret = (AIR_IN_CL(0, val, UCHAR_MAX)
+           && val == AIR_CAST(unsigned char, val));
+    break;
+  case nrrdTypeShort:
+    ret = (AIR_IN_CL(SHRT_MIN, val, SHRT_MAX)
+           && val == AIR_CAST(signed short, val));
+    break;
+  case nrrdTypeFloat:
+    ret = (AIR_IN_CL(-FLT_MAX, val, FLT_MAX)
+           && val == AIR_CAST(float, val));
+    break;
+  case nrrdTypeDouble:
+    ret = AIR_TRUE;
+    break;
+  default:
+    ret = AIR_FALSE;
+    break;
+  }
+  return ret;
+}
+
+/* whether the operation uses the (global) airRandMT RNG state */
+static int
+_nrrdArithRandom(unsigned int argNum, int op) {
+
+  return ((1 == argNum
+           && (nrrdUnaryOpRand == op || nrrdUnaryOpNormalRand == op))
+          || (2 == argNum
+              && (nrrdBinaryOpNormalRandScaleAdd == op
+                  || nrrdBinaryOpRicianRand == op)));
+}
+
+static void
+_nrrdArithRange(const _nrrdArithJob *job, size_t lo, size_t hi) {
+
+  if (job->fast) {
+    switch (job->outType) {
+    case nrrdTypeUChar:
+      _nrrdArithFastUC(job, lo, hi);
+      break;
+    case nrrdTypeShort:
+      _nrrdArithFastSH(job, lo, hi);
+      break;
+    case nrrdTypeFloat:
+      _nrrdArithFastFL(job, lo, hi);
+      break;
+    default:
+      _nrrdArithFastDB(job, lo, hi);
+      break;
+    }
+  } else {
+    _nrrdArithSlow(job, lo, hi);
+  }
+  return;
+}
+
+static void *
+_nrrdArithWorker(void *_task) {
+  _nrrdArithTask *task;
+
+  task = AIR_CAST(_nrrdArithTask *, _task);
+  _nrrdArithRange(task->job, task->lo, task->hi);
+  return _task;
+}
+
+/* fewest values for which it is worth starting another thread */
+#define _NRRD_ARITH_GRAIN 32768
+
+/*
+** _nrrdArithRun
+**
+** computes all num output values of job, after setting job->fast.
+** Operations using the RNG are done with a single thread, so that
+** their output (for a given seed) doesn't depend on nrrdDefaultThreadNum.
+*/
+static int
+_nrrdArithRun(_nrrdArithJob *job, size_t num) {
+  static const char me[]="_nrrdArithRun";
+  unsigned int ai, ti, threadNum;
+  _nrrdArithTask *task;
+  int single;
+
+  job->fast = (nrrdTypeUChar == job->outType
+               || nrrdTypeShort == job->outType
+               || nrrdTypeFloat == job->outType
+               || nrrdTypeDouble == job->outType);
+  single = _nrrdArithRandom(job->argNum, job->op);
+  for (ai=0; ai<job->argNum; ai++) {
+    const _nrrdArithArg *arg;
+    arg = job->arg + ai;
+    if (arg->data) {
+      /* fast needs the same type, and no wrapping around */
+      job->fast &= (arg->type == job->outType
+                    && arg->start + num <= arg->num);
+      if (arg->start && arg->data == job->out) {
+        /* in-place, but offset: only sequential computation gives the
+           same result as before multi-threading */
+        single = AIR_TRUE;
+      }
+    } else {
+      job->fast &= _nrrdArithFixedOk(job->outType, arg->val);
+    }
+  }
+  threadNum = single ? 1 : _nrrdThreadNum(num, num, _NRRD_ARITH_GRAIN);
+  if (1 == threadNum) {
+    _nrrdArithRange(job, 0, num);
+    return 0;
+  }
+
+  task = AIR_CALLOC(threadNum, _nrrdArithTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    return 1;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    task[ti].job = job;
+    task[ti].lo = num*ti/threadNum;
+    task[ti].hi = num*(ti+1)/threadNum;
+  }
+  if (_nrrdThreadRun(_nrrdArithWorker, task, sizeof(_nrrdArithTask),
+                     threadNum)) {
+    biffAddf(NRRD, "%s: trouble with %u threads", me, threadNum);
+    airFree(task); return 1;
+  }
+  airFree(task);
+  return 0;
+}
+
+/* sets up arg to produce the values of nin */
+static void
+_nrrdArithArgNrrd(_nrrdArithArg *arg, const Nrrd *nin) {
+
+  arg->data = nin->data;
+  arg->type = nin->type;
+  arg->num = nrrdElementNumber(nin);
+  arg->start = 0;
+  arg->val = AIR_NAN;
+  return;
+}
+
+/* sets up arg to produce the values of iter, with nrrdIterValue */
+static void
+_nrrdArithArgIter(_nrrdArithArg *arg, const NrrdIter *iter) {
+  const Nrrd *nin;
+
+  if ((nin = _NRRD_ITER_NRRD(iter))) {
+    arg->data = nin->data;
+    arg->type = nin->type;
+    arg->num = nrrdElementNumber(nin);
+    arg->start = (iter->data - AIR_CAST(const char *, nin->data))/iter->size;
+    arg->val = AIR_NAN;
+  } else {
+    arg->data = NULL;
+    arg->type = nrrdTypeDouble;
+    arg->num = 0;
+    arg->start = 0;
+    arg->val = iter->val;
+  }
+  return;
+}
+
+/* leaves iter as if nrrdIterValue had been called num times */
+static void
+_nrrdArithIterAdvance(NrrdIter *iter, size_t num) {
+  const Nrrd *nin;
+  size_t valNum, idx;
+
+  if ((nin = _NRRD_ITER_NRRD(iter))) {
+    valNum = nrrdElementNumber(nin);
+    idx = (iter->data - AIR_CAST(const char *, nin->data))/iter->size;
+    idx = (idx + num) % valNum;
+    iter->data = AIR_CAST(char *, nin->data) + idx*iter->size;
+    iter->left = valNum - 1 - idx;
+  }
+  return;
+}
+/* the clamping, if any, to do after binary operation op */
+static double
+(*_nrrdArithBinaryClamp(int op, int type))(double) {
+
+  return ((nrrdBinaryOpAddClamp == op
+           || nrrdBinaryOpSubtractClamp == op
+           || nrrdBinaryOpMultiplyClamp == op)
+          ? nrrdDClamp[type]
+          : NULL);
+}
+
 /* ---------------------------- unary -------------- */
 
 static double _nrrdUnaryOpNegative(double a)   {return -a;}
@@ -329,10 +771,7 @@ double (*_nrrdUnaryOp[NRRD_UNARY_OP_MAX+1])(double) = {
 int
 nrrdArithUnaryOp(Nrrd *nout, int op, const Nrrd *nin) {
   static const char me[]="nrrdArithUnaryOp";
-  size_t N, I;
-  int size[NRRD_DIM_MAX];
-  double (*insert)(void *v, size_t I, double d),
-    (*lookup)(const void *v, size_t I), (*uop)(double), val;
+  _nrrdArithJob job;
 
   if (!(nout && nin)) {
     biffAddf(NRRD, "%s: got NULL pointer", me);
@@ -353,15 +792,16 @@ nrrdArithUnaryOp(Nrrd *nout, int op, const Nrrd *nin) {
       return 1;
     }
   }
-  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, size);
-  uop = _nrrdUnaryOp[op];
-
-  N = nrrdElementNumber(nin);
-  lookup = nrrdDLookup[nin->type];
-  insert = nrrdDInsert[nin->type];
-  for (I=0; I<N; I++) {
-    val = lookup(nin->data, I);
-    insert(nout->data, I, uop(val));
+  memset(&job, 0, sizeof(job));
+  job.argNum = 1;
+  job.op = op;
+  job.uop = _nrrdUnaryOp[op];
+  _nrrdArithArgNrrd(job.arg + 0, nin);
+  job.out = nout->data;
+  job.outType = nout->type;
+  if (_nrrdArithRun(&job, nrrdElementNumber(nin))) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
   }
   if (nrrdContentSet_va(nout, airEnumStr(nrrdUnaryOp, op), nin, "")) {
     biffAddf(NRRD, "%s:", me);
@@ -455,10 +895,8 @@ int
 nrrdArithBinaryOp(Nrrd *nout, int op, const Nrrd *ninA, const Nrrd *ninB) {
   static const char me[]="nrrdArithBinaryOp";
   char *contA, *contB;
-  size_t N, I, size[NRRD_DIM_MAX];
-  double (*ins)(void *v, size_t I, double d), (*clmp)(double d),
-    (*lupA)(const void *v, size_t I), (*lupB)(const void *v, size_t I),
-    (*bop)(double a, double b), valA, valB;
+  size_t size[NRRD_DIM_MAX];
+  _nrrdArithJob job;
 
   if (!( nout && !nrrdCheck(ninA) && !nrrdCheck(ninB) )) {
     biffAddf(NRRD, "%s: NULL pointer or invalid args", me);
@@ -501,29 +939,18 @@ nrrdArithBinaryOp(Nrrd *nout, int op, const Nrrd *ninA, const Nrrd *ninB) {
   nrrdBasicInfoInit(nout,
                     NRRD_BASIC_INFO_ALL ^ (NRRD_BASIC_INFO_OLDMIN_BIT
                                            | NRRD_BASIC_INFO_OLDMAX_BIT));
-  bop = _nrrdBinaryOp[op];
-
-  N = nrrdElementNumber(ninA);
-  lupA = nrrdDLookup[ninA->type];
-  lupB = nrrdDLookup[ninB->type];
-  ins = nrrdDInsert[nout->type];
-  if (nrrdBinaryOpAddClamp == op
-      || nrrdBinaryOpSubtractClamp == op
-      || nrrdBinaryOpMultiplyClamp == op) {
-    clmp = nrrdDClamp[nout->type];
-  } else {
-    clmp = NULL;
-  }
-  for (I=0; I<N; I++) {
-    double tmp;
-    /* HEY: there is a loss of precision issue here with 64-bit ints */
-    valA = lupA(ninA->data, I);
-    valB = lupB(ninB->data, I);
-    tmp = bop(valA, valB);
-    if (clmp) {
-      tmp = clmp(tmp);
-    }
-    ins(nout->data, I, tmp);
+  memset(&job, 0, sizeof(job));
+  job.argNum = 2;
+  job.op = op;
+  job.bop = _nrrdBinaryOp[op];
+  job.clmp = _nrrdArithBinaryClamp(op, nout->type);
+  _nrrdArithArgNrrd(job.arg + 0, ninA);
+  _nrrdArithArgNrrd(job.arg + 1, ninB);
+  job.out = nout->data;
+  job.outType = nout->type;
+  if (_nrrdArithRun(&job, nrrdElementNumber(ninA))) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
   }
 
   contA = _nrrdContentGet(ninA);
@@ -544,10 +971,9 @@ nrrdArithIterBinaryOpSelect(Nrrd *nout, int op,
                             unsigned int which) {
   static const char me[]="nrrdArithIterBinaryOpSelect";
   char *contA, *contB;
-  size_t N, I, size[NRRD_DIM_MAX];
+  size_t N, size[NRRD_DIM_MAX];
   int type;
-  double (*insert)(void *v, size_t I, double d), (*clmp)(double d),
-    (*bop)(double a, double b), valA, valB;
+  _nrrdArithJob job;
   const Nrrd *nin;
 
   if (!(nout && inA && inB)) {
@@ -588,32 +1014,27 @@ nrrdArithIterBinaryOpSelect(Nrrd *nout, int op,
   nrrdBasicInfoInit(nout,
                     NRRD_BASIC_INFO_ALL ^ (NRRD_BASIC_INFO_OLDMIN_BIT
                                            | NRRD_BASIC_INFO_OLDMAX_BIT));
-  bop = _nrrdBinaryOp[op];
 
   /*
   fprintf(stderr, "%s: inA->left = %d, inB->left = %d\n", me,
           (int)(inA->left), (int)(inB->left));
   */
   N = nrrdElementNumber(nin);
-  insert = nrrdDInsert[type];
-  if (nrrdBinaryOpAddClamp == op
-      || nrrdBinaryOpSubtractClamp == op
-      || nrrdBinaryOpMultiplyClamp == op) {
-    clmp = nrrdDClamp[nout->type];
-  } else {
-    clmp = NULL;
-  }
-  for (I=0; I<N; I++) {
-    double tmp;
-    /* HEY: there is a loss of precision issue here with 64-bit ints */
-    valA = nrrdIterValue(inA);
-    valB = nrrdIterValue(inB);
-    tmp = bop(valA, valB);
-    if (clmp) {
-      tmp = clmp(tmp);
-    }
-    insert(nout->data, I, tmp);
+  memset(&job, 0, sizeof(job));
+  job.argNum = 2;
+  job.op = op;
+  job.bop = _nrrdBinaryOp[op];
+  job.clmp = _nrrdArithBinaryClamp(op, type);
+  _nrrdArithArgIter(job.arg + 0, inA);
+  _nrrdArithArgIter(job.arg + 1, inB);
+  job.out = nout->data;
+  job.outType = type;
+  if (_nrrdArithRun(&job, N)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
   }
+  _nrrdArithIterAdvance(inA, N);
+  _nrrdArithIterAdvance(inB, N);
   contA = nrrdIterContent(inA);
   contB = nrrdIterContent(inB);
   if (_nrrdContentSet_va(nout, airEnumStr(nrrdBinaryOp, op),
@@ -771,11 +1192,8 @@ nrrdArithTernaryOp(Nrrd *nout, int op, const Nrrd *ninA,
                    const Nrrd *ninB, const Nrrd *ninC) {
   static const char me[]="nrrdArithTernaryOp";
   char *contA, *contB, *contC;
-  size_t N, I, size[NRRD_DIM_MAX];
-  double (*ins)(void *v, size_t I, double d),
-    (*lupA)(const void *v, size_t I), (*lupB)(const void *v, size_t I),
-    (*lupC)(const void *v, size_t I),
-    (*top)(double a, double b, double c), valA, valB, valC;
+  size_t size[NRRD_DIM_MAX];
+  _nrrdArithJob job;
 
   if (!( nout && !nrrdCheck(ninA) && !nrrdCheck(ninB) && !nrrdCheck(ninC) )) {
     biffAddf(NRRD, "%s: NULL pointer or invalid args", me);
@@ -814,19 +1232,18 @@ nrrdArithTernaryOp(Nrrd *nout, int op, const Nrrd *ninA,
   nrrdBasicInfoInit(nout,
                     NRRD_BASIC_INFO_ALL ^ (NRRD_BASIC_INFO_OLDMIN_BIT
                                            | NRRD_BASIC_INFO_OLDMAX_BIT));
-  top = _nrrdTernaryOp[op];
-
-  N = nrrdElementNumber(ninA);
-  lupA = nrrdDLookup[ninA->type];
-  lupB = nrrdDLookup[ninB->type];
-  lupC = nrrdDLookup[ninC->type];
-  ins = nrrdDInsert[nout->type];
-  for (I=0; I<N; I++) {
-    /* HEY: there is a loss of precision issue here with 64-bit ints */
-    valA = lupA(ninA->data, I);
-    valB = lupB(ninB->data, I);
-    valC = lupC(ninC->data, I);
-    ins(nout->data, I, top(valA, valB, valC));
+  memset(&job, 0, sizeof(job));
+  job.argNum = 3;
+  job.op = op;
+  job.top = _nrrdTernaryOp[op];
+  _nrrdArithArgNrrd(job.arg + 0, ninA);
+  _nrrdArithArgNrrd(job.arg + 1, ninB);
+  _nrrdArithArgNrrd(job.arg + 2, ninC);
+  job.out = nout->data;
+  job.outType = nout->type;
+  if (_nrrdArithRun(&job, nrrdElementNumber(ninA))) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
   }
 
   contA = _nrrdContentGet(ninA);
@@ -850,10 +1267,9 @@ nrrdArithIterTernaryOpSelect(Nrrd *nout, int op,
                              unsigned int which) {
   static const char me[]="nrrdArithIterTernaryOpSelect";
   char *contA, *contB, *contC;
-  size_t N, I, size[NRRD_DIM_MAX];
+  size_t N, size[NRRD_DIM_MAX];
   int type;
-  double (*insert)(void *v, size_t I, double d),
-    (*top)(double a, double b, double c), valA, valB, valC;
+  _nrrdArithJob job;
   const Nrrd *nin;
 
   if (!(nout && inA && inB && inC)) {
@@ -895,28 +1311,28 @@ nrrdArithIterTernaryOpSelect(Nrrd *nout, int op,
   nrrdBasicInfoInit(nout,
                     NRRD_BASIC_INFO_ALL ^ (NRRD_BASIC_INFO_OLDMIN_BIT
                                            | NRRD_BASIC_INFO_OLDMAX_BIT));
-  top = _nrrdTernaryOp[op];
 
   /*
   fprintf(stderr, "%!s: inA->left = %d, inB->left = %d\n", me,
           (int)(inA->left), (int)(inB->left));
   */
   N = nrrdElementNumber(nin);
-  insert = nrrdDInsert[type];
-  for (I=0; I<N; I++) {
-    /* HEY: there is a loss of precision issue here with 64-bit ints */
-    valA = nrrdIterValue(inA);
-    valB = nrrdIterValue(inB);
-    valC = nrrdIterValue(inC);
-    /*
-    if (!(I % 1000)) {
-      fprintf(stderr, "!%s: %d: top(%g,%g,%g) = %g\n", me, (int)I,
-              valA, valB, valC,
-              top(valA, valB, valC));
-    }
-    */
-    insert(nout->data, I, top(valA, valB, valC));
+  memset(&job, 0, sizeof(job));
+  job.argNum = 3;
+  job.op = op;
+  job.top = _nrrdTernaryOp[op];
+  _nrrdArithArgIter(job.arg + 0, inA);
+  _nrrdArithArgIter(job.arg + 1, inB);
+  _nrrdArithArgIter(job.arg + 2, inC);
+  job.out = nout->data;
+  job.outType = type;
+  if (_nrrdArithRun(&job, N)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
   }
+  _nrrdArithIterAdvance(inA, N);
+  _nrrdArithIterAdvance(inB, N);
+  _nrrdArithIterAdvance(inC, N);
   contA = nrrdIterContent(inA);
   contB = nrrdIterContent(inB);
   contC = nrrdIterContent(inC);
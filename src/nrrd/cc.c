@@ -258,6 +258,661 @@ _nrrdCCFind_N(Nrrd *nout, unsigned int *numid, airArray *eqvArr,
   return 1;
 }
 
+/*
+** Everything below, up to nrrdCCFind, is the labeling that nrrdCCFind
+** uses for 2-D and 3-D data. It gives exactly the same ids as the first
+** pass above followed by airEqvMap, but it can be spread over
+** nrrdDefaultThreadNum threads. The volume (or the image, treated as an
+** sx-by-1-by-sy volume) is cut into slabs along the slowest axis, and
+** the id array itself is used as a union-find parent array, in which a
+** root always has the lowest index of its set:
+** 1) each slab is labeled on its own, and every sample is made to point
+**    to the root of its set within the slab
+** 2) thread 0 merges the sets that touch across each slab boundary, and
+**    points the slab roots involved (and the boundary samples) to their
+**    final roots
+** 3) each slab points its samples to their final roots, and counts the
+**    roots it contains
+** 4) the roots are numbered in raster order, which is the order in which
+**    airEqvMap numbers the components, and then every sample copies the
+**    number of its root
+** Roots are marked with _NRRD_CC_FLAG while being numbered, which is why
+** this is only used on arrays with fewer than 2^31 samples.
+*/
+#define _NRRD_CC_GRAIN 262144  /* fewest samples worth another thread */
+#define _NRRD_CC_FLAG (1U << 31)
+#define _NRRD_CC_NBR_MAX 13
+#define _NRRD_CC_CACHE 512    /* (power of 2) size of ccadj pair cache */
+
+typedef struct {
+  const void *data;           /* input values */
+  int type;                   /* type of input values */
+  unsigned int *id;           /* union-find parents, then CC ids */
+  size_t sx, sy, sz;          /* sizes of volume (sy == 1 for 2-D) */
+  unsigned int nbrNum,        /* number of neighbors visited */
+    nbrXNum,                  /* number of those not also neighbors of
+                                 the sample before along X */
+    slabNum;                  /* number of slabs (and threads) */
+  int nbr[_NRRD_CC_NBR_MAX][3],       /* neighbor coordinate offsets */
+    nbrX[_NRRD_CC_NBR_MAX][3];
+  ptrdiff_t nbrOff[_NRRD_CC_NBR_MAX],  /* and index offsets */
+    nbrXOff[_NRRD_CC_NBR_MAX];
+  size_t *slabLo;             /* slab ti is z in [slabLo[ti],
+                                 slabLo[ti+1]) */
+  unsigned int *rootNum,      /* roots in each slab, then first id */
+    idNum;                    /* total number of ids */
+  airThreadBarrier *barrier;  /* NULL when there is a single thread */
+} _nrrdCCJob;
+
+typedef struct {
+  _nrrdCCJob *job;
+  unsigned int idx,           /* which slab */
+    max;                      /* (ccadj) highest id seen */
+  airArray *pairArr;          /* (ccadj) adjacent pairs of ids */
+  unsigned int *pair,         /* (ccadj) pairArr->data */
+    cache[2*_NRRD_CC_CACHE],  /* (ccadj) recently added pairs */
+    *count;                   /* (ccsize) number of samples with each id */
+  size_t countLen;            /* (ccsize) allocated length of count */
+  int failed;                 /* (ccsize) count couldn't be grown */
+} _nrrdCCTask;
+
+/*
+** sets job->sx,sy,sz and the neighbors (which precede a sample in
+** raster order) for connectivity conny; neighbors that differ along an
+** axis of size 1 are never inside, so they're skipped
+*/
+static void
+_nrrdCCJobInit(_nrrdCCJob *job, const Nrrd *nin, unsigned int conny) {
+  static const int nbr[_NRRD_CC_NBR_MAX][3] = {
+    {-1,  0,  0}, { 0, -1,  0}, { 0,  0, -1},                 /* conny 1 */
+    {-1, -1,  0}, { 1, -1,  0}, { 0, -1, -1},
+    {-1,  0, -1}, { 1,  0, -1}, { 0,  1, -1},                 /* conny 2 */
+    {-1, -1, -1}, { 1, -1, -1}, {-1,  1, -1}, { 1,  1, -1}};  /* conny 3 */
+  unsigned int ni, num;
+
+  job->data = nin->data;
+  job->type = nin->type;
+  job->sx = nin->axis[0].size;
+  if (3 == nin->dim) {
+    job->sy = nin->axis[1].size;
+    job->sz = nin->axis[2].size;
+  } else {
+    job->sy = 1;
+    job->sz = 2 == nin->dim ? nin->axis[1].size : 1;
+  }
+  num = conny >= 3 ? 13 : (2 == conny ? 9 : 3);
+  job->nbrNum = 0;
+  for (ni=0; ni<num; ni++) {
+    if ((nbr[ni][0] && 1 == job->sx)
+        || (nbr[ni][1] && 1 == job->sy)
+        || (nbr[ni][2] && 1 == job->sz)) {
+      continue;
+    }
+    job->nbr[job->nbrNum][0] = nbr[ni][0];
+    job->nbr[job->nbrNum][1] = nbr[ni][1];
+    job->nbr[job->nbrNum][2] = nbr[ni][2];
+    job->nbrOff[job->nbrNum] = (nbr[ni][0]
+                                + AIR_CAST(ptrdiff_t, job->sx)
+                                *(nbr[ni][1]
+                                  + AIR_CAST(ptrdiff_t, job->sy)*nbr[ni][2]));
+    job->nbrNum++;
+  }
+  job->nbrXNum = 0;
+  for (ni=0; ni<job->nbrNum; ni++) {
+    unsigned int nj;
+    const int *nb;
+    nb = job->nbr[ni];
+    for (nj=0; nj<job->nbrNum; nj++) {
+      if (nb[0] + 1 == job->nbr[nj][0]
+          && nb[1] == job->nbr[nj][1]
+          && nb[2] == job->nbr[nj][2]) {
+        break;
+      }
+    }
+    if (nj < job->nbrNum || (-1 == nb[0] && !nb[1] && !nb[2])) {
+      /* shared with (or is) the sample before along X */
+      continue;
+    }
+    job->nbrX[job->nbrXNum][0] = nb[0];
+    job->nbrX[job->nbrXNum][1] = nb[1];
+    job->nbrX[job->nbrXNum][2] = nb[2];
+    job->nbrXOff[job->nbrXNum] = job->nbrOff[ni];
+    job->nbrXNum++;
+  }
+  return;
+}
+
+/* whether neighbor NB of sample (XI,YI,ZI) is inside, and at or above ZLO */
+#define _NRRD_CC_NBR_IN(NB, XI, YI, ZI, ZLO)                  \
+  (   ((NB)[0] >= 0 || (XI) > 0) && ((NB)[0] <= 0 || (XI)+1 < sx) \
+   && ((NB)[1] >= 0 || (YI) > 0) && ((NB)[1] <= 0 || (YI)+1 < sy) \
+   && ((NB)[2] >= 0 || (ZI) > (ZLO)))
+
+/* whether all neighbors of sample (XI,YI,ZI) are inside, and >= ZLO */
+#define _NRRD_CC_ALL_IN(XI, YI, ZI, ZLO)                          \
+  (   (1 == sx || ((XI) > 0 && (XI)+1 < sx))                      \
+   && (1 == sy || ((YI) > 0 && (YI)+1 < sy))                      \
+   && (1 == sz || (ZI) > (ZLO)))
+
+#define _NRRD_CC_WAIT(JOB) \
+  if ((JOB)->barrier) airThreadBarrierWait((JOB)->barrier)
+
+static unsigned int
+_nrrdCCRoot(unsigned int *id, unsigned int ii) {
+
+  while (id[ii] != ii) {
+    id[ii] = id[id[ii]];  /* path halving */
+    ii = id[ii];
+  }
+  return ii;
+}
+
+static void
+_nrrdCCLink(unsigned int *id, unsigned int aa, unsigned int bb) {
+
+  aa = _nrrdCCRoot(id, aa);
+  bb = _nrrdCCRoot(id, bb);
+  if (aa < bb) {
+    id[bb] = aa;
+  } else if (bb < aa) {
+    id[aa] = bb;
+  }
+  return;
+}
+
+#define _NRRD_CC_SLAB_LINK(OFF)                                     \
+  JJ = id[II + (OFF)];                                               \
+  if (JJ != root) {                                                  \
+    JJ = _nrrdCCRoot(id, JJ);                                        \
+  }                                                                  \
+  if (JJ < root) {                                                   \
+    id[root] = JJ;                                                   \
+    root = JJ;                                                       \
+  } else if (JJ > root) {                                            \
+    id[JJ] = root;                                                   \
+  }
+
+#define _NRRD_CC_SLAB_NBRS(NUM, NBR, OFF)                             \
+  if (_NRRD_CC_ALL_IN(xi, yi, zi, zlo)) {                             \
+    for (ni=0; ni<(NUM); ni++) {                                      \
+      if (vv == val[II + (OFF)[ni]]) {                                \
+        _NRRD_CC_SLAB_LINK((OFF)[ni]);                                \
+      }                                                               \
+    }                                                                 \
+  } else {                                                            \
+    for (ni=0; ni<(NUM); ni++) {                                      \
+      if (_NRRD_CC_NBR_IN((NBR)[ni], xi, yi, zi, zlo)                 \
+          && vv == val[II + (OFF)[ni]]) {                             \
+        _NRRD_CC_SLAB_LINK((OFF)[ni]);                                \
+      }                                                               \
+    }                                                                 \
+  }
+
+#define _NRRD_CC_SLAB(TT)                                             \
+  {                                                                   \
+    const TT *val;                                                    \
+    val = AIR_CAST(const TT *, job->data);                            \
+    for (zi=zlo; zi<zhi; zi++) {                                      \
+      for (yi=0; yi<sy; yi++) {                                       \
+        for (xi=0; xi<sx; xi++, II++) {                               \
+          TT vv;                                                      \
+          vv = val[II];                                               \
+          if (xi && vv == val[II-1]) {                                \
+            root = _nrrdCCRoot(id, id[II-1]);                         \
+            _NRRD_CC_SLAB_NBRS(job->nbrXNum, job->nbrX, job->nbrXOff); \
+          } else {                                                    \
+            root = AIR_CAST(unsigned int, II);                        \
+            _NRRD_CC_SLAB_NBRS(job->nbrNum, job->nbr, job->nbrOff);   \
+          }                                                           \
+          id[II] = root;                                              \
+        }                                                             \
+      }                                                               \
+    }                                                                 \
+  }
+
+/*
+** labels slab ti on its own, leaving every sample pointing to its root
+** within the slab. Since parents always precede their children, one
+** pass in raster order suffices for that. When a sample has the value
+** of the sample before it along X, only the neighbors that the two do
+** not share (job->nbrX) need to be visited.
+*/
+static void
+_nrrdCCSlab(_nrrdCCJob *job, unsigned int ti) {
+  unsigned int *id, ni, root, JJ;
+  size_t sx, sy, sz, xi, yi, zi, zlo, zhi, II, I0;
+
+  id = job->id;
+  sx = job->sx; sy = job->sy; sz = job->sz;
+  zlo = job->slabLo[ti];
+  zhi = job->slabLo[ti+1];
+  I0 = II = sx*sy*zlo;
+  switch (job->type) {
+  case nrrdTypeUChar:
+    _NRRD_CC_SLAB(unsigned char);
+    break;
+  case nrrdTypeUShort:
+    _NRRD_CC_SLAB(unsigned short);
+    break;
+  case nrrdTypeUInt:
+    _NRRD_CC_SLAB(unsigned int);
+    break;
+  }
+  for (II=I0; II<sx*sy*zhi; II++) {
+    id[II] = id[id[II]];
+  }
+  return;
+}
+
+/*
+** merges sets across the slab boundaries, which are then at most the
+** roots of the slabs, or the samples on either side of a boundary. Those
+** are the only entries changed, and are left pointing to final roots.
+*/
+static void
+_nrrdCCBoundary(_nrrdCCJob *job) {
+  unsigned int (*lup)(const void *, size_t), *id, si, ni;
+  size_t sx, sy, xi, yi, zi, II, JJ;
+
+  lup = nrrdUILookup[job->type];
+  id = job->id;
+  sx = job->sx; sy = job->sy;
+  for (si=1; si<job->slabNum; si++) {
+    zi = job->slabLo[si];
+    II = sx*sy*zi;
+    for (yi=0; yi<sy; yi++) {
+      for (xi=0; xi<sx; xi++, II++) {
+        for (ni=0; ni<job->nbrNum; ni++) {
+          if (job->nbr[ni][2] < 0
+              && _NRRD_CC_NBR_IN(job->nbr[ni], xi, yi, zi, 0)) {
+            JJ = II + job->nbrOff[ni];
+            if (lup(job->data, II) == lup(job->data, JJ)) {
+              /* starting from the parents means that only roots (of
+                 slabs or of merged sets) are ever changed */
+              _nrrdCCLink(id, id[II], id[JJ]);
+            }
+          }
+        }
+      }
+    }
+  }
+  for (si=1; si<job->slabNum; si++) {
+    for (II=sx*sy*(job->slabLo[si]-1); II<sx*sy*(job->slabLo[si]+1); II++) {
+      JJ = _nrrdCCRoot(id, id[II]);
+      id[id[II]] = AIR_CAST(unsigned int, JJ);
+      id[II] = AIR_CAST(unsigned int, JJ);
+    }
+  }
+  return;
+}
+
+static void *
+_nrrdCCFindWorker(void *_task) {
+  _nrrdCCTask *task;
+  _nrrdCCJob *job;
+  unsigned int *id, ti, rr, pp, num;
+  size_t II, I0, I1;
+
+  task = AIR_CAST(_nrrdCCTask *, _task);
+  job = task->job;
+  id = job->id;
+  I0 = job->sx*job->sy*job->slabLo[task->idx];
+  I1 = job->sx*job->sy*job->slabLo[task->idx+1];
+  _nrrdCCSlab(job, task->idx);
+  _NRRD_CC_WAIT(job);
+  if (!task->idx) {
+    _nrrdCCBoundary(job);
+  }
+  _NRRD_CC_WAIT(job);
+  /* every slab root now points to its final root, so one more step
+     takes every sample there, without ever reading an entry of another
+     slab that is being changed */
+  num = 0;
+  for (II=I0; II<I1; II++) {
+    pp = id[II];
+    if (pp == II) {
+      num++;
+    } else {
+      rr = id[pp];
+      if (rr != pp) {
+        id[II] = rr;
+      }
+    }
+  }
+  job->rootNum[task->idx] = num;
+  _NRRD_CC_WAIT(job);
+  if (!task->idx) {
+    num = 0;
+    for (ti=0; ti<job->slabNum; ti++) {
+      rr = job->rootNum[ti];
+      job->rootNum[ti] = num;
+      num += rr;
+    }
+    job->idNum = num;
+  }
+  _NRRD_CC_WAIT(job);
+  num = job->rootNum[task->idx];
+  for (II=I0; II<I1; II++) {
+    if (id[II] == II) {
+      id[II] = (num++) | _NRRD_CC_FLAG;
+    }
+  }
+  _NRRD_CC_WAIT(job);
+  for (II=I0; II<I1; II++) {
+    if (!(id[II] & _NRRD_CC_FLAG)) {
+      id[II] = id[id[II]] & ~_NRRD_CC_FLAG;
+    }
+  }
+  _NRRD_CC_WAIT(job);
+  for (II=I0; II<I1; II++) {
+    id[II] &= ~_NRRD_CC_FLAG;
+  }
+  return _task;
+}
+
+/*
+** sets up slabs and tasks for threadNum threads, runs worker on them,
+** and (for ccadj) frees the pair arrays afterwards by way of the mop
+*/
+static int
+_nrrdCCRun(_nrrdCCJob *job, _nrrdCCTask *task, unsigned int threadNum,
+           void *(*worker)(void *), airArray *mop) {
+  static const char me[]="_nrrdCCRun";
+  unsigned int ti;
+
+  job->slabNum = threadNum;
+  job->slabLo = AIR_CALLOC(threadNum+1, size_t);
+  job->rootNum = AIR_CALLOC(threadNum, unsigned int);
+  if (!(job->slabLo && job->rootNum)) {
+    biffAddf(NRRD, "%s: couldn't allocate slabs", me);
+    airFree(job->slabLo); airFree(job->rootNum);
+    return 1;
+  }
+  airMopAdd(mop, job->slabLo, airFree, airMopAlways);
+  airMopAdd(mop, job->rootNum, airFree, airMopAlways);
+  for (ti=0; ti<=threadNum; ti++) {
+    job->slabLo[ti] = ti*job->sz/threadNum;
+  }
+  for (ti=0; ti<threadNum; ti++) {
+    task[ti].job = job;
+    task[ti].idx = ti;
+  }
+  job->barrier = NULL;
+  if (threadNum > 1) {
+    job->barrier = airThreadBarrierNew(threadNum);
+    if (!job->barrier) {
+      biffAddf(NRRD, "%s: couldn't allocate barrier", me);
+      return 1;
+    }
+    airMopAdd(mop, job->barrier, (airMopper)airThreadBarrierNix,
+              airMopAlways);
+  }
+  /* either all the workers run (so they all reach the barrier), or none */
+  if (_nrrdThreadRun(worker, task, sizeof(_nrrdCCTask), threadNum)) {
+    biffAddf(NRRD, "%s: trouble with %u threads", me, threadNum);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** labels the CCs of 2-D or 3-D nin (with fewer than 2^31 samples) into
+** id, and sets *numid to the number of CCs
+*/
+static int
+_nrrdCCLabel(unsigned int *id, unsigned int *numid, const Nrrd *nin,
+             unsigned int conny) {
+  static const char me[]="_nrrdCCLabel";
+  _nrrdCCJob job;
+  _nrrdCCTask *task;
+  unsigned int threadNum;
+  airArray *mop;
+
+  mop = airMopNew();
+  _nrrdCCJobInit(&job, nin, conny);
+  job.id = id;
+  threadNum = _nrrdThreadNum(job.sz, nrrdElementNumber(nin),
+                             _NRRD_CC_GRAIN);
+  task = AIR_CALLOC(threadNum, _nrrdCCTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  if (_nrrdCCRun(&job, task, threadNum, _nrrdCCFindWorker, mop)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  *numid = job.idNum;
+  airMopOkay(mop);
+  return 0;
+}
+
+#define _NRRD_CC_ADJ(TT)                                                \
+  {                                                                     \
+    const TT *val;                                                      \
+    val = AIR_CAST(const TT *, job->data);                              \
+    for (zi=zlo; zi<zhi; zi++) {                                        \
+      for (yi=0; yi<sy; yi++) {                                         \
+        for (xi=0; xi<sx; xi++, II++) {                                 \
+          vv = AIR_CAST(unsigned int, val[II]);                         \
+          max = AIR_MAX(max, vv);                                       \
+          all = _NRRD_CC_ALL_IN(xi, yi, zi, 0);                         \
+          for (ni=0; ni<nbrNum; ni++) {                                 \
+            if (all || _NRRD_CC_NBR_IN(job->nbr[ni], xi, yi, zi, 0)) {  \
+              pv = AIR_CAST(unsigned int, val[II + job->nbrOff[ni]]);   \
+              if (pv != vv) {                                           \
+                _nrrdCCPairAdd(task, AIR_MIN(pv, vv), AIR_MAX(pv, vv)); \
+              }                                                         \
+            }                                                           \
+          }                                                             \
+        }                                                               \
+      }                                                                 \
+    }                                                                   \
+  }
+
+/*
+** records that ids lo < hi are adjacent, unless that was among the
+** pairs recently recorded
+*/
+static void
+_nrrdCCPairAdd(_nrrdCCTask *task, unsigned int lo, unsigned int hi) {
+  unsigned int ci, pi;
+
+  ci = 2*((lo*31 + hi) & (_NRRD_CC_CACHE-1));
+  if (task->cache[0 + ci] == lo && task->cache[1 + ci] == hi) {
+    return;
+  }
+  task->cache[0 + ci] = lo;
+  task->cache[1 + ci] = hi;
+  pi = airArrayLenIncr(task->pairArr, 1);
+  if (task->pair) {
+    task->pair[0 + 2*pi] = lo;
+    task->pair[1 + 2*pi] = hi;
+  }
+  return;
+}
+
+/*
+** finds the highest id and the adjacent pairs of ids in one slab; the
+** neighbors may be in another slab, since nothing is written there
+*/
+static void *
+_nrrdCCAdjWorker(void *_task) {
+  _nrrdCCTask *task;
+  _nrrdCCJob *job;
+  unsigned int ni, nbrNum, vv, pv, max;
+  size_t sx, sy, sz, xi, yi, zi, zlo, zhi, II;
+  int all;
+
+  task = AIR_CAST(_nrrdCCTask *, _task);
+  job = task->job;
+  sx = job->sx; sy = job->sy; sz = job->sz;
+  nbrNum = job->nbrNum;
+  zlo = job->slabLo[task->idx];
+  zhi = job->slabLo[task->idx+1];
+  II = sx*sy*zlo;
+  max = 0;
+  switch (job->type) {
+  case nrrdTypeChar:
+    _NRRD_CC_ADJ(signed char);
+    break;
+  case nrrdTypeUChar:
+    _NRRD_CC_ADJ(unsigned char);
+    break;
+  case nrrdTypeShort:
+    _NRRD_CC_ADJ(signed short);
+    break;
+  case nrrdTypeUShort:
+    _NRRD_CC_ADJ(unsigned short);
+    break;
+  case nrrdTypeInt:
+    _NRRD_CC_ADJ(signed int);
+    break;
+  case nrrdTypeUInt:
+    _NRRD_CC_ADJ(unsigned int);
+    break;
+  }
+  task->max = max;
+  return _task;
+}
+
+#define _NRRD_CC_COUNT(TT)                                              \
+  {                                                                     \
+    const TT *val;                                                      \
+    val = AIR_CAST(const TT *, job->data);                              \
+    for (II=I0; II<I1; II++) {                                          \
+      vv = AIR_CAST(unsigned int, val[II]);                             \
+      if (vv >= task->countLen && _nrrdCCCountGrow(task, vv)) {        \
+        return _task;                                                   \
+      }                                                                 \
+      task->count[vv]++;                                                \
+      max = AIR_MAX(max, vv);                                           \
+    }                                                                   \
+  }
+
+static int
+_nrrdCCCountGrow(_nrrdCCTask *task, unsigned int vv) {
+  unsigned int *count;
+  size_t len;
+
+  len = AIR_MAX(2*task->countLen, AIR_CAST(size_t, vv) + 1);
+  len = AIR_MAX(len, 256);
+  count = AIR_CAST(unsigned int *, realloc(task->count,
+                                           len*sizeof(unsigned int)));
+  if (!count) {
+    task->failed = AIR_TRUE;
+    return 1;
+  }
+  memset(count + task->countLen, 0,
+         (len - task->countLen)*sizeof(unsigned int));
+  task->count = count;
+  task->countLen = len;
+  return 0;
+}
+
+/*
+** counts the ids in one chunk of samples, into a count array that
+** grows as higher ids are seen
+*/
+static void *
+_nrrdCCSizeWorker(void *_task) {
+  _nrrdCCTask *task;
+  _nrrdCCJob *job;
+  unsigned int vv, max;
+  size_t II, I0, I1;
+
+  task = AIR_CAST(_nrrdCCTask *, _task);
+  job = task->job;
+  I0 = job->slabLo[task->idx];
+  I1 = job->slabLo[task->idx+1];
+  max = 0;
+  switch (job->type) {
+  case nrrdTypeChar:
+    _NRRD_CC_COUNT(signed char);
+    break;
+  case nrrdTypeUChar:
+    _NRRD_CC_COUNT(unsigned char);
+    break;
+  case nrrdTypeShort:
+    _NRRD_CC_COUNT(signed short);
+    break;
+  case nrrdTypeUShort:
+    _NRRD_CC_COUNT(unsigned short);
+    break;
+  case nrrdTypeInt:
+    _NRRD_CC_COUNT(signed int);
+    break;
+  case nrrdTypeUInt:
+    _NRRD_CC_COUNT(unsigned int);
+    break;
+  }
+  task->max = max;
+  return _task;
+}
+
+/*
+** the work of nrrdCCSize: allocates nout to hold, for every id up to
+** the highest one in nin, the number of samples with that id. This takes
+** a single pass through nin, split among threads.
+*/
+int
+_nrrdCCSizeCount(Nrrd *nout, const Nrrd *nin) {
+  static const char me[]="_nrrdCCSizeCount";
+  _nrrdCCJob job;
+  _nrrdCCTask *task;
+  unsigned int maxid, threadNum, ti, *out;
+  size_t NN, II;
+  airArray *mop;
+  int ret;
+
+  mop = airMopNew();
+  NN = nrrdElementNumber(nin);
+  /* the samples are chunked as if they were one column */
+  job.data = nin->data;
+  job.type = nin->type;
+  job.sx = job.sy = 1;
+  job.sz = NN;
+  job.nbrNum = 0;
+  threadNum = _nrrdThreadNum(NN, NN, _NRRD_CC_GRAIN);
+  task = AIR_CALLOC(threadNum, _nrrdCCTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  ret = _nrrdCCRun(&job, task, threadNum, _nrrdCCSizeWorker, mop);
+  for (ti=0; ti<threadNum; ti++) {
+    airMopAdd(mop, task[ti].count, airFree, airMopAlways);
+  }
+  if (ret) {
+    biffAddf(NRRD, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  maxid = 0;
+  for (ti=0; ti<threadNum; ti++) {
+    if (task[ti].failed) {
+      biffAddf(NRRD, "%s: couldn't allocate counts in chunk %u", me, ti);
+      airMopError(mop); return 1;
+    }
+    maxid = AIR_MAX(maxid, task[ti].max);
+  }
+  if (nrrdMaybeAlloc_va(nout, nrrdTypeUInt, 1,
+                        AIR_CAST(size_t, maxid) + 1)) {
+    biffAddf(NRRD, "%s: can't allocate output", me);
+    airMopError(mop); return 1;
+  }
+  out = AIR_CAST(unsigned int *, nout->data);
+  for (ti=0; ti<threadNum; ti++) {
+    for (II=0; II<=maxid && II<task[ti].countLen; II++) {
+      out[II] += task[ti].count[II];
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+}
+
 /*
 ******** nrrdCCFind
 **
@@ -276,6 +931,9 @@ _nrrdCCFind_N(Nrrd *nout, unsigned int *numid, airArray *eqvArr,
 ** The caller can get a record of the values in each CC by passing a
 ** non-NULL nval, which will be allocated to an array of the same type
 ** as nin, so that nval->data[I] is the value in nin inside CC #I.
+**
+** For 2-D and 3-D data, the labeling is split among nrrdDefaultThreadNum
+** threads, with no change in the output.
 */
 int
 nrrdCCFind(Nrrd *nout, Nrrd **nvalP, const Nrrd *nin, int type,
@@ -334,36 +992,44 @@ nrrdCCFind(Nrrd *nout, Nrrd **nvalP, const Nrrd *nin, int type,
 
   mop = airMopNew();
   airMopAdd(mop, nfpid, (airMopper)nrrdNuke, airMopAlways);
-  eqvArr = airArrayNew(NULL, NULL, 2*sizeof(unsigned int), _nrrdCC_EqvIncr);
-  airMopAdd(mop, eqvArr, (airMopper)airArrayNuke, airMopAlways);
-  ret = 0;
-  switch(nin->dim) {
-  case 1:
-    ret = _nrrdCCFind_1(nfpid, &numid, nin);
-    break;
-  case 2:
-    ret = _nrrdCCFind_2(nfpid, &numid, eqvArr, nin, conny);
-    break;
-  case 3:
-    ret = _nrrdCCFind_3(nfpid, &numid, eqvArr, nin, conny);
-    break;
-  default:
-    ret = _nrrdCCFind_N(nfpid, &numid, eqvArr, nin, conny);
-    break;
-  }
-  if (ret) {
-    biffAddf(NRRD, "%s: initial pass failed", me);
-    airMopError(mop); return 1;
-  }
-
-  map = AIR_MALLOC(numid, unsigned int);
-  airMopAdd(mop, map, airFree, airMopAlways);
-  numsettleid = airEqvMap(eqvArr, map, numid);
-  /* convert fpid values to final id values */
   fpid = (unsigned int*)(nfpid->data);
   NN = nrrdElementNumber(nfpid);
-  for (I=0; I<NN; I++) {
-    fpid[I] = map[fpid[I]];
+  if ((2 == nin->dim || 3 == nin->dim) && NN < _NRRD_CC_FLAG) {
+    if (_nrrdCCLabel(fpid, &numsettleid, nin, conny)) {
+      biffAddf(NRRD, "%s: trouble labeling", me);
+      airMopError(mop); return 1;
+    }
+  } else {
+    eqvArr = airArrayNew(NULL, NULL, 2*sizeof(unsigned int),
+                         _nrrdCC_EqvIncr);
+    airMopAdd(mop, eqvArr, (airMopper)airArrayNuke, airMopAlways);
+    ret = 0;
+    switch(nin->dim) {
+    case 1:
+      ret = _nrrdCCFind_1(nfpid, &numid, nin);
+      break;
+    case 2:
+      ret = _nrrdCCFind_2(nfpid, &numid, eqvArr, nin, conny);
+      break;
+    case 3:
+      ret = _nrrdCCFind_3(nfpid, &numid, eqvArr, nin, conny);
+      break;
+    default:
+      ret = _nrrdCCFind_N(nfpid, &numid, eqvArr, nin, conny);
+      break;
+    }
+    if (ret) {
+      biffAddf(NRRD, "%s: initial pass failed", me);
+      airMopError(mop); return 1;
+    }
+
+    map = AIR_MALLOC(numid, unsigned int);
+    airMopAdd(mop, map, airFree, airMopAlways);
+    numsettleid = airEqvMap(eqvArr, map, numid);
+    /* convert fpid values to final id values */
+    for (I=0; I<NN; I++) {
+      fpid[I] = map[fpid[I]];
+    }
   }
   if (nvalP) {
     if (!(*nvalP)) {
@@ -418,129 +1084,16 @@ nrrdCCFind(Nrrd *nout, Nrrd **nvalP, const Nrrd *nin, int type,
   return 0;
 }
 
-int
-_nrrdCCAdj_1(unsigned char *out, int numid, const Nrrd *nin) {
-
-  AIR_UNUSED(out);
-  AIR_UNUSED(numid);
-  AIR_UNUSED(nin);
-  return 0;
-}
-
-int
-_nrrdCCAdj_2(unsigned char *out, unsigned int numid, const Nrrd *nin,
-             unsigned int conny) {
-  unsigned int (*lup)(const void *, size_t), x, y, sx, sy, id=0;
-  double pid[5]={0,0,0,0,0};
-
-  lup = nrrdUILookup[nin->type];
-  sx = AIR_CAST(unsigned int, nin->axis[0].size);
-  sy = AIR_CAST(unsigned int, nin->axis[1].size);
-  for (y=0; y<sy; y++) {
-    for (x=0; x<sx; x++) {
-      if (!x) {
-        pid[1] = GETV_2(-1, y);
-        pid[2] = GETV_2(-1, y-1);
-        pid[3] = GETV_2(0, y-1);
-      } else {
-        pid[1] = id;
-        pid[2] = pid[3];
-        pid[3] = pid[4];
-      }
-      pid[4] = GETV_2(x+1, y-1);
-      id = AIR_CAST(unsigned int, GETV_2(x, y));
-#define TADJ(P) \
-      if (pid[(P)] != 0.5 && id != pid[(P)]) { \
-        out[id + numid*AIR_CAST(unsigned int, pid[(P)])] = \
-          out[AIR_CAST(unsigned int, pid[(P)]) + numid*id] = 1; \
-      }
-      TADJ(1);
-      TADJ(3);
-      if (2 == conny) {
-        TADJ(2);
-        TADJ(4);
-      }
-    }
-  }
-
-  return 0;
-}
-
-int
-_nrrdCCAdj_3(unsigned char *out, int numid, const Nrrd *nin,
-             unsigned int conny) {
-  unsigned int (*lup)(const void *, size_t), x, y, z, sx, sy, sz, id=0;
-  double pid[14]={0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-
-  lup = nrrdUILookup[nin->type];
-  sx = AIR_CAST(unsigned int, nin->axis[0].size);
-  sy = AIR_CAST(unsigned int, nin->axis[1].size);
-  sz = AIR_CAST(unsigned int, nin->axis[2].size);
-  for (z=0; z<sz; z++) {
-    for (y=0; y<sy; y++) {
-      for (x=0; x<sx; x++) {
-        if (!x) {
-          pid[ 1] = GETV_3(-1,   y,   z);
-          pid[ 2] = GETV_3(-1, y-1,   z);
-          pid[ 3] = GETV_3( 0, y-1,   z);
-          pid[ 5] = GETV_3(-1, y-1, z-1);
-          pid[ 8] = GETV_3(-1,   y, z-1);
-          pid[11] = GETV_3(-1, y+1, z-1);
-          pid[ 6] = GETV_3( 0, y-1, z-1);
-          pid[ 9] = GETV_3( 0,   y, z-1);
-          pid[12] = GETV_3( 0, y+1, z-1);
-        } else {
-          pid[ 1] = id;
-          pid[ 2] = pid[ 3];
-          pid[ 3] = pid[ 4];
-          pid[ 5] = pid[ 6];
-          pid[ 8] = pid[ 9];
-          pid[11] = pid[12];
-          pid[ 6] = pid[ 7];
-          pid[ 9] = pid[10];
-          pid[12] = pid[13];
-        }
-        pid[ 4] = GETV_3(x+1, y-1,   z);
-        pid[ 7] = GETV_3(x+1, y-1, z-1);
-        pid[10] = GETV_3(x+1,   y, z-1);
-        pid[13] = GETV_3(x+1, y+1, z-1);
-        id = AIR_CAST(unsigned int, GETV_3(x, y, z));
-        TADJ(1);
-        TADJ(3);
-        TADJ(9);
-        if (2 <= conny) {
-          TADJ(2); TADJ(4);
-          TADJ(6); TADJ(8); TADJ(10); TADJ(12);
-          if (3 == conny) {
-            TADJ(5); TADJ(7); TADJ(11); TADJ(13);
-          }
-        }
-      }
-    }
-  }
-
-  return 0;
-}
-
-int
-_nrrdCCAdj_N(unsigned char *out, int numid, const Nrrd *nin,
-             unsigned int conny) {
-  static const char me[]="_nrrdCCAdj_N";
-
-  AIR_UNUSED(out);
-  AIR_UNUSED(numid);
-  AIR_UNUSED(nin);
-  AIR_UNUSED(conny);
-  biffAddf(NRRD, "%s: sorry, not implemented", me);
-  return 1;
-}
-
 int
 nrrdCCAdjacency(Nrrd *nout, const Nrrd *nin, unsigned int conny) {
   static const char me[]="nrrdCCAdjacency", func[]="ccadj";
-  int ret;
-  unsigned int maxid;
+  _nrrdCCJob job;
+  _nrrdCCTask *task;
+  airPtrPtrUnion appu;
+  unsigned int maxid, threadNum, ti, pi, *pair;
   unsigned char *out;
+  size_t numid;
+  airArray *mop;
 
   if (!( nout && nrrdCCValid(nin) )) {
     biffAddf(NRRD, "%s: invalid args", me);
@@ -555,32 +1108,59 @@ nrrdCCAdjacency(Nrrd *nout, const Nrrd *nin, unsigned int conny) {
              "data (not %d)", me, nin->dim, nin->dim, conny);
     return 1;
   }
-  maxid = nrrdCCMax(nin);
-  if (nrrdMaybeAlloc_va(nout, nrrdTypeUChar, 2,
-                        AIR_CAST(size_t, maxid+1),
-                        AIR_CAST(size_t, maxid+1))) {
-    biffAddf(NRRD, "%s: trouble allocating output", me);
+  if (nin->dim > 3) {
+    biffAddf(NRRD, "%s: sorry, not implemented for %u-D data", me, nin->dim);
     return 1;
   }
-  out = (unsigned char *)(nout->data);
 
-  switch(nin->dim) {
-  case 1:
-    ret = _nrrdCCAdj_1(out, maxid+1, nin);
-    break;
-  case 2:
-    ret = _nrrdCCAdj_2(out, maxid+1, nin, conny);
-    break;
-  case 3:
-    ret = _nrrdCCAdj_3(out, maxid+1, nin, conny);
-    break;
-  default:
-    ret = _nrrdCCAdj_N(out, maxid+1, nin, conny);
-    break;
+  /* one pass, over slabs, finds both the highest id and the pairs of
+     adjacent ids; the pairs are set in the output afterwards */
+  mop = airMopNew();
+  _nrrdCCJobInit(&job, nin, conny);
+  if (1 == nin->dim) {
+    /* adjacencies have never been recorded for 1-D data */
+    job.nbrNum = 0;
   }
-  if (ret) {
+  threadNum = _nrrdThreadNum(job.sz, nrrdElementNumber(nin),
+                             _NRRD_CC_GRAIN);
+  task = AIR_CALLOC(threadNum, _nrrdCCTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  for (ti=0; ti<threadNum; ti++) {
+    appu.ui = &(task[ti].pair);
+    task[ti].pairArr = airArrayNew(appu.v, NULL, 2*sizeof(unsigned int),
+                                   _nrrdCC_EqvIncr);
+    airMopAdd(mop, task[ti].pairArr, (airMopper)airArrayNuke,
+              airMopAlways);
+  }
+  if (_nrrdCCRun(&job, task, threadNum, _nrrdCCAdjWorker, mop)) {
     biffAddf(NRRD, "%s: trouble", me);
-    return 1;
+    airMopError(mop); return 1;
+  }
+  maxid = 0;
+  for (ti=0; ti<threadNum; ti++) {
+    if (task[ti].pairArr->len && !task[ti].pair) {
+      biffAddf(NRRD, "%s: couldn't allocate adjacent pairs in slab %u",
+               me, ti);
+      airMopError(mop); return 1;
+    }
+    maxid = AIR_MAX(maxid, task[ti].max);
+  }
+  numid = AIR_CAST(size_t, maxid) + 1;
+  if (nrrdMaybeAlloc_va(nout, nrrdTypeUChar, 2, numid, numid)) {
+    biffAddf(NRRD, "%s: trouble allocating output", me);
+    airMopError(mop); return 1;
+  }
+  out = (unsigned char *)(nout->data);
+  for (ti=0; ti<threadNum; ti++) {
+    pair = task[ti].pair;
+    for (pi=0; pi<task[ti].pairArr->len; pi++) {
+      out[pair[0 + 2*pi] + numid*pair[1 + 2*pi]] =
+        out[pair[1 + 2*pi] + numid*pair[0 + 2*pi]] = 1;
+    }
   }
   /* this goofiness is just so that histo-based projections
      return the sorts of values that we expect */
@@ -589,9 +1169,10 @@ nrrdCCAdjacency(Nrrd *nout, const Nrrd *nin, unsigned int conny) {
   nout->axis[0].max = nout->axis[1].max = maxid + 0.5;
   if (nrrdContentSet_va(nout, func, nin, "%d", conny)) {
     biffAddf(NRRD, "%s:", me);
-    return 1;
+    airMopError(mop); return 1;
   }
 
+  airMopOkay(mop);
   return 0;
 }
 
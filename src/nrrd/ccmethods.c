@@ -59,25 +59,15 @@ nrrdCCValid(const Nrrd *nin) {
 unsigned int
 nrrdCCSize(Nrrd *nout, const Nrrd *nin) {
   static const char me[]="nrrdCCSize", func[]="ccsize";
-  unsigned int *out, maxid, (*lup)(const void *, size_t);
-  size_t I, NN;
 
   if (!( nout && nrrdCCValid(nin) )) {
     biffAddf(NRRD, "%s: invalid args", me);
     return 1;
   }
-  maxid = nrrdCCMax(nin);
-  if (nrrdMaybeAlloc_va(nout, nrrdTypeUInt, 1,
-                        AIR_CAST(size_t, maxid+1))) {
-    biffAddf(NRRD, "%s: can't allocate output", me);
+  if (_nrrdCCSizeCount(nout, nin)) {
+    biffAddf(NRRD, "%s: trouble counting", me);
     return 1;
   }
-  out = (unsigned int *)(nout->data);
-  lup = nrrdUILookup[nin->type];
-  NN = nrrdElementNumber(nin);
-  for (I=0; I<NN; I++) {
-    out[lup(nin->data, I)] += 1;
-  }
   if (nrrdContentSet_va(nout, func, nin, "")) {
     biffAddf(NRRD, "%s:", me);
     return 1;
@@ -53,6 +53,10 @@ int nrrdDefaultResampleCheap = AIR_FALSE;
 double nrrdDefaultResamplePadValue = 0.0;
 int nrrdDefaultResampleNonExistent = nrrdResampleNonExistentNoop;
 double nrrdDefaultKernelParm0 = 1.0;
+/* number of threads used by multi-threaded operations when not
+   otherwise specified: element-wise arithmetic (nrrdArith*Op), and
+   the initial value for nrrdResampleContext */
+unsigned int nrrdDefaultThreadNum = 1;
 /* ---- END non-NrrdIO */
 int nrrdDefaultCenter = nrrdCenterCell;
 double nrrdDefaultSpacing = 1.0;
@@ -124,6 +128,8 @@ const char *const nrrdEnvVarDefaultKernelParm0
   = "NRRD_DEFAULT_KERNEL_PARM0";
 const char *const nrrdEnvVarDefaultSpacing
   = "NRRD_DEFAULT_SPACING";
+const char *const nrrdEnvVarDefaultThreadNum
+  = "NRRD_DEFAULT_THREAD_NUM";
 
 const char *const nrrdEnvVarStateKindNoop
   = "NRRD_STATE_KIND_NOOP";
@@ -324,6 +330,8 @@ nrrdDefaultGetenv(void) {
                    nrrdEnvVarDefaultKernelParm0);
   nrrdGetenvDouble(/**/ &nrrdDefaultSpacing, NULL,
                    nrrdEnvVarDefaultSpacing);
+  nrrdGetenvUInt(/**/ &nrrdDefaultThreadNum, NULL,
+                 nrrdEnvVarDefaultThreadNum);
 
   return;
 }
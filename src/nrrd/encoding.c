@@ -107,5 +107,6 @@ nrrdEncodingArray[NRRD_ENCODING_TYPE_MAX+1] = {
   &_nrrdEncodingGzip,
   &_nrrdEncodingBzip2,
   &_nrrdEncodingZRL,
+  &_nrrdEncodingGzipBlocked,
 };
 
@@ -204,21 +204,14 @@ _nrrdEncodingGzip_read(FILE *file, void *_data, size_t elNum,
 #endif
 }
 
-static int
-_nrrdEncodingGzip_write(FILE *file, const void *_data, size_t elNum,
-                        const Nrrd *nrrd, NrrdIoState *nio) {
-  static const char me[]="_nrrdEncodingGzip_write";
-#if TEEM_ZLIB
-  size_t sizeData, sizeWrit;
-  int fmt_i=0, error;
-  const char *data;
-  char fmt[4];
-  gzFile gzfout;
-  unsigned int wrote, sizeChunk;
-
-  sizeData = nrrdElementSize(nrrd)*elNum;
+/*
+** sets the gzopen() mode string for writing, based on the NrrdIoState
+** parameters; also used by streamNrrd.c
+*/
+void
+_nrrdGzWriteMode(char fmt[4], const NrrdIoState *nio) {
+  int fmt_i=0;
 
-  /* Set format string based on the NrrdIoState parameters. */
   fmt[fmt_i++] = 'w';
   if (0 <= nio->zlibLevel && nio->zlibLevel <= 9)
     fmt[fmt_i++] = AIR_CAST(char, '0' + nio->zlibLevel);
@@ -234,6 +227,24 @@ _nrrdEncodingGzip_write(FILE *file, const void *_data, size_t elNum,
     break;
   }
   fmt[fmt_i] = 0;
+  return;
+}
+
+static int
+_nrrdEncodingGzip_write(FILE *file, const void *_data, size_t elNum,
+                        const Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdEncodingGzip_write";
+#if TEEM_ZLIB
+  size_t sizeData, sizeWrit;
+  int error;
+  const char *data;
+  char fmt[4];
+  gzFile gzfout;
+  unsigned int wrote, sizeChunk;
+
+  sizeData = nrrdElementSize(nrrd)*elNum;
+
+  _nrrdGzWriteMode(fmt, nio);
 
   /* Create the gzFile for writing in the gzipped data. */
   if ((gzfout = _nrrdGzOpen(file, fmt)) == Z_NULL) {
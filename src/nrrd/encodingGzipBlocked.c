@@ -0,0 +1,738 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "nrrd.h"
+#include "privateNrrd.h"
+
+/*
+** The "gzip-blocked" encoding: the raw data is cut into blocks of
+** nio->zlibBlockSize bytes (the last one may be shorter), and each block
+** is compressed independently into its own gzip member.  Concatenated
+** gzip members are still a valid gzip stream, so gunzip (or the "gzip"
+** encoding) can read the data.  Each member header carries, in a gzip
+** "extra" subfield with ID "NB", the total length of the member and the
+** length of the uncompressed block, so that a reader can hop from block
+** to block without inflating anything.  Since blocks are independent,
+** they are compressed and decompressed in parallel (nio->threadNum), and
+** blocks wholly outside the data of interest (as with byte skip) are
+** never inflated.
+**
+** member layout (multi-byte values little-endian):
+**   0: 0x1f 0x8b 0x08 (deflate) 0x04 (FEXTRA)
+**   4: mtime (0, 4 bytes), xfl (0), os (255)
+**  10: xlen (12, 2 bytes)
+**  12: 'N' 'B', subfield length (8, 2 bytes)
+**  16: member length (4 bytes), block length (4 bytes)
+**  24: raw deflate stream
+** end: crc32 of block (4 bytes), block length (4 bytes)
+*/
+
+#define GZB_HEAD 24
+#define GZB_TAIL 8
+
+static int
+_nrrdEncodingGzipBlocked_available(void) {
+
+#if TEEM_ZLIB
+  return AIR_TRUE;
+#else
+  return AIR_FALSE;
+#endif
+}
+
+#if TEEM_ZLIB
+
+typedef struct {
+  unsigned char *comp;  /* whole gzip member */
+  size_t compLen,       /* length of member */
+    compCap;            /* allocated size of comp */
+  char *raw;            /* uncompressed block (or where to inflate into) */
+  size_t rawLen;        /* length of uncompressed block */
+  char *tmp;            /* when only part of the block is wanted: buffer
+                           to inflate into, from which part is copied */
+  size_t tmpCap,        /* allocated size of tmp */
+    copyOff,            /* copy from tmp + copyOff ... */
+    copyLen;            /* ... this many bytes ... */
+  char *copyDst;        /* ... to here */
+  int err;              /* non-zero if something went wrong */
+} _nrrdGzbBlock;
+
+typedef struct {
+  _nrrdGzbBlock *block;
+  unsigned int batchNum,  /* number of blocks allocated */
+    blockNum,             /* number of blocks in current batch */
+    blockNext;            /* next block to work on */
+  int encode,             /* compressing (else decompressing) */
+    level, strategy;      /* for compressing */
+  airThreadMutex *mutex;
+} _nrrdGzbJob;
+
+static void
+_nrrdGzbPut4(unsigned char *dst, size_t val) {
+
+  dst[0] = AIR_CAST(unsigned char, val & 0xff);
+  dst[1] = AIR_CAST(unsigned char, (val >> 8) & 0xff);
+  dst[2] = AIR_CAST(unsigned char, (val >> 16) & 0xff);
+  dst[3] = AIR_CAST(unsigned char, (val >> 24) & 0xff);
+}
+
+static size_t
+_nrrdGzbGet4(const unsigned char *src) {
+
+  return (AIR_CAST(size_t, src[0])
+          | (AIR_CAST(size_t, src[1]) << 8)
+          | (AIR_CAST(size_t, src[2]) << 16)
+          | (AIR_CAST(size_t, src[3]) << 24));
+}
+
+/*
+** learns member and block length from a member header; returns non-zero
+** if it isn't a member header of the kind written here
+*/
+static int
+_nrrdGzbHeadParse(size_t *compLenP, size_t *rawLenP,
+                  const unsigned char *head) {
+
+  if (!( 0x1f == head[0] && 0x8b == head[1] && Z_DEFLATED == head[2]
+         && 0x04 == head[3]
+         && 12 == head[10] && 0 == head[11]
+         && 'N' == head[12] && 'B' == head[13]
+         && 8 == head[14] && 0 == head[15] )) {
+    return 1;
+  }
+  *compLenP = _nrrdGzbGet4(head + 16);
+  *rawLenP = _nrrdGzbGet4(head + 20);
+  return !(*compLenP > GZB_HEAD + GZB_TAIL);
+}
+
+static void
+_nrrdGzbEncode(_nrrdGzbBlock *blk, z_stream *zs) {
+  size_t defLen;
+  uLong crc;
+
+  deflateReset(zs);
+  zs->next_in = AIR_CAST(Bytef *, blk->raw);
+  zs->avail_in = AIR_CAST(uInt, blk->rawLen);
+  zs->next_out = AIR_CAST(Bytef *, blk->comp + GZB_HEAD);
+  zs->avail_out = AIR_CAST(uInt, blk->compCap - GZB_HEAD - GZB_TAIL);
+  if (Z_STREAM_END != deflate(zs, Z_FINISH)) {
+    blk->err = 1;
+    return;
+  }
+  defLen = AIR_CAST(size_t, zs->total_out);
+  blk->compLen = GZB_HEAD + defLen + GZB_TAIL;
+  memset(blk->comp, 0, GZB_HEAD);
+  blk->comp[0] = 0x1f;
+  blk->comp[1] = 0x8b;
+  blk->comp[2] = Z_DEFLATED;
+  blk->comp[3] = 0x04;
+  blk->comp[9] = 255;
+  blk->comp[10] = 12;
+  blk->comp[12] = 'N';
+  blk->comp[13] = 'B';
+  blk->comp[14] = 8;
+  _nrrdGzbPut4(blk->comp + 16, blk->compLen);
+  _nrrdGzbPut4(blk->comp + 20, blk->rawLen);
+  crc = crc32(crc32(0L, Z_NULL, 0), AIR_CAST(const Bytef *, blk->raw),
+              AIR_CAST(uInt, blk->rawLen));
+  _nrrdGzbPut4(blk->comp + GZB_HEAD + defLen, crc);
+  _nrrdGzbPut4(blk->comp + GZB_HEAD + defLen + 4, blk->rawLen);
+  blk->err = 0;
+}
+
+static void
+_nrrdGzbDecode(_nrrdGzbBlock *blk, z_stream *zs) {
+  const unsigned char *tail;
+  char *dst;
+  uLong crc;
+
+  dst = blk->copyDst ? blk->tmp : blk->raw;
+  inflateReset(zs);
+  zs->next_in = AIR_CAST(Bytef *, blk->comp + GZB_HEAD);
+  zs->avail_in = AIR_CAST(uInt, blk->compLen - GZB_HEAD - GZB_TAIL);
+  zs->next_out = AIR_CAST(Bytef *, dst);
+  zs->avail_out = AIR_CAST(uInt, blk->rawLen);
+  tail = blk->comp + blk->compLen - GZB_TAIL;
+  crc = crc32(0L, Z_NULL, 0);
+  if (Z_STREAM_END != inflate(zs, Z_FINISH)
+      || zs->total_out != blk->rawLen
+      || _nrrdGzbGet4(tail + 4) != (blk->rawLen & 0xffffffff)
+      || (_nrrdGzbGet4(tail)
+          != (crc32(crc, AIR_CAST(const Bytef *, dst),
+                    AIR_CAST(uInt, blk->rawLen)) & 0xffffffff))) {
+    blk->err = 1;
+    return;
+  }
+  if (blk->copyDst) {
+    memcpy(blk->copyDst, blk->tmp + blk->copyOff, blk->copyLen);
+  }
+  blk->err = 0;
+}
+
+static void *
+_nrrdGzbWorker(void *_job) {
+  _nrrdGzbJob *job;
+  _nrrdGzbBlock *blk;
+  z_stream zs;
+  unsigned int bi;
+  int zret;
+
+  job = AIR_CAST(_nrrdGzbJob *, _job);
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+  zret = (job->encode
+          ? deflateInit2(&zs, job->level, Z_DEFLATED, -MAX_WBITS,
+                         8, job->strategy)
+          : inflateInit2(&zs, -MAX_WBITS));
+  while (1) {
+    if (job->mutex) {
+      airThreadMutexLock(job->mutex);
+    }
+    bi = job->blockNext++;
+    if (job->mutex) {
+      airThreadMutexUnlock(job->mutex);
+    }
+    if (bi >= job->blockNum) {
+      break;
+    }
+    blk = job->block + bi;
+    if (Z_OK != zret) {
+      blk->err = 1;
+    } else if (job->encode) {
+      _nrrdGzbEncode(blk, &zs);
+    } else {
+      _nrrdGzbDecode(blk, &zs);
+    }
+  }
+  if (Z_OK == zret) {
+    if (job->encode) {
+      deflateEnd(&zs);
+    } else {
+      inflateEnd(&zs);
+    }
+  }
+  return _job;
+}
+
+/*
+** does job->blockNum blocks of work with threadNum threads
+*/
+static int
+_nrrdGzbRun(_nrrdGzbJob *job, airThread **thread, unsigned int threadNum) {
+  static const char me[]="_nrrdGzbRun";
+  unsigned int ti, bi;
+  void *retP;
+  int ret;
+
+  job->blockNext = 0;
+  threadNum = AIR_MIN(threadNum, job->blockNum);
+  if (threadNum <= 1) {
+    _nrrdGzbWorker(job);
+  } else {
+    for (ti=0; ti<threadNum; ti++) {
+      if ((ret = airThreadStart(thread[ti], _nrrdGzbWorker, job))) {
+        biffAddf(NRRD, "%s: thread %u failed to start: %d", me, ti, ret);
+        return 1;
+      }
+    }
+    for (ti=0; ti<threadNum; ti++) {
+      if ((ret = airThreadJoin(thread[ti], &retP))) {
+        biffAddf(NRRD, "%s: thread %u failed to join: %d", me, ti, ret);
+        return 1;
+      }
+    }
+  }
+  for (bi=0; bi<job->blockNum; bi++) {
+    if (job->block[bi].err) {
+      biffAddf(NRRD, "%s: zlib trouble %s block %u of batch", me,
+               job->encode ? "compressing" : "decompressing", bi);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void *
+_nrrdGzbBlocksNix(void *_job) {
+  _nrrdGzbJob *job;
+  unsigned int bi;
+
+  job = AIR_CAST(_nrrdGzbJob *, _job);
+  for (bi=0; bi<job->batchNum; bi++) {
+    airFree(job->block[bi].comp);
+    airFree(job->block[bi].tmp);
+  }
+  job->block = airFree(job->block);
+  return NULL;
+}
+
+/*
+** sets up threads, mutex, and batch of blocks for reading or writing;
+** everything is registered with the mop
+*/
+static int
+_nrrdGzbSetup(_nrrdGzbJob *job, airThread ***threadP,
+              unsigned int *threadNumP, unsigned int *batchNumP,
+              const NrrdIoState *nio, airArray *mop) {
+  static const char me[]="_nrrdGzbSetup";
+  unsigned int ti, threadNum, batchNum;
+
+  threadNum = AIR_MAX(1, nio->threadNum);
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
+  /* enough blocks in flight to keep all threads busy, without
+     holding too much of the data in compressed form at once */
+  batchNum = 4*threadNum;
+  job->block = AIR_CALLOC(batchNum, _nrrdGzbBlock);
+  *threadP = AIR_CALLOC(threadNum, airThread *);
+  if (!( job->block && *threadP )) {
+    biffAddf(NRRD, "%s: couldn't allocate %u blocks, %u threads",
+             me, batchNum, threadNum);
+    airFree(job->block);
+    airFree(*threadP);
+    return 1;
+  }
+  job->batchNum = batchNum;
+  airMopAdd(mop, job, _nrrdGzbBlocksNix, airMopAlways);
+  airMopAdd(mop, *threadP, airFree, airMopAlways);
+  job->mutex = NULL;
+  if (threadNum > 1) {
+    job->mutex = airThreadMutexNew();
+    airMopAdd(mop, job->mutex, (airMopper)airThreadMutexNix, airMopAlways);
+    for (ti=0; ti<threadNum; ti++) {
+      (*threadP)[ti] = airThreadNew();
+      airMopAdd(mop, (*threadP)[ti], (airMopper)airThreadNix, airMopAlways);
+    }
+  }
+  *threadNumP = threadNum;
+  *batchNumP = batchNum;
+  return 0;
+}
+
+/*
+** makes sure that blk->comp can hold len bytes
+*/
+static int
+_nrrdGzbCompAlloc(_nrrdGzbBlock *blk, size_t len) {
+
+  if (blk->compCap < len) {
+    airFree(blk->comp);
+    blk->comp = AIR_CALLOC(len, unsigned char);
+    blk->compCap = blk->comp ? len : 0;
+  }
+  return !blk->comp;
+}
+
+/*
+** A sequential reader of blocked gzip data, for reading only parts of
+** the data (as with nio->readCrop).  Skipping over the data (when data
+** is NULL in _nrrdGzbReaderRead) hops over whole blocks without
+** inflating them.
+*/
+typedef struct {
+  FILE *file;
+  z_stream zs;
+  int zinit;
+  _nrrdGzbBlock blk;    /* current block; blk.raw holds it inflated */
+  size_t rawCap,        /* allocated size of blk.raw */
+    rawPos;             /* position of next byte to read from blk.raw */
+} _nrrdGzbReader;
+
+void *
+_nrrdGzbReaderNew(FILE *file) {
+  _nrrdGzbReader *rd;
+
+  rd = AIR_CALLOC(1, _nrrdGzbReader);
+  if (rd) {
+    rd->file = file;
+    rd->zs.zalloc = Z_NULL;
+    rd->zs.zfree = Z_NULL;
+    rd->zs.opaque = Z_NULL;
+    rd->zinit = (Z_OK == inflateInit2(&(rd->zs), -MAX_WBITS));
+    if (!rd->zinit) {
+      rd = airFree(rd);
+    }
+  }
+  return rd;
+}
+
+void *
+_nrrdGzbReaderNix(void *_rd) {
+  _nrrdGzbReader *rd;
+
+  rd = AIR_CAST(_nrrdGzbReader *, _rd);
+  if (rd) {
+    if (rd->zinit) {
+      inflateEnd(&(rd->zs));
+    }
+    airFree(rd->blk.comp);
+    airFree(rd->blk.raw);
+    free(rd);
+  }
+  return NULL;
+}
+
+/*
+** reads (or with NULL data, skips) the next num bytes of the
+** uncompressed stream
+*/
+int
+_nrrdGzbReaderRead(void *_rd, void *_data, size_t num) {
+  static const char me[]="_nrrdGzbReaderRead";
+  _nrrdGzbReader *rd;
+  _nrrdGzbBlock *blk;
+  unsigned char head[GZB_HEAD];
+  size_t take, compLen, rawLen;
+  char *data;
+
+  rd = AIR_CAST(_nrrdGzbReader *, _rd);
+  blk = &(rd->blk);
+  data = AIR_CAST(char *, _data);
+  while (num) {
+    if (rd->rawPos < blk->rawLen) {
+      take = AIR_MIN(num, blk->rawLen - rd->rawPos);
+      if (data) {
+        memcpy(data, blk->raw + rd->rawPos, take);
+        data += take;
+      }
+      rd->rawPos += take;
+      num -= take;
+      continue;
+    }
+    /* current block used up; on to the next */
+    if (GZB_HEAD != fread(head, 1, GZB_HEAD, rd->file)) {
+      biffAddf(NRRD, "%s: hit end of data", me);
+      return 1;
+    }
+    if (_nrrdGzbHeadParse(&compLen, &rawLen, head)) {
+      biffAddf(NRRD, "%s: data isn't blocked gzip", me);
+      return 1;
+    }
+    blk->rawLen = 0;
+    rd->rawPos = 0;
+    if (!data && rawLen <= num) {
+      /* skipping the whole block */
+      if (fseek(rd->file, AIR_CAST(long int, compLen - GZB_HEAD), SEEK_CUR)
+          && (_nrrdGzbCompAlloc(blk, compLen)
+              || (compLen - GZB_HEAD
+                  != fread(blk->comp, 1, compLen - GZB_HEAD, rd->file)))) {
+        biffAddf(NRRD, "%s: couldn't skip block", me);
+        return 1;
+      }
+      num -= rawLen;
+      continue;
+    }
+    if (_nrrdGzbCompAlloc(blk, compLen)) {
+      biffAddf(NRRD, "%s: couldn't allocate block buffer", me);
+      return 1;
+    }
+    if (rd->rawCap < rawLen) {
+      airFree(blk->raw);
+      blk->raw = AIR_CALLOC(rawLen, char);
+      rd->rawCap = blk->raw ? rawLen : 0;
+      if (!blk->raw) {
+        biffAddf(NRRD, "%s: couldn't allocate block buffer", me);
+        return 1;
+      }
+    }
+    memcpy(blk->comp, head, GZB_HEAD);
+    if (compLen - GZB_HEAD
+        != fread(blk->comp + GZB_HEAD, 1, compLen - GZB_HEAD, rd->file)) {
+      biffAddf(NRRD, "%s: couldn't read block", me);
+      return 1;
+    }
+    blk->compLen = compLen;
+    blk->rawLen = rawLen;
+    blk->copyDst = NULL;
+    _nrrdGzbDecode(blk, &(rd->zs));
+    if (blk->err) {
+      biffAddf(NRRD, "%s: zlib trouble decompressing block", me);
+      blk->rawLen = 0;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+#endif /* TEEM_ZLIB */
+
+static int
+_nrrdEncodingGzipBlocked_read(FILE *file, void *_data, size_t elNum,
+                              Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdEncodingGzipBlocked_read";
+#if TEEM_ZLIB
+  _nrrdGzbJob job;
+  _nrrdGzbBlock *blk;
+  airThread **thread;
+  unsigned int threadNum, batchNum;
+  unsigned char head[GZB_HEAD];
+  size_t sizeData, lo, hi, upos, compLen, rawLen;
+  char *data;
+  airArray *mop;
+
+  data = AIR_CAST(char *, _data);
+  sizeData = nrrdElementSize(nrrd)*elNum;
+  mop = airMopNew();
+  if (_nrrdGzbSetup(&job, &thread, &threadNum, &batchNum, nio, mop)) {
+    biffAddf(NRRD, "%s: trouble setting up", me);
+    airMopError(mop); return 1;
+  }
+  job.encode = AIR_FALSE;
+
+  /* [lo,hi) is the range, in the uncompressed byte stream, of the data */
+  if (nio->byteSkip >= 0) {
+    lo = AIR_CAST(size_t, nio->byteSkip);
+  } else {
+    /* need to learn the total uncompressed size by hopping through the
+       member headers, which requires a seekable file */
+    long int pos0, backwards;
+    size_t total;
+    pos0 = ftell(file);
+    if (pos0 < 0) {
+      biffAddf(NRRD, "%s: negative byte skip needs a seekable file", me);
+      airMopError(mop); return 1;
+    }
+    total = 0;
+    while (GZB_HEAD == fread(head, 1, GZB_HEAD, file)) {
+      if (_nrrdGzbHeadParse(&compLen, &rawLen, head)
+          || fseek(file, AIR_CAST(long int, compLen - GZB_HEAD), SEEK_CUR)) {
+        biffAddf(NRRD, "%s: trouble hopping through blocks", me);
+        airMopError(mop); return 1;
+      }
+      total += rawLen;
+    }
+    backwards = -nio->byteSkip - 1;
+    if (total < sizeData + AIR_CAST(size_t, backwards)
+        || fseek(file, pos0, SEEK_SET)) {
+      char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
+      biffAddf(NRRD, "%s: expected %s bytes but have only %s", me,
+               airSprintSize_t(stmp1, sizeData + AIR_CAST(size_t, backwards)),
+               airSprintSize_t(stmp2, total));
+      airMopError(mop); return 1;
+    }
+    lo = total - sizeData - AIR_CAST(size_t, backwards);
+  }
+  hi = lo + sizeData;
+
+  upos = 0;
+  while (upos < hi) {
+    /* read in the next batch of blocks that overlap [lo,hi) */
+    job.blockNum = 0;
+    while (job.blockNum < batchNum && upos < hi) {
+      if (GZB_HEAD != fread(head, 1, GZB_HEAD, file)) {
+        char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
+        biffAddf(NRRD, "%s: expected %s bytes but received only %s", me,
+                 airSprintSize_t(stmp1, hi), airSprintSize_t(stmp2, upos));
+        airMopError(mop); return 1;
+      }
+      if (_nrrdGzbHeadParse(&compLen, &rawLen, head)) {
+        biffAddf(NRRD, "%s: data isn't blocked gzip (as written by the "
+                 "\"%s\" encoding)", me, nrrdEncodingGzipBlocked->name);
+        airMopError(mop); return 1;
+      }
+      if (upos + rawLen <= lo) {
+        /* block is entirely before data; skip it without inflating.
+           This only happens before any block has been put in the batch,
+           so the first block can be used as a buffer if can't seek */
+        blk = job.block;
+        if (fseek(file, AIR_CAST(long int, compLen - GZB_HEAD), SEEK_CUR)
+            && (_nrrdGzbCompAlloc(blk, compLen)
+                || (compLen - GZB_HEAD
+                    != fread(blk->comp, 1, compLen - GZB_HEAD, file)))) {
+          biffAddf(NRRD, "%s: couldn't skip block", me);
+          airMopError(mop); return 1;
+        }
+        upos += rawLen;
+        continue;
+      }
+      blk = job.block + job.blockNum;
+      if (_nrrdGzbCompAlloc(blk, compLen)) {
+        biffAddf(NRRD, "%s: couldn't allocate block buffer", me);
+        airMopError(mop); return 1;
+      }
+      memcpy(blk->comp, head, GZB_HEAD);
+      if (compLen - GZB_HEAD
+          != fread(blk->comp + GZB_HEAD, 1, compLen - GZB_HEAD, file)) {
+        biffAddf(NRRD, "%s: couldn't read block", me);
+        airMopError(mop); return 1;
+      }
+      blk->compLen = compLen;
+      blk->rawLen = rawLen;
+      if (lo <= upos && upos + rawLen <= hi) {
+        /* whole block is data; inflate directly into place */
+        blk->raw = data + (upos - lo);
+        blk->copyDst = NULL;
+      } else {
+        size_t ulo, uhi;
+        if (blk->tmpCap < rawLen) {
+          airFree(blk->tmp);
+          blk->tmp = AIR_CALLOC(rawLen, char);
+          blk->tmpCap = blk->tmp ? rawLen : 0;
+          if (!blk->tmp) {
+            biffAddf(NRRD, "%s: couldn't allocate block buffer", me);
+            airMopError(mop); return 1;
+          }
+        }
+        ulo = AIR_MAX(lo, upos);
+        uhi = AIR_MIN(hi, upos + rawLen);
+        blk->raw = NULL;
+        blk->copyOff = ulo - upos;
+        blk->copyLen = uhi - ulo;
+        blk->copyDst = data + (ulo - lo);
+      }
+      upos += rawLen;
+      job.blockNum++;
+    }
+    if (_nrrdGzbRun(&job, thread, threadNum)) {
+      biffAddf(NRRD, "%s: trouble decompressing", me);
+      airMopError(mop); return 1;
+    }
+  }
+
+  airMopOkay(mop);
+  return 0;
+#else
+  AIR_UNUSED(file);
+  AIR_UNUSED(_data);
+  AIR_UNUSED(elNum);
+  AIR_UNUSED(nrrd);
+  AIR_UNUSED(nio);
+  biffAddf(NRRD, "%s: sorry, this nrrd not compiled with zlib "
+           "(needed for gzip) enabled", me);
+  return 1;
+#endif
+}
+
+static int
+_nrrdEncodingGzipBlocked_write(FILE *file, const void *_data, size_t elNum,
+                               const Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdEncodingGzipBlocked_write";
+#if TEEM_ZLIB
+  _nrrdGzbJob job;
+  _nrrdGzbBlock *blk;
+  airThread **thread;
+  unsigned int threadNum, batchNum, bi;
+  size_t sizeData, blockSize, pos, compCap;
+  const char *data;
+  airArray *mop;
+
+  data = AIR_CAST(const char *, _data);
+  sizeData = nrrdElementSize(nrrd)*elNum;
+  blockSize = (nio->zlibBlockSize
+               ? nio->zlibBlockSize
+               : NRRD_ZLIB_BLOCK_SIZE_DEFAULT);
+  if (blockSize > NRRD_ZLIB_BLOCK_SIZE_MAX) {
+    char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
+    biffAddf(NRRD, "%s: block size %s > max %s", me,
+             airSprintSize_t(stmp1, blockSize),
+             airSprintSize_t(stmp2, NRRD_ZLIB_BLOCK_SIZE_MAX));
+    return 1;
+  }
+  mop = airMopNew();
+  if (_nrrdGzbSetup(&job, &thread, &threadNum, &batchNum, nio, mop)) {
+    biffAddf(NRRD, "%s: trouble setting up", me);
+    airMopError(mop); return 1;
+  }
+  job.encode = AIR_TRUE;
+  job.level = (0 <= nio->zlibLevel && nio->zlibLevel <= 9
+               ? nio->zlibLevel
+               : Z_DEFAULT_COMPRESSION);
+  switch (nio->zlibStrategy) {
+  case nrrdZlibStrategyHuffman:
+    job.strategy = Z_HUFFMAN_ONLY;
+    break;
+  case nrrdZlibStrategyFiltered:
+    job.strategy = Z_FILTERED;
+    break;
+  case nrrdZlibStrategyDefault:
+  default:
+    job.strategy = Z_DEFAULT_STRATEGY;
+    break;
+  }
+  compCap = (GZB_HEAD + GZB_TAIL
+             + deflateBound(NULL, AIR_CAST(uLong, blockSize)) + 64);
+
+  pos = 0;
+  /* do-while so that empty data still gets one (empty) member */
+  do {
+    job.blockNum = 0;
+    while (job.blockNum < batchNum && (pos < sizeData || !sizeData)) {
+      blk = job.block + job.blockNum;
+      if (_nrrdGzbCompAlloc(blk, compCap)) {
+        biffAddf(NRRD, "%s: couldn't allocate block buffer", me);
+        airMopError(mop); return 1;
+      }
+      /* the encoder only reads from blk->raw */
+      blk->raw = AIR_CAST(char *, AIR_VOIDP(data + pos));
+      blk->rawLen = AIR_MIN(blockSize, sizeData - pos);
+      pos += blk->rawLen;
+      job.blockNum++;
+      if (!sizeData) {
+        break;
+      }
+    }
+    if (_nrrdGzbRun(&job, thread, threadNum)) {
+      biffAddf(NRRD, "%s: trouble compressing", me);
+      airMopError(mop); return 1;
+    }
+    for (bi=0; bi<job.blockNum; bi++) {
+      blk = job.block + bi;
+      if (blk->compLen != fwrite(blk->comp, 1, blk->compLen, file)) {
+        biffAddf(NRRD, "%s: error writing block", me);
+        airMopError(mop); return 1;
+      }
+    }
+  } while (pos < sizeData);
+
+  airMopOkay(mop);
+  return 0;
+#else
+  AIR_UNUSED(file);
+  AIR_UNUSED(_data);
+  AIR_UNUSED(elNum);
+  AIR_UNUSED(nrrd);
+  AIR_UNUSED(nio);
+  biffAddf(NRRD, "%s: sorry, this nrrd not compiled with zlib "
+           "(needed for gzip) enabled", me);
+  return 1;
+#endif
+}
+
+const NrrdEncoding
+_nrrdEncodingGzipBlocked = {
+  "gzip-blocked", /* name */
+  "raw.gz",       /* suffix */
+  AIR_TRUE,       /* endianMatters */
+  AIR_TRUE,       /* isCompression */
+  _nrrdEncodingGzipBlocked_available,
+  _nrrdEncodingGzipBlocked_read,
+  _nrrdEncodingGzipBlocked_write
+};
+
+const NrrdEncoding *const
+nrrdEncodingGzipBlocked = &_nrrdEncodingGzipBlocked;
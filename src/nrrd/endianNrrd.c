@@ -102,7 +102,7 @@ _nrrdBlockEndian(void *data, size_t N) {
           airEnumStr(nrrdType, nrrdTypeBlock));
 }
 
-static void
+void
 (*_nrrdSwapEndian[])(void *, size_t) = {
   _nrrdNoopEndian,         /*  0: nobody knows! */
   _nrrdNoopEndian,         /*  1:   signed 1-byte integer */
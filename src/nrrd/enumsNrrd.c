@@ -203,7 +203,8 @@ _nrrdEncodingTypeStr[NRRD_ENCODING_TYPE_MAX+1] = {
   "hex",
   "gz",
   "bz2",
-  "zrl"
+  "zrl",
+  "gzb"
 };
 
 static const char *
@@ -215,6 +216,7 @@ _nrrdEncodingTypeDesc[NRRD_ENCODING_TYPE_MAX+1] = {
   "gzip compression of binary encoding",
   "bzip2 compression of binary encoding",
   "simple compression by encoding run-length of zeros",
+  "gzip compression of independent blocks of binary encoding",
 };
 
 static const char *
@@ -225,6 +227,7 @@ _nrrdEncodingTypeStrEqv[] = {
   "gz", "gzip",
   "bz2", "bzip2",
   "zrl",
+  "gzb", "gzip-blocked",
   ""
 };
 
@@ -235,7 +238,8 @@ _nrrdEncodingTypeValEqv[] = {
   nrrdEncodingTypeHex,
   nrrdEncodingTypeGzip, nrrdEncodingTypeGzip,
   nrrdEncodingTypeBzip2, nrrdEncodingTypeBzip2,
-  nrrdEncodingTypeZRL
+  nrrdEncodingTypeZRL,
+  nrrdEncodingTypeGzipBlocked, nrrdEncodingTypeGzipBlocked
 };
 
 airEnum
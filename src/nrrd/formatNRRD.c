@@ -299,6 +299,7 @@ _nrrdFormatNRRD_whichVersion(const Nrrd *nrrd, NrrdIoState *nio) {
   int ret;
 
   if (nrrdEncodingZRL == nio->encoding
+      || nrrdEncodingGzipBlocked == nio->encoding
       || nrrdSpaceRightUp == nrrd->space
       || nrrdSpaceRightDown == nrrd->space) {
     ret = 6;
@@ -418,6 +419,237 @@ _nrrdHeaderCheck(Nrrd *nrrd, NrrdIoState *nio, int checkSeen) {
   return 0;
 }
 
+static void
+_nrrdFormatNRRD_endianFix(Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdFormatNRRD_endianFix";
+
+  if (airEndianUnknown != nio->endian && nrrd->data) {
+    /* we positively know the endianness of data just read */
+    if (1 < nrrdElementSize(nrrd)
+        && nio->encoding->endianMatters
+        && nio->endian != airMyEndian()) {
+      /* endianness exposed in encoding, and its wrong */
+      if (2 <= nrrdStateVerboseIO) {
+        fprintf(stderr, "(%s: fixing endianness ... ", me);
+        fflush(stderr);
+      }
+      nrrdSwapEndian(nrrd);
+      if (2 <= nrrdStateVerboseIO) {
+        fprintf(stderr, "done)\n");
+        fflush(stderr);
+      }
+    }
+  }
+  return;
+}
+
+/*
+** gets dataFile (already opened by nrrdIoStateDataFileIterNext) ready
+** for st to read from the start of the data in it
+*/
+static int
+_nrrdFormatNRRD_readCropStart(_nrrdStream *st, FILE *dataFile,
+                              Nrrd *nhdr, NrrdIoState *nio) {
+  static const char me[]="_nrrdFormatNRRD_readCropStart";
+
+  if (nrrdLineSkip(dataFile, nio)) {
+    biffAddf(NRRD, "%s: couldn't skip lines", me);
+    return 1;
+  }
+  if (!nio->encoding->isCompression) {
+    if (nio->dataFSkip) {
+      if (_nrrdByteSkipSkip(dataFile, nhdr, nio,
+                            nio->dataFSkip[nio->dataFNIndex-1])) {
+        biffAddf(NRRD, "%s: couldn't skip bytes for list line %u",
+                 me, nio->dataFNIndex-1);
+        return 1;
+      }
+    } else if (nrrdByteSkip(dataFile, nhdr, nio)) {
+      biffAddf(NRRD, "%s: couldn't skip bytes", me);
+      return 1;
+    }
+  }
+  if (_nrrdStreamOpen(st, dataFile, nio->encoding)) {
+    biffAddf(NRRD, "%s: couldn't start reading", me);
+    return 1;
+  }
+  if (nio->encoding->isCompression && nio->byteSkip > 0
+      && _nrrdStreamSkip(st, AIR_CAST(size_t, nio->byteSkip))) {
+    biffAddf(NRRD, "%s: couldn't skip bytes", me);
+    _nrrdStreamClose(st);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** _nrrdFormatNRRD_readCrop
+**
+** for nio->readCrop: reads only the data inside the crop region.  The
+** data is streamed through in order, skipping (by seeking when possible)
+** what's outside the region, one run of contiguous samples at a time.
+** Data files that hold none of the region are never opened.
+*/
+static int
+_nrrdFormatNRRD_readCrop(Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdFormatNRRD_readCrop";
+  char stmp[3][AIR_STRLEN_SMALL], *data;
+  FILE *dataFile;
+  Nrrd *nhdr;
+  airArray *mop;
+  _nrrdStream st;
+  const size_t *min, *max;
+  size_t szIn[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX], cIn[NRRD_DIM_MAX],
+    cOut[NRRD_DIM_MAX], elSize, pieceSize, lineNum, lineIdx, idxIn,
+    runStart, runLen, start, len, pos, off, num;
+  unsigned int ai, dim, piece, pieceNum;
+  int streaming;
+
+  mop = airMopNew();
+  /* nhdr remembers the un-cropped header */
+  nhdr = nrrdNew();
+  airMopAdd(mop, nhdr, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdBasicInfoCopy(nhdr, nrrd, NRRD_BASIC_INFO_DATA_BIT)
+      || nrrdAxisInfoCopy(nhdr, nrrd, NULL, NRRD_AXIS_INFO_NONE)) {
+    biffAddf(NRRD, "%s: couldn't copy header", me);
+    airMopError(mop); return 1;
+  }
+  dim = nrrd->dim;
+  min = nio->readCropMin;
+  max = nio->readCropMax;
+  nrrdAxisInfoGet_nva(nhdr, nrrdAxisInfoSize, szIn);
+  lineNum = 1;
+  for (ai=0; ai<dim; ai++) {
+    if (!( min[ai] <= max[ai] && max[ai] < szIn[ai] )) {
+      biffAddf(NRRD, "%s: axis %u crop [%s,%s] not inside [0,%s]", me, ai,
+               airSprintSize_t(stmp[0], min[ai]),
+               airSprintSize_t(stmp[1], max[ai]),
+               airSprintSize_t(stmp[2], szIn[ai]-1));
+      airMopError(mop); return 1;
+    }
+    szOut[ai] = max[ai] - min[ai] + 1;
+    if (ai) {
+      lineNum *= szOut[ai];
+    }
+  }
+  nrrdAxisInfoSet_nva(nrrd, nrrdAxisInfoSize, szOut);
+  if (_nrrdCalloc(nrrd, nio, NULL)) {
+    biffAddf(NRRD, "%s: couldn't allocate memory for data", me);
+    airMopError(mop); return 1;
+  }
+  data = AIR_CAST(char *, nrrd->data);
+  elSize = nrrdElementSize(nhdr);
+  pieceNum = _nrrdDataFNNumber(nio);
+  pieceSize = elSize*(nrrdElementNumber(nhdr)/pieceNum);
+  if (2 <= nrrdStateVerboseIO) {
+    fprintf(stderr, "(%s: reading %s of %s bytes of %s data ... ", me,
+            airSprintSize_t(stmp[0], elSize*nrrdElementNumber(nrrd)),
+            airSprintSize_t(stmp[1], elSize*nrrdElementNumber(nhdr)),
+            nio->encoding->name);
+    fflush(stderr);
+  }
+
+  /* no data file is open yet */
+  dataFile = NULL;
+  piece = pieceNum;
+  streaming = AIR_FALSE;
+  pos = 0;
+  memset(cOut, 0, NRRD_DIM_MAX*sizeof(*cOut));
+  runStart = runLen = 0;
+  /* one more than lineNum, to finish the last run */
+  for (lineIdx=0; lineIdx<=lineNum; lineIdx++) {
+    if (lineIdx < lineNum) {
+      for (ai=0; ai<dim; ai++) {
+        cIn[ai] = cOut[ai] + min[ai];
+      }
+      NRRD_INDEX_GEN(idxIn, cIn, szIn, dim);
+      NRRD_COORD_INCR(cOut, szOut, dim, 1);
+      if (runLen && runStart + runLen == idxIn*elSize) {
+        /* this scanline continues the current run */
+        runLen += szOut[0]*elSize;
+        continue;
+      }
+    }
+    /* read the current run, then start the next one */
+    start = runStart;
+    len = runLen;
+    while (len) {
+      off = start % pieceSize;
+      if (piece != start/pieceSize || !streaming) {
+        /* start reading the data file that has start */
+        if (streaming) {
+          _nrrdStreamClose(&st);
+          streaming = AIR_FALSE;
+        }
+        if (piece != start/pieceSize) {
+          if (dataFile && dataFile != nio->headerFile) {
+            dataFile = airFclose(dataFile);
+          }
+          piece = AIR_CAST(unsigned int, start/pieceSize);
+          nio->dataFNIndex = piece;
+          if (nrrdIoStateDataFileIterNext(&dataFile, nio, AIR_TRUE)) {
+            biffAddf(NRRD, "%s: couldn't open data file %u", me, piece);
+            airMopError(mop); return 1;
+          }
+        }
+        if (_nrrdFormatNRRD_readCropStart(&st, dataFile, nhdr, nio)) {
+          biffAddf(NRRD, "%s: trouble with data file %u", me, piece);
+          if (dataFile && dataFile != nio->headerFile) {
+            airFclose(dataFile);
+          }
+          airMopError(mop); return 1;
+        }
+        streaming = AIR_TRUE;
+        pos = 0;
+      }
+      num = AIR_MIN(len, pieceSize - off);
+      if (_nrrdStreamSkip(&st, off - pos)
+          || _nrrdStreamRead(&st, data, num)) {
+        biffAddf(NRRD, "%s: trouble getting %s bytes at %s in data file %u",
+                 me, airSprintSize_t(stmp[0], num),
+                 airSprintSize_t(stmp[1], off), piece);
+        _nrrdStreamClose(&st);
+        if (dataFile != nio->headerFile) {
+          airFclose(dataFile);
+        }
+        airMopError(mop); return 1;
+      }
+      pos = off + num;
+      data += num;
+      start += num;
+      len -= num;
+    }
+    if (lineIdx < lineNum) {
+      runStart = idxIn*elSize;
+      runLen = szOut[0]*elSize;
+    }
+  }
+  if (streaming) {
+    _nrrdStreamClose(&st);
+  }
+  if (dataFile && dataFile != nio->headerFile) {
+    airFclose(dataFile);
+  }
+  nio->dataFNIndex = pieceNum;
+  if (2 <= nrrdStateVerboseIO) {
+    fprintf(stderr, "done)\n");
+  }
+  _nrrdFormatNRRD_endianFix(nrrd, nio);
+
+  /* now make the rest of nrrd look like the output of nrrdCrop(), which
+     doesn't propagate comments (or maybe key/value pairs) */
+  nrrdCommentClear(nrrd);
+  if (!nrrdStateKeyValuePairsPropagate) {
+    nrrdKeyValueClear(nrrd);
+  }
+  if (_nrrdCropPeripheral(nrrd, nhdr, min, max)) {
+    biffAddf(NRRD, "%s: trouble setting cropped header", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 /*
 ** NOTE: currently, this will read, without complaints or errors,
 ** newer NRRD format features from older NRRD files (as indicated by
@@ -437,6 +669,7 @@ _nrrdFormatNRRD_read(FILE *file, Nrrd *nrrd, NrrdIoState *nio) {
   size_t valsPerPiece;
   char *data;
   FILE *dataFile=NULL;
+  int tryMap, mapped;
 
   /* record where the header is being read from for the sake of
      nrrdIoStateDataFileIterNext() */
@@ -501,17 +734,46 @@ _nrrdFormatNRRD_read(FILE *file, Nrrd *nrrd, NrrdIoState *nio) {
     return 1;
   }
 
+  nrrdIoStateDataFileIterBegin(nio);
+  if (nio->readCrop
+      && !nio->skipData
+      && !nio->headerStringRead
+      && !nio->keepNrrdDataFileOpen
+      && _nrrdStreamCan(nio->encoding)
+      && !(nio->encoding->isCompression && nio->byteSkip < 0)) {
+    /* we can read only the data needed for the crop, opening only
+       the data files that hold some of it */
+    if (_nrrdFormatNRRD_readCrop(nrrd, nio)) {
+      biffAddf(NRRD, "%s: trouble reading cropped data", me);
+      return 1;
+    }
+    return 0;
+  }
   /* we seemed to have read in a valid header; now allocate the memory.
      For directIO-compatible allocation we need to get the first datafile */
-  nrrdIoStateDataFileIterBegin(nio);
   /* NOTE: if nio->headerStringRead, this may set dataFile to NULL */
   if (nrrdIoStateDataFileIterNext(&dataFile, nio, AIR_TRUE)) {
     biffAddf(NRRD, "%s: couldn't open the first datafile", me);
     return 1;
   }
+  /* we can only map raw data from a single data file, which won't need
+     its endianness fixed once it's in memory */
+  tryMap = (nio->mapData
+            && !nio->readCrop
+            && !nio->skipData
+            && dataFile
+            && nrrdEncodingRaw == nio->encoding
+            && 1 == _nrrdDataFNNumber(nio)
+            && !(1 < nrrdElementSize(nrrd)
+                 && airEndianUnknown != nio->endian
+                 && nio->endian != airMyEndian()));
+  mapped = AIR_FALSE;
   if (nio->skipData) {
     nrrd->data = NULL;
     data = NULL;
+  } else if (tryMap) {
+    /* allocation, if needed, is deferred until after skipping */
+    data = NULL;
   } else {
     if (_nrrdCalloc(nrrd, nio, dataFile)) {
       biffAddf(NRRD, "%s: couldn't allocate memory for data", me);
@@ -555,12 +817,24 @@ _nrrdFormatNRRD_read(FILE *file, Nrrd *nrrd, NrrdIoState *nio) {
         }
       }
     }
+    if (tryMap) {
+      /* now at the start of the data; it will either be mapped or
+         (if that isn't possible) allocated and read as usual */
+      mapped = _nrrdDataMapTry(nrrd, dataFile);
+      if (!mapped && _nrrdCalloc(nrrd, nio, dataFile)) {
+        biffAddf(NRRD, "%s: couldn't allocate memory for data", me);
+        return 1;
+      }
+      data = (char*)nrrd->data;
+      tryMap = AIR_FALSE;
+    }
     /* ---------------- read the data itself */
     if (2 <= nrrdStateVerboseIO) {
-      fprintf(stderr, "(%s: reading %s data ... ", me, nio->encoding->name);
+      fprintf(stderr, "(%s: %s %s data ... ", me,
+              mapped ? "mapped" : "reading", nio->encoding->name);
       fflush(stderr);
     }
-    if (!nio->skipData) {
+    if (!nio->skipData && !mapped) {
       if (nio->encoding->read(dataFile, data, valsPerPiece, nrrd, nio)) {
         if (2 <= nrrdStateVerboseIO) {
           fprintf(stderr, "error!\n");
@@ -587,22 +861,12 @@ _nrrdFormatNRRD_read(FILE *file, Nrrd *nrrd, NrrdIoState *nio) {
     }
   }
 
-  if (airEndianUnknown != nio->endian && nrrd->data) {
-    /* we positively know the endianness of data just read */
-    if (1 < nrrdElementSize(nrrd)
-        && nio->encoding->endianMatters
-        && nio->endian != airMyEndian()) {
-      /* endianness exposed in encoding, and its wrong */
-      if (2 <= nrrdStateVerboseIO) {
-        fprintf(stderr, "(%s: fixing endianness ... ", me);
-        fflush(stderr);
-      }
-      nrrdSwapEndian(nrrd);
-      if (2 <= nrrdStateVerboseIO) {
-        fprintf(stderr, "done)\n");
-        fflush(stderr);
-      }
-    }
+  if (!mapped) {
+    _nrrdFormatNRRD_endianFix(nrrd, nio);
+  }
+  if (nio->readCrop && !nio->skipData && _nrrdReadCropAfter(nrrd, nio)) {
+    biffAddf(NRRD, "%s: trouble cropping", me);
+    return 1;
   }
 
   return 0;
@@ -809,7 +1073,7 @@ _nrrdFormatNRRD_write(FILE *file, const Nrrd *nrrd, NrrdIoState *nio) {
         dataFile = airFclose(dataFile);
       }
       data += valsPerPiece*nrrdElementSize(nrrd);
-      if (nrrdIoStateDataFileIterNext(&dataFile, nio, AIR_TRUE)) {
+      if (nrrdIoStateDataFileIterNext(&dataFile, nio, AIR_FALSE)) {
         biffAddf(NRRD, "%s: couldn't get the next datafile", me);
         airMopError(mop); return 1;
       }
@@ -190,6 +190,37 @@ _nrrdLooksLikeANumber(const char *str) {
   }
 }
 
+/*
+******** nrrdHestIterNumber
+**
+** for a string that could be either a filename or a number (as with
+** nrrdHestIter), and that failed to open as a file: returns non-zero
+** iff the string should be taken as a number, which is then put in
+** *valP.  This is where nrrdHestIter decides that, so that other
+** readers of the same kind of operand can decide the same way.
+*/
+int
+nrrdHestIterNumber(double *valP, const char *str) {
+  double val;
+  int ret;
+
+  if (!(valP && str)) {
+    return AIR_FALSE;
+  }
+  ret = airSingleSscanf(str, "%lf", &val);
+  if (1 == ret
+      && (_nrrdLooksLikeANumber(str)
+          || !AIR_EXISTS(val)
+          || AIR_ABS(AIR_PI - val) < 0.0001
+          || AIR_ABS(-AIR_PI - val) < 0.0001)) {
+    /* either it patently looks like a number, or,
+       it already parsed as a number and it is a special value */
+    *valP = val;
+    return AIR_TRUE;
+  }
+  return AIR_FALSE;
+}
+
 int
 _nrrdHestIterParse(void *ptr, const char *str, char err[AIR_STRLEN_HUGE]) {
   char me[]="_nrrdHestIterParse", *nerr;
@@ -219,8 +250,8 @@ _nrrdHestIterParse(void *ptr, const char *str, char err[AIR_STRLEN_HUGE]) {
      really wants a general robust test to see if a given string is a
      valid number representation AND NOTHING BUT THAT, and sscanf() is
      not that test.  In any case, if there are to be improved smarts
-     about this matter, they need to be implemented below and nowhere
-     else. */
+     about this matter, they need to be implemented in
+     nrrdHestIterNumber and nowhere else. */
 
   nrrd = nrrdNew();
   ret = nrrdLoad(nrrd, str, NULL);
@@ -240,20 +271,8 @@ _nrrdHestIterParse(void *ptr, const char *str, char err[AIR_STRLEN_HUGE]) {
     } else {
       /* fopen() failed, so it probably wasn't meant to be a filename */
       free(biffGetDone(NRRD));
-      ret = airSingleSscanf(str, "%lf", &val);
-      if (_nrrdLooksLikeANumber(str)
-          || (1 == ret && (!AIR_EXISTS(val)
-                           || AIR_ABS(AIR_PI - val) < 0.0001
-                           || AIR_ABS(-AIR_PI - val) < 0.0001))) {
-        /* either it patently looks like a number, or,
-           it already parsed as a number and it is a special value */
-        if (1 == ret) {
-          nrrdIterSetValue(*iterP, val);
-        } else {
-          /* oh, this is bad. */
-          fprintf(stderr, "%s: PANIC, is it a number or not?", me);
-          exit(1);
-        }
+      if (nrrdHestIterNumber(&val, str)) {
+        nrrdIterSetValue(*iterP, val);
       } else {
         /* it doesn't look like a number, but the fopen failed, so
            we'll let it fail again and pass back the error messages */
@@ -24,6 +24,429 @@
 #include "nrrd.h"
 #include "privateNrrd.h"
 
+/* ---------------------------- threaded binning ---------------- */
+
+/*
+** Unweighted histograms are computed by first finding the bin index of
+** each value, a chunk of values at a time, and then counting bin hits
+** in size_t counters, which are finally saved into the output. For
+** small integral types, the bin of every possible value is looked up in
+** a table. Float values are read with a typed loop, and all other types
+** use nrrdDLookup. The work is divided among nrrdDefaultThreadNum
+** threads. nrrdHisto and nrrdHistoJoint either give each thread
+** private counters for all the bins, which are summed at the end, or
+** (when that would take too much memory, as with large joint
+** histograms) give each thread its own block of bins.
+**
+** The output is the same as from counting one value at a time in the
+** output type. Those counts stop rising at the type's maximum, or
+** when incrementing them stops changing them (2^24 for float, 2^53 for
+** double), and _nrrdHistoCountMax gives that limit.
+*/
+
+/* number of values binned at a time */
+#define _NRRD_HISTO_CHUNK 4096
+
+/* fewest values for which it is worth starting another thread */
+#define _NRRD_HISTO_GRAIN 262144
+
+/* most bytes of per-thread private counters for nrrdHistoJoint */
+#define _NRRD_HISTO_PRIVATE 33554432
+
+/* bin index for a value that is not counted */
+#define _NRRD_HISTO_SKIP (~AIR_CAST(size_t, 0))
+
+typedef struct {
+  const Nrrd *nin;
+  double lo, hi,             /* range of values to count */
+    imin, imax;              /* arguments to airIndex or airIndexClampULL */
+  size_t bins;
+  int clamp,                 /* values outside [lo,hi] are clamped to it,
+                                rather than skipped */
+    ull;                     /* use airIndexClampULL, not airIndex */
+  size_t *lut;               /* if non-NULL: bin for every value of the
+                                type, offset by nrrdTypeMin[nin->type] */
+} _nrrdHistoInput;
+
+typedef struct {
+  const void *job;
+  size_t lo, hi,             /* range of work to do */
+    *count,                  /* bin counters */
+    *bin, *flat;             /* _NRRD_HISTO_CHUNK long */
+  unsigned int *pos;         /* _NRRD_HISTO_CHUNK long */
+} _nrrdHistoTask;
+
+static size_t
+_nrrdHistoBinOne(const _nrrdHistoInput *hin, double val) {
+  size_t ret;
+
+  if (!AIR_EXISTS(val)) {
+    return _NRRD_HISTO_SKIP;
+  }
+  if (!AIR_IN_CL(hin->lo, val, hin->hi)) {
+    if (!hin->clamp) {
+      return _NRRD_HISTO_SKIP;
+    }
+    val = AIR_CLAMP(hin->lo, val, hin->hi);
+  }
+  if (hin->ull) {
+    ret = AIR_CAST(size_t, airIndexClampULL(hin->imin, val, hin->imax,
+                                            hin->bins));
+  } else {
+    ret = airIndex(hin->imin, val, hin->imax,
+                   AIR_CAST(unsigned int, hin->bins));
+  }
+  return ret;
+}
+
+/*
+** sets up hin for nin, and if there are more than valNum values to
+** bin, and nin's type is small enough, the table of bins
+*/
+static int
+_nrrdHistoInputInit(_nrrdHistoInput *hin, const Nrrd *nin, size_t valNum,
+                    airArray *mop) {
+  static const char me[]="_nrrdHistoInputInit";
+  size_t ii, lutLen;
+
+  hin->nin = nin;
+  hin->lut = NULL;
+  switch (nin->type) {
+  case nrrdTypeChar:
+  case nrrdTypeUChar:
+  case nrrdTypeShort:
+  case nrrdTypeUShort:
+    lutLen = AIR_CAST(size_t, nrrdTypeMax[nin->type]
+                      - nrrdTypeMin[nin->type] + 1);
+    break;
+  default:
+    lutLen = 0;
+    break;
+  }
+  if (lutLen && valNum > lutLen) {
+    hin->lut = AIR_CALLOC(lutLen, size_t);
+    if (!hin->lut) {
+      biffAddf(NRRD, "%s: couldn't allocate %u-entry bin table", me,
+               AIR_CAST(unsigned int, lutLen));
+      return 1;
+    }
+    airMopAdd(mop, hin->lut, airFree, airMopAlways);
+    for (ii=0; ii<lutLen; ii++) {
+      hin->lut[ii] = _nrrdHistoBinOne(hin, nrrdTypeMin[nin->type] + ii);
+    }
+  }
+  return 0;
+}
+
+/*
+** finds the bins of num values of hin->nin, at indices
+** I0 + stride*(pos ? pos[ii] : ii) for ii in [0,num)
+*/
+static void
+_nrrdHistoBinRun(size_t *bin, const _nrrdHistoInput *hin, size_t I0,
+                 size_t stride, const unsigned int *pos, size_t num) {
+  size_t ii;
+  const void *data;
+  double (*lup)(const void *, size_t);
+
+  data = hin->nin->data;
+#define INDEX (I0 + stride*(pos ? pos[ii] : ii))
+#define CASE(TYPE, CTYPE)                                               \
+  case TYPE:                                                            \
+    if (hin->lut) {                                                     \
+      for (ii=0; ii<num; ii++) {                                        \
+        bin[ii] = hin->lut[AIR_CAST(int, ((const CTYPE *)data)[INDEX])  \
+                           - AIR_CAST(int, nrrdTypeMin[TYPE])];         \
+      }                                                                 \
+    } else {                                                            \
+      for (ii=0; ii<num; ii++) {                                        \
+        bin[ii] = _nrrdHistoBinOne(hin, ((const CTYPE *)data)[INDEX]);  \
+      }                                                                 \
+    }                                                                   \
+    break
+  switch (hin->nin->type) {
+    CASE(nrrdTypeChar, signed char);
+    CASE(nrrdTypeUChar, unsigned char);
+    CASE(nrrdTypeShort, signed short);
+    CASE(nrrdTypeUShort, unsigned short);
+  case nrrdTypeFloat:
+    for (ii=0; ii<num; ii++) {
+      bin[ii] = _nrrdHistoBinOne(hin, ((const float *)data)[INDEX]);
+    }
+    break;
+  default:
+    lup = nrrdDLookup[hin->nin->type];
+    for (ii=0; ii<num; ii++) {
+      bin[ii] = _nrrdHistoBinOne(hin, lup(data, INDEX));
+    }
+    break;
+  }
+#undef CASE
+#undef INDEX
+  return;
+}
+
+static double
+_nrrdHistoCountMax(int type) {
+  double ret;
+
+  switch (type) {
+  case nrrdTypeFloat:
+    ret = 16777216.0;
+    break;
+  case nrrdTypeLLong:
+  case nrrdTypeULLong:
+  case nrrdTypeDouble:
+    ret = 9007199254740992.0;
+    break;
+  default:
+    ret = nrrdTypeMax[type];
+    break;
+  }
+  return ret;
+}
+
+/* saves num counts into nout, starting at index I0, with stride */
+static void
+_nrrdHistoCountSave(Nrrd *nout, size_t I0, size_t stride,
+                    const size_t *count, size_t num) {
+  double cmax, (*ins)(void *, size_t, double);
+  size_t ii;
+
+  cmax = _nrrdHistoCountMax(nout->type);
+  ins = nrrdDInsert[nout->type];
+  for (ii=0; ii<num; ii++) {
+    ins(nout->data, I0 + stride*ii, AIR_MIN(AIR_CAST(double, count[ii]),
+                                            cmax));
+  }
+  return;
+}
+
+static _nrrdHistoTask *
+_nrrdHistoTaskNew(const void *job, unsigned int threadNum, size_t workNum,
+                  size_t countNum, airArray *mop) {
+  static const char me[]="_nrrdHistoTaskNew";
+  _nrrdHistoTask *task;
+  unsigned int ti;
+
+  task = AIR_CALLOC(threadNum, _nrrdHistoTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    return NULL;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  for (ti=0; ti<threadNum; ti++) {
+    task[ti].job = job;
+    task[ti].lo = workNum*ti/threadNum;
+    task[ti].hi = workNum*(ti+1)/threadNum;
+    task[ti].count = AIR_CALLOC(countNum, size_t);
+    airMopAdd(mop, task[ti].count, airFree, airMopAlways);
+    task[ti].bin = AIR_CALLOC(2*_NRRD_HISTO_CHUNK, size_t);
+    airMopAdd(mop, task[ti].bin, airFree, airMopAlways);
+    task[ti].pos = AIR_CALLOC(_NRRD_HISTO_CHUNK, unsigned int);
+    airMopAdd(mop, task[ti].pos, airFree, airMopAlways);
+    if (!( task[ti].count && task[ti].bin && task[ti].pos )) {
+      char stmp[AIR_STRLEN_SMALL];
+      biffAddf(NRRD, "%s: couldn't allocate %s counters for task %u", me,
+               airSprintSize_t(stmp, countNum), ti);
+      return NULL;
+    }
+    task[ti].flat = task[ti].bin + _NRRD_HISTO_CHUNK;
+  }
+  return task;
+}
+
+typedef struct {
+  Nrrd *nout;
+  _nrrdHistoInput hin[NRRD_DIM_MAX];
+  unsigned int numNin;
+  size_t valNum,             /* number of values per input */
+    binNum,                  /* total number of (joint) bins */
+    lastStride;              /* product of bins for all but last input */
+  int blocked;               /* each task has a block of bins along the
+                                last input's axis, instead of a range of
+                                values */
+} _nrrdHistoJointJob;
+
+static void *
+_nrrdHistoJointWorker(void *_task) {
+  _nrrdHistoTask *task;
+  const _nrrdHistoJointJob *job;
+  size_t vlo, vhi, blo, bhi, I0, num, nn, ii, mm, *bin, *flat, *count;
+  unsigned int ai, last, *pos;
+
+  task = AIR_CAST(_nrrdHistoTask *, _task);
+  job = AIR_CAST(const _nrrdHistoJointJob *, task->job);
+  last = job->numNin - 1;
+  if (job->blocked) {
+    vlo = 0;
+    vhi = job->valNum;
+    blo = task->lo;
+    bhi = task->hi;
+  } else {
+    vlo = task->lo;
+    vhi = task->hi;
+    blo = 0;
+    bhi = job->hin[last].bins;
+  }
+  bin = task->bin;
+  flat = task->flat;
+  pos = task->pos;
+  count = task->count;
+  for (I0=vlo; I0<vhi; I0+=_NRRD_HISTO_CHUNK) {
+    num = AIR_MIN(_NRRD_HISTO_CHUNK, vhi - I0);
+    /* first find bins along last axis, filtering for [blo,bhi), then
+       bin the surviving values for the other inputs */
+    _nrrdHistoBinRun(bin, job->hin + last, I0, 1, NULL, num);
+    for (ii=mm=0; ii<num; ii++) {
+      if (_NRRD_HISTO_SKIP != bin[ii] && blo <= bin[ii] && bin[ii] < bhi) {
+        pos[mm] = AIR_CAST(unsigned int, ii);
+        flat[mm] = bin[ii] - blo;
+        mm++;
+      }
+    }
+    nn = mm;
+    for (ai=last; ai-- > 0;) {
+      _nrrdHistoBinRun(bin, job->hin + ai, I0, 1, pos, nn);
+      for (ii=mm=0; ii<nn; ii++) {
+        if (_NRRD_HISTO_SKIP != bin[ii]) {
+          pos[mm] = pos[ii];
+          flat[mm] = bin[ii] + job->hin[ai].bins*flat[ii];
+          mm++;
+        }
+      }
+      nn = mm;
+    }
+    for (ii=0; ii<nn; ii++) {
+      count[flat[ii]]++;
+    }
+  }
+  if (job->blocked) {
+    _nrrdHistoCountSave(job->nout, blo*job->lastStride, 1, count,
+                        (bhi - blo)*job->lastStride);
+  }
+  return _task;
+}
+
+/*
+** unweighted nrrdHisto and nrrdHistoJoint: job->hin[] and job->numNin
+** must be set, and job->nout allocated (and zeroed)
+*/
+static int
+_nrrdHistoJointRun(_nrrdHistoJointJob *job) {
+  static const char me[]="_nrrdHistoJointRun";
+  unsigned int ai, ti, threadNum;
+  size_t ii, workNum, countNum, lastBins;
+  _nrrdHistoTask *task;
+  airArray *mop;
+
+  mop = airMopNew();
+  job->valNum = nrrdElementNumber(job->hin[0].nin);
+  job->lastStride = 1;
+  for (ai=0; ai<job->numNin; ai++) {
+    if (_nrrdHistoInputInit(job->hin + ai, job->hin[ai].nin, job->valNum,
+                            mop)) {
+      biffAddf(NRRD, "%s: trouble with input %u", me, ai);
+      airMopError(mop); return 1;
+    }
+    if (ai < job->numNin-1) {
+      job->lastStride *= job->hin[ai].bins;
+    }
+  }
+  lastBins = job->hin[job->numNin-1].bins;
+  job->binNum = job->lastStride*lastBins;
+  threadNum = _nrrdThreadNum(1 + job->valNum/_NRRD_HISTO_CHUNK,
+                             job->valNum, _NRRD_HISTO_GRAIN);
+  job->blocked = (threadNum > 1
+                  && threadNum*job->binNum*sizeof(size_t)
+                  > _NRRD_HISTO_PRIVATE);
+  if (job->blocked) {
+    threadNum = AIR_CAST(unsigned int, AIR_MIN(threadNum, lastBins));
+    workNum = lastBins;
+    countNum = job->lastStride*((lastBins + threadNum - 1)/threadNum);
+  } else {
+    workNum = job->valNum;
+    countNum = job->binNum;
+  }
+  task = _nrrdHistoTaskNew(job, threadNum, workNum, countNum, mop);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't set up", me);
+    airMopError(mop); return 1;
+  }
+  if (_nrrdThreadRun(_nrrdHistoJointWorker, task, sizeof(_nrrdHistoTask),
+                     threadNum)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  if (!job->blocked) {
+    for (ti=1; ti<threadNum; ti++) {
+      for (ii=0; ii<job->binNum; ii++) {
+        task[0].count[ii] += task[ti].count[ii];
+      }
+    }
+    _nrrdHistoCountSave(job->nout, 0, 1, task[0].count, job->binNum);
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+typedef struct {
+  Nrrd *nout;
+  _nrrdHistoInput hin;
+  size_t innerNum,           /* number of scanlines per outer slice */
+    len,                     /* length of scanlines along histo axis */
+    blockLen,                /* number of scanlines per work unit */
+    blockNum;                /* number of work units per outer slice */
+} _nrrdHistoAxisJob;
+
+static void *
+_nrrdHistoAxisWorker(void *_task) {
+  _nrrdHistoTask *task;
+  const _nrrdHistoAxisJob *job;
+  size_t ui, oi, i0, nb, hh, h0, num, ii, bins, *bin, *count;
+
+  task = AIR_CAST(_nrrdHistoTask *, _task);
+  job = AIR_CAST(const _nrrdHistoAxisJob *, task->job);
+  bins = job->hin.bins;
+  bin = task->bin;
+  count = task->count;
+  for (ui=task->lo; ui<task->hi; ui++) {
+    oi = ui / job->blockNum;
+    i0 = (ui % job->blockNum)*job->blockLen;
+    nb = AIR_MIN(job->blockLen, job->innerNum - i0);
+    memset(count, 0, bins*nb*sizeof(size_t));
+    if (1 == job->innerNum) {
+      /* scanlines are contiguous */
+      for (h0=0; h0<job->len; h0+=_NRRD_HISTO_CHUNK) {
+        num = AIR_MIN(_NRRD_HISTO_CHUNK, job->len - h0);
+        _nrrdHistoBinRun(bin, &(job->hin), h0 + job->len*oi, 1, NULL, num);
+        for (ii=0; ii<num; ii++) {
+          if (_NRRD_HISTO_SKIP != bin[ii]) {
+            count[bin[ii]]++;
+          }
+        }
+      }
+    } else {
+      for (hh=0; hh<job->len; hh++) {
+        _nrrdHistoBinRun(bin, &(job->hin),
+                         i0 + job->innerNum*(hh + job->len*oi),
+                         1, NULL, nb);
+        for (ii=0; ii<nb; ii++) {
+          if (_NRRD_HISTO_SKIP != bin[ii]) {
+            count[ii + nb*bin[ii]]++;
+          }
+        }
+      }
+    }
+    for (hh=0; hh<bins; hh++) {
+      _nrrdHistoCountSave(job->nout, i0 + job->innerNum*(hh + bins*oi), 1,
+                          count + nb*hh, nb);
+    }
+  }
+  return _task;
+}
+
+
 /*
 ******** nrrdHisto()
 **
@@ -120,26 +543,39 @@ nrrdHisto(Nrrd *nout, const Nrrd *nin, const NrrdRange *_range,
   /* nout->axis[0].label set below */
 
   /* make histogram */
-  num = nrrdElementNumber(nin);
-  for (I=0; I<num; I++) {
-    val = nrrdDLookup[nin->type](nin->data, I);
-    if (AIR_EXISTS(val)) {
-      if (val < min || val > max+eps) {
-        /* value is outside range; ignore it */
-        continue;
-      }
-      if (AIR_IN_CL(min, val, max)) {
-        idx = airIndex(min, val, max+eps, AIR_CAST(unsigned int, bins));
-        /*
-        printf("!%s: %d: index(%g, %g, %g, %d) = %d\n",
-               me, (int)I, min, val, max, bins, idx);
-        */
-        /* count is a double in order to simplify clamping the
-           hit values to the representable range for nout->type */
-        count = nrrdDLookup[nout->type](nout->data, idx);
-        incr = nwght ? lup(nwght->data, I) : 1;
-        count = nrrdDClamp[nout->type](count + incr);
-        nrrdDInsert[nout->type](nout->data, idx, count);
+  if (!nwght) {
+    _nrrdHistoJointJob job;
+    job.nout = nout;
+    job.numNin = 1;
+    job.hin[0].nin = nin;
+    job.hin[0].lo = job.hin[0].imin = min;
+    job.hin[0].hi = max;
+    job.hin[0].imax = max+eps;
+    job.hin[0].bins = bins;
+    job.hin[0].clamp = AIR_FALSE;
+    job.hin[0].ull = AIR_FALSE;
+    if (_nrrdHistoJointRun(&job)) {
+      biffAddf(NRRD, "%s: trouble making histogram", me);
+      airMopError(mop); return 1;
+    }
+  } else {
+    num = nrrdElementNumber(nin);
+    for (I=0; I<num; I++) {
+      val = nrrdDLookup[nin->type](nin->data, I);
+      if (AIR_EXISTS(val)) {
+        if (val < min || val > max+eps) {
+          /* value is outside range; ignore it */
+          continue;
+        }
+        if (AIR_IN_CL(min, val, max)) {
+          idx = airIndex(min, val, max+eps, AIR_CAST(unsigned int, bins));
+          /* count is a double in order to simplify clamping the
+             hit values to the representable range for nout->type */
+          count = nrrdDLookup[nout->type](nout->data, idx);
+          incr = lup(nwght->data, I);
+          count = nrrdDClamp[nout->type](count + incr);
+          nrrdDInsert[nout->type](nout->data, idx, count);
+        }
       }
     }
   }
@@ -336,11 +772,10 @@ nrrdHistoAxis(Nrrd *nout, const Nrrd *nin, const NrrdRange *_range,
               unsigned int hax, size_t bins, int type) {
   static const char me[]="nrrdHistoAxis", func[]="histax";
   int map[NRRD_DIM_MAX];
-  unsigned int ai, hidx;
-  size_t szIn[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX], size[NRRD_DIM_MAX],
-    coordIn[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX];
-  size_t I, hI, num;
-  double val, count;
+  unsigned int ai, threadNum;
+  size_t size[NRRD_DIM_MAX], num, outerNum;
+  _nrrdHistoAxisJob job;
+  _nrrdHistoTask *task;
   airArray *mop;
   NrrdRange *range;
 
@@ -411,27 +846,36 @@ nrrdHistoAxis(Nrrd *nout, const Nrrd *nin, const NrrdRange *_range,
     nout->axis[hax].kind = nrrdKindDomain;
   }
 
-  /* the skinny: we traverse the input samples in linear order, and
-     increment the bin in the histogram for the scanline we're in.
-     This is not terribly clever, and the memory locality is a
-     disaster */
-  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
-  nrrdAxisInfoGet_nva(nout, nrrdAxisInfoSize, szOut);
-  memset(coordIn, 0, NRRD_DIM_MAX*sizeof(size_t));
+  /* the skinny: the scanlines along hax are histogrammed in blocks of
+     up to job.blockLen adjacent scanlines (which are interleaved in
+     memory), so that both the input and output are traversed in order */
+  job.nout = nout;
+  job.hin.nin = nin;
+  job.hin.lo = job.hin.imin = range->min;
+  job.hin.hi = job.hin.imax = range->max;
+  job.hin.bins = bins;
+  job.hin.clamp = AIR_FALSE;
+  job.hin.ull = AIR_FALSE;
+  job.innerNum = 1;
+  for (ai=0; ai<hax; ai++) {
+    job.innerNum *= nin->axis[ai].size;
+  }
+  job.len = nin->axis[hax].size;
   num = nrrdElementNumber(nin);
-  for (I=0; I<num; I++) {
-    /* get input nrrd value and compute its histogram index */
-    val = nrrdDLookup[nin->type](nin->data, I);
-    if (AIR_EXISTS(val) && AIR_IN_CL(range->min, val, range->max)) {
-      hidx = airIndex(range->min, val, range->max, AIR_CAST(unsigned int, bins));
-      memcpy(coordOut, coordIn, nin->dim*sizeof(size_t));
-      coordOut[hax] = (unsigned int)hidx;
-      NRRD_INDEX_GEN(hI, coordOut, szOut, nout->dim);
-      count = nrrdDLookup[nout->type](nout->data, hI);
-      count = nrrdDClamp[nout->type](count + 1);
-      nrrdDInsert[nout->type](nout->data, hI, count);
-    }
-    NRRD_COORD_INCR(coordIn, szIn, nin->dim, 0);
+  outerNum = num/(job.innerNum*job.len);
+  job.blockLen = AIR_MIN(job.innerNum,
+                         AIR_MAX(1, AIR_MIN(_NRRD_HISTO_CHUNK,
+                                            _NRRD_HISTO_PRIVATE
+                                            /(8*bins*sizeof(size_t)))));
+  job.blockNum = (job.innerNum + job.blockLen - 1)/job.blockLen;
+  threadNum = _nrrdThreadNum(outerNum*job.blockNum, num, _NRRD_HISTO_GRAIN);
+  if (_nrrdHistoInputInit(&(job.hin), nin, num, mop)
+      || !(task = _nrrdHistoTaskNew(&job, threadNum, outerNum*job.blockNum,
+                                    bins*job.blockLen, mop))
+      || _nrrdThreadRun(_nrrdHistoAxisWorker, task, sizeof(_nrrdHistoTask),
+                        threadNum)) {
+    biffAddf(NRRD, "%s: trouble making histograms", me);
+    airMopError(mop); return 1;
   }
 
   if (nrrdContentSet_va(nout, func, nin, "%d,%d", hax, bins)) {
@@ -596,38 +1040,58 @@ nrrdHistoJoint(Nrrd *nout, const Nrrd *const *nin,
       rmax[ai] = range[ai]->min;
     }
   }
-  numEl = nrrdElementNumber(nin[0]);
-  for (Iin=0; Iin<numEl; Iin++) {
-    skip = 0;
+  if (!nwght) {
+    _nrrdHistoJointJob job;
+    job.nout = nout;
+    job.numNin = numNin;
     for (ai=0; ai<numNin; ai++) {
-      val = nrrdDLookup[nin[ai]->type](nin[ai]->data, Iin);
-      if (!AIR_EXISTS(val)) {
-        /* coordinate d in the joint histo can't be determined
-           if nin[ai] has a non-existent value here */
-        skip = 1;
-        break;
-      }
-      if (!AIR_IN_CL(rmin[ai], val, rmax[ai])) {
-        if (clamp[ai]) {
-          val = AIR_CLAMP(rmin[ai], val, rmax[ai]);
-        } else {
+      job.hin[ai].nin = nin[ai];
+      job.hin[ai].lo = rmin[ai];
+      job.hin[ai].hi = rmax[ai];
+      job.hin[ai].imin = range[ai]->min;
+      job.hin[ai].imax = range[ai]->max;
+      job.hin[ai].bins = bins[ai];
+      job.hin[ai].clamp = clamp[ai];
+      job.hin[ai].ull = AIR_TRUE;
+    }
+    if (_nrrdHistoJointRun(&job)) {
+      biffAddf(NRRD, "%s: trouble making histogram", me);
+      airMopError(mop); return 1;
+    }
+  } else {
+    numEl = nrrdElementNumber(nin[0]);
+    for (Iin=0; Iin<numEl; Iin++) {
+      skip = 0;
+      for (ai=0; ai<numNin; ai++) {
+        val = nrrdDLookup[nin[ai]->type](nin[ai]->data, Iin);
+        if (!AIR_EXISTS(val)) {
+          /* coordinate d in the joint histo can't be determined
+             if nin[ai] has a non-existent value here */
           skip = 1;
           break;
         }
+        if (!AIR_IN_CL(rmin[ai], val, rmax[ai])) {
+          if (clamp[ai]) {
+            val = AIR_CLAMP(rmin[ai], val, rmax[ai]);
+          } else {
+            skip = 1;
+            break;
+          }
+        }
+        coord[ai] = AIR_CAST(size_t, airIndexClampULL(range[ai]->min,
+                                                      val,
+                                                      range[ai]->max,
+                                                      bins[ai]));
       }
-      coord[ai] = AIR_CAST(size_t, airIndexClampULL(range[ai]->min,
-                                                    val,
-                                                    range[ai]->max,
-                                                    bins[ai]));
-    }
-    if (skip) {
-      continue;
-    }
-    NRRD_INDEX_GEN(Iout, coord, bins, numNin);
-    count = nrrdDLookup[nout->type](nout->data, Iout);
-    incr = nwght ? lup(nwght->data, Iin) : 1.0;
-    count = nrrdDClamp[nout->type](count + incr);
-    nrrdDInsert[nout->type](nout->data, Iout, count);
+      if (skip) {
+        continue;
+      }
+      NRRD_INDEX_GEN(Iout, coord, bins, numNin);
+      count = nrrdDLookup[nout->type](nout->data, Iout);
+      incr = lup(nwght->data, Iin);
+      count = nrrdDClamp[nout->type](count + incr);
+      nrrdDInsert[nout->type](nout->data, Iout, count);
+    }
   }
 
   /* HEY: switch to nrrdContentSet_va? */
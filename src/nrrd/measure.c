@@ -1166,6 +1166,302 @@ _nrrdMeasureType(const Nrrd *nin, int measr) {
   return type;
 }
 
+/* ---------------------------- blocked projection -------------- */
+
+/*
+** nrrdProject gathers each column (with stride colNum) into a scanline
+** for nrrdMeasureLine[measr], which is slow when projecting along a
+** slow axis.  The measures that can be computed by updating a running
+** value with each successive value (those for which _nrrdProjectBlocks
+** is true) are instead computed by sweeping through contiguous memory:
+** each run of values (at one position along the projection axis)
+** updates the accumulators of a block of up to _NRRD_PROJECT_BLOCK
+** columns.  The work is split into (row, block) units, which are
+** divided among nrrdDefaultThreadNum threads.
+**
+** The results are exactly those of nrrdMeasureLine: values are
+** accumulated in the same order, with the same handling of
+** non-existent values: until the first existent value, a column's
+** accumulator just holds the most recent value (as with the
+** "for (ii=0; !AIR_EXISTS(M) && ii<len; ii++)" loops above), and after
+** that, non-existent values are skipped.
+*/
+
+#define _NRRD_PROJECT_BLOCK 1024
+
+typedef struct {
+  int measr, iType, oType;
+  const char *iData;
+  char *oData;
+  size_t colNum, rowNum, linLen,
+    blockNum;                /* number of column blocks per row */
+} _nrrdProjectJob;
+
+typedef struct {
+  const _nrrdProjectJob *job;
+  size_t lo, hi;             /* range of (row, block) units to do */
+  double *val, *acc, *mean;  /* each _NRRD_PROJECT_BLOCK long */
+  size_t *cnt;               /* number of existent values so far */
+} _nrrdProjectTask;
+
+static int
+_nrrdProjectBlocks(int measr) {
+
+  switch (measr) {
+  case nrrdMeasureMin:
+  case nrrdMeasureMax:
+  case nrrdMeasureMean:
+  case nrrdMeasureProduct:
+  case nrrdMeasureSum:
+  case nrrdMeasureL1:
+  case nrrdMeasureL2:
+  case nrrdMeasureL4:
+  case nrrdMeasureNormalizedL2:
+  case nrrdMeasureRootMeanSquare:
+  case nrrdMeasureLinf:
+  case nrrdMeasureVariance:
+  case nrrdMeasureSD:
+    return AIR_TRUE;
+  }
+  return AIR_FALSE;
+}
+
+#define _NRRD_PROJECT_LOAD(TYPE)                            \
+  for (ii=0; ii<num; ii++) {                                \
+    val[ii] = AIR_CAST(const TYPE *, data)[ii];             \
+  }                                                         \
+  break
+
+/* loads num contiguous values of given type into val */
+static void
+_nrrdProjectLoad(double *val, const void *data, int type, size_t num) {
+  double (*lup)(const void*, size_t);
+  size_t ii;
+
+  switch (type) {
+  case nrrdTypeChar:   _NRRD_PROJECT_LOAD(signed char);
+  case nrrdTypeUChar:  _NRRD_PROJECT_LOAD(unsigned char);
+  case nrrdTypeShort:  _NRRD_PROJECT_LOAD(signed short);
+  case nrrdTypeUShort: _NRRD_PROJECT_LOAD(unsigned short);
+  case nrrdTypeInt:    _NRRD_PROJECT_LOAD(signed int);
+  case nrrdTypeUInt:   _NRRD_PROJECT_LOAD(unsigned int);
+  case nrrdTypeFloat:  _NRRD_PROJECT_LOAD(float);
+  case nrrdTypeDouble: _NRRD_PROJECT_LOAD(double);
+  default:
+    /* the 64-bit integers, with their portability issues */
+    lup = nrrdDLookup[type];
+    for (ii=0; ii<num; ii++) {
+      val[ii] = lup(data, ii);
+    }
+    break;
+  }
+  return;
+}
+
+/*
+** updates the accumulators of the ncol columns with the values in val;
+** cnt[ci] is zero until the first existent value, which sets acc[ci]
+** to START, after which acc[ci] is UPDATEd with each existent value vv
+*/
+#define _NRRD_PROJECT_ACC(START, UPDATE)                    \
+  for (ci=0; ci<ncol; ci++) {                               \
+    vv = val[ci];                                           \
+    if (!AIR_EXISTS(vv)) {                                  \
+      if (!cnt[ci]) {                                       \
+        acc[ci] = vv;                                       \
+      }                                                     \
+    } else if (cnt[ci]++) {                                 \
+      UPDATE;                                               \
+    } else {                                                \
+      acc[ci] = (START);                                    \
+    }                                                       \
+  }                                                         \
+  break
+
+/* does the ncol columns starting at column col0 of row rowIdx */
+static void
+_nrrdProjectUnit(const _nrrdProjectTask *task, size_t rowIdx,
+                 size_t col0, size_t ncol) {
+  const _nrrdProjectJob *job;
+  const char *iData;
+  char *oData;
+  double *val, *acc, *mean, vv, ret;
+  size_t *cnt, iElSz, oElSz, iStep, ei, ci;
+  int integral;
+
+  job = task->job;
+  val = task->val;
+  acc = task->acc;
+  mean = task->mean;
+  cnt = task->cnt;
+  iElSz = nrrdTypeSize[job->iType];
+  oElSz = nrrdTypeSize[job->oType];
+  iStep = iElSz*job->colNum;
+  iData = job->iData + iElSz*(col0 + rowIdx*job->linLen*job->colNum);
+  oData = job->oData + oElSz*(col0 + rowIdx*job->colNum);
+  integral = nrrdTypeIsIntegral[job->iType];
+  for (ci=0; ci<ncol; ci++) {
+    acc[ci] = AIR_NAN;
+    mean[ci] = 0.0;
+    cnt[ci] = 0;
+  }
+
+  if (nrrdMeasureVariance == job->measr || nrrdMeasureSD == job->measr) {
+    /* as with _nrrdMeasureVariance: two passes */
+    for (ei=0; ei<job->linLen; ei++) {
+      _nrrdProjectLoad(val, iData + ei*iStep, job->iType, ncol);
+      for (ci=0; ci<ncol; ci++) {
+        vv = val[ci];
+        if (AIR_EXISTS(vv)) {
+          cnt[ci]++;
+          mean[ci] += vv;
+        }
+      }
+    }
+    for (ci=0; ci<ncol; ci++) {
+      acc[ci] = 0.0;
+      if (cnt[ci]) {
+        mean[ci] /= cnt[ci];
+      }
+    }
+    for (ei=0; ei<job->linLen; ei++) {
+      _nrrdProjectLoad(val, iData + ei*iStep, job->iType, ncol);
+      for (ci=0; ci<ncol; ci++) {
+        vv = val[ci];
+        if (AIR_EXISTS(vv)) {
+          acc[ci] += (vv-mean[ci])*(vv-mean[ci]);
+        }
+      }
+    }
+    for (ci=0; ci<ncol; ci++) {
+      ret = cnt[ci] ? acc[ci]/cnt[ci] : AIR_NAN;
+      nrrdDStore[job->oType](oData + oElSz*ci, ret);
+      if (nrrdMeasureSD == job->measr) {
+        /* as with _nrrdMeasureSD */
+        ret = nrrdDLoad[job->oType](oData + oElSz*ci);
+        nrrdDStore[job->oType](oData + oElSz*ci, sqrt(ret));
+      }
+    }
+    return;
+  }
+
+  for (ei=0; ei<job->linLen; ei++) {
+    _nrrdProjectLoad(val, iData + ei*iStep, job->iType, ncol);
+    switch (job->measr) {
+    case nrrdMeasureMin:
+      _NRRD_PROJECT_ACC(vv, acc[ci] = AIR_MIN(acc[ci], vv));
+    case nrrdMeasureMax:
+      _NRRD_PROJECT_ACC(vv, acc[ci] = AIR_MAX(acc[ci], vv));
+    case nrrdMeasureProduct:
+      _NRRD_PROJECT_ACC(vv, acc[ci] *= vv);
+    case nrrdMeasureMean:
+    case nrrdMeasureSum:
+      _NRRD_PROJECT_ACC(vv, acc[ci] += vv);
+    case nrrdMeasureL1:
+      _NRRD_PROJECT_ACC(AIR_ABS(vv), acc[ci] += AIR_ABS(vv));
+    case nrrdMeasureLinf:
+      _NRRD_PROJECT_ACC(AIR_ABS(vv), vv = AIR_ABS(vv);
+                        acc[ci] = AIR_MAX(acc[ci], vv));
+    case nrrdMeasureL4:
+      /* the START is how L2_BODY evaluates it */
+      _NRRD_PROJECT_ACC(integral ? vv*vv*vv*vv : vv*(vv*vv*vv),
+                        acc[ci] += vv*vv*vv*vv);
+    default:
+      /* nrrdMeasureL2, nrrdMeasureNormalizedL2, nrrdMeasureRootMeanSquare */
+      _NRRD_PROJECT_ACC(vv*vv, acc[ci] += vv*vv);
+    }
+  }
+  for (ci=0; ci<ncol; ci++) {
+    ret = acc[ci];
+    switch (job->measr) {
+    case nrrdMeasureMean:
+      ret = cnt[ci] ? ret/cnt[ci] : AIR_NAN;
+      break;
+    case nrrdMeasureL1:
+    case nrrdMeasureLinf:
+      ret = AIR_ABS(ret);
+      break;
+    case nrrdMeasureL2:
+      ret = AIR_EXISTS(ret) ? sqrt(ret) : AIR_NAN;
+      break;
+    case nrrdMeasureL4:
+      ret = AIR_EXISTS(ret) ? sqrt(sqrt(ret)) : AIR_NAN;
+      break;
+    case nrrdMeasureNormalizedL2:
+      ret = AIR_EXISTS(ret) ? sqrt(ret)/cnt[ci] : AIR_NAN;
+      break;
+    case nrrdMeasureRootMeanSquare:
+      ret = AIR_EXISTS(ret) ? sqrt(ret/cnt[ci]) : AIR_NAN;
+      break;
+    }
+    nrrdDStore[job->oType](oData + oElSz*ci, ret);
+  }
+  return;
+}
+
+static void *
+_nrrdProjectWorker(void *_task) {
+  _nrrdProjectTask *task;
+  const _nrrdProjectJob *job;
+  size_t ui, col0;
+
+  task = AIR_CAST(_nrrdProjectTask *, _task);
+  job = task->job;
+  for (ui=task->lo; ui<task->hi; ui++) {
+    col0 = (ui % job->blockNum)*_NRRD_PROJECT_BLOCK;
+    _nrrdProjectUnit(task, ui/job->blockNum, col0,
+                     AIR_MIN(_NRRD_PROJECT_BLOCK, job->colNum - col0));
+  }
+  return _task;
+}
+
+/* fewest input values for which it is worth starting another thread */
+#define _NRRD_PROJECT_GRAIN 65536
+
+static int
+_nrrdProjectRun(_nrrdProjectJob *job) {
+  static const char me[]="_nrrdProjectRun";
+  unsigned int ti, threadNum;
+  size_t unitNum;
+  _nrrdProjectTask *task;
+  airArray *mop;
+
+  job->blockNum = (job->colNum + _NRRD_PROJECT_BLOCK - 1)/_NRRD_PROJECT_BLOCK;
+  unitNum = job->rowNum*job->blockNum;
+  threadNum = _nrrdThreadNum(unitNum, job->rowNum*job->colNum*job->linLen,
+                             _NRRD_PROJECT_GRAIN);
+
+  mop = airMopNew();
+  task = AIR_CALLOC(threadNum, _nrrdProjectTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  for (ti=0; ti<threadNum; ti++) {
+    task[ti].job = job;
+    task[ti].lo = unitNum*ti/threadNum;
+    task[ti].hi = unitNum*(ti+1)/threadNum;
+    task[ti].val = AIR_CALLOC(3*_NRRD_PROJECT_BLOCK, double);
+    task[ti].cnt = AIR_CALLOC(_NRRD_PROJECT_BLOCK, size_t);
+    airMopAdd(mop, task[ti].val, airFree, airMopAlways);
+    airMopAdd(mop, task[ti].cnt, airFree, airMopAlways);
+    if (!(task[ti].val && task[ti].cnt)) {
+      biffAddf(NRRD, "%s: couldn't allocate buffers for task %u", me, ti);
+      airMopError(mop); return 1;
+    }
+    task[ti].acc = task[ti].val + _NRRD_PROJECT_BLOCK;
+    task[ti].mean = task[ti].val + 2*_NRRD_PROJECT_BLOCK;
+  }
+  if (_nrrdThreadRun(_nrrdProjectWorker, task, sizeof(_nrrdProjectTask),
+                     threadNum)) {
+    biffAddf(NRRD, "%s: trouble with %u threads", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 int
 nrrdProject(Nrrd *nout, const Nrrd *cnin, unsigned int axis,
             int measr, int type) {
@@ -1260,30 +1556,46 @@ nrrdProject(Nrrd *nout, const Nrrd *cnin, unsigned int axis,
     airMopError(mop); return 1;
   }
 
-  /* allocate a scanline buffer */
-  if (!(line = AIR_CALLOC(linLen*iElSz, char))) {
-    char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
-    biffAddf(NRRD, "%s: couldn't calloc(%s,%s) scanline buffer", me,
-             airSprintSize_t(stmp1, linLen),
-             airSprintSize_t(stmp2, iElSz));
-    airMopError(mop); return 1;
-  }
-  airMopAdd(mop, line, airFree, airMopAlways);
-
-  /* the skinny */
-  axmin = (nin ? nin : cnin)->axis[axis].min;
-  axmax = (nin ? nin : cnin)->axis[axis].max;
   iData = AIR_CAST(char *, (nin ? nin : cnin)->data);
   oData = AIR_CAST(char *, nout->data);
-  for (rowIdx=0; rowIdx<rowNum; rowIdx++) {
-    for (colIdx=0; colIdx<colNum; colIdx++) {
-      ptr = iData + iElSz*(colIdx + rowIdx*colStep);
-      for (ei=0; ei<linLen; ei++) {
-        memcpy(line + ei*iElSz, ptr + ei*iElSz*colNum, iElSz);
+  if (_nrrdProjectBlocks(measr)) {
+    _nrrdProjectJob job;
+    job.measr = measr;
+    job.iType = iType;
+    job.oType = oType;
+    job.iData = iData;
+    job.oData = oData;
+    job.colNum = colNum;
+    job.rowNum = rowNum;
+    job.linLen = linLen;
+    if (_nrrdProjectRun(&job)) {
+      biffAddf(NRRD, "%s: trouble", me);
+      airMopError(mop); return 1;
+    }
+  } else {
+    /* allocate a scanline buffer */
+    if (!(line = AIR_CALLOC(linLen*iElSz, char))) {
+      char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
+      biffAddf(NRRD, "%s: couldn't calloc(%s,%s) scanline buffer", me,
+               airSprintSize_t(stmp1, linLen),
+               airSprintSize_t(stmp2, iElSz));
+      airMopError(mop); return 1;
+    }
+    airMopAdd(mop, line, airFree, airMopAlways);
+
+    /* the skinny */
+    axmin = (nin ? nin : cnin)->axis[axis].min;
+    axmax = (nin ? nin : cnin)->axis[axis].max;
+    for (rowIdx=0; rowIdx<rowNum; rowIdx++) {
+      for (colIdx=0; colIdx<colNum; colIdx++) {
+        ptr = iData + iElSz*(colIdx + rowIdx*colStep);
+        for (ei=0; ei<linLen; ei++) {
+          memcpy(line + ei*iElSz, ptr + ei*iElSz*colNum, iElSz);
+        }
+        nrrdMeasureLine[measr](oData, oType, line, iType, linLen,
+                               axmin, axmax);
+        oData += oElSz;
       }
-      nrrdMeasureLine[measr](oData, oType, line, iType, linLen,
-                             axmin, axmax);
-      oData += oElSz;
     }
   }
 
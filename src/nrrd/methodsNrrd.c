@@ -280,9 +280,15 @@ nrrdIoStateInit(NrrdIoState *nio) {
     nio->skipData = AIR_FALSE;
     nio->skipFormatURL = AIR_FALSE;
     nio->keepNrrdDataFileOpen = AIR_FALSE;
+    nio->mapData = AIR_FALSE;
     nio->zlibLevel = -1;
     nio->zlibStrategy = nrrdZlibStrategyDefault;
     nio->bzip2BlockSize = -1;
+    nio->threadNum = 1;
+    nio->zlibBlockSize = 0;
+    nio->readCrop = AIR_FALSE;
+    memset(nio->readCropMin, 0, NRRD_DIM_MAX*sizeof(size_t));
+    memset(nio->readCropMax, 0, NRRD_DIM_MAX*sizeof(size_t));
     nio->learningHeaderStrlen = AIR_FALSE;
     nio->PNGsRGBIntentKnown = AIR_FALSE;
     /* this is the most backwards-compatible */
@@ -471,7 +477,7 @@ nrrdBasicInfoInit(Nrrd *nrrd, int bitflag) {
   }
 
   if (!(NRRD_BASIC_INFO_DATA_BIT & bitflag)) {
-    nrrd->data = airFree(nrrd->data);
+    nrrd->data = _nrrdDataFree(nrrd->data);
   }
   if (!(NRRD_BASIC_INFO_TYPE_BIT & bitflag)) {
     nrrd->type = nrrdTypeUnknown;
@@ -757,7 +763,7 @@ Nrrd *
 nrrdEmpty(Nrrd *nrrd) {
 
   if (nrrd) {
-    nrrd->data = airFree(nrrd->data);
+    nrrd->data = _nrrdDataFree(nrrd->data);
     nrrdInit(nrrd);
   }
   return nrrd;
@@ -998,7 +1004,7 @@ nrrdAlloc_nva(Nrrd *nrrd, int type, unsigned int dim, const size_t *size) {
     return 1;
   }
 
-  nrrd->data = airFree(nrrd->data);
+  nrrd->data = _nrrdDataFree(nrrd->data);
   if (nrrdWrap_nva(nrrd, NULL, type, dim, size)) {
     biffAddf(NRRD, "%s:", me);
     return 1 ;
@@ -0,0 +1,211 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "nrrd.h"
+#include "privateNrrd.h"
+
+/*
+** Memory-mapping of raw data for nrrdLoad (when nio->mapData is set).
+** Data that was mapped rather than allocated is remembered in a small
+** registry keyed by the data pointer, so that all the places that would
+** otherwise airFree() nrrd->data instead go through _nrrdDataFree(),
+** which does the right thing for either kind of data.
+*/
+
+#if defined(_WIN32)
+#  define NRRD_MMAP 0
+#else
+#  define NRRD_MMAP 1
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+typedef struct {
+  void *data,       /* what nrrd->data was set to */
+    *base;          /* what mmap() returned (page aligned) */
+  size_t len;       /* length of the mapping */
+} _nrrdMapping;
+
+static _nrrdMapping *_nrrdMap = NULL;
+static airArray *_nrrdMapArr = NULL;
+/* the lock is created (only once, by whichever thread first needs it)
+   by _nrrdMapLock; the registry is only ever read or changed while
+   holding it, since airArrayLenIncr() may move _nrrdMap */
+static airThreadMutex *_nrrdMapMutex = NULL;
+static unsigned int _nrrdMapNum = 0;
+
+static void
+_nrrdMapLock(void) {
+  if (airThreadCapable && airThreadMutexNewOnce(&_nrrdMapMutex)) {
+    airThreadMutexLock(_nrrdMapMutex);
+  }
+}
+
+static void
+_nrrdMapUnlock(void) {
+  if (airThreadCapable && _nrrdMapMutex) {
+    airThreadMutexUnlock(_nrrdMapMutex);
+  }
+}
+
+/* returns index in registry of data, or _nrrdMapNum if not there;
+   the caller must hold the lock */
+static unsigned int
+_nrrdMapFind(const void *data) {
+  unsigned int mi;
+
+  for (mi=0; mi<_nrrdMapNum; mi++) {
+    if (data == _nrrdMap[mi].data) {
+      break;
+    }
+  }
+  return mi;
+}
+
+/*
+******** nrrdDataMapped
+**
+** returns non-zero iff the given data pointer (such as nrrd->data) is
+** currently memory-mapped from a file, rather than allocated
+*/
+int
+nrrdDataMapped(const void *data) {
+  unsigned int mi;
+  int ret;
+
+  if (!data) {
+    return AIR_FALSE;
+  }
+  _nrrdMapLock();
+  mi = _nrrdMapFind(data);
+  ret = (mi < _nrrdMapNum);
+  _nrrdMapUnlock();
+  return ret;
+}
+
+/*
+** _nrrdDataFree
+**
+** frees nrrd->data, whether it was allocated or mapped; returns NULL
+** so that it can be used like airFree()
+*/
+void *
+_nrrdDataFree(void *data) {
+  unsigned int mi;
+
+  if (!data) {
+    return NULL;
+  }
+  _nrrdMapLock();
+  mi = _nrrdMapFind(data);
+  if (mi < _nrrdMapNum) {
+#if NRRD_MMAP
+    munmap(_nrrdMap[mi].base, _nrrdMap[mi].len);
+#endif
+    _nrrdMap[mi] = _nrrdMap[_nrrdMapNum-1];
+    airArrayLenIncr(_nrrdMapArr, -1);
+    _nrrdMapUnlock();
+    return NULL;
+  }
+  _nrrdMapUnlock();
+  free(data);
+  return NULL;
+}
+
+/*
+** _nrrdDataMapTry
+**
+** tries to set nrrd->data by memory-mapping the (already sized) data
+** from the current position in the given file.  Returns non-zero iff
+** that worked; there is no error if it didn't, since the caller will
+** just fall back to allocating and reading.  The mapping is private
+** (copy-on-write): modifying the data never changes the file.  This
+** requires that the data start at an offset that is aligned for the
+** element size, that the file is a regular file that has all the data,
+** and that there's no need to change the data after it is read.
+*/
+int
+_nrrdDataMapTry(Nrrd *nrrd, FILE *file) {
+#if NRRD_MMAP
+  struct stat sbuf;
+  size_t size, elSize, align, pageSize, delta;
+  long int offset;
+  char *base;
+  unsigned int mi;
+  int fd;
+
+  elSize = nrrdElementSize(nrrd);
+  size = nrrdElementNumber(nrrd)*elSize;
+  fd = file ? fileno(file) : -1;
+  if (!size || -1 == fd) {
+    return AIR_FALSE;
+  }
+  offset = ftell(file);
+  if (offset < 0
+      || fstat(fd, &sbuf)
+      || !S_ISREG(sbuf.st_mode)
+      || AIR_CAST(size_t, sbuf.st_size) < AIR_CAST(size_t, offset) + size) {
+    return AIR_FALSE;
+  }
+  /* largest power of 2 (up to 8) that divides the element size */
+  align = 1;
+  while (align < 8 && !(elSize % (2*align))) {
+    align *= 2;
+  }
+  if (AIR_CAST(size_t, offset) % align) {
+    return AIR_FALSE;
+  }
+  pageSize = AIR_CAST(size_t, sysconf(_SC_PAGESIZE));
+  delta = AIR_CAST(size_t, offset) % pageSize;
+  base = AIR_CAST(char *, mmap(NULL, size + delta, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE, fd,
+                               AIR_CAST(off_t, offset) - delta));
+  if (MAP_FAILED == AIR_CAST(void *, base)) {
+    return AIR_FALSE;
+  }
+  _nrrdMapLock();
+  if (!_nrrdMapArr) {
+    _nrrdMapArr = airArrayNew(AIR_CAST(void **, &_nrrdMap), &_nrrdMapNum,
+                              sizeof(_nrrdMapping), 16);
+  }
+  mi = _nrrdMapArr ? airArrayLenIncr(_nrrdMapArr, 1) : 0;
+  if (!_nrrdMapArr || !_nrrdMap) {
+    _nrrdMapUnlock();
+    munmap(base, size + delta);
+    return AIR_FALSE;
+  }
+  _nrrdMap[mi].base = base;
+  _nrrdMap[mi].data = base + delta;
+  _nrrdMap[mi].len = size + delta;
+  _nrrdMapUnlock();
+  nrrd->data = base + delta;
+  return AIR_TRUE;
+#else
+  AIR_UNUSED(nrrd);
+  AIR_UNUSED(file);
+  return AIR_FALSE;
+#endif
+}
@@ -419,6 +419,16 @@ typedef struct NrrdIoState_t {
                                nrrd format. Probably used in conjunction with
                                skipData.  (currently for "unu data")
                                ON WRITE: no semantics */
+    mapData,                /* ON READ: for NRRD files with raw encoding in
+                               a single (attached or detached) data file,
+                               try to memory-map the data (copy-on-write)
+                               instead of allocating and reading it.  Falls
+                               back to reading if the endianness is wrong,
+                               the data start is misaligned, or mmap isn't
+                               available.  Mapped data is freed correctly by
+                               nrrdEmpty/nrrdNuke, but must never be passed
+                               to free(); see nrrdDataMapped().
+                               ON WRITE: no semantics */
     zlibLevel,              /* zlib compression level (0-9, -1 for
                                default[6], 0 for no compression). */
     zlibStrategy,           /* zlib compression strategy, can be one
@@ -434,6 +444,25 @@ typedef struct NrrdIoState_t {
                                written to PNG, we know an sRGB intent */
     PNGsRGBIntent;          /* ON READ+WRITE: iff sRGBIntentKnown, the intent
                                itself, from nrrdFormatPNGsRGBIntent* enum */
+  unsigned int threadNum;   /* ON READ+WRITE: number of threads to use for
+                               encodings that can use more than one
+                               (currently only gzip-blocked) */
+  size_t zlibBlockSize;     /* ON WRITE: for gzip-blocked, bytes of raw data
+                               compressed independently in each block
+                               (0 for default NRRD_ZLIB_BLOCK_SIZE_DEFAULT) */
+  int readCrop;             /* ON READ: if non-zero, read only the region
+                               [readCropMin, readCropMax] (inclusive, per
+                               axis), giving the same result as nrrdCrop()
+                               would on the whole array.  For NRRD files
+                               with raw, gzip, bzip2, or gzip-blocked
+                               encoding, only the needed data is read (and
+                               only the needed detached data files are
+                               opened), so memory use scales with the size
+                               of the region; otherwise the whole array is
+                               read and then cropped.  No effect with
+                               skipData */
+  size_t readCropMin[NRRD_DIM_MAX], /* ON READ: lower and upper corners */
+    readCropMax[NRRD_DIM_MAX];      /* of region to read, with readCrop */
   void *oldData;            /* ON READ: if non-NULL, pointer to space that
                                has already been allocated for oldDataSize */
   size_t oldDataSize;       /* ON READ: size of mem pointed to by oldData */
@@ -469,6 +498,41 @@ typedef struct {
   int hasNonExist;  /* from the nrrdHasNonExist* enum values */
 } NrrdRange;
 
+/*
+******** NrrdRangeSummary
+**
+** a summary of the values in a nrrd, for finding percentiles (as many
+** and as often as needed) without re-visiting all the values.  Made by
+** nrrdRangeSummarySet, and used by nrrdRangeSummaryPercentile and
+** nrrdRangePercentileSummarySet.  The percentiles are found by
+** selection in the sampled values val[], which are partially re-ordered
+** by each query; the ranks whose values have been found are remembered
+** in fixed[], which makes later queries faster.
+*/
+typedef struct {
+  const void *data;    /* data pointer, type, and number of values of the
+                          nrrd summarized, for noticing (in
+                          nrrdRangeSummarySet) that it has been summarized
+                          already.  If the values change in place, use
+                          nrrdRangeSummaryReset */
+  int type;
+  size_t num,
+    stride;            /* every stride-th value was sampled */
+  double min, max;     /* extremal existent values (among all values,
+                          not just those sampled) */
+  int hasNonExist;     /* from the nrrdHasNonExist* enum values */
+  double *val;         /* the valNum existent sampled values */
+  size_t valNum,
+    *fixed;            /* sorted list of fixedNum ranks at which val[]
+                          has the value it would have if sorted */
+  unsigned int fixedNum;
+  airArray *fixedArr;
+  double rankError;    /* if stride > 1: bound (as fraction in [0,1]) on
+                          the error in the rank of percentiles found, with
+                          99.9% confidence, if the sampled values are
+                          representative of the rest; otherwise 0 */
+} NrrdRangeSummary;
+
 /*
 ******** NrrdKernel struct
 **
@@ -627,6 +691,15 @@ typedef struct {
                                 centering to use when resampling */
     nonExistent;             /* from nrrdResampleNonExistent enum */
   double padValue;           /* if padding, what value to pad with */
+  unsigned int threadNum;    /* number of threads to use for resampling the
+                                scanlines of each pass; the output is the
+                                same regardless of this */
+  size_t memBudget;          /* if non-zero: approximate limit (in bytes) on
+                                the memory for the intermediate results of
+                                resampling; the volume will be resampled
+                                in slabs along the slowest axis as needed
+                                to stay within it.  The output is the same
+                                regardless of this */
   /* ----------- input/internal ---------- */
   unsigned int dim,          /* dimension of nin (saved here to help
                                 manage state in NrrdResampleAxis[]) */
@@ -676,6 +749,33 @@ typedef struct {
   double padValue;             /* padding value, if needed */
 } NrrdBoundarySpec;
 
+/*
+******** NrrdStream struct
+**
+** For reading or writing the data of a nrrd in order, a piece at a
+** time, so that the whole array never has to be in memory at once
+** (as for "unu 2op -stream").  See streamNrrd.c for which formats
+** and encodings can really be streamed; the others are handled by
+** holding the whole array in nrrd->data.
+*/
+typedef struct {
+  Nrrd *nrrd;                  /* header of the array being read or
+                                  written; nrrd->data is NULL unless the
+                                  data couldn't be streamed */
+  NrrdIoState *nio;            /* I/O state; set any parameters for
+                                  writing (encoding, format, etc) in here
+                                  before nrrdStreamWriteOpen */
+  int writing;                 /* opened for writing, not reading */
+  size_t elementNum,           /* number of elements in the whole array */
+    elementDone;               /* number read or written so far */
+  /* --------- internal --------- */
+  int open;                    /* between *Open and nrrdStreamClose */
+  FILE *file;                  /* file the data is read from/written to */
+  char *filename;              /* where to save data held in nrrd->data */
+  void *stream;                /* private (de)compression state, or NULL
+                                  if data is held in nrrd->data */
+} NrrdStream;
+
 /* ---- END non-NrrdIO */
 
 /******** defaults (nrrdDefault..) and state (nrrdState..) */
@@ -695,6 +795,7 @@ NRRD_EXPORT int nrrdDefaultResampleCheap;
 NRRD_EXPORT double nrrdDefaultResamplePadValue;
 NRRD_EXPORT int nrrdDefaultResampleNonExistent;
 NRRD_EXPORT double nrrdDefaultKernelParm0;
+NRRD_EXPORT unsigned int nrrdDefaultThreadNum;
 /* ---- END non-NrrdIO */
 NRRD_EXPORT int nrrdDefaultCenter;
 NRRD_EXPORT double nrrdDefaultSpacing;
@@ -724,6 +825,7 @@ NRRD_EXPORT const char *const nrrdEnvVarDefaultWriteCharsPerLine;
 NRRD_EXPORT const char *const nrrdEnvVarDefaultWriteValsPerLine;
 NRRD_EXPORT const char *const nrrdEnvVarDefaultKernelParm0;
 NRRD_EXPORT const char *const nrrdEnvVarDefaultSpacing;
+NRRD_EXPORT const char *const nrrdEnvVarDefaultThreadNum;
 NRRD_EXPORT const char *const nrrdEnvVarStateKindNoop;
 NRRD_EXPORT const char *const nrrdEnvVarStateVerboseIO;
 NRRD_EXPORT const char *const nrrdEnvVarStateKeyValuePairsPropagate;
@@ -990,6 +1092,7 @@ NRRD_EXPORT const NrrdEncoding *const nrrdEncodingHex;
 NRRD_EXPORT const NrrdEncoding *const nrrdEncodingGzip;
 NRRD_EXPORT const NrrdEncoding *const nrrdEncodingBzip2;
 NRRD_EXPORT const NrrdEncoding *const nrrdEncodingZRL;
+NRRD_EXPORT const NrrdEncoding *const nrrdEncodingGzipBlocked;
 /* encoding.c */
 NRRD_EXPORT const NrrdEncoding *const nrrdEncodingUnknown;
 NRRD_EXPORT const NrrdEncoding *
@@ -1013,6 +1116,9 @@ NRRD_EXPORT int nrrdSpaceVectorParse(double dir[NRRD_SPACE_DIM_MAX],
 NRRD_EXPORT size_t (*const nrrdStringValsParse[NRRD_TYPE_MAX+1])
                     (void *out, const char *s, const char *sep, size_t n);
 
+/* mmapNrrd.c */
+NRRD_EXPORT int nrrdDataMapped(const void *data);
+
 /* read.c */
 NRRD_EXPORT int _nrrdOneLine(unsigned int *lenP, NrrdIoState *nio, FILE *file);
 NRRD_EXPORT int nrrdLineSkip(FILE *dataFile, NrrdIoState *nio);
@@ -1044,6 +1150,22 @@ NRRD_EXPORT int nrrdWrite(FILE *file, const Nrrd *nrrd,
 NRRD_EXPORT int nrrdStringWrite(char **stringP, const Nrrd *nrrd,
                                 NrrdIoState *nio);
 
+/* ---- BEGIN non-NrrdIO */
+/* streamNrrd.c */
+NRRD_EXPORT NrrdStream *nrrdStreamNew(void);
+NRRD_EXPORT NrrdStream *nrrdStreamNix(NrrdStream *nst);
+NRRD_EXPORT int nrrdStreamReadOpen(NrrdStream *nst, const char *filename);
+NRRD_EXPORT int nrrdStreamRead(NrrdStream *nst, void *data, size_t num);
+NRRD_EXPORT int nrrdStreamSlabRead(NrrdStream *nst, Nrrd *nslab,
+                                   size_t maxBytes);
+NRRD_EXPORT int nrrdStreamWriteOpen(NrrdStream *nst, const char *filename,
+                                    const Nrrd *nhdr);
+NRRD_EXPORT int nrrdStreamWrite(NrrdStream *nst, const void *data,
+                                size_t num);
+NRRD_EXPORT int nrrdStreamSlabWrite(NrrdStream *nst, const Nrrd *nslab);
+NRRD_EXPORT int nrrdStreamClose(NrrdStream *nst);
+/* ---- END non-NrrdIO */
+
 /******** getting value into and out of an array of general type, and
    all other simplistic functionality pseudo-parameterized by type */
 /* accessors.c */
@@ -1127,6 +1249,7 @@ NRRD_EXPORT hestCB *nrrdHestNrrd;
 NRRD_EXPORT hestCB *nrrdHestKernelSpec;
 NRRD_EXPORT hestCB *nrrdHestBoundarySpec;
 NRRD_EXPORT hestCB *nrrdHestIter;
+NRRD_EXPORT int nrrdHestIterNumber(double *valP, const char *str);
 
 /******** nrrd value iterator gadget */
 /* iter.c */
@@ -1159,6 +1282,20 @@ NRRD_EXPORT int nrrdRangePercentileFromStringSet(NrrdRange *range,
 NRRD_EXPORT void nrrdRangeSafeSet(NrrdRange *range,
                                   const Nrrd *nrrd, int blind8BitRange);
 NRRD_EXPORT NrrdRange *nrrdRangeNewSet(const Nrrd *nrrd, int blind8BitRange);
+NRRD_EXPORT NrrdRangeSummary *nrrdRangeSummaryNew(void);
+NRRD_EXPORT NrrdRangeSummary *nrrdRangeSummaryNix(NrrdRangeSummary *summ);
+NRRD_EXPORT void nrrdRangeSummaryReset(NrrdRangeSummary *summ);
+NRRD_EXPORT int nrrdRangeSummarySet(NrrdRangeSummary *summ, const Nrrd *nrrd,
+                                    size_t sampleMax);
+NRRD_EXPORT int nrrdRangeSummaryPercentile(double *val,
+                                           NrrdRangeSummary *summ,
+                                           const double *perc,
+                                           unsigned int percNum);
+NRRD_EXPORT int nrrdRangePercentileSummarySet(NrrdRange *range,
+                                              NrrdRangeSummary *summ,
+                                              const Nrrd *nrrd,
+                                              double minPerc, double maxPerc,
+                                              int blind8BitRange);
 NRRD_EXPORT int nrrdHasNonExist(const Nrrd *nrrd);
 
 /******** some of the point-wise value remapping, conversion, and such */
@@ -1457,6 +1594,10 @@ NRRD_EXPORT int nrrdResampleRoundSet(NrrdResampleContext *rsmc,
                                      int round);
 NRRD_EXPORT int nrrdResampleClampSet(NrrdResampleContext *rsmc,
                                      int clamp);
+NRRD_EXPORT int nrrdResampleThreadNumSet(NrrdResampleContext *rsmc,
+                                         unsigned int threadNum);
+NRRD_EXPORT int nrrdResampleMemoryBudgetSet(NrrdResampleContext *rsmc,
+                                            size_t memBudget);
 NRRD_EXPORT int nrrdResampleExecute(NrrdResampleContext *rsmc, Nrrd *nout);
 
 /* resampleNrrd.c */
@@ -100,6 +100,12 @@ extern "C" {
                                          being unknown is not an error */
 #define NRRD_NONE "none"              /* like NRRD_UNKNOWN, but with an air
                                          of certainty */
+/* ---- BEGIN non-NrrdIO */
+#define NRRD_ZLIB_BLOCK_SIZE_DEFAULT (1 << 20) /* bytes of raw data per
+                                                 block in the gzip-blocked
+                                                 encoding */
+#define NRRD_ZLIB_BLOCK_SIZE_MAX (1 << 30)
+/* ---- END non-NrrdIO */
 
 #ifdef __cplusplus
 }
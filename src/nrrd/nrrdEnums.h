@@ -147,9 +147,10 @@ enum {
   nrrdEncodingTypeGzip,     /* 4: gzip'ed raw data */
   nrrdEncodingTypeBzip2,    /* 5: bzip2'ed raw data */
   nrrdEncodingTypeZRL,      /* 6: zero run-length compresion */
+  nrrdEncodingTypeGzipBlocked, /* 7: gzip'ed independent blocks of raw */
   nrrdEncodingTypeLast
 };
-#define NRRD_ENCODING_TYPE_MAX 6
+#define NRRD_ENCODING_TYPE_MAX 7
 
 /*
 ******** nrrdZlibStrategy enum
@@ -104,6 +104,9 @@ extern const NrrdFormat _nrrdFormatText;
 extern const NrrdFormat _nrrdFormatEPS;
 extern int _nrrdHeaderCheck(Nrrd *nrrd, NrrdIoState *nio, int checkSeen);
 extern int _nrrdFormatNRRD_whichVersion(const Nrrd *nrrd, NrrdIoState *nio);
+extern void nrrdIoStateDataFileIterBegin(NrrdIoState *nio);
+extern int nrrdIoStateDataFileIterNext(FILE **fileP, NrrdIoState *nio,
+                                       int reading);
 
 /* encodingXXX.c */
 extern const NrrdEncoding _nrrdEncodingRaw;
@@ -112,8 +115,42 @@ extern const NrrdEncoding _nrrdEncodingHex;
 extern const NrrdEncoding _nrrdEncodingGzip;
 extern const NrrdEncoding _nrrdEncodingBzip2;
 extern const NrrdEncoding _nrrdEncodingZRL;
+extern const NrrdEncoding _nrrdEncodingGzipBlocked;
+
+/* mmapNrrd.c */
+extern void *_nrrdDataFree(void *data);
+extern int _nrrdDataMapTry(Nrrd *nrrd, FILE *file);
+
+/* streamNrrd.c */
+typedef struct {
+  FILE *file;
+  const NrrdEncoding *encoding;
+  void *state;          /* gzFile, BZFILE *, or blocked gzip reader */
+  char *buff;           /* buffer for skipping by reading */
+} _nrrdStream;
+extern int _nrrdStreamCan(const NrrdEncoding *encoding);
+extern int _nrrdStreamOpen(_nrrdStream *st, FILE *file,
+                           const NrrdEncoding *encoding);
+extern int _nrrdStreamRead(_nrrdStream *st, void *data, size_t num);
+extern int _nrrdStreamSkip(_nrrdStream *st, size_t num);
+extern void _nrrdStreamClose(_nrrdStream *st);
+extern int _nrrdStreamWriteOpen(_nrrdStream *st, FILE *file,
+                                const NrrdIoState *nio);
+extern int _nrrdStreamWrite(_nrrdStream *st, const void *data, size_t num);
+extern int _nrrdStreamWriteClose(_nrrdStream *st);
+
+/* encodingGzip.c */
+extern void _nrrdGzWriteMode(char fmt[4], const NrrdIoState *nio);
+
+/* endianNrrd.c */
+extern void (*_nrrdSwapEndian[])(void *data, size_t num);
+
+/* subset.c */
+extern int _nrrdCropPeripheral(Nrrd *nout, const Nrrd *nin,
+                               const size_t *min, const size_t *max);
 
 /* read.c */
+extern int _nrrdReadCropAfter(Nrrd *nrrd, NrrdIoState *nio);
 extern int _nrrdByteSkipSkip(FILE *dataFile, Nrrd *nrrd, NrrdIoState *nio,
                              long int byteSkip);
 extern int _nrrdCalloc(Nrrd *nrrd, NrrdIoState *nio, FILE *file);
@@ -168,6 +205,9 @@ extern int _nrrdReshapeUpGrayscale(Nrrd *nimg);
 extern void _nrrdSplitName(char **dirP, char **baseP, const char *name);
 
 /* write.c */
+extern int _nrrdEncodingMaybeSet(NrrdIoState *nio);
+extern int _nrrdFormatMaybeGuess(const Nrrd *nrrd, NrrdIoState *nio,
+                                 const char *filename);
 extern int _nrrdFieldInteresting(const Nrrd *nrrd, NrrdIoState *nio,
                                  int field);
 extern void _nrrdSprintFieldInfo(char **strP, const char *prefix,
@@ -203,6 +243,11 @@ extern int _nrrdGzRead(gzFile file, void* buf, unsigned int len,
                        unsigned int* read);
 extern int _nrrdGzWrite(gzFile file, const void* buf, unsigned int len,
                         unsigned int* written);
+
+/* encodingGzipBlocked.c */
+extern void *_nrrdGzbReaderNew(FILE *file);
+extern void *_nrrdGzbReaderNix(void *rd);
+extern int _nrrdGzbReaderRead(void *rd, void *data, size_t num);
 #endif
 
 /* ---- BEGIN non-NrrdIO */
@@ -210,6 +255,22 @@ extern int _nrrdGzWrite(gzFile file, const void* buf, unsigned int len,
 extern double _nrrdApplyDomainMin(const Nrrd *nmap, int ramps, int mapAxis);
 extern double _nrrdApplyDomainMax(const Nrrd *nmap, int ramps, int mapAxis);
 
+/* threadNrrd.c */
+extern unsigned int _nrrdThreadNum(size_t workNum, size_t NN, size_t grain);
+extern int _nrrdThreadRun(void *(*worker)(void *), void *task,
+                          size_t taskSize, unsigned int num);
+
+/* cc.c */
+extern int _nrrdCCSizeCount(Nrrd *nout, const Nrrd *nin);
+
+/* reorder.c */
+extern int _nrrdPermuteRun(char *dataOut, const char *dataIn, size_t unitSize,
+                           unsigned int dim, const size_t *szIn,
+                           const size_t *szOut, const unsigned int *axes);
+extern int _nrrdShuffleRun(char *dataOut, const char *dataIn,
+                           size_t unitSize, unsigned int dim,
+                           const size_t *size, const size_t *perm);
+
 /* superset.c */
 extern size_t _nrrdMirror_64(size_t N, ptrdiff_t I);
 extern unsigned int _nrrdMirror_32(unsigned int N, int I);
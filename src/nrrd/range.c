@@ -65,13 +65,38 @@ nrrdRangeReset(NrrdRange *range) {
   }
 }
 
+/*
+** if blind8BitRange says to know the range of 8-bit types blindly, and
+** type is 8-bit, sets the range to that of the type, and returns
+** non-zero
+*/
+static int
+_nrrdRangeBlindSet(NrrdRange *range, int type, int blind8BitRange) {
+  int blind;
+
+  blind = (nrrdBlind8BitRangeTrue == blind8BitRange
+           || (nrrdBlind8BitRangeState == blind8BitRange
+               && nrrdStateBlind8BitRange));
+  if (blind && 1 == nrrdTypeSize[type]) {
+    if (nrrdTypeChar == type) {
+      range->min = SCHAR_MIN;
+      range->max = SCHAR_MAX;
+    } else {
+      range->min = 0;
+      range->max = UCHAR_MAX;
+    }
+    range->hasNonExist = nrrdHasNonExistFalse;
+    return 1;
+  }
+  return 0;
+}
+
 /*
 ** not using biff (obviously)
 */
 void
 nrrdRangeSet(NrrdRange *range, const Nrrd *nrrd, int blind8BitRange) {
   NRRD_TYPE_BIGGEST _min, _max;
-  int blind;
 
   if (!range) {
     return;
@@ -79,19 +104,7 @@ nrrdRangeSet(NrrdRange *range, const Nrrd *nrrd, int blind8BitRange) {
   if (nrrd
       && !airEnumValCheck(nrrdType, nrrd->type)
       && nrrdTypeBlock != nrrd->type) {
-    blind = (nrrdBlind8BitRangeTrue == blind8BitRange
-             || (nrrdBlind8BitRangeState == blind8BitRange
-                 && nrrdStateBlind8BitRange));
-    if (blind && 1 == nrrdTypeSize[nrrd->type]) {
-      if (nrrdTypeChar == nrrd->type) {
-        range->min = SCHAR_MIN;
-        range->max = SCHAR_MAX;
-      } else {
-        range->min = 0;
-        range->max = UCHAR_MAX;
-      }
-      range->hasNonExist = nrrdHasNonExistFalse;
-    } else {
+    if (!_nrrdRangeBlindSet(range, nrrd->type, blind8BitRange)) {
       nrrdMinMaxExactFind[nrrd->type](&_min, &_max, &(range->hasNonExist),
                                       nrrd);
       range->min = nrrdDLoad[nrrd->type](&_min);
@@ -104,6 +117,321 @@ nrrdRangeSet(NrrdRange *range, const Nrrd *nrrd, int blind8BitRange) {
   return;
 }
 
+/*
+******** nrrdRangeSummaryNew, nrrdRangeSummaryNix, nrrdRangeSummaryReset
+**
+** NrrdRangeSummary is described in nrrd.h
+*/
+NrrdRangeSummary *
+nrrdRangeSummaryNew(void) {
+  NrrdRangeSummary *summ;
+
+  summ = AIR_CALLOC(1, NrrdRangeSummary);
+  if (summ) {
+    summ->val = NULL;
+    summ->fixed = NULL;
+    summ->fixedArr = airArrayNew(AIR_CAST(void **, &(summ->fixed)),
+                                 &(summ->fixedNum), sizeof(size_t), 32);
+    if (!summ->fixedArr) {
+      airFree(summ);
+      return NULL;
+    }
+    nrrdRangeSummaryReset(summ);
+  }
+  return summ;
+}
+
+NrrdRangeSummary *
+nrrdRangeSummaryNix(NrrdRangeSummary *summ) {
+
+  if (summ) {
+    airFree(summ->val);
+    airArrayNuke(summ->fixedArr);
+    airFree(summ);
+  }
+  return NULL;
+}
+
+/*
+** forgets everything about the last nrrd summarized; call this if the
+** values in that nrrd have changed in place
+*/
+void
+nrrdRangeSummaryReset(NrrdRangeSummary *summ) {
+
+  if (summ) {
+    summ->data = NULL;
+    summ->type = nrrdTypeUnknown;
+    summ->num = 0;
+    summ->stride = 0;
+    summ->min = summ->max = AIR_NAN;
+    summ->hasNonExist = nrrdHasNonExistUnknown;
+    summ->val = AIR_CAST(double *, airFree(summ->val));
+    summ->valNum = 0;
+    summ->rankError = AIR_NAN;
+    airArrayLenSet(summ->fixedArr, 0);
+  }
+  return;
+}
+
+/*
+******** nrrdRangeSummarySet
+**
+** summarizes the values in nrrd: the min and max are found exactly,
+** and the existent values among every stride-th value (with stride
+** chosen so that at most sampleMax values are sampled, or 1 if
+** sampleMax is 0) are copied for later percentile queries.  Does
+** nothing if summ already summarizes the same nrrd data the same way.
+*/
+int
+nrrdRangeSummarySet(NrrdRangeSummary *summ, const Nrrd *nrrd,
+                    size_t sampleMax) {
+  static const char me[]="nrrdRangeSummarySet";
+  NRRD_TYPE_BIGGEST _min, _max;
+  double val, (*lup)(const void *, size_t);
+  size_t num, stride, II, vi;
+
+  if (!(summ && nrrd)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (airEnumValCheck(nrrdType, nrrd->type)
+      || nrrdTypeBlock == nrrd->type) {
+    biffAddf(NRRD, "%s: can't summarize values of type %s", me,
+             airEnumStr(nrrdType, nrrd->type));
+    return 1;
+  }
+  num = nrrdElementNumber(nrrd);
+  stride = sampleMax ? AIR_MAX(1, (num + sampleMax - 1)/sampleMax) : 1;
+  if (summ->data == nrrd->data
+      && summ->type == nrrd->type
+      && summ->num == num
+      && summ->stride == stride) {
+    /* already have it */
+    return 0;
+  }
+  nrrdRangeSummaryReset(summ);
+  summ->val = AIR_CALLOC((num + stride - 1)/stride, double);
+  if (!summ->val) {
+    char stmp[AIR_STRLEN_SMALL];
+    biffAddf(NRRD, "%s: couldn't allocate %s samples", me,
+             airSprintSize_t(stmp, (num + stride - 1)/stride));
+    return 1;
+  }
+  nrrdMinMaxExactFind[nrrd->type](&_min, &_max, &(summ->hasNonExist),
+                                  nrrd);
+  summ->min = nrrdDLoad[nrrd->type](&_min);
+  summ->max = nrrdDLoad[nrrd->type](&_max);
+  lup = nrrdDLookup[nrrd->type];
+  vi = 0;
+  for (II=0; II<num; II+=stride) {
+    val = lup(nrrd->data, II);
+    if (AIR_EXISTS(val)) {
+      summ->val[vi++] = val;
+    }
+  }
+  summ->valNum = vi;
+  /* Dvoretzky-Kiefer-Wolfowitz inequality, with 99.9% confidence */
+  summ->rankError = (stride > 1 && vi
+                     ? sqrt(log(2/0.001)/(2.0*AIR_CAST(double, vi)))
+                     : 0.0);
+  summ->data = nrrd->data;
+  summ->type = nrrd->type;
+  summ->num = num;
+  summ->stride = stride;
+  return 0;
+}
+
+/*
+** partitions val[lo..hi] (inclusive) so that val[kk] is the value that
+** would be there if val[lo..hi] were sorted, with smaller values before
+** and larger values after.  This is quickselect with median-of-three
+** pivots, but if that is taking too long (too many bad pivots), the
+** remaining interval is sorted instead.
+*/
+static void
+_nrrdRangeSelect(double *val, size_t lo, size_t hi, size_t kk) {
+  size_t ii, jj, mid;
+  unsigned int tries;
+  double piv, tmp;
+
+#define SWAP(A, B) tmp = val[A]; val[A] = val[B]; val[B] = tmp
+  for (ii=hi-lo+1, tries=4; ii; ii/=2) {
+    tries += 2;
+  }
+  while (lo < hi) {
+    if (!tries--) {
+      qsort(val + lo, hi - lo + 1, sizeof(double),
+            nrrdValCompare[nrrdTypeDouble]);
+      break;
+    }
+    mid = lo + (hi - lo)/2;
+    if (val[mid] < val[lo]) { SWAP(mid, lo); }
+    if (val[hi] < val[lo]) { SWAP(hi, lo); }
+    if (val[hi] < val[mid]) { SWAP(hi, mid); }
+    piv = val[mid];
+    /* Hoare partition of [lo,hi] around piv */
+    ii = lo;
+    jj = hi;
+    while (ii <= jj) {
+      while (val[ii] < piv) {
+        ii++;
+      }
+      while (piv < val[jj]) {
+        jj--;
+      }
+      if (ii <= jj) {
+        SWAP(ii, jj);
+        ii++;
+        if (!jj) {
+          break;
+        }
+        jj--;
+      }
+    }
+    /* now val[lo..jj] <= piv <= val[ii..hi], and anything between is
+       equal to piv */
+    if (kk <= jj) {
+      hi = jj;
+    } else if (kk >= ii) {
+      lo = ii;
+    } else {
+      break;
+    }
+  }
+#undef SWAP
+  return;
+}
+
+/* finds the kk-th smallest sampled value, using and updating fixed[] */
+static double
+_nrrdRangeSummaryRank(NrrdRangeSummary *summ, size_t kk) {
+  size_t lo, hi, fi, ii;
+
+  /* fixed[] is sorted list of ranks already selected, so that values
+     between successive fixed ranks are bounded by the values there */
+  for (fi=0; fi<summ->fixedNum && summ->fixed[fi] < kk; fi++)
+    ;
+  if (fi < summ->fixedNum && summ->fixed[fi] == kk) {
+    return summ->val[kk];
+  }
+  lo = fi ? summ->fixed[fi-1] + 1 : 0;
+  hi = fi < summ->fixedNum ? summ->fixed[fi] - 1 : summ->valNum - 1;
+  _nrrdRangeSelect(summ->val, lo, hi, kk);
+  airArrayLenIncr(summ->fixedArr, 1);
+  for (ii=summ->fixedNum-1; ii>fi; ii--) {
+    summ->fixed[ii] = summ->fixed[ii-1];
+  }
+  summ->fixed[fi] = kk;
+  return summ->val[kk];
+}
+
+/*
+******** nrrdRangeSummaryPercentile
+**
+** finds percNum percentiles (each in [0,100]) of the summarized values:
+** the perc-th percentile of N values is found at rank perc*(N-1)/100 in
+** their sorted order, with linear interpolation between the values at
+** neighboring ranks (so the 50th percentile is the median).  The
+** percentiles are found by selection, not sorting; the partial ordering
+** created by selection is remembered in summ, which makes later queries
+** faster.
+*/
+int
+nrrdRangeSummaryPercentile(double *val, NrrdRangeSummary *summ,
+                           const double *perc, unsigned int percNum) {
+  static const char me[]="nrrdRangeSummaryPercentile";
+  unsigned int pi;
+  double rank, frac, vlo, vhi;
+  size_t klo;
+
+  if (!(val && summ && perc)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!summ->valNum) {
+    biffAddf(NRRD, "%s: have no existent values to find percentiles of",
+             me);
+    return 1;
+  }
+  for (pi=0; pi<percNum; pi++) {
+    if (!( AIR_EXISTS(perc[pi]) && AIR_IN_CL(0, perc[pi], 100) )) {
+      biffAddf(NRRD, "%s: percentile[%u] %g not in [0,100]", me, pi,
+               perc[pi]);
+      return 1;
+    }
+  }
+  for (pi=0; pi<percNum; pi++) {
+    rank = perc[pi]*AIR_CAST(double, summ->valNum - 1)/100;
+    klo = AIR_CAST(size_t, rank);
+    klo = AIR_MIN(klo, summ->valNum - 1);
+    frac = rank - AIR_CAST(double, klo);
+    vlo = _nrrdRangeSummaryRank(summ, klo);
+    if (frac > 0 && klo + 1 < summ->valNum) {
+      vhi = _nrrdRangeSummaryRank(summ, klo + 1);
+      val[pi] = AIR_LERP(frac, vlo, vhi);
+    } else {
+      val[pi] = vlo;
+    }
+  }
+  return 0;
+}
+
+/*
+******** nrrdRangePercentileSummarySet
+**
+** like nrrdRangePercentileSet, but the percentiles are found by
+** selection, using summ, which is (re-)set to summarize all of nrrd's
+** values if it isn't already summarizing nrrd (perhaps by sampling).
+** Non-existent values are ignored.
+*/
+int
+nrrdRangePercentileSummarySet(NrrdRange *range, NrrdRangeSummary *summ,
+                              const Nrrd *nrrd, double minPerc,
+                              double maxPerc, int blind8BitRange) {
+  static const char me[]="nrrdRangePercentileSummarySet";
+  double perc[2], pval[2], allmin, allmax;
+
+  if (!(range && summ && nrrd)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!minPerc && !maxPerc) {
+    /* wanted full range; no need to summarize */
+    nrrdRangeSet(range, nrrd, blind8BitRange);
+    return 0;
+  }
+  if (!( summ->data == nrrd->data
+         && summ->type == nrrd->type
+         && summ->num == nrrdElementNumber(nrrd) )) {
+    if (nrrdRangeSummarySet(summ, nrrd, 0)) {
+      biffAddf(NRRD, "%s: trouble summarizing values", me);
+      return 1;
+    }
+  }
+  if (!_nrrdRangeBlindSet(range, nrrd->type, blind8BitRange)) {
+    range->min = summ->min;
+    range->max = summ->max;
+    range->hasNonExist = summ->hasNonExist;
+  }
+  allmin = range->min;
+  allmax = range->max;
+  perc[0] = AIR_ABS(minPerc);
+  perc[1] = 100 - AIR_ABS(maxPerc);
+  if (nrrdRangeSummaryPercentile(pval, summ, perc, 2)) {
+    biffAddf(NRRD, "%s: trouble finding %g and %g percentiles", me,
+             perc[0], perc[1]);
+    return 1;
+  }
+  if (minPerc) {
+    range->min = minPerc > 0 ? pval[0] : 2*allmin - pval[0];
+  }
+  if (maxPerc) {
+    range->max = maxPerc > 0 ? pval[1] : 2*allmax - pval[1];
+  }
+  return 0;
+}
+
 /*
 ******** nrrdRangePercentileSet
 **
@@ -111,6 +439,9 @@ nrrdRangeSet(NrrdRange *range, const Nrrd *nrrd, int blind8BitRange) {
 ** nrrd is requested; and the learned information is put into "range"
 ** (overwriting whatever is there!)
 **
+** The percentiles are found from a histogram with hbins bins, or if
+** hbins is 0, exactly, by selection (with nrrdRangePercentileSummarySet).
+**
 ** uses biff
 */
 int
@@ -127,6 +458,23 @@ nrrdRangePercentileSet(NrrdRange *range, const Nrrd *nrrd,
     biffAddf(NRRD, "%s: got NULL pointer", me);
     return 0;
   }
+  if (!hbins) {
+    NrrdRangeSummary *summ;
+    mop = airMopNew();
+    summ = nrrdRangeSummaryNew();
+    airMopAdd(mop, summ, (airMopper)nrrdRangeSummaryNix, airMopAlways);
+    if (!summ) {
+      biffAddf(NRRD, "%s: couldn't allocate summary", me);
+      airMopError(mop); return 1;
+    }
+    if (nrrdRangePercentileSummarySet(range, summ, nrrd, minPerc, maxPerc,
+                                      blind8BitRange)) {
+      biffAddf(NRRD, "%s: trouble finding percentiles", me);
+      airMopError(mop); return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
   nrrdRangeSet(range, nrrd, blind8BitRange);
   /* range->min and range->max
      are the full range of nrrd (except maybe for blind8) */
@@ -134,11 +482,6 @@ nrrdRangePercentileSet(NrrdRange *range, const Nrrd *nrrd,
     /* wanted full range; there is nothing more to do */
     return 0;
   }
-  if (!hbins) {
-    biffAddf(NRRD, "%s: sorry, non-histogram-based percentiles not "
-             "currently implemented (need hbins > 0)", me);
-    return 1;
-  }
   if (!(hbins >= 5)) {
     biffAddf(NRRD, "%s: # histogram bins %u unreasonably small", me, hbins);
     return 1;
@@ -203,7 +203,7 @@ _nrrdCalloc(Nrrd *nrrd, NrrdIoState *nio, FILE *file) {
     /* its not an error to have a directIO-incompatible pointer, so
        there's no other error checking to do here */
   } else {
-    nrrd->data = airFree(nrrd->data);
+    nrrd->data = _nrrdDataFree(nrrd->data);
     fd = file ? fileno(file) : -1;
     if (nrrdEncodingRaw == nio->encoding
         && -1 != fd
@@ -467,10 +467,17 @@ _nrrdRead(Nrrd *nrrd, FILE *file, const char *string, NrrdIoState *_nio) {
     }
   }
 
+  /* the NRRD format does its own cropping */
+  if (nio->readCrop && !nio->skipData && nrrdFormatNRRD != nio->format
+      && _nrrdReadCropAfter(nrrd, nio)) {
+    biffAddf(NRRD, "%s: trouble cropping", me);
+    airMopError(mop); return 1;
+  }
+
   /* free prior memory if we didn't end up using it */
   /* HEY: could actually do a check on the nio to refine this */
   if (nio->oldData != nrrd->data) {
-    nio->oldData = airFree(nio->oldData);
+    nio->oldData = _nrrdDataFree(nio->oldData);
     nio->oldDataSize = 0;
   }
 
@@ -486,6 +493,30 @@ _nrrdRead(Nrrd *nrrd, FILE *file, const char *string, NrrdIoState *_nio) {
   return 0;
 }
 
+/*
+** _nrrdReadCropAfter
+**
+** for when nio->readCrop is set but the whole array had to be read:
+** replaces it with the requested crop
+*/
+int
+_nrrdReadCropAfter(Nrrd *nrrd, NrrdIoState *nio) {
+  static const char me[]="_nrrdReadCropAfter";
+  Nrrd *ncrop;
+  airArray *mop;
+
+  mop = airMopNew();
+  ncrop = nrrdNew();
+  airMopAdd(mop, ncrop, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdCrop(ncrop, nrrd, nio->readCropMin, nio->readCropMax)
+      || nrrdCopy(nrrd, ncrop)) {
+    biffAddf(NRRD, "%s: trouble cropping", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 /*
 ******** nrrdRead()
 **
@@ -98,6 +98,8 @@ nrrdResampleContextInit(NrrdResampleContext *rsmc) {
     rsmc->defaultCenter = nrrdDefaultCenter;
     rsmc->nonExistent = nrrdDefaultResampleNonExistent;
     rsmc->padValue = nrrdDefaultResamplePadValue;
+    rsmc->threadNum = AIR_MAX(1, nrrdDefaultThreadNum);
+    rsmc->memBudget = 0;
     rsmc->dim = 0;
     rsmc->passNum = AIR_CAST(unsigned int, -1); /* 4294967295 */
     rsmc->topRax = AIR_CAST(unsigned int, -1);
@@ -540,6 +542,49 @@ nrrdResampleRoundSet(NrrdResampleContext *rsmc,
   return 0;
 }
 
+int
+nrrdResampleThreadNumSet(NrrdResampleContext *rsmc,
+                         unsigned int threadNum) {
+  static const char me[]="nrrdResampleThreadNumSet";
+
+  if (!rsmc) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(NRRD, "%s: need threadNum >= 1", me);
+    return 1;
+  }
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
+
+  /* no flag needs setting: the number of threads doesn't change
+     the output, only how fast we get it */
+  rsmc->threadNum = threadNum;
+
+  return 0;
+}
+
+int
+nrrdResampleMemoryBudgetSet(NrrdResampleContext *rsmc,
+                            size_t memBudget) {
+  static const char me[]="nrrdResampleMemoryBudgetSet";
+
+  if (!rsmc) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+
+  /* as with threadNum, no flag: this changes how the output is
+     computed, not what it is */
+  rsmc->memBudget = memBudget;
+
+  return 0;
+}
+
 int
 nrrdResampleClampSet(NrrdResampleContext *rsmc,
                      int clamp) {
@@ -1150,6 +1195,230 @@ _nrrdResampleTrivial(NrrdResampleContext *rsmc, Nrrd *nout,
   return 0;
 }
 
+/*
+** state shared (read-only) by all the workers resampling the scanlines
+** of a single pass; the only thing a worker owns is its scanline buffer
+*/
+typedef struct {
+  const NrrdResampleContext *rsmc;
+  const NrrdResampleAxis *axisIn, *axisOut;
+  int typeIn,                /* type of nin */
+    last,                    /* this is the last pass */
+    doRound;
+  size_t strideIn, strideOut;
+  const void *dataIn;        /* input to first pass */
+  const nrrdResample_t *rsmpIn;
+  void *dataOut;             /* output of last pass */
+  nrrdResample_t *rsmpOut;
+  const int *indx;
+  const nrrdResample_t *weight;
+  nrrdResample_t (*lup)(const void *, size_t);
+  nrrdResample_t (*clamp)(nrrdResample_t);
+  nrrdResample_t (*ins)(void *, size_t, nrrdResample_t);
+} _nrrdResamplePass;
+
+typedef struct {
+  airThread *thread;
+  const _nrrdResamplePass *pass;
+  nrrdResample_t *line;      /* this worker's scanline buffer */
+  size_t lineStart, lineStop;
+} _nrrdResampleTask;
+
+/*
+** Helper macros for _nrrdResampleLines.  RSMP_GATHER copies a scanline
+** of the input to the first pass into the scanline buffer, without
+** going through the nrrdResample_t lookup function for the more common
+** types; RSMP_DOT_LOOP does the convolution (without regard for value
+** existance) for all the output samples in the scanline, with DOT being
+** the code to sum the dotLen weighted values into "val"
+*/
+#define RSMP_GATHER(TT)                                                 \
+  {                                                                     \
+    const TT *_in;                                                      \
+    size_t _stride;                                                     \
+    _in = AIR_CAST(const TT *, pass->dataIn) + indexIn;                 \
+    _stride = pass->strideIn;                                           \
+    for (smpIdx=0; smpIdx<axisIn->sizeIn; smpIdx++) {                   \
+      line[smpIdx] = AIR_CAST(nrrdResample_t, _in[smpIdx*_stride]);     \
+    }                                                                   \
+  }
+
+#define RSMP_GATHER_RSMP                                                \
+  {                                                                     \
+    const nrrdResample_t *_in;                                          \
+    _in = pass->rsmpIn + indexIn;                                       \
+    for (smpIdx=0; smpIdx<axisIn->sizeIn; smpIdx++) {                   \
+      line[smpIdx] = _in[smpIdx*pass->strideIn];                        \
+    }                                                                   \
+  }
+
+#define RSMP_SAVE                                                       \
+  if (!pass->last) {                                                    \
+    pass->rsmpOut[smpIdx*pass->strideOut + indexOut]                    \
+      = AIR_CAST(nrrdResample_t, val);                                  \
+  } else {                                                              \
+    if (pass->doRound) {                                                \
+      val = AIR_CAST(nrrdResample_t, AIR_ROUNDUP(val));                 \
+    }                                                                   \
+    if (rsmc->clamp) {                                                  \
+      val = pass->clamp(AIR_CAST(nrrdResample_t, val));                 \
+    }                                                                   \
+    pass->ins(pass->dataOut, smpIdx*pass->strideOut + indexOut,         \
+              AIR_CAST(nrrdResample_t, val));                           \
+  }
+
+#define RSMP_TERM(II) val += line[indx[II]]*weight[II]
+#define RSMP_DOT2 RSMP_TERM(0); RSMP_TERM(1)
+#define RSMP_DOT4 RSMP_DOT2; RSMP_TERM(2); RSMP_TERM(3)
+#define RSMP_DOT6 RSMP_DOT4; RSMP_TERM(4); RSMP_TERM(5)
+#define RSMP_DOT8 RSMP_DOT6; RSMP_TERM(6); RSMP_TERM(7)
+
+#define RSMP_DOT_LOOP(DOT)                                              \
+  for (smpIdx=0; smpIdx<axisIn->samples; smpIdx++) {                    \
+    const int *indx;                                                    \
+    const nrrdResample_t *weight;                                       \
+    double val;                                                         \
+    indx = pass->indx + dotLen*smpIdx;                                  \
+    weight = pass->weight + dotLen*smpIdx;                              \
+    val = 0.0;                                                          \
+    DOT;                                                                \
+    RSMP_SAVE;                                                          \
+  }
+
+/*
+** resamples scanlines [lineStart, lineStop) of one pass, using the
+** given scanline buffer (which must have sizeIn+1 values, the last
+** one being the pad value)
+*/
+static void
+_nrrdResampleLines(const _nrrdResamplePass *pass, nrrdResample_t *line,
+                   size_t lineStart, size_t lineStop) {
+  const NrrdResampleContext *rsmc;
+  const NrrdResampleAxis *axisIn, *axisOut;
+  unsigned int axIdx;
+  size_t lineIdx, rem, coordIn[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX];
+
+  rsmc = pass->rsmc;
+  axisIn = pass->axisIn;
+  axisOut = pass->axisOut;
+
+  /* find the input and output coordinates of the first scanline;
+     lines are ordered by all input axes other than topRax, with
+     lower axes faster, as in the coordinate incrementing below */
+  rem = lineStart;
+  for (axIdx=0; axIdx<rsmc->dim; axIdx++) {
+    if (axIdx == rsmc->topRax) {
+      coordIn[axIdx] = 0;
+    } else {
+      coordIn[axIdx] = rem % axisIn->sizePerm[axIdx];
+      rem /= axisIn->sizePerm[axIdx];
+    }
+    coordOut[rsmc->permute[axIdx]] = coordIn[axIdx];
+  }
+
+  /* the skinny */
+  for (lineIdx=lineStart; lineIdx<lineStop; lineIdx++) {
+    size_t smpIdx, dotIdx, dotLen, indexIn, indexOut;
+
+    /* calculate the (linear) indices of the beginnings of
+       the input and output scanlines */
+    NRRD_INDEX_GEN(indexIn, coordIn, axisIn->sizePerm, rsmc->dim);
+    NRRD_INDEX_GEN(indexOut, coordOut, axisOut->sizePerm, rsmc->dim);
+
+    /* read input scanline into scanline buffer */
+    if (pass->dataIn) {
+      switch (pass->typeIn) {
+      case nrrdTypeUChar:  RSMP_GATHER(unsigned char);  break;
+      case nrrdTypeShort:  RSMP_GATHER(signed short);   break;
+      case nrrdTypeUShort: RSMP_GATHER(unsigned short); break;
+      case nrrdTypeFloat:  RSMP_GATHER(float);          break;
+      case nrrdTypeDouble: RSMP_GATHER(double);         break;
+      default:
+        for (smpIdx=0; smpIdx<axisIn->sizeIn; smpIdx++) {
+          line[smpIdx] = pass->lup(pass->dataIn,
+                                   smpIdx*pass->strideIn + indexIn);
+        }
+        break;
+      }
+    } else {
+      RSMP_GATHER_RSMP;
+    }
+    /* do the bloody convolution and save the output value */
+    dotLen = axisIn->nweight->axis[0].size;
+    if (nrrdResampleNonExistentNoop != rsmc->nonExistent) {
+      for (smpIdx=0; smpIdx<axisIn->samples; smpIdx++) {
+        const int *indx;
+        const nrrdResample_t *weight;
+        double val, wsum;
+        indx = pass->indx + dotLen*smpIdx;
+        weight = pass->weight + dotLen*smpIdx;
+        val = wsum = 0.0;
+        for (dotIdx=0; dotIdx<dotLen; dotIdx++) {
+          double tmpV, tmpW;
+          tmpV = line[indx[dotIdx]];
+          if (AIR_EXISTS(tmpV)) {
+            tmpW = weight[dotIdx];
+            val += tmpV*tmpW;
+            wsum += tmpW;
+          }
+        }
+        if (wsum) {
+          if (nrrdResampleNonExistentRenormalize == rsmc->nonExistent) {
+            val /= wsum;
+          }
+          /* else nrrdResampleNonExistentWeight: leave as is */
+        } else {
+          val = AIR_NAN;
+        }
+        RSMP_SAVE;
+      }
+    } else {
+      /* nrrdResampleNonExistentNoop: do convolution sum w/out worries
+         about value existance.  The common short kernel supports get
+         their own fully unrolled loops; the terms are summed in the same
+         order as the general loop, so the results are the same */
+      switch (dotLen) {
+      case 2: RSMP_DOT_LOOP(RSMP_DOT2); break;
+      case 4: RSMP_DOT_LOOP(RSMP_DOT4); break;
+      case 6: RSMP_DOT_LOOP(RSMP_DOT6); break;
+      case 8: RSMP_DOT_LOOP(RSMP_DOT8); break;
+      default:
+        RSMP_DOT_LOOP(for (dotIdx=0; dotIdx<dotLen; dotIdx++) {
+            val += line[indx[dotIdx]]*weight[dotIdx];
+          });
+        break;
+      }
+    }
+
+    /* as long as there's another line to be processed, increment the
+       coordinates for the scanline starts.  We don't use the usual
+       NRRD_COORD macros because we're subject to the unusual constraint
+       that coordIn[topRax] and coordOut[permute[topRax]] must stay == 0 */
+    if (lineIdx < lineStop-1) {
+      axIdx = rsmc->topRax ? 0 : 1;
+      coordIn[axIdx]++;
+      coordOut[rsmc->permute[axIdx]]++;
+      while (coordIn[axIdx] == axisIn->sizePerm[axIdx]) {
+        coordIn[axIdx] = coordOut[rsmc->permute[axIdx]] = 0;
+        axIdx++;
+        axIdx += axIdx == rsmc->topRax;
+        coordIn[axIdx]++;
+        coordOut[rsmc->permute[axIdx]]++;
+      }
+    }
+  }
+  return;
+}
+
+static void *
+_nrrdResampleWorker(void *_task) {
+  _nrrdResampleTask *task;
+
+  task = AIR_CAST(_nrrdResampleTask *, _task);
+  _nrrdResampleLines(task->pass, task->line, task->lineStart, task->lineStop);
+  return _task;
+}
+
 int
 _nrrdResampleCore(NrrdResampleContext *rsmc, Nrrd *nout,
                   int typeOut, int doRound,
@@ -1157,13 +1426,10 @@ _nrrdResampleCore(NrrdResampleContext *rsmc, Nrrd *nout,
                   nrrdResample_t (*clamp)(nrrdResample_t),
                   nrrdResample_t (*ins)(void *, size_t, nrrdResample_t)) {
   static const char me[]="_nrrdResampleCore";
-  unsigned int axIdx, passIdx;
-  size_t strideIn, strideOut, lineNum, lineIdx,
-    coordIn[NRRD_DIM_MAX], coordOut[NRRD_DIM_MAX];
-  nrrdResample_t *line, *weight, *rsmpIn, *rsmpOut;
-  int *indx;
-  const void *dataIn;
-  void *dataOut;
+  unsigned int axIdx, passIdx, threadNum, tidx;
+  size_t strideIn, strideOut, lineNum, lineMax, sizeInMax;
+  _nrrdResamplePass pass;
+  _nrrdResampleTask *task;
   NrrdResampleAxis *axisIn, *axisOut;
   airArray *mop;
 
@@ -1184,7 +1450,62 @@ _nrrdResampleCore(NrrdResampleContext *rsmc, Nrrd *nout,
   }
 
   mop = airMopNew();
+
+  /* set up the workers; worker 0 uses the per-axis scanline buffers,
+     the others get their own buffer, long enough for any pass.  There
+     is no point in having more workers than scanlines in the biggest
+     pass */
+  threadNum = AIR_MAX(1, rsmc->threadNum);
+  lineMax = 0;
+  sizeInMax = 0;
   for (passIdx=0; passIdx<rsmc->passNum; passIdx++) {
+    axisIn = rsmc->axis + rsmc->passAxis[passIdx];
+    lineNum = 1;
+    for (axIdx=0; axIdx<rsmc->dim; axIdx++) {
+      if (axIdx != rsmc->topRax) {
+        lineNum *= axisIn->sizePerm[axIdx];
+      }
+    }
+    lineMax = AIR_MAX(lineMax, lineNum);
+    sizeInMax = AIR_MAX(sizeInMax, axisIn->sizeIn);
+  }
+  threadNum = AIR_CAST(unsigned int, AIR_MIN(threadNum, lineMax));
+  task = AIR_CALLOC(threadNum, _nrrdResampleTask);
+  if (!task) {
+    biffAddf(NRRD, "%s: couldn't allocate %u tasks", me, threadNum);
+    airMopError(mop); return 1;
+  }
+  airMopAdd(mop, task, airFree, airMopAlways);
+  for (tidx=0; tidx<threadNum; tidx++) {
+    task[tidx].pass = &pass;
+    if (threadNum > 1) {
+      task[tidx].thread = airThreadNew();
+      airMopAdd(mop, task[tidx].thread, (airMopper)airThreadNix,
+                airMopAlways);
+    }
+    if (tidx) {
+      task[tidx].line = AIR_CALLOC(sizeInMax+1, nrrdResample_t);
+      if (!task[tidx].line) {
+        biffAddf(NRRD, "%s: couldn't allocate scanline buffer for worker %u",
+                 me, tidx);
+        airMopError(mop); return 1;
+      }
+      airMopAdd(mop, task[tidx].line, airFree, airMopAlways);
+    }
+  }
+  if (rsmc->verbose && threadNum > 1) {
+    fprintf(stderr, "%s: using %u threads\n", me, threadNum);
+  }
+
+  pass.rsmc = rsmc;
+  pass.typeIn = rsmc->nin->type;
+  pass.doRound = doRound;
+  pass.strideIn = strideIn;
+  pass.lup = lup;
+  pass.clamp = clamp;
+  pass.ins = ins;
+  for (passIdx=0; passIdx<rsmc->passNum; passIdx++) {
+    unsigned int workNum;
     if (rsmc->verbose) {
       fprintf(stderr, "%s: -------------- pass %u/%u \n",
               me, passIdx, rsmc->passNum);
@@ -1242,131 +1563,425 @@ _nrrdResampleCore(NrrdResampleContext *rsmc, Nrrd *nout,
     }
 
     /* set up data pointers */
+    pass.axisIn = axisIn;
+    pass.axisOut = axisOut;
+    pass.last = (passIdx == rsmc->passNum-1);
+    pass.strideOut = strideOut;
     if (0 == passIdx) {
-      rsmpIn = NULL;
-      dataIn = rsmc->nin->data;
+      pass.rsmpIn = NULL;
+      pass.dataIn = rsmc->nin->data;
     } else {
-      rsmpIn = (nrrdResample_t *)(axisIn->nrsmp->data);
-      dataIn = NULL;
+      pass.rsmpIn = (nrrdResample_t *)(axisIn->nrsmp->data);
+      pass.dataIn = NULL;
     }
-    if (passIdx < rsmc->passNum-1) {
-      rsmpOut = (nrrdResample_t *)(axisOut->nrsmp->data);
-      dataOut = NULL;
+    if (!pass.last) {
+      pass.rsmpOut = (nrrdResample_t *)(axisOut->nrsmp->data);
+      pass.dataOut = NULL;
     } else {
-      rsmpOut = NULL;
-      dataOut = nout->data;
+      pass.rsmpOut = NULL;
+      pass.dataOut = nout->data;
     }
-
-    line = (nrrdResample_t *)(axisIn->nline->data);
-    indx = (int *)(axisIn->nindex->data);
-    weight = (nrrdResample_t *)(axisIn->nweight->data);
+    pass.indx = (const int *)(axisIn->nindex->data);
+    pass.weight = (const nrrdResample_t *)(axisIn->nweight->data);
+    task[0].line = (nrrdResample_t *)(axisIn->nline->data);
     if (rsmc->verbose) {
       fprintf(stderr, "%s: {rsmp,data}In = %p/%p; {rsmp,data}Out = %p/%p\n",
-              me, (void*)rsmpIn, (void*)dataIn,
-              (void*)rsmpOut, (void*)dataOut);
+              me, AIR_CVOIDP(pass.rsmpIn), pass.dataIn,
+              AIR_VOIDP(pass.rsmpOut), pass.dataOut);
       fprintf(stderr, "%s: line = %p; indx = %p; weight = %p\n",
-              me, (void*)line, (void*)indx, (void*)weight);
+              me, AIR_VOIDP(task[0].line), AIR_CVOIDP(pass.indx),
+              AIR_CVOIDP(pass.weight));
+    }
+
+    /* divvy up the scanlines into contiguous runs, one per worker.
+       Every output value is computed from exactly one scanline, by
+       the same arithmetic, so the result doesn't depend on threadNum */
+    workNum = AIR_CAST(unsigned int, AIR_MIN(threadNum, lineNum));
+    for (tidx=0; tidx<workNum; tidx++) {
+      task[tidx].lineStart = lineNum*tidx/workNum;
+      task[tidx].lineStop = lineNum*(tidx+1)/workNum;
+      if (tidx) {
+        task[tidx].line[axisIn->sizeIn] = task[0].line[axisIn->sizeIn];
+      }
+    }
+    if (1 == workNum) {
+      _nrrdResampleLines(&pass, task[0].line, 0, lineNum);
+    } else {
+      int ret;
+      void *retP;
+      for (tidx=0; tidx<workNum; tidx++) {
+        if ((ret = airThreadStart(task[tidx].thread, _nrrdResampleWorker,
+                                  AIR_VOIDP(task + tidx)))) {
+          biffAddf(NRRD, "%s: pass %u thread %u failed to start: %d",
+                   me, passIdx, tidx, ret);
+          airMopError(mop); return 1;
+        }
+      }
+      for (tidx=0; tidx<workNum; tidx++) {
+        if ((ret = airThreadJoin(task[tidx].thread, &retP))) {
+          biffAddf(NRRD, "%s: pass %u thread %u failed to join: %d",
+                   me, passIdx, tidx, ret);
+          airMopError(mop); return 1;
+        }
+      }
+    }
+
+    /* (maybe) free input to this pass, now that we're done with it */
+    if (axisIn->nrsmp) {
+      if (rsmc->verbose) {
+        fprintf(stderr, "%s: nrrdNuke(%p) pass %u input (on axis %u)\n",
+                me, AIR_CAST(void*, axisIn->nrsmp), axisIn->passIdx,
+                axisIn->axIdx);
+      }
+      axisIn->nrsmp = nrrdNuke(axisIn->nrsmp);
+      /* airMopSub(mop, axisIn->nrsmp, (airMopper)nrrdNuke); */
     }
+  } /* for passIdx */
 
-    /* the skinny */
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** _nrrdResampleTileRowsFind
+**
+** For tiled resampling (see _nrrdResampleTiled): returns how many output
+** samples along the slowest axis should be computed at once, so that
+** the intermediate resampling results stay (approximately) within
+** rsmc->memBudget bytes.  Returns 0 when tiling isn't needed, either
+** because there is no budget, or because the intermediate results for
+** the whole volume already fit within it.
+*/
+static size_t
+_nrrdResampleTileRowsFind(const NrrdResampleContext *rsmc) {
+  static const char me[]="_nrrdResampleTileRowsFind";
+  const NrrdResampleAxis *axisOut, *axisSlow;
+  unsigned int passIdx, axIdx;
+  size_t elemNum, lastNum, pairMax, sizeIn, sizeOut, planeIn, planeOut,
+    perRow, rows, rowsIn, bytes;
+
+  if (!rsmc->memBudget || rsmc->passNum < 2) {
+    /* either no budget, or no intermediate results */
+    return 0;
+  }
+  /* find the largest intermediate results (input and output of one
+     pass) that are alive at the same time */
+  pairMax = lastNum = 0;
+  for (passIdx=0; passIdx<rsmc->passNum-1; passIdx++) {
+    axisOut = rsmc->axis + rsmc->passAxis[passIdx+1];
+    elemNum = 1;
     for (axIdx=0; axIdx<rsmc->dim; axIdx++) {
-      coordIn[axIdx] = 0;
-      coordOut[axIdx] = 0;
+      elemNum *= axisOut->sizePerm[axIdx];
+    }
+    pairMax = AIR_MAX(pairMax, lastNum + elemNum);
+    lastNum = elemNum;
+  }
+  if (pairMax*sizeof(nrrdResample_t) <= rsmc->memBudget) {
+    return 0;
+  }
+
+  /* in all the passes generating the intermediate results, the slowest
+     axis is not (yet) resampled, so the memory needed per input slice
+     along the slowest axis is the same for every tile */
+  axisSlow = rsmc->axis + rsmc->dim-1;
+  sizeIn = axisSlow->sizeIn;
+  sizeOut = axisSlow->kernel ? axisSlow->samples : sizeIn;
+  planeIn = nrrdElementNumber(rsmc->nin)/sizeIn;
+  planeOut = 1;
+  for (axIdx=0; axIdx<rsmc->dim-1; axIdx++) {
+    planeOut *= (rsmc->axis[axIdx].kernel
+                 ? rsmc->axis[axIdx].samples
+                 : rsmc->axis[axIdx].sizeIn);
+  }
+  perRow = pairMax/sizeIn*sizeof(nrrdResample_t);
+  if (axisSlow->kernel) {
+    /* the input slices are copied into their own nrrd */
+    perRow += planeIn*nrrdElementSize(rsmc->nin);
+  }
+  rows = sizeOut;
+  do {
+    if (axisSlow->kernel) {
+      rowsIn = (rows*sizeIn + sizeOut - 1)/sizeOut
+        + axisSlow->nweight->axis[0].size;
+      rowsIn = AIR_MIN(rowsIn, sizeIn);
+      /* plus the per-sample accumulators for the last pass */
+      bytes = rowsIn*perRow + 2*planeOut*sizeof(double);
+    } else {
+      bytes = rows*perRow;
+    }
+    if (bytes <= rsmc->memBudget || 1 == rows) {
+      break;
     }
-    for (lineIdx=0; lineIdx<lineNum; lineIdx++) {
-      size_t smpIdx, dotIdx, dotLen, indexIn, indexOut;
+    rows = (rows + 1)/2;
+  } while (1);
+  if (rsmc->verbose) {
+    char stmp1[AIR_STRLEN_SMALL], stmp2[AIR_STRLEN_SMALL];
+    fprintf(stderr, "%s: %s output samples per tile (~%s bytes)\n", me,
+            airSprintSize_t(stmp1, rows), airSprintSize_t(stmp2, bytes));
+  }
+  return rows;
+}
 
-      /* calculate the (linear) indices of the beginnings of
-         the input and output scanlines */
-      NRRD_INDEX_GEN(indexIn, coordIn, axisIn->sizePerm, rsmc->dim);
-      NRRD_INDEX_GEN(indexOut, coordOut, axisOut->sizePerm, rsmc->dim);
+/*
+** _nrrdResampleTiled
+**
+** resamples the volume in tiles (slabs) along the slowest axis, so that
+** the intermediate results never have to be allocated for the whole
+** volume.  Resampling along all the other axes doesn't mix values from
+** different slices along the slowest axis, so each tile is resampled
+** along those axes with a second (sub) resampling context.  If the
+** slowest axis is itself resampled, which happens last in the
+** non-tiled passes anyway, that is done here, from the index and weight
+** vectors already set up in rsmc.  The result is the same as from
+** _nrrdResampleCore.
+*/
+static int
+_nrrdResampleTiled(NrrdResampleContext *rsmc, Nrrd *nout,
+                   int typeOut, int doRound, size_t tileRows,
+                   nrrdResample_t (*clamp)(nrrdResample_t),
+                   nrrdResample_t (*ins)(void *, size_t, nrrdResample_t)) {
+  static const char me[]="_nrrdResampleTiled";
+  NrrdResampleContext *sub;
+  NrrdResampleAxis *axisSlow;
+  Nrrd *nslab, *npart, *nwrapIn, *nwrapOut;
+  unsigned int axIdx, slax;
+  size_t sizeIn, sizeOut, planeIn, planeOut, rowIdx, rowLo, rowHi, uniqNum,
+    size[NRRD_DIM_MAX], dotLen, dotIdx, ii, *uniq;
+  int *rowMap, E;
+  const int *indx;
+  const nrrdResample_t *weight;
+  double *accum, *wsum;
+  nrrdResample_t pad;
+  airArray *mop;
 
-      /* read input scanline into scanline buffer */
-      if (0 == passIdx) {
-        for (smpIdx=0; smpIdx<axisIn->sizeIn; smpIdx++) {
-          line[smpIdx] = lup(dataIn, smpIdx*strideIn + indexIn);
+  mop = airMopNew();
+  slax = rsmc->dim-1;
+  axisSlow = rsmc->axis + slax;
+  sizeIn = axisSlow->sizeIn;
+  sizeOut = axisSlow->kernel ? axisSlow->samples : sizeIn;
+  planeIn = nrrdElementNumber(rsmc->nin)/sizeIn;
+  for (axIdx=0; axIdx<rsmc->dim; axIdx++) {
+    size[axIdx] = (rsmc->axis[axIdx].kernel
+                   ? rsmc->axis[axIdx].samples
+                   : rsmc->axis[axIdx].sizeIn);
+  }
+  planeOut = 1;
+  for (axIdx=0; axIdx<slax; axIdx++) {
+    planeOut *= size[axIdx];
+  }
+  if (nrrdMaybeAlloc_nva(nout, typeOut, rsmc->dim, size)) {
+    biffAddf(NRRD, "%s: trouble allocating final output", me);
+    airMopError(mop); return 1;
+  }
+
+  /* set up the context for resampling all but the slowest axis */
+  sub = nrrdResampleContextNew();
+  airMopAdd(mop, sub, (airMopper)nrrdResampleContextNix, airMopAlways);
+  sub->verbose = rsmc->verbose > 1 ? rsmc->verbose - 1 : 0;
+  nslab = nrrdNew();
+  airMopAdd(mop, nslab, (airMopper)nrrdNuke, airMopAlways);
+  npart = nrrdNew();
+  airMopAdd(mop, npart, (airMopper)nrrdNuke, airMopAlways);
+  nwrapIn = nrrdNew();
+  airMopAdd(mop, nwrapIn, (airMopper)nrrdNix, airMopAlways);
+  nwrapOut = nrrdNew();
+  airMopAdd(mop, nwrapOut, (airMopper)nrrdNix, airMopAlways);
+  uniq = AIR_CALLOC(sizeIn, size_t);
+  airMopAdd(mop, uniq, airFree, airMopAlways);
+  rowMap = AIR_CALLOC(sizeIn+1, int);
+  airMopAdd(mop, rowMap, airFree, airMopAlways);
+  accum = AIR_CALLOC(2*planeOut, double);
+  airMopAdd(mop, accum, airFree, airMopAlways);
+  if (!( sub && nslab && npart && nwrapIn && nwrapOut && uniq && rowMap && accum )) {
+    biffAddf(NRRD, "%s: couldn't allocate tiling buffers", me);
+    airMopError(mop); return 1;
+  }
+  wsum = accum + planeOut;
+  pad = AIR_CAST(nrrdResample_t, rsmc->padValue);
+  dotLen = axisSlow->kernel ? axisSlow->nweight->axis[0].size : 0;
+
+  for (rowLo=0; rowLo<sizeOut; rowLo += tileRows) {
+    const Nrrd *nsubin;
+    Nrrd *nsubout;
+    size_t slabSize[NRRD_DIM_MAX];
+
+    rowHi = AIR_MIN(rowLo + tileRows, sizeOut);
+    /* find (in increasing order) the input slices needed for this tile */
+    if (axisSlow->kernel) {
+      indx = (const int *)(axisSlow->nindex->data);
+      for (ii=0; ii<=sizeIn; ii++) {
+        rowMap[ii] = -1;
+      }
+      for (ii=rowLo*dotLen; ii<rowHi*dotLen; ii++) {
+        /* the index sizeIn means padding */
+        if (AIR_CAST(size_t, indx[ii]) < sizeIn) {
+          rowMap[indx[ii]] = 0;
         }
-      } else {
-        for (smpIdx=0; smpIdx<axisIn->sizeIn; smpIdx++) {
-          line[smpIdx] = rsmpIn[smpIdx*strideIn + indexIn];
+      }
+      uniqNum = 0;
+      for (ii=0; ii<sizeIn; ii++) {
+        if (!rowMap[ii]) {
+          rowMap[ii] = AIR_CAST(int, uniqNum);
+          uniq[uniqNum++] = ii;
         }
       }
-      /* do the bloody convolution and save the output value */
-      dotLen = axisIn->nweight->axis[0].size;
-      for (smpIdx=0; smpIdx<axisIn->samples; smpIdx++) {
-        double val;
-        val = 0.0;
+    } else {
+      uniqNum = rowHi - rowLo;
+      for (ii=0; ii<uniqNum; ii++) {
+        uniq[ii] = rowLo + ii;
+      }
+    }
+    if (!uniqNum) {
+      /* every needed value is padding; make a token slice so that the
+         sub-resampling has something to chew on */
+      uniq[uniqNum++] = 0;
+    }
+    for (axIdx=0; axIdx<slax; axIdx++) {
+      slabSize[axIdx] = rsmc->axis[axIdx].sizeIn;
+    }
+    slabSize[slax] = uniqNum;
+    if (uniq[uniqNum-1] - uniq[0] + 1 == uniqNum) {
+      /* the slices are contiguous; the slab is in nin already */
+      if (nrrdWrap_nva(nwrapIn, (AIR_CAST(char *, rsmc->nin->data)
+                                 + (uniq[0]*planeIn
+                                    *nrrdElementSize(rsmc->nin))),
+                       rsmc->nin->type, rsmc->dim, slabSize)) {
+        biffAddf(NRRD, "%s: trouble wrapping input slab", me);
+        airMopError(mop); return 1;
+      }
+      nsubin = nwrapIn;
+    } else {
+      size_t planeBytes;
+      if (nrrdMaybeAlloc_nva(nslab, rsmc->nin->type, rsmc->dim, slabSize)) {
+        biffAddf(NRRD, "%s: trouble allocating input slab", me);
+        airMopError(mop); return 1;
+      }
+      planeBytes = planeIn*nrrdElementSize(rsmc->nin);
+      for (ii=0; ii<uniqNum; ii++) {
+        memcpy(AIR_CAST(char *, nslab->data) + ii*planeBytes,
+               AIR_CAST(const char *, rsmc->nin->data) + uniq[ii]*planeBytes,
+               planeBytes);
+      }
+      nsubin = nslab;
+    }
+
+    E = AIR_FALSE;
+    if (!E) E |= nrrdResampleDefaultCenterSet(sub, rsmc->defaultCenter);
+    if (!E) E |= nrrdResampleInputSet(sub, nsubin);
+    for (axIdx=0; axIdx<slax; axIdx++) {
+      NrrdResampleAxis *axis;
+      axis = rsmc->axis + axIdx;
+      if (!E) E |= nrrdResampleKernelSet(sub, axIdx, axis->kernel,
+                                         axis->kparm);
+      if (axis->kernel) {
+        if (!E) E |= nrrdResampleOverrideCenterSet(sub, axIdx, axis->center);
+        if (!E) E |= nrrdResampleSamplesSet(sub, axIdx, axis->samples);
+        if (!E) E |= nrrdResampleRangeSet(sub, axIdx, axis->min, axis->max);
+      }
+    }
+    if (!E) E |= nrrdResampleKernelSet(sub, slax, NULL, NULL);
+    if (!E) E |= nrrdResampleBoundarySet(sub, rsmc->boundary);
+    if (!E) E |= nrrdResamplePadValueSet(sub, rsmc->padValue);
+    if (!E) E |= nrrdResampleRenormalizeSet(sub, rsmc->renormalize);
+    if (!E) E |= nrrdResampleNonExistentSet(sub, rsmc->nonExistent);
+    if (!E) E |= nrrdResampleThreadNumSet(sub, rsmc->threadNum);
+    if (axisSlow->kernel) {
+      /* the slowest axis still to be resampled: keep full precision */
+      if (!E) E |= nrrdResampleTypeOutSet(sub, nrrdResample_nt);
+      if (!E) E |= nrrdResampleRoundSet(sub, AIR_FALSE);
+      if (!E) E |= nrrdResampleClampSet(sub, AIR_FALSE);
+      nsubout = npart;
+    } else {
+      /* have the sub-resampling write directly into this tile of nout */
+      if (!E) E |= nrrdResampleTypeOutSet(sub, typeOut);
+      if (!E) E |= nrrdResampleRoundSet(sub, rsmc->roundlast);
+      if (!E) E |= nrrdResampleClampSet(sub, rsmc->clamp);
+      for (axIdx=0; axIdx<slax; axIdx++) {
+        slabSize[axIdx] = size[axIdx];
+      }
+      slabSize[slax] = rowHi - rowLo;
+      if (!E) E |= nrrdWrap_nva(nwrapOut, (AIR_CAST(char *, nout->data)
+                                           + (rowLo*planeOut
+                                              *nrrdTypeSize[typeOut])),
+                                typeOut, rsmc->dim, slabSize);
+      nsubout = nwrapOut;
+    }
+    if (!E) E |= nrrdResampleExecute(sub, nsubout);
+    if (E) {
+      biffAddf(NRRD, "%s: trouble resampling tile [%u,%u)", me,
+               AIR_CAST(unsigned int, rowLo), AIR_CAST(unsigned int, rowHi));
+      airMopError(mop); return 1;
+    }
+    if (!axisSlow->kernel) {
+      /* nout tile already done */
+      continue;
+    }
+
+    /* now the last pass, along the slowest axis, in the same way as
+       _nrrdResampleLines, but with all the scanlines in the tile
+       updated together, instead of one at a time */
+    indx = (const int *)(axisSlow->nindex->data);
+    weight = (const nrrdResample_t *)(axisSlow->nweight->data);
+    for (rowIdx=rowLo; rowIdx<rowHi; rowIdx++) {
+      size_t indexOut;
+      for (ii=0; ii<planeOut; ii++) {
+        accum[ii] = wsum[ii] = 0.0;
+      }
+      for (dotIdx=0; dotIdx<dotLen; dotIdx++) {
+        const nrrdResample_t *part;
+        nrrdResample_t wght;
+        int idx;
+        idx = indx[dotIdx + dotLen*rowIdx];
+        wght = weight[dotIdx + dotLen*rowIdx];
+        part = (AIR_CAST(size_t, idx) < sizeIn
+                ? (AIR_CAST(const nrrdResample_t *, npart->data)
+                   + rowMap[idx]*planeOut)
+                : NULL);
         if (nrrdResampleNonExistentNoop != rsmc->nonExistent) {
-          double wsum;
-          wsum = 0.0;
-          for (dotIdx=0; dotIdx<dotLen; dotIdx++) {
+          for (ii=0; ii<planeOut; ii++) {
             double tmpV, tmpW;
-            tmpV = line[indx[dotIdx + dotLen*smpIdx]];
+            tmpV = part ? part[ii] : pad;
             if (AIR_EXISTS(tmpV)) {
-              tmpW = weight[dotIdx + dotLen*smpIdx];
-              val += tmpV*tmpW;
-              wsum += tmpW;
+              tmpW = wght;
+              accum[ii] += tmpV*tmpW;
+              wsum[ii] += tmpW;
             }
           }
-          if (wsum) {
+        } else {
+          if (part) {
+            for (ii=0; ii<planeOut; ii++) {
+              accum[ii] += part[ii]*wght;
+            }
+          } else {
+            for (ii=0; ii<planeOut; ii++) {
+              accum[ii] += pad*wght;
+            }
+          }
+        }
+      }
+      indexOut = rowIdx*planeOut;
+      for (ii=0; ii<planeOut; ii++) {
+        double val;
+        val = accum[ii];
+        if (nrrdResampleNonExistentNoop != rsmc->nonExistent) {
+          if (wsum[ii]) {
             if (nrrdResampleNonExistentRenormalize == rsmc->nonExistent) {
-              val /= wsum;
+              val /= wsum[ii];
             }
-            /* else nrrdResampleNonExistentWeight: leave as is */
           } else {
             val = AIR_NAN;
           }
-        } else {
-          /* nrrdResampleNonExistentNoop: do convolution sum
-             w/out worries about value existance */
-          for (dotIdx=0; dotIdx<dotLen; dotIdx++) {
-            val += (line[indx[dotIdx + dotLen*smpIdx]]
-                    * weight[dotIdx + dotLen*smpIdx]);
-          }
         }
-        if (passIdx < rsmc->passNum-1) {
-          rsmpOut[smpIdx*strideOut + indexOut] = val;
-        } else {
-          if (doRound) {
-            val = AIR_CAST(nrrdResample_t, AIR_ROUNDUP(val));
-          }
-          if (rsmc->clamp) {
-            val = clamp(val);
-          }
-          ins(dataOut, smpIdx*strideOut + indexOut, val);
+        if (doRound) {
+          val = AIR_CAST(nrrdResample_t, AIR_ROUNDUP(val));
         }
-      }
-
-      /* as long as there's another line to be processed, increment the
-         coordinates for the scanline starts.  We don't use the usual
-         NRRD_COORD macros because we're subject to the unusual constraint
-         that coordIn[topRax] and coordOut[permute[topRax]] must stay == 0 */
-      if (lineIdx < lineNum-1) {
-        axIdx = rsmc->topRax ? 0 : 1;
-        coordIn[axIdx]++;
-        coordOut[rsmc->permute[axIdx]]++;
-        while (coordIn[axIdx] == axisIn->sizePerm[axIdx]) {
-          coordIn[axIdx] = coordOut[rsmc->permute[axIdx]] = 0;
-          axIdx++;
-          axIdx += axIdx == rsmc->topRax;
-          coordIn[axIdx]++;
-          coordOut[rsmc->permute[axIdx]]++;
+        if (rsmc->clamp) {
+          val = clamp(AIR_CAST(nrrdResample_t, val));
         }
+        ins(nout->data, indexOut + ii, AIR_CAST(nrrdResample_t, val));
       }
     }
-
-    /* (maybe) free input to this pass, now that we're done with it */
-    if (axisIn->nrsmp) {
-      if (rsmc->verbose) {
-        fprintf(stderr, "%s: nrrdNuke(%p) pass %u input (on axis %u)\n",
-                me, AIR_CAST(void*, axisIn->nrsmp), axisIn->passIdx,
-                axisIn->axIdx);
-      }
-      axisIn->nrsmp = nrrdNuke(axisIn->nrsmp);
-      /* airMopSub(mop, axisIn->nrsmp, (airMopper)nrrdNuke); */
-    }
-  } /* for passIdx */
-
+  }
   airMopOkay(mop);
   return 0;
 }
@@ -1384,6 +1999,7 @@ _nrrdResampleOutputUpdate(NrrdResampleContext *rsmc, Nrrd *nout,
 #endif
   unsigned int axIdx;
   int typeOut, doRound;
+  size_t tileRows;
 
   if (rsmc->flag[flagClamp]
       || rsmc->flag[flagNonExistent]
@@ -1423,6 +2039,12 @@ _nrrdResampleOutputUpdate(NrrdResampleContext *rsmc, Nrrd *nout,
         biffAddf(NRRD, "%s: trouble", me);
         return 1;
       }
+    } else if ((tileRows = _nrrdResampleTileRowsFind(rsmc))) {
+      if (_nrrdResampleTiled(rsmc, nout, typeOut, doRound, tileRows,
+                             clamp, ins)) {
+        biffAddf(NRRD, "%s: trouble", me);
+        return 1;
+      }
     } else {
       if (_nrrdResampleCore(rsmc, nout, typeOut, doRound,
                             lup, clamp, ins)) {
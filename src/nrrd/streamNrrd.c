@@ -0,0 +1,853 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "nrrd.h"
+#include "privateNrrd.h"
+
+#if TEEM_BZIP2
+#include <bzlib.h>
+#endif
+
+/*
+** Sequential reading of the (decoded) data in a file, in arbitrary
+** pieces, with the possibility of skipping over parts of it.  Skipping
+** seeks when possible (raw encoding, whole blocks of gzip-blocked), and
+** otherwise decodes and discards.  This is how only part of the data
+** is read when nio->readCrop is set.  Sequential writing (raw, gzip,
+** and bzip2 only) is also here, and both are used for the NrrdStream
+** (at the bottom of this file), for processing arrays that don't fit
+** in memory.
+*/
+
+#define STREAM_CHUNK (1 << 20)
+
+/*
+** _nrrdStreamCan
+**
+** returns non-zero iff data in the given encoding can be streamed
+*/
+int
+_nrrdStreamCan(const NrrdEncoding *encoding) {
+
+  return ((nrrdEncodingRaw == encoding
+           || nrrdEncodingGzip == encoding
+           || nrrdEncodingBzip2 == encoding
+           || nrrdEncodingGzipBlocked == encoding)
+          && encoding->available());
+}
+
+int
+_nrrdStreamOpen(_nrrdStream *st, FILE *file, const NrrdEncoding *encoding) {
+  static const char me[]="_nrrdStreamOpen";
+
+  st->file = file;
+  st->encoding = encoding;
+  st->state = NULL;
+  st->buff = NULL;
+  if (!_nrrdStreamCan(encoding)) {
+    biffAddf(NRRD, "%s: can't stream %s encoding", me, encoding->name);
+    return 1;
+  }
+#if TEEM_ZLIB
+  if (nrrdEncodingGzip == encoding) {
+    if (!(st->state = _nrrdGzOpen(file, "rb"))) {
+      biffAddf(NRRD, "%s: error opening gzFile", me);
+      return 1;
+    }
+  } else if (nrrdEncodingGzipBlocked == encoding) {
+    if (!(st->state = _nrrdGzbReaderNew(file))) {
+      biffAddf(NRRD, "%s: error setting up blocked gzip reader", me);
+      return 1;
+    }
+  }
+#endif
+#if TEEM_BZIP2
+  if (nrrdEncodingBzip2 == encoding) {
+    int bzerror;
+    st->state = BZ2_bzReadOpen(&bzerror, file, 0, 0, NULL, 0);
+    if (BZ_OK != bzerror) {
+      biffAddf(NRRD, "%s: error opening BZFILE: %s", me,
+               BZ2_bzerror(st->state, &bzerror));
+      BZ2_bzReadClose(&bzerror, st->state);
+      st->state = NULL;
+      return 1;
+    }
+  }
+#endif
+  return 0;
+}
+
+/*
+** reads the next num bytes into data; or if data is NULL, skips them
+*/
+static int
+_nrrdStreamDo(_nrrdStream *st, void *_data, size_t num) {
+  static const char me[]="_nrrdStreamDo";
+  char *data, stmp[AIR_STRLEN_SMALL];
+  size_t got, chunk;
+
+#if TEEM_ZLIB
+  if (nrrdEncodingGzipBlocked == st->encoding) {
+    if (_nrrdGzbReaderRead(st->state, _data, num)) {
+      biffAddf(NRRD, "%s: trouble with %s bytes", me,
+               airSprintSize_t(stmp, num));
+      return 1;
+    }
+    return 0;
+  }
+#endif
+  if (!_data && nrrdEncodingRaw == st->encoding && num <= LONG_MAX
+      && !fseek(st->file, AIR_CAST(long int, num), SEEK_CUR)) {
+    return 0;
+  }
+  if (!_data && !st->buff) {
+    if (!(st->buff = AIR_CALLOC(STREAM_CHUNK, char))) {
+      biffAddf(NRRD, "%s: couldn't allocate skip buffer", me);
+      return 1;
+    }
+  }
+  data = AIR_CAST(char *, _data);
+  while (num) {
+    chunk = AIR_MIN(num, STREAM_CHUNK);
+    got = 0;
+    if (nrrdEncodingRaw == st->encoding) {
+      got = fread(data ? data : st->buff, 1, chunk, st->file);
+    }
+#if TEEM_ZLIB
+    if (nrrdEncodingGzip == st->encoding) {
+      unsigned int didread;
+      if (_nrrdGzRead(st->state, data ? data : st->buff,
+                      AIR_CAST(unsigned int, chunk), &didread)) {
+        biffAddf(NRRD, "%s: error reading from gzFile", me);
+        return 1;
+      }
+      got = didread;
+    }
+#endif
+#if TEEM_BZIP2
+    if (nrrdEncodingBzip2 == st->encoding) {
+      int bzerror, didread;
+      didread = BZ2_bzRead(&bzerror, st->state, data ? data : st->buff,
+                           AIR_CAST(int, chunk));
+      if (!( BZ_OK == bzerror || BZ_STREAM_END == bzerror )) {
+        biffAddf(NRRD, "%s: error reading from BZFILE: %s", me,
+                 BZ2_bzerror(st->state, &bzerror));
+        return 1;
+      }
+      got = AIR_CAST(size_t, AIR_MAX(0, didread));
+    }
+#endif
+    if (!got) {
+      biffAddf(NRRD, "%s: hit end of data with %s bytes to go", me,
+               airSprintSize_t(stmp, num));
+      return 1;
+    }
+    num -= got;
+    if (data) {
+      data += got;
+    }
+  }
+  return 0;
+}
+
+int
+_nrrdStreamRead(_nrrdStream *st, void *data, size_t num) {
+  static const char me[]="_nrrdStreamRead";
+
+  if (!data) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (_nrrdStreamDo(st, data, num)) {
+    biffAddf(NRRD, "%s: trouble reading", me);
+    return 1;
+  }
+  return 0;
+}
+
+int
+_nrrdStreamSkip(_nrrdStream *st, size_t num) {
+  static const char me[]="_nrrdStreamSkip";
+
+  if (_nrrdStreamDo(st, NULL, num)) {
+    biffAddf(NRRD, "%s: trouble skipping", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** frees everything set up by _nrrdStreamOpen, but (like the encodings)
+** does not close st->file
+*/
+void
+_nrrdStreamClose(_nrrdStream *st) {
+
+  if (st->state) {
+#if TEEM_ZLIB
+    if (nrrdEncodingGzip == st->encoding) {
+      _nrrdGzClose(st->state);
+    } else if (nrrdEncodingGzipBlocked == st->encoding) {
+      _nrrdGzbReaderNix(st->state);
+    }
+#endif
+#if TEEM_BZIP2
+    if (nrrdEncodingBzip2 == st->encoding) {
+      int bzerror;
+      BZ2_bzReadClose(&bzerror, st->state);
+    }
+#endif
+    st->state = NULL;
+  }
+  st->buff = airFree(st->buff);
+}
+
+/*
+** _nrrdStreamWriteOpen
+**
+** like _nrrdStreamOpen, but for writing data with nio->encoding, which
+** has to be raw, gzip, or bzip2
+*/
+int
+_nrrdStreamWriteOpen(_nrrdStream *st, FILE *file, const NrrdIoState *nio) {
+  static const char me[]="_nrrdStreamWriteOpen";
+
+  st->file = file;
+  st->encoding = nio->encoding;
+  st->state = NULL;
+  st->buff = NULL;
+  if (!((nrrdEncodingRaw == st->encoding
+         || nrrdEncodingGzip == st->encoding
+         || nrrdEncodingBzip2 == st->encoding)
+        && st->encoding->available())) {
+    biffAddf(NRRD, "%s: can't stream %s encoding", me, st->encoding->name);
+    return 1;
+  }
+#if TEEM_ZLIB
+  if (nrrdEncodingGzip == st->encoding) {
+    char fmt[4];
+    _nrrdGzWriteMode(fmt, nio);
+    if (!(st->state = _nrrdGzOpen(file, fmt))) {
+      biffAddf(NRRD, "%s: error opening gzFile", me);
+      return 1;
+    }
+  }
+#endif
+#if TEEM_BZIP2
+  if (nrrdEncodingBzip2 == st->encoding) {
+    int bs, bzerror;
+    bs = (1 <= nio->bzip2BlockSize && nio->bzip2BlockSize <= 9
+          ? nio->bzip2BlockSize
+          : 9);
+    st->state = BZ2_bzWriteOpen(&bzerror, file, bs, 0, 0);
+    if (BZ_OK != bzerror) {
+      biffAddf(NRRD, "%s: error opening BZFILE: %s", me,
+               BZ2_bzerror(st->state, &bzerror));
+      BZ2_bzWriteClose(&bzerror, st->state, 0, NULL, NULL);
+      st->state = NULL;
+      return 1;
+    }
+  }
+#endif
+  return 0;
+}
+
+int
+_nrrdStreamWrite(_nrrdStream *st, const void *_data, size_t num) {
+  static const char me[]="_nrrdStreamWrite";
+  char stmp[AIR_STRLEN_SMALL];
+  const char *data;
+  size_t chunk;
+
+  data = AIR_CAST(const char *, _data);
+  while (num) {
+    chunk = AIR_MIN(num, STREAM_CHUNK);
+    if (nrrdEncodingRaw == st->encoding) {
+      if (chunk != fwrite(data, 1, chunk, st->file)) {
+        biffAddf(NRRD, "%s: fwrite failed with %s bytes to go", me,
+                 airSprintSize_t(stmp, num));
+        return 1;
+      }
+    }
+#if TEEM_ZLIB
+    if (nrrdEncodingGzip == st->encoding) {
+      unsigned int wrote;
+      if (_nrrdGzWrite(st->state, data, AIR_CAST(unsigned int, chunk),
+                       &wrote)
+          || wrote != chunk) {
+        biffAddf(NRRD, "%s: error writing to gzFile", me);
+        return 1;
+      }
+    }
+#endif
+#if TEEM_BZIP2
+    if (nrrdEncodingBzip2 == st->encoding) {
+      int bzerror;
+      BZ2_bzWrite(&bzerror, st->state, AIR_CAST(void *, data),
+                  AIR_CAST(int, chunk));
+      if (BZ_OK != bzerror) {
+        biffAddf(NRRD, "%s: error writing to BZFILE: %s", me,
+                 BZ2_bzerror(st->state, &bzerror));
+        return 1;
+      }
+    }
+#endif
+    num -= chunk;
+    data += chunk;
+  }
+  return 0;
+}
+
+/*
+** finishes the compressed stream (if any); returns non-zero if that
+** failed.  Like _nrrdStreamClose, does not close st->file
+*/
+int
+_nrrdStreamWriteClose(_nrrdStream *st) {
+  static const char me[]="_nrrdStreamWriteClose";
+  int ret;
+
+  ret = 0;
+  if (st->state) {
+#if TEEM_ZLIB
+    if (nrrdEncodingGzip == st->encoding && _nrrdGzClose(st->state)) {
+      biffAddf(NRRD, "%s: error closing gzFile", me);
+      ret = 1;
+    }
+#endif
+#if TEEM_BZIP2
+    if (nrrdEncodingBzip2 == st->encoding) {
+      int bzerror;
+      BZ2_bzWriteClose(&bzerror, st->state, 0, NULL, NULL);
+      if (BZ_OK != bzerror) {
+        biffAddf(NRRD, "%s: error closing BZFILE", me);
+        ret = 1;
+      }
+    }
+#endif
+    st->state = NULL;
+  }
+  if (!ret && nrrdEncodingRaw == st->encoding && fflush(st->file)) {
+    biffAddf(NRRD, "%s: error flushing data", me);
+    ret = 1;
+  }
+  return ret;
+}
+
+/* ---------------------------------------------------------------- */
+
+NrrdStream *
+nrrdStreamNew(void) {
+  NrrdStream *nst;
+
+  nst = AIR_CALLOC(1, NrrdStream);
+  if (nst) {
+    nst->nrrd = nrrdNew();
+    nst->nio = nrrdIoStateNew();
+    nst->writing = AIR_FALSE;
+    nst->elementNum = nst->elementDone = 0;
+    nst->open = AIR_FALSE;
+    nst->file = NULL;
+    nst->filename = NULL;
+    nst->stream = NULL;
+  }
+  return nst;
+}
+
+/*
+** releases everything from the *Open functions, without finishing
+** anything that was being written
+*/
+static void
+_nrrdStreamRelease(NrrdStream *nst) {
+
+  if (nst->stream) {
+    if (nst->writing) {
+      /* whatever the compressor says now, the output is incomplete */
+      _nrrdStreamWriteClose(AIR_CAST(_nrrdStream *, nst->stream));
+    } else {
+      _nrrdStreamClose(AIR_CAST(_nrrdStream *, nst->stream));
+    }
+    nst->stream = airFree(nst->stream);
+  }
+  nst->file = airFclose(nst->file);
+  nst->filename = airFree(nst->filename);
+  nrrdEmpty(nst->nrrd);
+  nrrdIoStateInit(nst->nio);
+  nst->open = AIR_FALSE;
+  return;
+}
+
+NrrdStream *
+nrrdStreamNix(NrrdStream *nst) {
+
+  if (nst) {
+    _nrrdStreamRelease(nst);
+    nrrdNuke(nst->nrrd);
+    nrrdIoStateNix(nst->nio);
+    free(nst);
+  }
+  return NULL;
+}
+
+/*
+** sets nout to have the header of nin, except that the size of the
+** last (slowest) axis is sliceNum.  With alloc, allocates data for it
+** (re-using what's already there if possible), otherwise nout->data
+** is NULL.
+*/
+static int
+_nrrdStreamHeaderSet(Nrrd *nout, const Nrrd *nin, size_t sliceNum,
+                     int alloc) {
+  static const char me[]="_nrrdStreamHeaderSet";
+  size_t size[NRRD_DIM_MAX];
+
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, size);
+  size[nin->dim-1] = sliceNum;
+  if (alloc) {
+    if (nrrdMaybeAlloc_nva(nout, nin->type, nin->dim, size)) {
+      biffAddf(NRRD, "%s: couldn't allocate slab", me);
+      return 1;
+    }
+  } else {
+    nout->data = _nrrdDataFree(nout->data);
+    if (nrrdWrap_nva(nout, NULL, nin->type, nin->dim, size)) {
+      biffAddf(NRRD, "%s: couldn't set header", me);
+      return 1;
+    }
+  }
+  nrrdAxisInfoCopy(nout, nin, NULL, NRRD_AXIS_INFO_SIZE_BIT);
+  nrrdBasicInfoInit(nout, NRRD_BASIC_INFO_DATA_BIT);
+  if (nrrdBasicInfoCopy(nout, nin, NRRD_BASIC_INFO_DATA_BIT)) {
+    biffAddf(NRRD, "%s: trouble copying basic info", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** nrrdStreamReadOpen
+**
+** reads the header of the given file (or "-" for stdin) into nst->nrrd,
+** and gets ready to read the data with nrrdStreamRead or
+** nrrdStreamSlabRead.  The data is streamed (read only as it is asked
+** for) from NRRD files with a single data file in raw, gzip, bzip2, or
+** gzip-blocked encoding.  Otherwise, the data is read all at once into
+** nst->nrrd->data, which is possible for non-stdin input, or for NRRD
+** input from stdin with its data attached.
+**
+** As with nrrdLoad, returns 2 if the file couldn't be opened.
+*/
+int
+nrrdStreamReadOpen(NrrdStream *nst, const char *filename) {
+  static const char me[]="nrrdStreamReadOpen";
+  NrrdIoState *nio;
+  _nrrdStream *st;
+  int ret;
+
+  if (!(nst && filename)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (nst->open) {
+    biffAddf(NRRD, "%s: stream already open", me);
+    return 1;
+  }
+  nio = nst->nio;
+  nio->skipData = AIR_TRUE;
+  nio->keepNrrdDataFileOpen = AIR_TRUE;
+  ret = nrrdLoad(nst->nrrd, filename, nio);
+  nio->skipData = AIR_FALSE;
+  nio->keepNrrdDataFileOpen = AIR_FALSE;
+  if (ret) {
+    biffAddf(NRRD, "%s: trouble reading header of \"%s\"", me, filename);
+    return ret;
+  }
+  nst->writing = AIR_FALSE;
+  nst->open = AIR_TRUE;
+  nst->elementNum = nrrdElementNumber(nst->nrrd);
+  nst->elementDone = 0;
+  if (nrrdFormatNRRD == nio->format && nio->dataFile) {
+    /* the file is at the start of the data (after any line skip, and any
+       byte skip for non-compression encodings) */
+    nst->file = nio->dataFile;
+    nio->dataFile = NULL;
+    if (_nrrdStreamCan(nio->encoding)
+        && !(nio->encoding->isCompression && nio->byteSkip < 0)) {
+      if (!(st = AIR_CALLOC(1, _nrrdStream))) {
+        biffAddf(NRRD, "%s: couldn't allocate stream", me);
+        _nrrdStreamRelease(nst); return 1;
+      }
+      nst->stream = st;
+      if (_nrrdStreamOpen(st, nst->file, nio->encoding)) {
+        biffAddf(NRRD, "%s: couldn't start reading", me);
+        /* _nrrdStreamOpen cleaned up after itself */
+        nst->stream = airFree(nst->stream);
+        _nrrdStreamRelease(nst); return 1;
+      }
+      if (nio->encoding->isCompression && nio->byteSkip > 0
+          && _nrrdStreamSkip(st, AIR_CAST(size_t, nio->byteSkip))) {
+        biffAddf(NRRD, "%s: couldn't skip bytes", me);
+        _nrrdStreamRelease(nst); return 1;
+      }
+    } else {
+      /* read it all now, as _nrrdFormatNRRD_read would have */
+      if (_nrrdCalloc(nst->nrrd, nio, nst->file)
+          || nio->encoding->read(nst->file, nst->nrrd->data,
+                                 nst->elementNum, nst->nrrd, nio)) {
+        biffAddf(NRRD, "%s: trouble reading %s data", me,
+                 nio->encoding->name);
+        _nrrdStreamRelease(nst); return 1;
+      }
+      if (airEndianUnknown != nio->endian
+          && 1 < nrrdElementSize(nst->nrrd)
+          && nio->encoding->endianMatters
+          && nio->endian != airMyEndian()) {
+        nrrdSwapEndian(nst->nrrd);
+      }
+    }
+  } else if (strcmp("-", filename)) {
+    /* other formats, or multiple data files: read it all */
+    nrrdIoStateInit(nio);
+    if (nrrdLoad(nst->nrrd, filename, nio)) {
+      biffAddf(NRRD, "%s: trouble reading \"%s\"", me, filename);
+      _nrrdStreamRelease(nst); return 1;
+    }
+  } else {
+    biffAddf(NRRD, "%s: can't read %s from stdin after its header; "
+             "only NRRD with attached data can be", me,
+             (nrrdFormatNRRD == nio->format
+              ? "NRRD with detached data"
+              : nio->format->name));
+    _nrrdStreamRelease(nst); return 1;
+  }
+  return 0;
+}
+
+/*
+******** nrrdStreamRead
+**
+** reads the next num elements (values, for nrrdTypeBlock) of data,
+** in the native endianness, into data
+*/
+int
+nrrdStreamRead(NrrdStream *nst, void *data, size_t num) {
+  static const char me[]="nrrdStreamRead";
+  char stmp[2][AIR_STRLEN_SMALL];
+  size_t elSize;
+
+  if (!(nst && data)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!nst->open || nst->writing) {
+    biffAddf(NRRD, "%s: stream not open for reading", me);
+    return 1;
+  }
+  if (num > nst->elementNum - nst->elementDone) {
+    biffAddf(NRRD, "%s: asked for %s elements, but only %s left", me,
+             airSprintSize_t(stmp[0], num),
+             airSprintSize_t(stmp[1], nst->elementNum - nst->elementDone));
+    return 1;
+  }
+  elSize = nrrdElementSize(nst->nrrd);
+  if (nst->stream) {
+    if (_nrrdStreamRead(AIR_CAST(_nrrdStream *, nst->stream),
+                        data, num*elSize)) {
+      biffAddf(NRRD, "%s: trouble reading %s elements at %s", me,
+               airSprintSize_t(stmp[0], num),
+               airSprintSize_t(stmp[1], nst->elementDone));
+      return 1;
+    }
+    if (airEndianUnknown != nst->nio->endian
+        && 1 < elSize
+        && nst->nio->encoding->endianMatters
+        && nst->nio->endian != airMyEndian()) {
+      _nrrdSwapEndian[nst->nrrd->type](data, num);
+    }
+  } else {
+    memcpy(data, AIR_CAST(char *, nst->nrrd->data)
+           + nst->elementDone*elSize, num*elSize);
+  }
+  nst->elementDone += num;
+  return 0;
+}
+
+/*
+******** nrrdStreamSlabRead
+**
+** reads the next slab of slices along the last (slowest) axis: as many
+** as fit in maxBytes (but at least one, and no more than are left)
+** into nslab, which gets the same header as nst->nrrd except for the
+** size of that axis.  Memory for nslab is re-used when possible.
+*/
+int
+nrrdStreamSlabRead(NrrdStream *nst, Nrrd *nslab, size_t maxBytes) {
+  static const char me[]="nrrdStreamSlabRead";
+  size_t sliceSize, sliceLeft, sliceNum;
+
+  if (!(nst && nslab)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!nst->open || nst->writing) {
+    biffAddf(NRRD, "%s: stream not open for reading", me);
+    return 1;
+  }
+  sliceSize = nst->elementNum/nst->nrrd->axis[nst->nrrd->dim-1].size;
+  if (nst->elementDone % sliceSize) {
+    biffAddf(NRRD, "%s: previous reads didn't end on a slice", me);
+    return 1;
+  }
+  sliceLeft = (nst->elementNum - nst->elementDone)/sliceSize;
+  if (!sliceLeft) {
+    biffAddf(NRRD, "%s: no data left", me);
+    return 1;
+  }
+  sliceNum = maxBytes/(sliceSize*nrrdElementSize(nst->nrrd));
+  sliceNum = AIR_MAX(1, sliceNum);
+  sliceNum = AIR_MIN(sliceLeft, sliceNum);
+  if (_nrrdStreamHeaderSet(nslab, nst->nrrd, sliceNum, AIR_TRUE)
+      || nrrdStreamRead(nst, nslab->data, sliceNum*sliceSize)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** nrrdStreamWriteOpen
+**
+** writes the header nhdr (any data it has is ignored) to the given
+** file (or "-" for stdout) with the format and encoding set in
+** nst->nio (or guessed from filename, as with nrrdSave), and gets ready
+** to write the data with nrrdStreamWrite or nrrdStreamSlabWrite.  The
+** data is streamed out for NRRD files with a single (attached or
+** detached) data file in raw, gzip, or bzip2 encoding.  Otherwise, it
+** is collected in nst->nrrd->data and saved by nrrdStreamClose.
+*/
+int
+nrrdStreamWriteOpen(NrrdStream *nst, const char *filename,
+                    const Nrrd *nhdr) {
+  static const char me[]="nrrdStreamWriteOpen";
+  NrrdIoState *nio;
+  FILE *file, *dataFile;
+  _nrrdStream *st;
+  int ret;
+
+  if (!(nst && filename && nhdr)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (nst->open) {
+    biffAddf(NRRD, "%s: stream already open", me);
+    return 1;
+  }
+  if (_nrrdCheck(nhdr, AIR_FALSE, AIR_TRUE)) {
+    biffAddf(NRRD, "%s: problem with header", me);
+    return 1;
+  }
+  nio = nst->nio;
+  if (_nrrdStreamHeaderSet(nst->nrrd, nhdr, nhdr->axis[nhdr->dim-1].size,
+                           AIR_FALSE)
+      || _nrrdEncodingMaybeSet(nio)
+      || _nrrdFormatMaybeGuess(nst->nrrd, nio, filename)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
+  }
+  nst->writing = AIR_TRUE;
+  nst->open = AIR_TRUE;
+  nst->elementNum = nrrdElementNumber(nst->nrrd);
+  nst->elementDone = 0;
+  if (!( nrrdFormatNRRD == nio->format
+         && (nrrdEncodingRaw == nio->encoding
+             || nrrdEncodingGzip == nio->encoding
+             || nrrdEncodingBzip2 == nio->encoding)
+         && nrrdTypeBlock != nst->nrrd->type
+         && !nio->dataFNFormat
+         && nio->dataFNArr->len <= 1
+         && !nio->byteSkip && !nio->lineSkip )) {
+    if (_nrrdStreamHeaderSet(nst->nrrd, nhdr, nhdr->axis[nhdr->dim-1].size,
+                             AIR_TRUE)) {
+      biffAddf(NRRD, "%s: couldn't allocate output", me);
+      _nrrdStreamRelease(nst); return 1;
+    }
+    nst->filename = airStrdup(filename);
+    return 0;
+  }
+  if (airEndsWith(filename, NRRD_EXT_NHDR)) {
+    /* as in nrrdSave */
+    nio->detachedHeader = AIR_TRUE;
+    _nrrdSplitName(&(nio->path), &(nio->base), filename);
+    nio->base[strlen(nio->base) - strlen(NRRD_EXT_NHDR)] = 0;
+  } else {
+    nio->detachedHeader = AIR_FALSE;
+  }
+  if (!( file = airFopen(filename, stdout, "wb") )) {
+    biffAddf(NRRD, "%s: couldn't fopen(\"%s\",\"wb\"): %s",
+             me, filename, strerror(errno));
+    _nrrdStreamRelease(nst); return 1;
+  }
+  nio->skipData = AIR_TRUE;
+  ret = nrrdFormatNRRD->write(file, nst->nrrd, nio);
+  nio->skipData = AIR_FALSE;
+  if (!ret) {
+    nrrdIoStateDataFileIterBegin(nio);
+    ret = nrrdIoStateDataFileIterNext(&dataFile, nio, AIR_FALSE);
+  }
+  if (ret || !dataFile) {
+    biffAddf(NRRD, "%s: trouble writing header or opening data file", me);
+    airFclose(file);
+    _nrrdStreamRelease(nst); return 1;
+  }
+  if (dataFile != file) {
+    airFclose(file);
+  }
+  nst->file = dataFile;
+  if (!(st = AIR_CALLOC(1, _nrrdStream))) {
+    biffAddf(NRRD, "%s: couldn't allocate stream", me);
+    _nrrdStreamRelease(nst); return 1;
+  }
+  nst->stream = st;
+  if (_nrrdStreamWriteOpen(st, dataFile, nio)) {
+    biffAddf(NRRD, "%s: couldn't start writing", me);
+    nst->stream = airFree(nst->stream);
+    _nrrdStreamRelease(nst); return 1;
+  }
+  return 0;
+}
+
+/*
+******** nrrdStreamWrite
+**
+** writes the next num elements of data
+*/
+int
+nrrdStreamWrite(NrrdStream *nst, const void *data, size_t num) {
+  static const char me[]="nrrdStreamWrite";
+  char stmp[2][AIR_STRLEN_SMALL];
+  size_t elSize;
+
+  if (!(nst && data)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!nst->open || !nst->writing) {
+    biffAddf(NRRD, "%s: stream not open for writing", me);
+    return 1;
+  }
+  if (num > nst->elementNum - nst->elementDone) {
+    biffAddf(NRRD, "%s: given %s elements, but only %s left", me,
+             airSprintSize_t(stmp[0], num),
+             airSprintSize_t(stmp[1], nst->elementNum - nst->elementDone));
+    return 1;
+  }
+  elSize = nrrdElementSize(nst->nrrd);
+  if (nst->stream) {
+    if (_nrrdStreamWrite(AIR_CAST(_nrrdStream *, nst->stream),
+                         data, num*elSize)) {
+      biffAddf(NRRD, "%s: trouble writing %s elements at %s", me,
+               airSprintSize_t(stmp[0], num),
+               airSprintSize_t(stmp[1], nst->elementDone));
+      return 1;
+    }
+  } else {
+    memcpy(AIR_CAST(char *, nst->nrrd->data) + nst->elementDone*elSize,
+           data, num*elSize);
+  }
+  nst->elementDone += num;
+  return 0;
+}
+
+/*
+******** nrrdStreamSlabWrite
+**
+** writes all the data of nslab, which has to have the same type as
+** nst->nrrd
+*/
+int
+nrrdStreamSlabWrite(NrrdStream *nst, const Nrrd *nslab) {
+  static const char me[]="nrrdStreamSlabWrite";
+
+  if (!(nst && nslab)) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (nslab->type != nst->nrrd->type
+      || nrrdElementSize(nslab) != nrrdElementSize(nst->nrrd)) {
+    biffAddf(NRRD, "%s: slab type %s != stream type %s", me,
+             airEnumStr(nrrdType, nslab->type),
+             airEnumStr(nrrdType, nst->nrrd->type));
+    return 1;
+  }
+  if (nrrdStreamWrite(nst, nslab->data, nrrdElementNumber(nslab))) {
+    biffAddf(NRRD, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** nrrdStreamClose
+**
+** finishes reading or writing.  When writing, it is an error if not
+** all the data was written; data collected in memory is saved now.
+** Either way, everything is cleaned up, so that nst can be re-used
+** with another *Open.
+*/
+int
+nrrdStreamClose(NrrdStream *nst) {
+  static const char me[]="nrrdStreamClose";
+  char stmp[2][AIR_STRLEN_SMALL];
+  int ret;
+
+  if (!nst) {
+    biffAddf(NRRD, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!nst->open) {
+    biffAddf(NRRD, "%s: stream not open", me);
+    return 1;
+  }
+  ret = 0;
+  if (nst->writing) {
+    if (nst->elementDone < nst->elementNum) {
+      biffAddf(NRRD, "%s: only wrote %s of %s elements", me,
+               airSprintSize_t(stmp[0], nst->elementDone),
+               airSprintSize_t(stmp[1], nst->elementNum));
+      ret = 1;
+    } else if (nst->stream) {
+      if (_nrrdStreamWriteClose(AIR_CAST(_nrrdStream *, nst->stream))) {
+        biffAddf(NRRD, "%s: trouble finishing data", me);
+        ret = 1;
+      }
+      nst->stream = airFree(nst->stream);
+    } else if (nrrdSave(nst->filename, nst->nrrd, nst->nio)) {
+      biffAddf(NRRD, "%s: trouble saving \"%s\"", me, nst->filename);
+      ret = 1;
+    }
+  }
+  _nrrdStreamRelease(nst);
+  return ret;
+}
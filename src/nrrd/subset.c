@@ -185,8 +185,7 @@ nrrdSlice(Nrrd *nout, const Nrrd *cnin, unsigned int saxi, size_t pos) {
 */
 int
 nrrdCrop(Nrrd *nout, const Nrrd *nin, size_t *min, size_t *max) {
-  static const char me[]="nrrdCrop", func[] = "crop";
-  char buff1[NRRD_DIM_MAX*30], buff2[AIR_STRLEN_SMALL];
+  static const char me[]="nrrdCrop";
   unsigned int ai;
   size_t I,
     lineSize,                /* #bytes in one scanline to be copied */
@@ -276,6 +275,33 @@ nrrdCrop(Nrrd *nout, const Nrrd *nin, size_t *min, size_t *max) {
        copying one (1-D) scanline at a time */
     NRRD_COORD_INCR(cOut, szOut, nin->dim, 1);
   }
+  if (_nrrdCropPeripheral(nout, nin, min, max)) {
+    biffAddf(NRRD, "%s:", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** _nrrdCropPeripheral
+**
+** everything that nrrdCrop does besides copying the data: sets the
+** axis and basic information of nout (which has already been allocated
+** to the cropped size, and holds the cropped data) from nin.  Also used
+** for reading a cropped region of a file (nio->readCrop), in which case
+** nin is a data-less nrrd with the full header.
+*/
+int
+_nrrdCropPeripheral(Nrrd *nout, const Nrrd *nin,
+                    const size_t *min, const size_t *max) {
+  static const char me[]="_nrrdCropPeripheral", func[] = "crop";
+  char buff1[NRRD_DIM_MAX*30], buff2[AIR_STRLEN_SMALL];
+  char stmp[2][AIR_STRLEN_SMALL];
+  size_t szIn[NRRD_DIM_MAX], szOut[NRRD_DIM_MAX];
+  unsigned int ai;
+
+  nrrdAxisInfoGet_nva(nin, nrrdAxisInfoSize, szIn);
+  nrrdAxisInfoGet_nva(nout, nrrdAxisInfoSize, szOut);
   if (nrrdAxisInfoCopy(nout, nin, NULL, (NRRD_AXIS_INFO_SIZE_BIT |
                                          NRRD_AXIS_INFO_MIN_BIT |
                                          NRRD_AXIS_INFO_MAX_BIT ))) {
@@ -0,0 +1,161 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "../nrrd.h"
+
+/*
+** benchmarks nrrdResampleExecute: a random float volume is upsampled
+** along every axis with each of a list of kernels (by default, the
+** non-derivative kernels defined in kernel.c), and the speed is reported
+** as output voxels per second.  For example:
+** rsmpbench 100 2 1
+** rsmpbench 200 1.5 8 tent c4h
+*/
+
+static const char *
+_rsmpKernDefault[] = {
+  "box",
+  "tent",
+  "cubic:0,0.5",
+  "ctmr",
+  "quartic:0.0834",
+  "c3q",
+  "c4h",
+  "c5septic",
+  "bspl3",
+  "bspl5",
+  "gauss:1,3",
+  "hann:3",
+  "black:4",
+  NULL
+};
+
+void
+usage(char *me) {
+  /*                      0     1      2       3        (4..) */
+  fprintf(stderr, "usage: %s <size> <scale> <threads> [kern0 kern1 ...]\n",
+          me);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[]) {
+  char *me, *err;
+  const char **kernS;
+  unsigned int size, threadNum, kernNum, ki, ai, reps;
+  double scale, time0, dt;
+  size_t ii, nn, voxNum;
+  float *in;
+  Nrrd *nin, *nout;
+  NrrdKernelSpec *ksp;
+  NrrdResampleContext *rsmc;
+  airArray *mop;
+  int E;
+
+  me = argv[0];
+  if (argc < 4) {
+    usage(me);
+  }
+  if (3 != (sscanf(argv[1], "%u", &size)
+            + sscanf(argv[2], "%lf", &scale)
+            + sscanf(argv[3], "%u", &threadNum))) {
+    fprintf(stderr, "%s: couldn't parse \"%s\", \"%s\", \"%s\" as "
+            "uint, double, uint\n", me, argv[1], argv[2], argv[3]);
+    exit(1);
+  }
+  if (argc > 4) {
+    kernS = AIR_CAST(const char **, argv + 4);
+    kernNum = AIR_CAST(unsigned int, argc - 4);
+  } else {
+    kernS = _rsmpKernDefault;
+    for (kernNum=0; kernS[kernNum]; kernNum++);
+  }
+
+  mop = airMopNew();
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  ksp = nrrdKernelSpecNew();
+  airMopAdd(mop, ksp, (airMopper)nrrdKernelSpecNix, airMopAlways);
+  rsmc = nrrdResampleContextNew();
+  airMopAdd(mop, rsmc, (airMopper)nrrdResampleContextNix, airMopAlways);
+  if (nrrdAlloc_va(nin, nrrdTypeFloat, 3, AIR_CAST(size_t, size),
+                   AIR_CAST(size_t, size), AIR_CAST(size_t, size))) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: trouble allocating:\n%s", me, err);
+    airMopError(mop); exit(1);
+  }
+  in = AIR_CAST(float *, nin->data);
+  nn = nrrdElementNumber(nin);
+  airSrandMT(42);
+  for (ii=0; ii<nn; ii++) {
+    in[ii] = AIR_CAST(float, airDrandMT());
+  }
+
+  printf("%s: %u^3 floats, x%g, %u thread%s\n", me, size, scale,
+         threadNum, 1 == threadNum ? "" : "s");
+  for (ki=0; ki<kernNum; ki++) {
+    if (nrrdKernelSpecParse(ksp, kernS[ki])) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble parsing \"%s\":\n%s", me, kernS[ki], err);
+      airMopError(mop); exit(1);
+    }
+    E = AIR_FALSE;
+    if (!E) E |= nrrdResampleInputSet(rsmc, nin);
+    for (ai=0; ai<3; ai++) {
+      if (!E) E |= nrrdResampleKernelSet(rsmc, ai, ksp->kernel, ksp->parm);
+      if (!E) E |= nrrdResampleSamplesSet(rsmc, ai,
+                                          AIR_ROUNDUP(scale*size));
+      if (!E) E |= nrrdResampleRangeFullSet(rsmc, ai);
+    }
+    if (!E) E |= nrrdResampleBoundarySet(rsmc, nrrdBoundaryBleed);
+    if (!E) E |= nrrdResampleTypeOutSet(rsmc, nrrdTypeFloat);
+    if (!E) E |= nrrdResampleRenormalizeSet(rsmc, AIR_TRUE);
+    if (!E) E |= nrrdResampleThreadNumSet(rsmc, threadNum);
+    /* run until at least a second has passed, to get a stable number */
+    reps = 0;
+    time0 = airTime();
+    do {
+      /* re-setting the input makes nrrdResampleExecute re-do the work
+         (but not before the first execution: setting the input again
+         then would forget the per-axis kernels just set) */
+      if (!E && reps) E |= nrrdResampleInputSet(rsmc, nin);
+      if (!E) E |= nrrdResampleExecute(rsmc, nout);
+      reps++;
+      dt = airTime() - time0;
+    } while (!E && dt < 1.0);
+    if (E) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: trouble resampling with \"%s\":\n%s",
+              me, kernS[ki], err);
+      airMopError(mop); exit(1);
+    }
+    voxNum = nrrdElementNumber(nout);
+    printf("%16s: %8.3f Mvox/sec (%u reps in %g sec)\n", kernS[ki],
+           AIR_CAST(double, voxNum)*reps/(dt*1000000), reps, dt);
+  }
+
+  airMopOkay(mop);
+  exit(0);
+}
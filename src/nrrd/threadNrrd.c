@@ -0,0 +1,151 @@
+/*
+  Teem: Tools to process and visualize scientific data and images             .
+  Copyright (C) 2009--2019  University of Chicago
+  Copyright (C) 2008, 2007, 2006, 2005  Gordon Kindlmann
+  Copyright (C) 2004, 2003, 2002, 2001, 2000, 1999, 1998  University of Utah
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  The terms of redistributing and/or modifying this software also
+  include exceptions to the LGPL that facilitate static linking.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "nrrd.h"
+#include "privateNrrd.h"
+
+/*
+** The multi-threading shared by the nrrd functions that divide their
+** work among nrrdDefaultThreadNum threads: _nrrdThreadNum decides how
+** many threads to use, and _nrrdThreadRun runs a worker on an array of
+** tasks, one thread per task.
+*/
+
+/*
+** _nrrdThreadNum
+**
+** the number of threads to use for workNum units of work, over NN
+** values (or bytes): nrrdDefaultThreadNum, but no more than the units
+** of work, and only one more for every grain values (the fewest for
+** which it is worth starting another thread).  Always at least 1.
+*/
+unsigned int
+_nrrdThreadNum(size_t workNum, size_t NN, size_t grain) {
+  static const char me[]="_nrrdThreadNum";
+  unsigned int threadNum;
+
+  threadNum = AIR_MAX(1, nrrdDefaultThreadNum);
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
+  threadNum = AIR_CAST(unsigned int, AIR_MIN(threadNum, workNum));
+  threadNum = AIR_CAST(unsigned int, AIR_MIN(threadNum, 1 + NN/grain));
+  return AIR_MAX(1, threadNum);
+}
+
+typedef struct {
+  airThreadMutex *mutex;     /* held while the threads are started */
+  int failed;                /* a thread failed to start */
+} _nrrdThreadGate;
+
+typedef struct {
+  _nrrdThreadGate *gate;
+  void *(*worker)(void *);
+  void *task;
+} _nrrdThreadArg;
+
+static void *
+_nrrdThreadBody(void *_arg) {
+  _nrrdThreadArg *arg;
+  int failed;
+
+  arg = AIR_CAST(_nrrdThreadArg *, _arg);
+  /* wait until all the threads have been started (or not) */
+  airThreadMutexLock(arg->gate->mutex);
+  failed = arg->gate->failed;
+  airThreadMutexUnlock(arg->gate->mutex);
+  return failed ? NULL : arg->worker(arg->task);
+}
+
+/*
+** _nrrdThreadRun
+**
+** runs worker on each of the num tasks in the task array (each of
+** taskSize bytes), with one thread per task, or in the calling thread
+** when num is 1 (num should come from _nrrdThreadNum).  No worker runs
+** until all the threads have started, so workers may wait for each other
+** (as with an airThreadBarrier for num threads).  If a thread fails to
+** start, no worker runs at all, and the threads that did start are
+** joined before returning an error.
+*/
+int
+_nrrdThreadRun(void *(*worker)(void *), void *task, size_t taskSize,
+               unsigned int num) {
+  static const char me[]="_nrrdThreadRun";
+  _nrrdThreadGate gate;
+  _nrrdThreadArg *arg;
+  airThread **thread;
+  unsigned int ti, startNum;
+  airArray *mop;
+  int ret, E;
+
+  if (1 == num) {
+    worker(task);
+    return 0;
+  }
+  mop = airMopNew();
+  gate.mutex = airThreadMutexNew();
+  airMopAdd(mop, gate.mutex, (airMopper)airThreadMutexNix, airMopAlways);
+  gate.failed = AIR_FALSE;
+  arg = AIR_CALLOC(num, _nrrdThreadArg);
+  airMopAdd(mop, arg, airFree, airMopAlways);
+  thread = AIR_CALLOC(num, airThread *);
+  airMopAdd(mop, thread, airFree, airMopAlways);
+  if (!( gate.mutex && arg && thread )) {
+    biffAddf(NRRD, "%s: couldn't allocate for %u threads", me, num);
+    airMopError(mop); return 1;
+  }
+  for (ti=0; ti<num; ti++) {
+    thread[ti] = airThreadNew();
+    airMopAdd(mop, thread[ti], (airMopper)airThreadNix, airMopAlways);
+    arg[ti].gate = &gate;
+    arg[ti].worker = worker;
+    arg[ti].task = AIR_CAST(char *, task) + ti*taskSize;
+  }
+  airThreadMutexLock(gate.mutex);
+  for (ti=0; ti<num; ti++) {
+    if ((ret = airThreadStart(thread[ti], _nrrdThreadBody,
+                              AIR_VOIDP(arg + ti)))) {
+      biffAddf(NRRD, "%s: thread %u failed to start: %d", me, ti, ret);
+      gate.failed = AIR_TRUE;
+      break;
+    }
+  }
+  startNum = ti;
+  airThreadMutexUnlock(gate.mutex);
+  E = gate.failed;
+  for (ti=0; ti<startNum; ti++) {
+    void *retP;
+    if ((ret = airThreadJoin(thread[ti], &retP))) {
+      biffAddf(NRRD, "%s: thread %u failed to join: %d", me, ti, ret);
+      E = 1;
+    }
+  }
+  if (E) {
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
@@ -79,6 +79,7 @@ pullContextNew(void) {
   ELL_4V_SET(pctx->binsEdge, 0, 0, 0, 0);
   pctx->binNum = 0;
   pctx->binNextIdx = 0;
+  pctx->binPointClaimed = 0;
 
   pctx->tmpPointPerm = NULL;
   pctx->tmpPointPtr = NULL;
@@ -35,43 +35,78 @@ _pullVerbose = 0;
   )
 /*
 ** this is the core of the worker threads: as long as there are bins
-** left to process, get the next one, and process it
+** left to process, claim the next run of them, and process them.
+**
+** Bins are claimed (under binMutex) in runs of consecutive bins holding
+** about 1/(2*threadNum) of the points not yet claimed, so that the
+** mutex is taken rarely while there is a lot of work left, and the runs
+** get smaller (down to a single non-empty bin) towards the end, so that
+** the threads finish at about the same time.  Weighting by points
+** (rather than counting bins) is what keeps this balanced when points
+** are concentrated in few bins.  Empty bins are skipped after the mutex
+** is released.  With one thread, bins are processed in the same order
+** as always.
 */
 int
 _pullProcess(pullTask *task) {
   static const char me[]="_pullProcess";
-  unsigned int binIdx;
+  pullContext *pctx;
+  unsigned int binIdx, binLo, binHi, pointClaim, pointTarget;
+  double time0;
 
-  while (task->pctx->binNextIdx < task->pctx->binNum) {
-    /* get the index of the next bin to process */
-    if (task->pctx->threadNum > 1) {
-      airThreadMutexLock(task->pctx->binMutex);
+  pctx = task->pctx;
+  time0 = airTime();
+  task->binProcessNum = 0;
+  task->pointProcessNum = 0;
+  while (1) {
+    /* claim the next run of bins [binLo, binHi) */
+    if (pctx->threadNum > 1) {
+      airThreadMutexLock(pctx->binMutex);
     }
-    /* note that we entirely skip bins with no points */
-    do {
-      binIdx = task->pctx->binNextIdx;
-      if (task->pctx->binNextIdx < task->pctx->binNum) {
-        task->pctx->binNextIdx++;
-      }
-    } while (binIdx < task->pctx->binNum
-             && 0 == task->pctx->bin[binIdx].pointNum);
-    if (task->pctx->threadNum > 1) {
-      airThreadMutexUnlock(task->pctx->binMutex);
+    binLo = pctx->binNextIdx;
+    while (binLo < pctx->binNum && 0 == pctx->bin[binLo].pointNum) {
+      binLo++;
     }
-    if (binIdx == task->pctx->binNum) {
+    pointTarget = (pctx->pointNum > pctx->binPointClaimed
+                   ? (pctx->pointNum - pctx->binPointClaimed)
+                   /(2*pctx->threadNum)
+                   : 0);
+    pointClaim = 0;
+    binHi = binLo;
+    while (binHi < pctx->binNum
+           && (binHi == binLo || pointClaim < pointTarget)) {
+      pointClaim += pctx->bin[binHi].pointNum;
+      binHi++;
+    }
+    pctx->binNextIdx = binHi;
+    pctx->binPointClaimed += pointClaim;
+    if (pctx->threadNum > 1) {
+      airThreadMutexUnlock(pctx->binMutex);
+    }
+    if (binLo == pctx->binNum) {
       /* no more bins to process! */
       break;
     }
-    if (task->pctx->verbose > 1) {
-      fprintf(stderr, "%s(%u): calling pullBinProcess(%u)\n",
-              me, task->threadIdx, binIdx);
-    }
-    if (pullBinProcess(task, binIdx)) {
-      biffAddf(PULL, "%s(%u): had trouble on bin %u", me,
-               task->threadIdx, binIdx);
-      return 1;
+    for (binIdx=binLo; binIdx<binHi; binIdx++) {
+      /* note that we entirely skip bins with no points */
+      if (!pctx->bin[binIdx].pointNum) {
+        continue;
+      }
+      if (pctx->verbose > 1) {
+        fprintf(stderr, "%s(%u): calling pullBinProcess(%u)\n",
+                me, task->threadIdx, binIdx);
+      }
+      task->binProcessNum += 1;
+      task->pointProcessNum += pctx->bin[binIdx].pointNum;
+      if (pullBinProcess(task, binIdx)) {
+        biffAddf(PULL, "%s(%u): had trouble on bin %u", me,
+                 task->threadIdx, binIdx);
+        task->timeProcess = airTime() - time0;
+        return 1;
+      }
     }
   }
+  task->timeProcess = airTime() - time0;
   return 0;
 }
 
@@ -276,6 +311,7 @@ _pullIterate(pullContext *pctx, int mode) {
 
   /* initialize index of next bin to be doled out to threads */
   pctx->binNextIdx=0;
+  pctx->binPointClaimed=0;
 
   if (pctx->threadNum > 1) {
     airThreadBarrierWait(pctx->iterBarrierA);
@@ -300,6 +336,26 @@ _pullIterate(pullContext *pctx, int mode) {
     if (pctx->pointNum > _PULL_PROGRESS_POINT_NUM_MIN) {
       fprintf(stderr, ".\n"); /* finishing line of progress indicators */
     }
+    if (pctx->threadNum > 1) {
+      double tmin, tmax, tsum, tt;
+      tmin = tmax = tsum = pctx->task[0]->timeProcess;
+      for (ti=1; ti<pctx->threadNum; ti++) {
+        tt = pctx->task[ti]->timeProcess;
+        tmin = AIR_MIN(tmin, tt);
+        tmax = AIR_MAX(tmax, tt);
+        tsum += tt;
+      }
+      fprintf(stderr, "%s: thread process times min %g, mean %g, max %g "
+              "(sec)\n", me, tmin, tsum/pctx->threadNum, tmax);
+      if (pctx->verbose > 1) {
+        for (ti=0; ti<pctx->threadNum; ti++) {
+          fprintf(stderr, "%s: thread %u: %u bins, %u points, %g sec\n",
+                  me, ti, pctx->task[ti]->binProcessNum,
+                  pctx->task[ti]->pointProcessNum,
+                  pctx->task[ti]->timeProcess);
+        }
+      }
+    }
   }
 
   /* depending on mode, run one of the iteration finishers */
@@ -516,7 +516,12 @@ typedef struct pullTask_t {
   unsigned int nixPointNum;     /* # of points to nix */
   airArray *nixPointArr;        /* airArray around nixPoint, nixPointNum */
   void *returnPtr;              /* for airThreadJoin */
-  unsigned int stuckNum;        /* # stuck particles seen by this task */
+  unsigned int stuckNum,        /* # stuck particles seen by this task */
+    binProcessNum,              /* # bins processed in last iter */
+    pointProcessNum;            /* # points processed in last iter */
+  double timeProcess;           /* time spent processing bins in last iter,
+                                   (compare between tasks to see how well
+                                   work was balanced between threads) */
 } pullTask;
 
 /*
@@ -955,8 +960,9 @@ typedef struct pullContext_t {
   unsigned int binsEdge[4],        /* # bins along each volume edge,
                                       determined by maxEval and scale */
     binNum,                        /* total # bins in grid */
-    binNextIdx;                    /* next bin of points to be processed,
+    binNextIdx,                    /* next bin of points to be processed,
                                       we're done when binNextIdx == binNum */
+    binPointClaimed;               /* # points in bins before binNextIdx */
   unsigned int *tmpPointPerm;      /* storing points during rebinning */
   pullPoint **tmpPointPtr;
   unsigned int tmpPointNum;
@@ -115,6 +115,9 @@ _pullTaskNew(pullContext *pctx, int threadIdx) {
                                   PULL_POINT_NEIGH_INCR);
   task->returnPtr = NULL;
   task->stuckNum = 0;
+  task->binProcessNum = 0;
+  task->pointProcessNum = 0;
+  task->timeProcess = 0;
   return task;
 }
 
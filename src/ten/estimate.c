@@ -229,6 +229,7 @@ tenEstimateContextNew() {
     tec->verbose = 0;
     tec->progress = AIR_FALSE;
     tec->WLSIterNum = 3;
+    tec->threadNum = 1;
     for (fi=flagUnknown+1; fi<flagLast; fi++) {
       tec->flag[fi] = AIR_FALSE;
     }
@@ -433,6 +434,24 @@ tenEstimateSkipReset(tenEstimateContext *tec) {
   return 0;
 }
 
+int
+tenEstimateThreadNumSet(tenEstimateContext *tec, unsigned int threadNum) {
+  static const char me[]="tenEstimateThreadNumSet";
+
+  if (!tec) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(TEN, "%s: need threadNum >= 1", me);
+    return 1;
+  }
+
+  tec->threadNum = threadNum;
+
+  return 0;
+}
+
 int
 tenEstimateThresholdFind(double *threshP, unsigned char *isB0, Nrrd *nin4d) {
   static const char me[]="tenEstimateThresholdFind";
@@ -1890,17 +1909,374 @@ tenEstimate1TensorSingle_d(tenEstimateContext *tec,
   return 0;
 }
 
+/*
+** _tenEstimateContextCopy
+**
+** makes a deep copy of an updated tenEstimateContext, so that a copy
+** can estimate at the same time (in a different thread) as the
+** original.  The caller's gradient or B-matrix nrrd is shared, not
+** copied, since it is only read.
+*/
+static tenEstimateContext *
+_tenEstimateContextCopy(const tenEstimateContext *tec) {
+  static const char me[]="_tenEstimateContextCopy";
+  tenEstimateContext *cec;
+  airPtrPtrUnion appu;
+  int E;
+
+  cec = AIR_CAST(tenEstimateContext *, malloc(sizeof(tenEstimateContext)));
+  if (!cec) {
+    biffAddf(TEN, "%s: couldn't allocate context", me);
+    return NULL;
+  }
+  memcpy(cec, tec, sizeof(tenEstimateContext));
+  cec->skipList = NULL;
+  appu.ui = &(cec->skipList);
+  cec->skipListArr = airArrayNew(appu.v, NULL,
+                                 2*sizeof(unsigned int), 128);
+  cec->skipListArr->noReallocWhenSmaller = AIR_TRUE;
+  cec->nbmat = nrrdNew();
+  cec->nwght = nrrdNew();
+  cec->nemat = nrrdNew();
+  cec->all = cec->bnorm = cec->allTmp = cec->dwiTmp = cec->dwi = NULL;
+  cec->skipLut = NULL;
+  E = 0;
+  if (!E) {
+    airArrayLenSet(cec->skipListArr, tec->skipListArr->len);
+    E |= (tec->skipListArr->len && !cec->skipList);
+    if (!E && tec->skipListArr->len) {
+      memcpy(cec->skipList, tec->skipList,
+             2*sizeof(unsigned int)*tec->skipListArr->len);
+    }
+  }
+#define COPY(TYPE, FIELD, NUM)                                  \
+  if (!E && tec->FIELD) {                                       \
+    cec->FIELD = AIR_CAST(TYPE *, calloc(NUM, sizeof(TYPE)));   \
+    E |= !cec->FIELD;                                           \
+    if (!E) memcpy(cec->FIELD, tec->FIELD, NUM*sizeof(TYPE));   \
+  }
+  COPY(double, all, tec->allNum);
+  COPY(double, bnorm, tec->allNum);
+  COPY(double, allTmp, tec->allNum);
+  COPY(double, dwiTmp, tec->dwiNum);
+  COPY(double, dwi, tec->dwiNum);
+  COPY(unsigned char, skipLut, tec->allNum);
+#undef COPY
+  if (E) {
+    biffAddf(TEN, "%s: couldn't allocate arrays", me);
+    return tenEstimateContextNix(cec);
+  }
+  if (!E) E |= (tec->nbmat->data && nrrdCopy(cec->nbmat, tec->nbmat));
+  if (!E) E |= (tec->nwght->data && nrrdCopy(cec->nwght, tec->nwght));
+  if (!E) E |= (tec->nemat->data && nrrdCopy(cec->nemat, tec->nemat));
+  if (E) {
+    biffMovef(TEN, NRRD, "%s: couldn't copy matrices", me);
+    return tenEstimateContextNix(cec);
+  }
+  return cec;
+}
+
+/*
+** everything about one call to tenEstimate1TensorVolume4D, shared by
+** all the threads (the "next" voxel is the only thing they change)
+*/
+typedef struct {
+  const Nrrd *ndwi;
+  Nrrd *nten, *nB0, *nterr;
+  double (*lup)(const void *, size_t),
+    (*ins)(void *v, size_t I, double d);
+  size_t NN,               /* total number of voxels */
+    slab,                  /* number of voxels claimed at once */
+    next;                  /* first voxel not yet claimed */
+  int progress, failed;
+  size_t failII;           /* first voxel (found) where estimation failed */
+  airThreadMutex *mutex;
+} _tenEstimateVolumeJob;
+
+typedef struct {
+  _tenEstimateVolumeJob *job;
+  tenEstimateContext *tec; /* this thread's context */
+  double *all;             /* this thread's DWI values at one voxel */
+} _tenEstimateVolumeTask;
+
+/*
+** saves, at voxel II of the output volumes, what tec estimated there
+*/
+static void
+_tenEstimateVolumeSave(_tenEstimateVolumeJob *job, tenEstimateContext *tec,
+                       size_t II, const double ten[7]) {
+  size_t sizeTen;
+
+  sizeTen = nrrdKindSize(nrrdKind3DMaskedSymMatrix);
+  job->ins(job->nten->data, 0 + sizeTen*II, ten[0]);
+  job->ins(job->nten->data, 1 + sizeTen*II, ten[1]);
+  job->ins(job->nten->data, 2 + sizeTen*II, ten[2]);
+  job->ins(job->nten->data, 3 + sizeTen*II, ten[3]);
+  job->ins(job->nten->data, 4 + sizeTen*II, ten[4]);
+  job->ins(job->nten->data, 5 + sizeTen*II, ten[5]);
+  job->ins(job->nten->data, 6 + sizeTen*II, ten[6]);
+  if (job->nB0) {
+    job->ins(job->nB0->data, II, (tec->estimateB0
+                                  ? tec->estimatedB0
+                                  : tec->knownB0));
+  }
+  if (job->nterr) {
+    /* this works because tenEstimate1TensorVolume4D checked that only
+       one of the tec->record* flags is set */
+    if (tec->recordErrorDwi) {
+      job->ins(job->nterr->data, II, tec->errorDwi);
+    } else if (tec->recordErrorLogDwi) {
+      job->ins(job->nterr->data, II, tec->errorLogDwi);
+    } else if (tec->recordLikelihoodDwi) {
+      job->ins(job->nterr->data, II, tec->likelihoodDwi);
+    }
+  }
+  return;
+}
+
+/* number of voxels at a time in _tenEstimateVolumeRangeLLS */
+#define LLS_BLOCK 64
+
+/*
+** linear least-squares estimation at voxels [lo, hi), the same as
+** _tenEstimate1TensorSingle with tenEstimate1MethodLLS, but a block of
+** voxels at a time: the log values for all voxels in the block are
+** multiplied by the (same) pseudo-inverse tec->nemat in one matrix
+** product, which the compiler can vectorize across voxels.  The sums
+** are formed in the same order as in _tenEstimate1Tensor_LLS, so the
+** results are exactly the same.
+*/
+static int
+_tenEstimateVolumeRangeLLS(tenEstimateContext *tec,
+                           _tenEstimateVolumeJob *job, size_t lo, size_t hi,
+                           size_t tick, size_t *failP) {
+  static const char me[]="_tenEstimateVolumeRangeLLS";
+  char doneStr[20];
+  double *val, *xx, *coef, conf[LLS_BLOCK], knownB0[LLS_BLOCK], ten[7],
+    *emat, *cc, *xi, ee,
+    tmp, logB0;
+  size_t II, bII;
+  unsigned int vi, vn, ii, jj, dd, num, rowNum;
+  airArray *mop;
+
+  num = tec->estimateB0 ? tec->allNum : tec->dwiNum;
+  rowNum = tec->estimateB0 ? 7 : 6;
+  emat = AIR_CAST(double *, tec->nemat->data);
+  mop = airMopNew();
+  val = AIR_CALLOC(LLS_BLOCK*tec->allNum, double);
+  airMopAdd(mop, val, airFree, airMopAlways);
+  xx = AIR_CALLOC(LLS_BLOCK*num, double);
+  airMopAdd(mop, xx, airFree, airMopAlways);
+  coef = AIR_CALLOC(LLS_BLOCK*rowNum, double);
+  airMopAdd(mop, coef, airFree, airMopAlways);
+  if (!( val && xx && coef )) {
+    biffAddf(TEN, "%s: couldn't allocate buffers", me);
+    *failP = lo;
+    airMopError(mop); return 1;
+  }
+  for (bII=lo; bII<hi; bII+=LLS_BLOCK) {
+    vn = AIR_CAST(unsigned int, AIR_MIN(LLS_BLOCK, hi - bII));
+    /* values, confidence, and log values (with voxels along the faster
+       axis of xx) */
+    for (vi=0; vi<vn; vi++) {
+      II = bII + vi;
+      if (tick && 0 == II%tick) {
+        fprintf(stderr, "%s", airDoneStr(0, II, job->NN-1, doneStr));
+      }
+      for (dd=0; dd<tec->allNum; dd++) {
+        val[dd + tec->allNum*vi] = job->lup(job->ndwi->data,
+                                            dd + tec->allNum*II);
+      }
+      tec->all_f = NULL;
+      tec->all_d = val + tec->allNum*vi;
+      _tenEstimateValuesSet(tec);
+      conf[vi] = tec->conf;
+      knownB0[vi] = tec->knownB0;
+      if (tec->estimateB0) {
+        for (ii=0; ii<tec->allNum; ii++) {
+          tmp = AIR_MAX(tec->valueMin, tec->all[ii]);
+          xx[vi + LLS_BLOCK*ii] = -log(tmp)/(tec->bValue);
+        }
+      } else {
+        logB0 = log(AIR_MAX(tec->valueMin, tec->knownB0));
+        for (ii=0; ii<tec->dwiNum; ii++) {
+          tmp = AIR_MAX(tec->valueMin, tec->dwi[ii]);
+          xx[vi + LLS_BLOCK*ii] = (logB0 - log(tmp))/(tec->bValue);
+        }
+      }
+    }
+    /* coefficients for all voxels in block */
+    for (jj=0; jj<rowNum; jj++) {
+      cc = coef + LLS_BLOCK*jj;
+      for (vi=0; vi<vn; vi++) {
+        cc[vi] = 0;
+      }
+      for (ii=0; ii<num; ii++) {
+        ee = emat[ii + num*jj];
+        xi = xx + LLS_BLOCK*ii;
+        for (vi=0; vi<vn; vi++) {
+          cc[vi] += ee*xi[vi];
+        }
+      }
+    }
+    /* finish as in _tenEstimate1TensorSingle, and save */
+    for (vi=0; vi<vn; vi++) {
+      II = bII + vi;
+      _tenEstimateOutputInit(tec);
+      ten[0] = conf[vi];
+      for (jj=0; jj<6; jj++) {
+        ten[1+jj] = coef[vi + LLS_BLOCK*jj];
+      }
+      if (tec->estimateB0) {
+        for (jj=0; jj<6; jj++) {
+          if (!AIR_EXISTS(ten[1+jj])) {
+            biffAddf(TEN, "%s: estimated non-existent tensor coef (%u) %g",
+                     me, jj, ten[1+jj]);
+            *failP = II;
+            airMopError(mop); return 1;
+          }
+        }
+        tec->estimatedB0 = exp(tec->bValue*coef[vi + LLS_BLOCK*6]);
+        tec->estimatedB0 = AIR_MIN(FLT_MAX, tec->estimatedB0);
+        if (!AIR_EXISTS(tec->estimatedB0)) {
+          biffAddf(TEN, "%s: estimated non-existent B0 %g (b=%g, tmp=%g)",
+                   me, tec->estimatedB0, tec->bValue,
+                   coef[vi + LLS_BLOCK*6]);
+          *failP = II;
+          airMopError(mop); return 1;
+        }
+      }
+      TEN_T_COPY(tec->ten, ten);
+      if (tec->negEvalShift) {
+        double eval[3];
+        tenEigensolve_d(eval, NULL, tec->ten);
+        if (eval[2] < 0) {
+          tec->ten[1] += -eval[2];
+          tec->ten[4] += -eval[2];
+          tec->ten[6] += -eval[2];
+        }
+      }
+      tec->knownB0 = knownB0[vi];
+      if (tec->recordErrorDwi
+          || tec->recordErrorLogDwi) {
+        /* need this voxel's values again */
+        tec->all_f = NULL;
+        tec->all_d = val + tec->allNum*vi;
+        _tenEstimateValuesSet(tec);
+        if (_tenEstimate1TensorSimulateSingle(tec, 0.0, tec->bValue,
+                                              (tec->estimateB0
+                                               ? tec->estimatedB0
+                                               : tec->knownB0), tec->ten)) {
+          biffAddf(TEN, "%s: simulation failed", me);
+          *failP = II;
+          airMopError(mop); return 1;
+        }
+        if (tec->recordErrorDwi) {
+          tec->errorDwi = _tenEstimateErrorDwi(tec);
+        }
+        if (tec->recordErrorLogDwi) {
+          tec->errorLogDwi = _tenEstimateErrorLogDwi(tec);
+        }
+      }
+      _tenEstimateVolumeSave(job, tec, II, tec->ten);
+    }
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
+/*
+** estimates and saves tensors at voxels [lo, hi); on failure, *failP
+** is set to the index of the voxel where estimation failed
+*/
+static int
+_tenEstimateVolumeRange(tenEstimateContext *tec, double *all,
+                        _tenEstimateVolumeJob *job, size_t lo, size_t hi,
+                        size_t tick, size_t *failP) {
+  static const char me[]="_tenEstimateVolumeRange";
+  char doneStr[20];
+  double ten[7];
+  size_t II;
+  unsigned int dd;
+
+  if (tenEstimate1MethodLLS == tec->estimate1Method && !tec->verbose) {
+    return _tenEstimateVolumeRangeLLS(tec, job, lo, hi, tick, failP);
+  }
+  for (II=lo; II<hi; II++) {
+    if (tick && 0 == II%tick) {
+      fprintf(stderr, "%s", airDoneStr(0, II, job->NN-1, doneStr));
+    }
+    for (dd=0; dd<tec->allNum; dd++) {
+      all[dd] = job->lup(job->ndwi->data, dd + tec->allNum*II);
+    }
+    if (tec->verbose) {
+      fprintf(stderr, "!%s: hello; II=%u\n", me, AIR_CAST(unsigned int, II));
+    }
+    if (tenEstimate1TensorSingle_d(tec, ten, all)) {
+      *failP = II;
+      return 1;
+    }
+    _tenEstimateVolumeSave(job, tec, II, ten);
+  }
+  return 0;
+}
+
+static void *
+_tenEstimateVolumeWorker(void *_task) {
+  _tenEstimateVolumeTask *task;
+  _tenEstimateVolumeJob *job;
+  char doneStr[20];
+  size_t lo, hi, failII;
+
+  task = AIR_CAST(_tenEstimateVolumeTask *, _task);
+  job = task->job;
+  while (1) {
+    airThreadMutexLock(job->mutex);
+    if (job->failed || job->next == job->NN) {
+      airThreadMutexUnlock(job->mutex);
+      break;
+    }
+    lo = job->next;
+    hi = AIR_MIN(lo + job->slab, job->NN);
+    job->next = hi;
+    if (job->progress) {
+      fprintf(stderr, "%s", airDoneStr(0, lo, job->NN-1, doneStr));
+    }
+    airThreadMutexUnlock(job->mutex);
+    if (_tenEstimateVolumeRange(task->tec, task->all, job, lo, hi,
+                                0, &failII)) {
+      airThreadMutexLock(job->mutex);
+      if (!job->failed || failII < job->failII) {
+        job->failII = failII;
+      }
+      job->failed = AIR_TRUE;
+      airThreadMutexUnlock(job->mutex);
+      break;
+    }
+  }
+  return _task;
+}
+
+/*
+******** tenEstimate1TensorVolume4D
+**
+** estimates single tensors at all voxels of a 4-D DWI volume.  With
+** tec->threadNum > 1 (see tenEstimateThreadNumSet), the voxels are
+** divided into slabs, which are claimed by threads that each have their
+** own copy of tec; the results are the same as with one thread.
+*/
 int
 tenEstimate1TensorVolume4D(tenEstimateContext *tec,
                            Nrrd *nten, Nrrd **nB0P, Nrrd **nterrP,
                            const Nrrd *ndwi, int outType) {
   static const char me[]="tenEstimate1TensorVolume4D";
   char doneStr[20];
-  size_t sizeTen, sizeX, sizeY, sizeZ, NN, II, tick;
-  double *all, ten[7], (*lup)(const void *, size_t),
-    (*ins)(void *v, size_t I, double d);
-  unsigned int dd;
+  size_t sizeTen, sizeX, sizeY, sizeZ, tick, failII;
+  double *all;
+  unsigned int ti, threadNum;
+  _tenEstimateVolumeJob job;
   airArray *mop;
+  int failed;
   int axmap[4];
   char stmp[AIR_STRLEN_SMALL];
 
@@ -2022,59 +2398,100 @@ tenEstimate1TensorVolume4D(tenEstimateContext *tec,
     airMopAdd(mop, *nterrP, (airMopper)nrrdNuke, airMopOnError);
     airMopAdd(mop, nterrP, (airMopper)airSetNull, airMopOnError);
   }
-  NN = sizeX * sizeY * sizeZ;
-  lup = nrrdDLookup[ndwi->type];
-  ins = nrrdDInsert[outType];
+  job.ndwi = ndwi;
+  job.nten = nten;
+  job.nB0 = nB0P ? *nB0P : NULL;
+  job.nterr = nterrP ? *nterrP : NULL;
+  job.lup = nrrdDLookup[ndwi->type];
+  job.ins = nrrdDInsert[outType];
+  job.NN = sizeX * sizeY * sizeZ;
+  /* slabs are slices, unless there are too few slices to go around */
+  job.slab = (sizeZ >= 4*tec->threadNum ? sizeX*sizeY : sizeX);
+  job.next = 0;
+  job.progress = tec->progress;
+  job.failed = AIR_FALSE;
+  job.failII = 0;
+  job.mutex = NULL;
+  threadNum = tec->threadNum;
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
   if (tec->progress) {
     fprintf(stderr, "%s:       ", me);
   }
   fflush(stderr);
-  tick = NN / 200;
-  tick = AIR_MAX(1, tick);
-  for (II=0; II<NN; II++) {
-    if (tec->progress && 0 == II%tick) {
-      fprintf(stderr, "%s", airDoneStr(0, II, NN-1, doneStr));
-    }
-    for (dd=0; dd<tec->allNum; dd++) {
-      all[dd] = lup(ndwi->data, dd + tec->allNum*II);
-    }
-    /*
-    tec->verbose = 10*(II == 42509);
-    */
-    if (tec->verbose) {
-      fprintf(stderr, "!%s: hello; II=%u\n", me, AIR_CAST(unsigned int, II));
-    }
-    if (tenEstimate1TensorSingle_d(tec, ten, all)) {
-      biffAddf(TEN, "%s: failed at sample %s", me,
-               airSprintSize_t(stmp, II));
+  if (1 == threadNum) {
+    tick = job.NN / 200;
+    tick = AIR_MAX(1, tick);
+    failed = _tenEstimateVolumeRange(tec, all, &job, 0, job.NN,
+                                     tec->progress ? tick : 0, &failII);
+  } else {
+    _tenEstimateVolumeTask *task;
+    airThread **thread;
+    void *ret;
+    task = AIR_CALLOC(threadNum, _tenEstimateVolumeTask);
+    airMopAdd(mop, task, airFree, airMopAlways);
+    thread = AIR_CALLOC(threadNum, airThread *);
+    airMopAdd(mop, thread, airFree, airMopAlways);
+    if (!( task && thread )) {
+      biffAddf(TEN, "%s: couldn't allocate %u tasks", me, threadNum);
       airMopError(mop); return 1;
     }
-    ins(nten->data, 0 + sizeTen*II, ten[0]);
-    ins(nten->data, 1 + sizeTen*II, ten[1]);
-    ins(nten->data, 2 + sizeTen*II, ten[2]);
-    ins(nten->data, 3 + sizeTen*II, ten[3]);
-    ins(nten->data, 4 + sizeTen*II, ten[4]);
-    ins(nten->data, 5 + sizeTen*II, ten[5]);
-    ins(nten->data, 6 + sizeTen*II, ten[6]);
-    if (nB0P) {
-      ins((*nB0P)->data, II, (tec->estimateB0
-                              ? tec->estimatedB0
-                              : tec->knownB0));
-    }
-    if (nterrP) {
-      /* this works because above we checked that only one of the
-         tec->record* flags is set */
-      if (tec->recordErrorDwi) {
-        ins((*nterrP)->data, II, tec->errorDwi);
-      } else if (tec->recordErrorLogDwi) {
-        ins((*nterrP)->data, II, tec->errorLogDwi);
-      } else if (tec->recordLikelihoodDwi) {
-        ins((*nterrP)->data, II, tec->likelihoodDwi);
+    job.mutex = airThreadMutexNew();
+    airMopAdd(mop, job.mutex, (airMopper)airThreadMutexNix, airMopAlways);
+    for (ti=0; ti<threadNum; ti++) {
+      task[ti].job = &job;
+      if (!ti) {
+        /* first thread uses the given context, as with one thread */
+        task[ti].tec = tec;
+        task[ti].all = all;
+      } else {
+        if (!( task[ti].tec = _tenEstimateContextCopy(tec) )) {
+          biffAddf(TEN, "%s: couldn't copy context for thread %u", me, ti);
+          airMopError(mop); return 1;
+        }
+        airMopAdd(mop, task[ti].tec, (airMopper)tenEstimateContextNix,
+                  airMopAlways);
+        task[ti].all = AIR_CALLOC(tec->allNum, double);
+        if (!task[ti].all) {
+          biffAddf(TEN, "%s: couldn't allocate values for thread %u",
+                   me, ti);
+          airMopError(mop); return 1;
+        }
+        airMopAdd(mop, task[ti].all, airFree, airMopAlways);
+      }
+      thread[ti] = airThreadNew();
+      airMopAdd(mop, thread[ti], (airMopper)airThreadNix, airMopAlways);
+    }
+    for (ti=0; ti<threadNum; ti++) {
+      if (airThreadStart(thread[ti], _tenEstimateVolumeWorker,
+                         AIR_CAST(void *, task + ti))) {
+        biffAddf(TEN, "%s: couldn't start thread %u", me, ti);
+        /* wait for the threads that did start */
+        airThreadMutexLock(job.mutex);
+        job.failed = AIR_TRUE;
+        airThreadMutexUnlock(job.mutex);
+        while (ti) {
+          airThreadJoin(thread[--ti], &ret);
+        }
+        airMopError(mop); return 1;
       }
     }
+    for (ti=0; ti<threadNum; ti++) {
+      airThreadJoin(thread[ti], &ret);
+    }
+    failed = job.failed;
+    failII = job.failII;
+  }
+  if (failed) {
+    biffAddf(TEN, "%s: failed at sample %s", me,
+             airSprintSize_t(stmp, failII));
+    airMopError(mop); return 1;
   }
   if (tec->progress) {
-    fprintf(stderr, "%s\n", airDoneStr(0, II, NN-1, doneStr));
+    fprintf(stderr, "%s\n", airDoneStr(0, job.NN, job.NN-1, doneStr));
   }
 
   ELL_4V_SET(axmap, -1, 1, 2, 3);
@@ -1041,12 +1041,151 @@ tenFiberMultiNix(tenFiberMulti *tfm) {
   return NULL;
 }
 
+/*
+** traces all directions from seeds seedLo through seedHi-1, into
+** fiberArr (an airArray of tenFiberSingle) starting at index *fibrNumP,
+** which is incremented for every fiber traced.  Existing entries of
+** fiberArr are re-used; it is only lengthened as needed.  On error,
+** *failSeedP is set to the index of the seed that failed
+*/
+static int
+_fiberMultiTraceRange(tenFiberContext *tfx, airArray *fiberArr,
+                      unsigned int *fibrNumP, unsigned int *failSeedP,
+                      const double *seedData, unsigned int seedLo,
+                      unsigned int seedHi, unsigned int seedNum) {
+  static const char me[]="_fiberMultiTraceRange";
+  tenFiberSingle *fiber;
+  double seed[3];
+  unsigned int seedIdx, fibrNum, dirNum, dirIdx;
+
+  /* HEY: the correctness of the use of the airArray here is quite subtle */
+  fibrNum = *fibrNumP;
+  for (seedIdx=seedLo; seedIdx<seedHi; seedIdx++) {
+    ELL_3V_COPY(seed, seedData + 3*seedIdx);
+    dirNum = tenFiberDirectionNumber(tfx, seed);
+    if (!dirNum) {
+      biffAddf(TEN, "%s: couldn't learn dirNum at seed (%g,%g,%g)", me,
+              seed[0], seed[1], seed[2]);
+      *failSeedP = seedIdx;
+      return 1;
+    }
+    for (dirIdx=0; dirIdx<dirNum; dirIdx++) {
+      if (tfx->verbose > 1) {
+        fprintf(stderr, "%s: dir %u/%u on seed %u/%u; len %u; # %u\n",
+                me, dirIdx, dirNum, seedIdx, seedNum,
+                fiberArr->len, fibrNum);
+      }
+      /* fiberArr->len can never be < fibrNum */
+      if (fiberArr->len == fibrNum) {
+        airArrayLenIncr(fiberArr, 1);
+      }
+      fiber = AIR_CAST(tenFiberSingle *, fiberArr->data) + fibrNum;
+      ELL_3V_COPY(fiber->seedPos, seed);
+      fiber->dirIdx = dirIdx;
+      fiber->dirNum = dirNum;
+      if (tenFiberSingleTrace(tfx, fiber, seed, dirIdx)) {
+        biffAddf(TEN, "%s: trouble on seed (%g,%g,%g) %u/%u, dir %u/%u", me,
+                seed[0], seed[1], seed[2], seedIdx, seedNum, dirIdx, dirNum);
+        *failSeedP = seedIdx;
+        return 1;
+      }
+      if (tfx->verbose) {
+        if (tenFiberStopUnknown == fiber->whyNowhere) {
+          fprintf(stderr, "%s: (%g,%g,%g) ->\n"
+                  "   steps = %u,%u; len = %g,%g; whyStop = %s,%s\n",
+                  me, seed[0], seed[1], seed[2],
+                  fiber->stepNum[0], fiber->stepNum[1],
+                  fiber->halfLen[0], fiber->halfLen[1],
+                  airEnumStr(tenFiberStop, fiber->whyStop[0]),
+                  airEnumStr(tenFiberStop, fiber->whyStop[1]));
+        } else {
+          fprintf(stderr, "%s: (%g,%g,%g) -> whyNowhere: %s\n",
+                  me, seed[0], seed[1], seed[2],
+                  airEnumStr(tenFiberStop, fiber->whyNowhere));
+        }
+      }
+      fibrNum++;
+    }
+  }
+  *fibrNumP = fibrNum;
+  return 0;
+}
+
+/*
+** everything about one multi-threaded tenFiberMultiTrace, shared by all
+** threads.  Seeds are claimed in chunks of "chunk" consecutive seeds; the
+** fibers from chunk ci are traced by thread chunkThread[ci] into its own
+** fiber array, starting at index chunkFiber[ci], chunkNum[ci] of them
+*/
+typedef struct {
+  const double *seedData;
+  unsigned int seedNum,    /* total number of seeds */
+    chunk,                 /* number of seeds claimed at once */
+    next,                  /* first seed not yet claimed */
+    *chunkThread, *chunkFiber, *chunkNum;
+  int failed;
+  unsigned int failSeed;   /* first seed (found) where tracing failed */
+  airThreadMutex *mutex;
+} _fiberMultiJob;
+
+typedef struct {
+  _fiberMultiJob *job;
+  unsigned int threadIdx;
+  tenFiberContext *tfx;    /* this thread's context */
+  airArray *fiberArr;      /* this thread's fibers */
+  unsigned int fibrNum;    /* number of fibers in fiberArr used so far */
+} _fiberMultiTask;
+
+static void *
+_fiberMultiWorker(void *_task) {
+  _fiberMultiTask *task;
+  _fiberMultiJob *job;
+  unsigned int lo, hi, ci, fibrLo, failSeed;
+
+  task = AIR_CAST(_fiberMultiTask *, _task);
+  job = task->job;
+  while (1) {
+    airThreadMutexLock(job->mutex);
+    if (job->failed || job->next == job->seedNum) {
+      airThreadMutexUnlock(job->mutex);
+      break;
+    }
+    lo = job->next;
+    hi = AIR_MIN(lo + job->chunk, job->seedNum);
+    job->next = hi;
+    airThreadMutexUnlock(job->mutex);
+    fibrLo = task->fibrNum;
+    if (_fiberMultiTraceRange(task->tfx, task->fiberArr, &(task->fibrNum),
+                              &failSeed, job->seedData, lo, hi,
+                              job->seedNum)) {
+      airThreadMutexLock(job->mutex);
+      if (!job->failed || failSeed < job->failSeed) {
+        job->failSeed = failSeed;
+      }
+      job->failed = AIR_TRUE;
+      airThreadMutexUnlock(job->mutex);
+      break;
+    }
+    ci = lo/job->chunk;
+    job->chunkThread[ci] = task->threadIdx;
+    job->chunkFiber[ci] = fibrLo;
+    job->chunkNum[ci] = task->fibrNum - fibrLo;
+  }
+  return _task;
+}
+
 /*
 ******** tenFiberMultiTrace
 **
 ** does tractography for a list of seedpoints
 **
 ** tfml has been returned from tenFiberMultiNew()
+**
+** With tfx->threadNum > 1 (see tenFiberThreadNumSet), chunks of seeds
+** are claimed by threads that each have their own copy of tfx (made by
+** tenFiberContextCopy) and their own fibers.  These are then moved into
+** tfml in seed order, so the result does not depend on the number of
+** threads.  tfx must have been through tenFiberUpdate().
 */
 int
 tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
@@ -1054,8 +1193,7 @@ tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
   static const char me[]="tenFiberMultiTrace";
   airArray *mop;
   const double *seedData;
-  double seed[3];
-  unsigned int seedNum, seedIdx, fibrNum, dirNum, dirIdx;
+  unsigned int seedNum, fibrNum, threadNum, failSeed;
   Nrrd *nseed;
 
   if (!(tfx && tfml && _nseed)) {
@@ -1083,57 +1221,127 @@ tenFiberMultiTrace(tenFiberContext *tfx, tenFiberMulti *tfml,
     airMopAdd(mop, nseed, AIR_CAST(airMopper, nrrdNuke), airMopAlways);
     if (nrrdConvert(nseed, _nseed, nrrdTypeDouble)) {
       biffMovef(TEN, NRRD, "%s: couldn't convert seed list", me);
-      return 1;
+      airMopError(mop); return 1;
     }
     seedData = AIR_CAST(const double *, nseed->data);
   }
 
-  /* HEY: the correctness of the use of the airArray here is quite subtle */
+  threadNum = AIR_MIN(tfx->threadNum, seedNum);
+  if (threadNum > 1 && !airThreadCapable) {
+    fprintf(stderr, "%s: WARNING: this Teem not thread capable: "
+            "will use 1 thread, not %u\n", me, threadNum);
+    threadNum = 1;
+  }
   fibrNum = 0;
-  for (seedIdx=0; seedIdx<seedNum; seedIdx++) {
-    dirNum = tenFiberDirectionNumber(tfx, seed);
-    if (!dirNum) {
-      biffAddf(TEN, "%s: couldn't learn dirNum at seed (%g,%g,%g)", me,
-              seed[0], seed[1], seed[2]);
-      return 1;
+  if (threadNum <= 1) {
+    if (_fiberMultiTraceRange(tfx, tfml->fiberArr, &fibrNum, &failSeed,
+                              seedData, 0, seedNum, seedNum)) {
+      biffAddf(TEN, "%s: trouble tracing", me);
+      airMopError(mop); return 1;
     }
-    for (dirIdx=0; dirIdx<dirNum; dirIdx++) {
-      if (tfx->verbose > 1) {
-        fprintf(stderr, "%s: dir %u/%u on seed %u/%u; len %u; # %u\n",
-                me, dirIdx, dirNum, seedIdx, seedNum,
-                tfml->fiberArr->len, fibrNum);
-      }
-      /* tfml->fiberArr->len can never be < fibrNum */
-      if (tfml->fiberArr->len == fibrNum) {
-        airArrayLenIncr(tfml->fiberArr, 1);
+  } else {
+    _fiberMultiJob job;
+    _fiberMultiTask *task;
+    airThread **thread;
+    tenFiberSingle *fsrc, *fdst, ftmp;
+    unsigned int ti, ci, chunkNum, fi;
+    void *ret;
+
+    job.seedData = seedData;
+    job.seedNum = seedNum;
+    /* small chunks, since fibers vary so much in length */
+    job.chunk = seedNum/(16*threadNum);
+    job.chunk = AIR_CLAMP(1, job.chunk, TEN_FIBER_INCR/4);
+    job.next = 0;
+    job.failed = AIR_FALSE;
+    job.failSeed = 0;
+    chunkNum = (seedNum + job.chunk - 1)/job.chunk;
+    job.chunkThread = AIR_CALLOC(chunkNum, unsigned int);
+    airMopAdd(mop, job.chunkThread, airFree, airMopAlways);
+    job.chunkFiber = AIR_CALLOC(chunkNum, unsigned int);
+    airMopAdd(mop, job.chunkFiber, airFree, airMopAlways);
+    job.chunkNum = AIR_CALLOC(chunkNum, unsigned int);
+    airMopAdd(mop, job.chunkNum, airFree, airMopAlways);
+    task = AIR_CALLOC(threadNum, _fiberMultiTask);
+    airMopAdd(mop, task, airFree, airMopAlways);
+    thread = AIR_CALLOC(threadNum, airThread *);
+    airMopAdd(mop, thread, airFree, airMopAlways);
+    if (!( job.chunkThread && job.chunkFiber && job.chunkNum
+           && task && thread )) {
+      biffAddf(TEN, "%s: couldn't allocate %u tasks", me, threadNum);
+      airMopError(mop); return 1;
+    }
+    job.mutex = airThreadMutexNew();
+    airMopAdd(mop, job.mutex, (airMopper)airThreadMutexNix, airMopAlways);
+    for (ti=0; ti<threadNum; ti++) {
+      task[ti].job = &job;
+      task[ti].threadIdx = ti;
+      task[ti].fibrNum = 0;
+      if (!ti) {
+        /* first thread uses the given context, as with one thread */
+        task[ti].tfx = tfx;
+      } else {
+        if (!( task[ti].tfx = tenFiberContextCopy(tfx) )) {
+          biffAddf(TEN, "%s: couldn't copy context for thread %u", me, ti);
+          airMopError(mop); return 1;
+        }
+        airMopAdd(mop, task[ti].tfx, (airMopper)tenFiberContextNix,
+                  airMopAlways);
       }
-      ELL_3V_COPY(tfml->fiber[fibrNum].seedPos, seedData + 3*seedIdx);
-      tfml->fiber[fibrNum].dirIdx = dirIdx;
-      tfml->fiber[fibrNum].dirNum = dirNum;
-      ELL_3V_COPY(seed, seedData + 3*seedIdx);
-      if (tenFiberSingleTrace(tfx, &(tfml->fiber[fibrNum]), seed, dirIdx)) {
-        biffAddf(TEN, "%s: trouble on seed (%g,%g,%g) %u/%u, dir %u/%u", me,
-                seed[0], seed[1], seed[2], seedIdx, seedNum, dirIdx, dirNum);
-        return 1;
+      task[ti].fiberArr = airArrayNew(NULL, NULL, sizeof(tenFiberSingle),
+                                      TEN_FIBER_INCR);
+      if (!task[ti].fiberArr) {
+        biffAddf(TEN, "%s: couldn't create fibers for thread %u", me, ti);
+        airMopError(mop); return 1;
       }
-      if (tfx->verbose) {
-        if (tenFiberStopUnknown == tfml->fiber[fibrNum].whyNowhere) {
-          fprintf(stderr, "%s: (%g,%g,%g) ->\n"
-                  "   steps = %u,%u; len = %g,%g; whyStop = %s,%s\n",
-                  me, seed[0], seed[1], seed[2],
-                  tfml->fiber[fibrNum].stepNum[0],
-                  tfml->fiber[fibrNum].stepNum[1],
-                  tfml->fiber[fibrNum].halfLen[0],
-                  tfml->fiber[fibrNum].halfLen[1],
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyStop[0]),
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyStop[1]));
-        } else {
-          fprintf(stderr, "%s: (%g,%g,%g) -> whyNowhere: %s\n",
-                  me, seed[0], seed[1], seed[2],
-                  airEnumStr(tenFiberStop, tfml->fiber[fibrNum].whyNowhere));
+      airArrayStructCB(task[ti].fiberArr,
+                       AIR_CAST(void (*)(void *), tenFiberSingleInit),
+                       AIR_CAST(void (*)(void *), tenFiberSingleDone));
+      airMopAdd(mop, task[ti].fiberArr, (airMopper)airArrayNuke,
+                airMopAlways);
+      thread[ti] = airThreadNew();
+      airMopAdd(mop, thread[ti], (airMopper)airThreadNix, airMopAlways);
+    }
+    for (ti=0; ti<threadNum; ti++) {
+      if (airThreadStart(thread[ti], _fiberMultiWorker,
+                         AIR_CAST(void *, task + ti))) {
+        biffAddf(TEN, "%s: couldn't start thread %u", me, ti);
+        /* wait for the threads that did start */
+        airThreadMutexLock(job.mutex);
+        job.failed = AIR_TRUE;
+        airThreadMutexUnlock(job.mutex);
+        while (ti) {
+          airThreadJoin(thread[--ti], &ret);
         }
+        airMopError(mop); return 1;
+      }
+    }
+    for (ti=0; ti<threadNum; ti++) {
+      airThreadJoin(thread[ti], &ret);
+    }
+    if (job.failed) {
+      biffAddf(TEN, "%s: trouble tracing from seed %u", me, job.failSeed);
+      airMopError(mop); return 1;
+    }
+    /* move the fibers into tfml in seed order, by swapping structs, so
+       that each nvert and nval stays owned by exactly one array */
+    for (ci=0; ci<chunkNum; ci++) {
+      fibrNum += job.chunkNum[ci];
+    }
+    if (tfml->fiberArr->len < fibrNum) {
+      airArrayLenSet(tfml->fiberArr, fibrNum);
+    }
+    fdst = tfml->fiber;
+    for (ci=0; ci<chunkNum; ci++) {
+      fsrc = (AIR_CAST(tenFiberSingle *,
+                       task[job.chunkThread[ci]].fiberArr->data)
+              + job.chunkFiber[ci]);
+      for (fi=0; fi<job.chunkNum[ci]; fi++) {
+        ftmp = *fdst;
+        *fdst = fsrc[fi];
+        fsrc[fi] = ftmp;
+        fdst++;
       }
-      fibrNum++;
     }
   }
   /* if the airArray got to be its length only because of the work above,
@@ -177,6 +177,7 @@ _tenFiberContextCommonNew(const Nrrd *vol, int useDwi,
   tfx->minRadius = 1;    /* above lament applies here as well */
   tfx->minFraction = 0.5; /* and here */
   tfx->wPunct = tenDefFiberWPunct;
+  tfx->threadNum = 1;
 
   GAGE_QUERY_RESET(tfx->query);
   tfx->mframe[0] = vol->measurementFrame[0][0];
@@ -247,6 +248,24 @@ tenFiberVerboseSet(tenFiberContext *tfx, int verbose) {
   return;
 }
 
+int
+tenFiberThreadNumSet(tenFiberContext *tfx, unsigned int threadNum) {
+  static const char me[]="tenFiberThreadNumSet";
+
+  if (!tfx) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return 1;
+  }
+  if (!threadNum) {
+    biffAddf(TEN, "%s: need threadNum >= 1", me);
+    return 1;
+  }
+
+  tfx->threadNum = threadNum;
+
+  return 0;
+}
+
 int
 tenFiberTypeSet(tenFiberContext *tfx, int ftype) {
   static const char me[]="tenFiberTypeSet";
@@ -829,41 +848,56 @@ tenFiberUpdate(tenFiberContext *tfx) {
 /*
 ** exact same precautions about utility of this as with gageContextCopy!!!
 ** So: only after tenFiberUpdate, and don't touch anything, and don't
-** call anything except tenFiberTrace and tenFiberContextNix
+** call anything except tenFiberTrace, tenFiberSingleTrace, and
+** tenFiberContextNix
+**
+** The gage answer pointers are re-based from the old pervolume answer
+** array onto the new one, rather than being re-learned from the fiber
+** and anisotropy types, so that this works the same for tensor and DWI
+** contexts.
 */
+#define _FIBER_ANS_REBASE(ptr, opvl, npvl) \
+  ((ptr) ? (npvl)->answer + ((ptr) - (opvl)->answer) : NULL)
+
 tenFiberContext *
 tenFiberContextCopy(tenFiberContext *oldTfx) {
   static const char me[]="tenFiberContextCopy";
   tenFiberContext *tfx;
+  gagePerVolume *opvl, *npvl;
 
-  if (oldTfx->useDwi) {
-    fprintf(stderr, "!%s: sorry, can't copy DWI contexts; bye.\n", me);
-    exit(1);
+  if (!oldTfx) {
+    biffAddf(TEN, "%s: got NULL pointer", me);
+    return NULL;
   }
   tfx = AIR_CALLOC(1, tenFiberContext);
+  if (!tfx) {
+    biffAddf(TEN, "%s: couldn't allocate context", me);
+    return NULL;
+  }
   memcpy(tfx, oldTfx, sizeof(tenFiberContext));
   tfx->ksp = nrrdKernelSpecCopy(oldTfx->ksp);
   tfx->gtx = gageContextCopy(oldTfx->gtx);
-  tfx->pvl = tfx->gtx->pvl[0];  /* HEY! gage API sucks */
-  tfx->gageTen = gageAnswerPointer(tfx->gtx, tfx->pvl, tenGageTensor);
-  tfx->gageEval = gageAnswerPointer(tfx->gtx, tfx->pvl, tenGageEval0);
-  /* HEY: COPY AND PASTE */
-  tfx->gageEvec
-    = gageAnswerPointer(tfx->gtx, tfx->pvl,
-                        (tenFiberTypeEvec0 == tfx->fiberType
-                         ? tenGageEvec0
-                         : (tenFiberTypeEvec1 == tfx->fiberType
-                            ? tenGageEvec1
-                            : tenGageEvec2)));
-  tfx->gageAnisoStop = gageAnswerPointer(tfx->gtx, tfx->pvl,
-                                         tfx->anisoStopType);
-  tfx->gageAnisoSpeed = (tfx->anisoSpeedType
-                         ? gageAnswerPointer(tfx->gtx, tfx->pvl,
-                                             tfx->anisoSpeedType)
-                         : NULL);
+  if (!(tfx->ksp && tfx->gtx)) {
+    biffMovef(TEN, GAGE, "%s: couldn't copy kernel or gage context", me);
+    nrrdKernelSpecNix(tfx->ksp);
+    gageContextNix(tfx->gtx);
+    free(tfx);
+    return NULL;
+  }
+  opvl = oldTfx->pvl;
+  npvl = tfx->pvl = tfx->gtx->pvl[0];  /* HEY! gage API sucks */
+  tfx->gageTen = _FIBER_ANS_REBASE(oldTfx->gageTen, opvl, npvl);
+  tfx->gageEval = _FIBER_ANS_REBASE(oldTfx->gageEval, opvl, npvl);
+  tfx->gageEvec = _FIBER_ANS_REBASE(oldTfx->gageEvec, opvl, npvl);
+  tfx->gageAnisoStop = _FIBER_ANS_REBASE(oldTfx->gageAnisoStop, opvl, npvl);
+  tfx->gageAnisoSpeed = _FIBER_ANS_REBASE(oldTfx->gageAnisoSpeed,
+                                          opvl, npvl);
+  tfx->gageTen2 = _FIBER_ANS_REBASE(oldTfx->gageTen2, opvl, npvl);
   return tfx;
 }
 
+#undef _FIBER_ANS_REBASE
+
 tenFiberContext *
 tenFiberContextNix(tenFiberContext *tfx) {
 
@@ -832,6 +832,7 @@ typedef struct {
     minFraction;        /* minimum fractional constituency in multi-tensor */
   double wPunct;        /* knob for tensor lines */
   unsigned int ten2Which;  /* which path to follow in 2-tensor tracking */
+  unsigned int threadNum;  /* number of threads tenFiberMultiTrace uses */
   /* ---- internal ----- */
   gageQuery query;      /* query we'll send to gageQuerySet */
   int halfIdx,          /* current fiber half being computed (0 or 1) */
@@ -1044,7 +1045,9 @@ typedef struct {
     negEvalShift,          /* if non-zero, shift eigenvalues upwards so that
                               smallest one is non-negative */
     progress;              /* progress indication for volume processing */
-  unsigned int WLSIterNum; /* number of iterations for WLS */
+  unsigned int WLSIterNum, /* number of iterations for WLS */
+    threadNum;             /* number of threads to use in
+                              tenEstimate1TensorVolume4D */
   /* internal -------- */
   /* a "dwi" in here is basically any value (diffusion-weighted or not)
      that varies as a function of the model parameters being estimated */
@@ -1472,6 +1475,8 @@ TEN_EXPORT int tenEstimateSkipSet(tenEstimateContext *tec,
                                   unsigned int valIdx,
                                   int doSkip);
 TEN_EXPORT int tenEstimateSkipReset(tenEstimateContext *tec);
+TEN_EXPORT int tenEstimateThreadNumSet(tenEstimateContext *tec,
+                                       unsigned int threadNum);
 TEN_EXPORT int tenEstimateThresholdFind(double *threshP, unsigned char *isB0,
                                         Nrrd *nin4d);
 TEN_EXPORT int tenEstimateThresholdSet(tenEstimateContext *tec,
@@ -1556,6 +1561,8 @@ TEN_EXPORT tenFiberContext *tenFiberContextDwiNew(const Nrrd *dwivol,
                                                   int ten1method,
                                                   int ten2method);
 TEN_EXPORT void tenFiberVerboseSet(tenFiberContext *tfx, int verbose);
+TEN_EXPORT int tenFiberThreadNumSet(tenFiberContext *tfx,
+                                    unsigned int threadNum);
 TEN_EXPORT int tenFiberTypeSet(tenFiberContext *tfx, int type);
 TEN_EXPORT int tenFiberKernelSet(tenFiberContext *tfx,
                                  const NrrdKernel *kern,
@@ -46,7 +46,7 @@ tend_estimMain(int argc, const char **argv, const char *me,
   char *outS, *terrS, *bmatS, *eb0S;
   float soft, scale, sigma;
   int dwiax, EE, knownB0, oldstuff, estmeth, verbose, fixneg;
-  unsigned int ninLen, axmap[4], wlsi, *skip, skipNum, skipIdx;
+  unsigned int ninLen, axmap[4], wlsi, *skip, skipNum, skipIdx, threadNum;
   double valueMin, thresh;
 
   Nrrd *ngradKVP=NULL, *nbmatKVP=NULL;
@@ -68,6 +68,9 @@ tend_estimMain(int argc, const char **argv, const char *me,
   hestOptAdd(&hopt, "wlsi", "WLS iters", airTypeUInt, 1, 1, &wlsi, "1",
              "when using weighted-least-squares (\"-est wls\"), how "
              "many iterations to do after the initial weighted fit.");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to estimate with (not used with \"-old\"). "
+             "The output doesn't depend on the number of threads.");
   hestOptAdd(&hopt, "fixneg", NULL, airTypeInt, 0, 0, &fixneg, NULL,
              "after estimating the tensor, ensure that there are no negative "
              "eigenvalues by adding (to all eigenvalues) the amount by which "
@@ -271,6 +274,7 @@ tend_estimMain(int argc, const char **argv, const char *me,
     if (!EE) EE |= tenEstimateMethodSet(tec, estmeth);
     if (!EE) EE |= tenEstimateBMatricesSet(tec, nbmat, bval, !knownB0);
     if (!EE) EE |= tenEstimateValueMinSet(tec, valueMin);
+    if (!EE) EE |= tenEstimateThreadNumSet(tec, threadNum);
     for (skipIdx=0; skipIdx<skipNum; skipIdx++) {
       /* fprintf(stderr, "%s: skipping %u\n", me, skip[skipIdx]); */
       if (!EE) EE |= tenEstimateSkipSet(tec, skip[skipIdx], AIR_TRUE);
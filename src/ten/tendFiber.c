@@ -47,7 +47,7 @@ tend_fiberMain(int argc, const char **argv, const char *me,
   int E, intg, useDwi, allPaths, verbose, worldSpace, worldSpaceOut,
     ftype, ftypeDef;
   Nrrd *nin, *nseed, *nmat, *_nmat;
-  unsigned int si, stopLen, whichPath;
+  unsigned int si, stopLen, whichPath, threadNum;
   double matx[16]={1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
   tenFiberMulti *tfml;
   limnPolyData *fiberPld;
@@ -79,6 +79,9 @@ tend_fiberMain(int argc, const char **argv, const char *me,
              "follow all paths from (all) seedpoint(s), output will be "
              "polydata, rather than a single 3-by-N nrrd, even if only "
              "a single path is generated");
+  hestOptAdd(&hopt, "nt", "# threads", airTypeUInt, 1, 1, &threadNum, "1",
+             "number of threads to trace with (only used with \"-ap\"). "
+             "The output doesn't depend on the number of threads.");
   hestOptAdd(&hopt, "wspo", NULL, airTypeInt, 0, 0, &worldSpaceOut, NULL,
              "output should be in worldspace, even if input is not "
              "(this feature is unstable and/or confusing)");
@@ -218,6 +221,7 @@ tend_fiberMain(int argc, const char **argv, const char *me,
   if (!E) E |= tenFiberParmSet(tfx, tenFiberParmStepSize, step);
   if (!E) E |= tenFiberParmSet(tfx, tenFiberParmUseIndexSpace,
                                worldSpace ? AIR_FALSE: AIR_TRUE);
+  if (!E) E |= tenFiberThreadNumSet(tfx, threadNum);
   if (!E) E |= tenFiberUpdate(tfx);
   if (E) {
     airMopAdd(mop, err = biffGetDone(TEN), airFree, airMopAlways);
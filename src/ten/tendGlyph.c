@@ -305,6 +305,10 @@ tend_glyphMain(int argc, const char **argv, const char *me,
                "(* ray-traced only *) "
                "number of threads to be used for rendering");
   }
+  hestOptAdd(&hopt, "bvh", "bool", airTypeBool, 1, 1, &(eparm->bvh), "true",
+             "(* ray-traced only *) "
+             "build a bounding volume hierarchy over the glyphs (with the "
+             "surface area heuristic) to speed up rendering of many glyphs");
   hestOptAdd(&hopt, "al", "B U V N E", airTypeFloat, 5, 5, buvne,
              "0 -1 -1 -4 0.7",
              "(* ray-traced only *) "
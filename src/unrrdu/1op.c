@@ -27,18 +27,49 @@
 #define INFO "Unary operation on a nrrd"
 static const char *_unrrdu_1opInfoL =
   (INFO
-   ".\n "
+   ". With \"-stream\", works on slabs of the input at a time.\n "
    "* Uses nrrdArithUnaryOp");
 
+typedef struct {
+  int op, type;
+  Nrrd *ntmp;
+} _unrrdu_1opParm;
+
+static int
+_unrrdu_1opSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_1opSlab";
+  _unrrdu_1opParm *parm;
+  const Nrrd *ntmp;
+
+  parm = AIR_CAST(_unrrdu_1opParm *, _parm);
+  if (nrrdTypeDefault != parm->type) {
+    /* they requested conversion to another type prior to the 1op */
+    if (nrrdConvert(parm->ntmp, nin[0], parm->type)) {
+      biffAddf(NRRD, "%s: error converting input nrrd", me);
+      return 1;
+    }
+    ntmp = parm->ntmp;
+  } else {
+    ntmp = nin[0];
+  }
+  if (nrrdArithUnaryOp(nout, parm->op, ntmp)) {
+    biffAddf(NRRD, "%s: error doing unary operation", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_1opMain(int argc, const char **argv, const char *me,
                hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err, *seedS;
-  Nrrd *nin, *nout, *ntmp=NULL;
+  char *inS, *out, *err, *seedS;
+  Nrrd *nin, *nout;
   int op, pret, type;
   airArray *mop;
-  unsigned int seed;
+  unsigned int seed, threadNum;
+  double slabMB;
+  _unrrdu_1opParm parm;
 
   hestOptAdd(&opt, NULL, "operator", airTypeEnum, 1, 1, &op, NULL,
              "Unary operator. Possibilities include:\n "
@@ -75,7 +106,13 @@ unrrdu_1opMain(int argc, const char **argv, const char *me,
              "(not using this option), the types of "
              "the input nrrds are left unchanged.",
              NULL, NULL, &unrrduHestMaybeTypeCB);
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
+  hestOptAdd(&opt, "nt,threadnum", "# thr", airTypeUInt, 1, 1, &threadNum,
+             "0", "number of threads to use; 0 means to use "
+             "nrrdDefaultThreadNum, which can be set with the "
+             "NRRD_DEFAULT_THREAD_NUM environment variable. The output "
+             "doesn't depend on this.");
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -84,22 +121,14 @@ unrrdu_1opMain(int argc, const char **argv, const char *me,
   USAGE(_unrrdu_1opInfoL);
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
-
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
-  if (nrrdTypeDefault != type) {
-    /* they requested conversion to another type prior to the 1op */
-    airMopAdd(mop, ntmp=nrrdNew(), (airMopper)nrrdNuke, airMopAlways);
-    if (nrrdConvert(ntmp, nin, type)) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: error converting input nrrd:\n%s", me, err);
-      airMopError(mop);
-      return 1;
-    }
-  } else {
-    ntmp = nin;
+  if (threadNum) {
+    nrrdDefaultThreadNum = threadNum;
   }
+
+  parm.op = op;
+  parm.type = type;
+  parm.ntmp = nrrdNew();
+  airMopAdd(mop, parm.ntmp, (airMopper)nrrdNuke, airMopAlways);
   /* see note in 2op.c about the hazards of trying to be clever
   ** about minimizing the seeding of the RNG
   ** if (nrrdUnaryOpRand == op
@@ -117,14 +146,31 @@ unrrdu_1opMain(int argc, const char **argv, const char *me,
     /* got no request for specific seed */
     airSrandMT(AIR_CAST(unsigned int, airTime()));
   }
-  if (nrrdArithUnaryOp(nout, op, ntmp)) {
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_1opSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_1opSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error doing unary operation:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
-  /* if we had to create ntmp with nrrdConvert, it will be mopped,
-     otherwise ntmp is an alias for nin, which will also be mopped */
 
   SAVE(out, nout, NULL);
 
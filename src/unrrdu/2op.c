@@ -30,19 +30,69 @@ static const char *_unrrdu_2opInfoL =
  ". Either the first or second operand can be a float constant, "
  "but not both.  Use \"-\" for an operand to signify "
  "a nrrd to be read from stdin (a pipe).  Note, however, "
- "that \"-\" can probably only be used once (reliably).\n "
+ "that \"-\" can probably only be used once (reliably). "
+ "With \"-stream\", works on slabs of the input(s) at a time.\n "
  "* Uses nrrdArithIterBinaryOp or (with -w) nrrdArithIterBinaryOpSelect");
 
+typedef struct {
+  int op, type, which,
+    isNrrd[2];          /* else operand is val[] */
+  double val[2];
+} _unrrdu_2opParm;
+
+/* nin[] are only the operands that are nrrds */
+static int
+_unrrdu_2opSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_2opSlab";
+  _unrrdu_2opParm *parm;
+  NrrdIter *in[2];
+  Nrrd *ntmp;
+  unsigned int ii, ni;
+  airArray *mop;
+
+  parm = AIR_CAST(_unrrdu_2opParm *, _parm);
+  mop = airMopNew();
+  for (ii=0, ni=0; ii<2; ii++) {
+    in[ii] = nrrdIterNew();
+    airMopAdd(mop, in[ii], (airMopper)nrrdIterNix, airMopAlways);
+    if (!parm->isNrrd[ii]) {
+      nrrdIterSetValue(in[ii], parm->val[ii]);
+    } else if (nrrdTypeDefault != parm->type) {
+      /* they wanted to convert nrrds to some other type first */
+      ntmp = nrrdNew();
+      airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+      if (nrrdConvert(ntmp, nin[ni++], parm->type)) {
+        biffAddf(NRRD, "%s: error converting input nrrd %u", me, ii);
+        airMopError(mop); return 1;
+      }
+      nrrdIterSetNrrd(in[ii], ntmp);
+    } else {
+      nrrdIterSetNrrd(in[ii], nin[ni++]);
+    }
+  }
+  if (-1 == parm->which
+      ? nrrdArithIterBinaryOp(nout, parm->op, in[0], in[1])
+      : nrrdArithIterBinaryOpSelect(nout, parm->op, in[0], in[1],
+                                    AIR_CAST(unsigned int, parm->which))) {
+    biffAddf(NRRD, "%s: error doing binary operation", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 int
 unrrdu_2opMain(int argc, const char **argv, const char *me,
                hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err, *seedS;
-  NrrdIter *in1, *in2;
-  Nrrd *nout, *ntmp=NULL;
-  int op, type, E, pret, which;
+  char *out, *err, *seedS, *inS[2], perr[AIR_STRLEN_HUGE];
+  NrrdIter *in[2];
+  Nrrd *nout, *nin[2];
+  int op, type, pret, which;
   airArray *mop;
-  unsigned int seed;
+  unsigned int ii, ninNum, seed, threadNum;
+  double slabMB;
+  _unrrdu_2opParm parm;
 
   hestOptAdd(&opt, NULL, "operator", airTypeEnum, 1, 1, &op, NULL,
              "Binary operator. Possibilities include:\n "
@@ -70,12 +120,10 @@ unrrdu_2opMain(int argc, const char **argv, const char *me,
              "\b\bo \"rrand\": sample Rician distribution with 1st value "
              "for \"true\" mean, and 2nd value for sigma",
              NULL, nrrdBinaryOp);
-  hestOptAdd(&opt, NULL, "in1", airTypeOther, 1, 1, &in1, NULL,
-             "First input.  Can be a single value or a nrrd.",
-             NULL, NULL, nrrdHestIter);
-  hestOptAdd(&opt, NULL, "in2", airTypeOther, 1, 1, &in2, NULL,
-             "Second input.  Can be a single value or a nrrd.",
-             NULL, NULL, nrrdHestIter);
+  hestOptAdd(&opt, NULL, "in1", airTypeString, 1, 1, inS + 0, NULL,
+             "First input.  Can be a single value or a nrrd.");
+  hestOptAdd(&opt, NULL, "in2", airTypeString, 1, 1, inS + 1, NULL,
+             "Second input.  Can be a single value or a nrrd.");
   hestOptAdd(&opt, "s,seed", "seed", airTypeString, 1, 1, &seedS, "",
              "seed value for RNG for nrand, so that you "
              "can get repeatable results between runs, or, "
@@ -92,6 +140,12 @@ unrrdu_2opMain(int argc, const char **argv, const char *me,
              "Which argument (0 or 1) should be used to determine the "
              "shape of the output nrrd. By default (not using this option), "
              "the first non-constant argument is used. ");
+  hestOptAdd(&opt, "nt,threadnum", "# thr", airTypeUInt, 1, 1, &threadNum,
+             "0", "number of threads to use; 0 means to use "
+             "nrrdDefaultThreadNum, which can be set with the "
+             "NRRD_DEFAULT_THREAD_NUM environment variable. The output "
+             "doesn't depend on this.");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -100,35 +154,13 @@ unrrdu_2opMain(int argc, const char **argv, const char *me,
   USAGE(_unrrdu_2opInfoL);
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
-
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
-  /*
-  fprintf(stderr, "%s: op = %d\n", me, op);
-  fprintf(stderr, "%s: in1->left = %d, in2->left = %d\n", me,
-          (int)(in1->left), (int)(in2->left));
-  */
-  if (nrrdTypeDefault != type) {
-    /* they wanted to convert nrrds to some other type first */
-    E = 0;
-    if (in1->ownNrrd) {
-      if (!E) E |= nrrdConvert(ntmp=nrrdNew(), in1->ownNrrd, type);
-      if (!E) nrrdIterSetOwnNrrd(in1, ntmp);
-    }
-    if (in2->ownNrrd) {
-      if (!E) E |= nrrdConvert(ntmp=nrrdNew(), in2->ownNrrd, type);
-      if (!E) nrrdIterSetOwnNrrd(in2, ntmp);
-    }
-    if (E) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: error converting input nrrd(s):\n%s", me, err);
-      airMopError(mop);
-      return 1;
-    }
-    /* this will still leave a nrrd in the NrrdIter for nrrdIterNix()
-       (called by hestParseFree() called be airMopOkay()) to clear up */
+  if (threadNum) {
+    nrrdDefaultThreadNum = threadNum;
   }
+
+  parm.op = op;
+  parm.type = type;
+  parm.which = which;
   /*
   ** Used to only deal with RNG seed for particular op:
   **   if (nrrdBinaryOpNormalRandScaleAdd == op) {
@@ -151,12 +183,48 @@ unrrdu_2opMain(int argc, const char **argv, const char *me,
     /* got no request for specific seed */
     airSrandMT(AIR_CAST(unsigned int, airTime()));
   }
-  if (-1 == which
-      ? nrrdArithIterBinaryOp(nout, op, in1, in2)
-      : nrrdArithIterBinaryOpSelect(nout, op, in1, in2,
-                                    AIR_CAST(unsigned int, which))) {
+
+  if (slabMB > 0) {
+    NrrdStream *nst[2], *nsin[2], *nsout;
+    if (!strcmp("-", inS[0]) && !strcmp("-", inS[1])) {
+      fprintf(stderr, "%s: can't stream both inputs from stdin\n", me);
+      airMopError(mop);
+      return 1;
+    }
+    ninNum = 0;
+    for (ii=0; ii<2; ii++) {
+      LOAD_STREAM_OPERAND(inS[ii], nst[ii], parm.isNrrd[ii], parm.val[ii]);
+      if (parm.isNrrd[ii]) {
+        nsin[ninNum++] = nst[ii];
+      }
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, nsin, ninNum, slabMB,
+                          _unrrdu_2opSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  ninNum = 0;
+  for (ii=0; ii<2; ii++) {
+    LOAD_OPERAND(inS[ii], in[ii]);
+    parm.isNrrd[ii] = !!in[ii]->ownNrrd;
+    parm.val[ii] = in[ii]->val;
+    if (parm.isNrrd[ii]) {
+      nin[ninNum++] = in[ii]->ownNrrd;
+    }
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_2opSlab(nout, nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error doing binary operation:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
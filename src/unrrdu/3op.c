@@ -30,18 +30,69 @@ static const char *_unrrdu_3opInfoL =
  ". Can have one, two, or three nrrds, but not zero. "
  "Use \"-\" for an operand to signify "
  "a nrrd to be read from stdin (a pipe).  Note, however, "
- "that \"-\" can probably only be used once (reliably).\n "
+ "that \"-\" can probably only be used once (reliably). "
+ "With \"-stream\", works on slabs of the input(s) at a time.\n "
  "* Uses nrrdArithIterTernaryOp or (with -w) nrrdArithIterTernaryOpSelect");
 
+typedef struct {
+  int op, type, which,
+    isNrrd[3];          /* else operand is val[] */
+  double val[3];
+} _unrrdu_3opParm;
+
+/* nin[] are only the operands that are nrrds */
+static int
+_unrrdu_3opSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_3opSlab";
+  _unrrdu_3opParm *parm;
+  NrrdIter *in[3];
+  Nrrd *ntmp;
+  unsigned int ii, ni;
+  airArray *mop;
+
+  parm = AIR_CAST(_unrrdu_3opParm *, _parm);
+  mop = airMopNew();
+  for (ii=0, ni=0; ii<3; ii++) {
+    in[ii] = nrrdIterNew();
+    airMopAdd(mop, in[ii], (airMopper)nrrdIterNix, airMopAlways);
+    if (!parm->isNrrd[ii]) {
+      nrrdIterSetValue(in[ii], parm->val[ii]);
+    } else if (nrrdTypeDefault != parm->type) {
+      /* they wanted to convert nrrds to some other type first */
+      ntmp = nrrdNew();
+      airMopAdd(mop, ntmp, (airMopper)nrrdNuke, airMopAlways);
+      if (nrrdConvert(ntmp, nin[ni++], parm->type)) {
+        biffAddf(NRRD, "%s: error converting input nrrd %u", me, ii);
+        airMopError(mop); return 1;
+      }
+      nrrdIterSetNrrd(in[ii], ntmp);
+    } else {
+      nrrdIterSetNrrd(in[ii], nin[ni++]);
+    }
+  }
+  if (-1 == parm->which
+      ? nrrdArithIterTernaryOp(nout, parm->op, in[0], in[1], in[2])
+      : nrrdArithIterTernaryOpSelect(nout, parm->op, in[0], in[1], in[2],
+                                     AIR_CAST(unsigned int, parm->which))) {
+    biffAddf(NRRD, "%s: error doing ternary operation", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 int
 unrrdu_3opMain(int argc, const char **argv, const char *me,
                hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
-  NrrdIter *in1, *in2, *in3;
-  Nrrd *nout, *ntmp=NULL;
-  int op, type, E, pret, which;
+  char *out, *err, *inS[3], perr[AIR_STRLEN_HUGE];
+  NrrdIter *in[3];
+  Nrrd *nout, *nin[3];
+  int op, type, pret, which;
+  unsigned int ii, ninNum, threadNum;
+  double slabMB;
   airArray *mop;
+  _unrrdu_3opParm parm;
 
   hestOptAdd(&opt, NULL, "operator", airTypeEnum, 1, 1, &op, NULL,
              "Ternary operator. Possibilities include:\n "
@@ -73,15 +124,12 @@ unrrdu_3opMain(int argc, const char **argv, const char *me,
              "\b\bo \"rician\": evaluate (at 1st value) Rician with mean=2nd "
              "and stdv=3rd value",
              NULL, nrrdTernaryOp);
-  hestOptAdd(&opt, NULL, "in1", airTypeOther, 1, 1, &in1, NULL,
-             "First input.  Can be a single value or a nrrd.",
-             NULL, NULL, nrrdHestIter);
-  hestOptAdd(&opt, NULL, "in2", airTypeOther, 1, 1, &in2, NULL,
-             "Second input.  Can be a single value or a nrrd.",
-             NULL, NULL, nrrdHestIter);
-  hestOptAdd(&opt, NULL, "in3", airTypeOther, 1, 1, &in3, NULL,
-             "Third input.  Can be a single value or a nrrd.",
-             NULL, NULL, nrrdHestIter);
+  hestOptAdd(&opt, NULL, "in1", airTypeString, 1, 1, inS + 0, NULL,
+             "First input.  Can be a single value or a nrrd.");
+  hestOptAdd(&opt, NULL, "in2", airTypeString, 1, 1, inS + 1, NULL,
+             "Second input.  Can be a single value or a nrrd.");
+  hestOptAdd(&opt, NULL, "in3", airTypeString, 1, 1, inS + 2, NULL,
+             "Third input.  Can be a single value or a nrrd.");
   hestOptAdd(&opt, "t,type", "type", airTypeOther, 1, 1, &type, "default",
              "type to convert all nrrd inputs to, prior to "
              "doing operation.  This also determines output type. "
@@ -92,6 +140,12 @@ unrrdu_3opMain(int argc, const char **argv, const char *me,
              "Which argument (0, 1, or 2) should be used to determine the "
              "shape of the output nrrd. By default (not using this option), "
              "the first non-constant argument is used. ");
+  hestOptAdd(&opt, "nt,threadnum", "# thr", airTypeUInt, 1, 1, &threadNum,
+             "0", "number of threads to use; 0 means to use "
+             "nrrdDefaultThreadNum, which can be set with the "
+             "NRRD_DEFAULT_THREAD_NUM environment variable. The output "
+             "doesn't depend on this.");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -100,49 +154,62 @@ unrrdu_3opMain(int argc, const char **argv, const char *me,
   USAGE(_unrrdu_3opInfoL);
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
+  if (threadNum) {
+    nrrdDefaultThreadNum = threadNum;
+  }
 
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  parm.op = op;
+  parm.type = type;
+  parm.which = which;
 
-  /*
-  fprintf(stderr, "%s: op = %d\n", me, op);
-  fprintf(stderr, "%s: in1->left = %d, in2->left = %d\n", me,
-          (int)(in1->left), (int)(in2->left));
-  */
-  if (nrrdTypeDefault != type) {
-    /* they wanted to convert nrrds to some other type first */
-    E = 0;
-    if (in1->ownNrrd) {
-      if (!E) E |= nrrdConvert(ntmp=nrrdNew(), in1->ownNrrd, type);
-      if (!E) nrrdIterSetOwnNrrd(in1, ntmp);
+  /* HEY: will need to add handling of RNG seed (as in 1op and 2op)
+     if there are any 3ops involving random numbers */
+
+  if (slabMB > 0) {
+    NrrdStream *nst[3], *nsin[3], *nsout;
+    for (ninNum=0, ii=0; ii<3; ii++) {
+      ninNum += !strcmp("-", inS[ii]);
     }
-    if (in2->ownNrrd) {
-      if (!E) E |= nrrdConvert(ntmp=nrrdNew(), in2->ownNrrd, type);
-      if (!E) nrrdIterSetOwnNrrd(in2, ntmp);
+    if (ninNum > 1) {
+      fprintf(stderr, "%s: can't stream more than one input from stdin\n",
+              me);
+      airMopError(mop);
+      return 1;
     }
-    if (in3->ownNrrd) {
-      if (!E) E |= nrrdConvert(ntmp=nrrdNew(), in3->ownNrrd, type);
-      if (!E) nrrdIterSetOwnNrrd(in3, ntmp);
+    ninNum = 0;
+    for (ii=0; ii<3; ii++) {
+      LOAD_STREAM_OPERAND(inS[ii], nst[ii], parm.isNrrd[ii], parm.val[ii]);
+      if (parm.isNrrd[ii]) {
+        nsin[ninNum++] = nst[ii];
+      }
     }
-    if (E) {
-      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-      fprintf(stderr, "%s: error converting input nrrd(s):\n%s", me, err);
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, nsin, ninNum, slabMB,
+                          _unrrdu_3opSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
       airMopError(mop);
       return 1;
     }
-    /* this will still leave a nrrd in the NrrdIter for nrrdIterNix()
-       (called by hestParseFree() called be airMopOkay()) to clear up */
+    airMopOkay(mop);
+    return 0;
   }
 
-  /* HEY: will need to add handling of RNG seed (as in 1op and 2op)
-     if there are any 3ops involving random numbers */
-
-  if (-1 == which
-      ? nrrdArithIterTernaryOp(nout, op, in1, in2, in3)
-      : nrrdArithIterTernaryOpSelect(nout, op, in1, in2, in3,
-                                     AIR_CAST(unsigned int, which))) {
+  ninNum = 0;
+  for (ii=0; ii<3; ii++) {
+    LOAD_OPERAND(inS[ii], in[ii]);
+    parm.isNrrd[ii] = !!in[ii]->ownNrrd;
+    parm.val[ii] = in[ii]->val;
+    if (parm.isNrrd[ii]) {
+      nin[ninNum++] = in[ii]->ownNrrd;
+    }
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_3opSlab(nout, nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error doing ternary operation:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
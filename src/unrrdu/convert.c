@@ -34,22 +34,49 @@ static const char *_unrrdu_convertInfoL =
  "with \"-clamp\". "
  "See also \"unu quantize\","
  "\"unu 2op x\", and \"unu 3op clamp\".\n "
+ "With \"-stream\", works on slabs of the input at a time.\n "
  "* Uses nrrdConvert or nrrdClampConvert");
 
+typedef struct {
+  int type, doClamp;
+} _unrrdu_convertParm;
+
+static int
+_unrrdu_convertSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_convertSlab";
+  _unrrdu_convertParm *parm;
+  int E;
+
+  parm = AIR_CAST(_unrrdu_convertParm *, _parm);
+  if (parm->doClamp) {
+    E = nrrdClampConvert(nout, nin[0], parm->type);
+  } else {
+    E = nrrdConvert(nout, nin[0], parm->type);
+  }
+  if (E) {
+    biffAddf(NRRD, "%s: error converting nrrd", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_convertMain(int argc, const char **argv, const char *me,
                    hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout;
-  int type, pret, E, doClamp;
+  int type, pret, doClamp;
+  double slabMB;
   airArray *mop;
+  _unrrdu_convertParm parm;
 
   OPT_ADD_TYPE(type, "type to convert to", NULL);
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
   hestOptAdd(&opt, "clamp", NULL, airTypeInt, 0, 0, &doClamp, NULL,
              "clamp input values to representable range of values of "
              "output type, to avoid wrap-around problems");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -59,17 +86,30 @@ unrrdu_convertMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
+  parm.type = type;
+  parm.doClamp = doClamp;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_convertSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
   nout = nrrdNew();
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
-  if (doClamp) {
-    E = nrrdClampConvert(nout, nin, type);
-  } else {
-    E = nrrdConvert(nout, nin, type);
-  }
-  if (E) {
+  if (_unrrdu_convertSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error converting nrrd:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
@@ -26,17 +26,19 @@
 
 #define INFO "Crop along each axis to make a smaller nrrd"
 static const char *_unrrdu_cropInfoL =
-  (INFO ".\n "
-   "* Uses nrrdCrop");
+  (INFO ". With \"-lazy\", only the data inside the bounding box "
+   "is read from the input file, when possible.\n "
+   "* Uses nrrdCrop, or nrrdLoad with nio->readCrop");
 
 int
 unrrdu_cropMain(int argc, const char **argv, const char *me,
                 hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout;
+  NrrdIoState *nio;
   unsigned int ai;
-  int minLen, maxLen, pret;
+  int minLen, maxLen, pret, lazy;
   long int *minOff, *maxOff;
   size_t min[NRRD_DIM_MAX], max[NRRD_DIM_MAX];
   airArray *mop;
@@ -63,7 +65,15 @@ unrrdu_cropMain(int argc, const char **argv, const char *me,
              "\"m\" and \"M\" semantics (above) are currently not "
              "supported in the bounds file.",
              NULL, NULL, nrrdHestNrrd);
-  OPT_ADD_NIN(nin, "input nrrd");
+  hestOptAdd(&opt, "lazy", NULL, airTypeInt, 0, 0, &lazy, NULL,
+             "read from the input file only the data inside the bounding "
+             "box, instead of reading all of it and then cropping. This "
+             "can be much faster and use much less memory for a small "
+             "region of a large file. Only NRRD files with raw, gzip, "
+             "bzip2, or gzip-blocked encoding benefit; other inputs "
+             "(including stdin) are read in full.");
+  hestOptAdd(&opt, "i,input", "nin", airTypeString, 1, 1, &inS, "-",
+             "input nrrd");
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -73,6 +83,20 @@ unrrdu_cropMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
+  /* with -lazy, first read only the header, to learn the axis sizes */
+  lazy = lazy && strcmp("-", inS);
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nio->skipData = lazy;
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  if (nrrdLoad(nin, inS, nio)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: error reading input \"%s\":\n%s", me, inS, err);
+    airMopError(mop);
+    return 1;
+  }
+
   if (!_nbounds) {
     if (!( minLen == (int)nin->dim && maxLen == (int)nin->dim )) {
       fprintf(stderr,
@@ -141,7 +165,20 @@ unrrdu_cropMain(int argc, const char **argv, const char *me,
   nout = nrrdNew();
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
 
-  if (nrrdCrop(nout, nin, min, max)) {
+  if (lazy) {
+    nrrdIoStateInit(nio);
+    nio->readCrop = AIR_TRUE;
+    for (ai=0; ai<nin->dim; ai++) {
+      nio->readCropMin[ai] = min[ai];
+      nio->readCropMax[ai] = max[ai];
+    }
+    if (nrrdLoad(nout, inS, nio)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: error reading cropped nrrd:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+  } else if (nrrdCrop(nout, nin, min, max)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
     fprintf(stderr, "%s: error cropping nrrd:\n%s", me, err);
     airMopError(mop);
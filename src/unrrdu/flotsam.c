@@ -752,3 +752,181 @@ hestCB unrrduHestFormatCB = {
   unrrduParseFormat,
   NULL
 };
+
+/*
+******** unrrduStreamRangeSet
+**
+** With "-stream", the input data can't be scanned (ahead of processing
+** it) to learn its range.  This keeps whichever of range->min and
+** range->max are already set, and sets the others from the type of
+** 8-bit data if blind8BitRange says so; otherwise it's an error.
+*/
+int
+unrrduStreamRangeSet(NrrdRange *range, const Nrrd *nhdr,
+                     int blind8BitRange) {
+  static const char me[]="unrrduStreamRangeSet";
+  int blind;
+
+  if (!(range && nhdr)) {
+    biffAddf(UNRRDU, "%s: got NULL pointer", me);
+    return 1;
+  }
+  blind = (nrrdBlind8BitRangeTrue == blind8BitRange
+           || (nrrdBlind8BitRangeState == blind8BitRange
+               && nrrdStateBlind8BitRange));
+  if (blind && 1 == nrrdTypeSize[nhdr->type]) {
+    if (!AIR_EXISTS(range->min)) {
+      range->min = nrrdTypeChar == nhdr->type ? SCHAR_MIN : 0;
+    }
+    if (!AIR_EXISTS(range->max)) {
+      range->max = nrrdTypeChar == nhdr->type ? SCHAR_MAX : UCHAR_MAX;
+    }
+  }
+  if (!( AIR_EXISTS(range->min) && AIR_EXISTS(range->max) )) {
+    biffAddf(UNRRDU, "%s: when streaming, the input can't be scanned for "
+             "its range, so need both \"-min\" and \"-max\" explicitly",
+             me);
+    return 1;
+  }
+  range->hasNonExist = nrrdHasNonExistUnknown;
+  return 0;
+}
+
+/*
+******** unrrduStreamRangeFromStringSet
+**
+** like nrrdRangePercentileFromStringSet, but for streaming: the min
+** and max have to be plain numbers, not percentiles
+*/
+int
+unrrduStreamRangeFromStringSet(NrrdRange *range, const Nrrd *nhdr,
+                               const char *minStr, const char *maxStr,
+                               int blind8BitRange) {
+  static const char me[]="unrrduStreamRangeFromStringSet";
+  const char *str;
+  double *val;
+  unsigned int mmi;
+
+  if (!(range && nhdr && minStr && maxStr)) {
+    biffAddf(UNRRDU, "%s: got NULL pointer", me);
+    return 1;
+  }
+  for (mmi=0; mmi<2; mmi++) {
+    str = mmi ? maxStr : minStr;
+    val = mmi ? &(range->max) : &(range->min);
+    if (airEndsWith(str, NRRD_MINMAX_PERC_SUFF)) {
+      biffAddf(UNRRDU, "%s: can't use percentile %s \"%s\" when streaming",
+               me, mmi ? "max" : "min", str);
+      return 1;
+    }
+    if (1 != airSingleSscanf(str, "%lf", val)) {
+      biffAddf(UNRRDU, "%s: couldn't parse %s \"%s\" as double",
+               me, mmi ? "max" : "min", str);
+      return 1;
+    }
+  }
+  if (unrrduStreamRangeSet(range, nhdr, blind8BitRange)) {
+    biffAddf(UNRRDU, "%s: trouble", me);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+******** unrrduStreamSlabs
+**
+** The work of "-stream" for element-wise commands: reads the inputs
+** (opened with nrrdStreamReadOpen, all the same size) in slabs along
+** their slowest axis, of about slabMB megabytes total, calls func on
+** each slab to make the output slab, and writes that to outS with
+** nsout.  The output header is that of the first output slab, with
+** the size of the slowest axis (which func must preserve) restored.
+** Memory use is O(slab), unless the input or output can't be streamed
+** (see nrrdStreamReadOpen, nrrdStreamWriteOpen).
+*/
+int
+unrrduStreamSlabs(NrrdStream *nsout, const char *outS,
+                  NrrdStream *const *nsin, unsigned int nsinNum,
+                  double slabMB, unrrduSlabFunc *func, void *data) {
+  static const char me[]="unrrduStreamSlabs";
+  Nrrd **nslab, *nout;
+  size_t sliceSize, sliceBytes, sliceNum, sliceTotal, sliceOut;
+  unsigned int ii, last;
+  airArray *mop;
+  int E;
+
+  if (!(nsout && outS && nsin && nsinNum && func)) {
+    biffAddf(UNRRDU, "%s: got NULL pointer or no inputs", me);
+    return 1;
+  }
+  last = nsin[0]->nrrd->dim - 1;
+  for (ii=1; ii<nsinNum; ii++) {
+    if (!nrrdSameSize(nsin[0]->nrrd, nsin[ii]->nrrd, AIR_TRUE)) {
+      biffMovef(UNRRDU, NRRD, "%s: input %u size mismatch with input 0",
+                me, ii);
+      return 1;
+    }
+  }
+  mop = airMopNew();
+  nslab = AIR_CALLOC(nsinNum, Nrrd *);
+  airMopAdd(mop, nslab, airFree, airMopAlways);
+  for (ii=0; ii<nsinNum; ii++) {
+    nslab[ii] = nrrdNew();
+    airMopAdd(mop, nslab[ii], (airMopper)nrrdNuke, airMopAlways);
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+
+  /* all inputs are read a slab of the same number of slices at a time */
+  sliceTotal = nsin[0]->nrrd->axis[last].size;
+  sliceSize = nsin[0]->elementNum/sliceTotal;
+  sliceBytes = 0;
+  for (ii=0; ii<nsinNum; ii++) {
+    sliceBytes += sliceSize*nrrdElementSize(nsin[ii]->nrrd);
+  }
+  sliceNum = AIR_CAST(size_t, slabMB*1024*1024)/sliceBytes;
+  sliceNum = AIR_MAX(1, sliceNum);
+  while (nsin[0]->elementDone < nsin[0]->elementNum) {
+    for (ii=0; ii<nsinNum; ii++) {
+      if (nrrdStreamSlabRead(nsin[ii], nslab[ii], sliceNum*sliceSize
+                             *nrrdElementSize(nsin[ii]->nrrd))) {
+        biffMovef(UNRRDU, NRRD, "%s: trouble reading slab of input %u",
+                  me, ii);
+        airMopError(mop); return 1;
+      }
+    }
+    if (func(nout, nslab, data)) {
+      biffMovef(UNRRDU, NRRD, "%s: trouble processing slab", me);
+      airMopError(mop); return 1;
+    }
+    sliceOut = nout->axis[nout->dim-1].size;
+    if (sliceOut != nslab[0]->axis[last].size) {
+      char stmp[2][AIR_STRLEN_SMALL];
+      biffAddf(UNRRDU, "%s: output slab has %s slices, not %s", me,
+               airSprintSize_t(stmp[0], sliceOut),
+               airSprintSize_t(stmp[1], nslab[0]->axis[last].size));
+      airMopError(mop); return 1;
+    }
+    if (!nsout->open) {
+      /* the output header is the first slab's, but with all the slices
+         (the data pointer is ignored) */
+      nout->axis[nout->dim-1].size = sliceTotal;
+      E = nrrdStreamWriteOpen(nsout, outS, nout);
+      nout->axis[nout->dim-1].size = sliceOut;
+      if (E) {
+        biffMovef(UNRRDU, NRRD, "%s: trouble starting output", me);
+        airMopError(mop); return 1;
+      }
+    }
+    if (nrrdStreamSlabWrite(nsout, nout)) {
+      biffMovef(UNRRDU, NRRD, "%s: trouble writing slab", me);
+      airMopError(mop); return 1;
+    }
+  }
+  if (nrrdStreamClose(nsout)) {
+    biffMovef(UNRRDU, NRRD, "%s: trouble finishing output", me);
+    airMopError(mop); return 1;
+  }
+  airMopOkay(mop);
+  return 0;
+}
@@ -30,20 +30,47 @@ static const char *_unrrdu_gammaInfoL =
  ". Just as in xv, the gamma value here is actually the "
  "reciprocal of the exponent actually used to transform "
  "the values. Can also do the non-linear transforms used "
- "in the sRGB standard (see https://en.wikipedia.org/wiki/SRGB)\n "
+ "in the sRGB standard (see https://en.wikipedia.org/wiki/SRGB). "
+ "With \"-stream\", works on slabs of the input at a time.\n "
  "* Uses nrrdArithGamma or nrrdArithGammaSRGB");
 
+typedef struct {
+  NrrdRange *range;
+  double Gamma;
+  int srgb, forward;
+} _unrrdu_gammaParm;
+
+static int
+_unrrdu_gammaSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_gammaSlab";
+  _unrrdu_gammaParm *parm;
+  int E;
+
+  parm = AIR_CAST(_unrrdu_gammaParm *, _parm);
+  if (parm->srgb) {
+    E = nrrdArithSRGBGamma(nout, nin[0], parm->range, parm->forward);
+  } else {
+    E = nrrdArithGamma(nout, nin[0], parm->range, parm->Gamma);
+  }
+  if (E) {
+    biffAddf(NRRD, "%s: error doing gamma", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_gammaMain(int argc, const char **argv, const char *me,
                  hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout;
   char *GammaS;
-  double min, max, Gamma;
+  double min, max, Gamma, slabMB;
   airArray *mop;
   int pret, blind8BitRange, srgb, forward;
   NrrdRange *range;
+  _unrrdu_gammaParm parm;
 
   hestOptAdd(&opt, "g,gamma", "gamma", airTypeString, 1, 1, &GammaS, NULL,
              "gamma > 1.0 brightens; gamma < 1.0 darkens. "
@@ -60,7 +87,8 @@ unrrdu_gammaMain(int argc, const char **argv, const char *me,
              nrrdStateBlind8BitRange ? "true" : "false",
              "Whether to know the range of 8-bit data blindly "
              "(uchar is always [0,255], signed char is [-128,127]).");
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -86,21 +114,41 @@ unrrdu_gammaMain(int argc, const char **argv, const char *me,
       return 1;
     }
   }
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
   range = nrrdRangeNew(min, max);
   airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
-  nrrdRangeSafeSet(range, nin, blind8BitRange);
-  int E;
-  if (srgb) {
-    E =nrrdArithSRGBGamma(nout, nin, range, forward);
-  } else {
-    E =nrrdArithGamma(nout, nin, range, Gamma);
+  parm.range = range;
+  parm.Gamma = Gamma;
+  parm.srgb = srgb;
+  parm.forward = forward;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    if (unrrduStreamRangeSet(range, nsin->nrrd, blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_gammaSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
   }
-  if (E) {
+
+  LOAD(inS, nin);
+  nrrdRangeSafeSet(range, nin, blind8BitRange);
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_gammaSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error doing gamma:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
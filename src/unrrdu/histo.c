@@ -28,18 +28,74 @@
 static const char *_unrrdu_histoInfoL =
   (INFO
    ". Can explicitly set bounds of histogram domain or can learn these "
-   "from the data.\n "
+   "from the data. With \"-stream\" (and without \"-w\"), the histogram "
+   "is accumulated over slabs of the input, but the bounds have to be "
+   "set explicitly.\n "
    "* Uses nrrdHisto");
 
+/*
+** histogram with nrrdHisto (into double) of each slab of the input,
+** summed, and then clamped into the output type once at the end, which
+** (for counting, without weights) matches what nrrdHisto would do on
+** all the input at once
+*/
+static int
+_unrrdu_histoStream(Nrrd *nout, NrrdStream *nsin, const NrrdRange *range,
+                    unsigned int bins, int type, double slabMB) {
+  static const char me[]="_unrrdu_histoStream";
+  Nrrd *nslab, *nhist;
+  double *hist, *acc;
+  size_t sliceBytes, slabBytes;
+  unsigned int bi;
+  airArray *mop;
+
+  mop = airMopNew();
+  nslab = nrrdNew();
+  airMopAdd(mop, nslab, (airMopper)nrrdNuke, airMopAlways);
+  nhist = nrrdNew();
+  airMopAdd(mop, nhist, (airMopper)nrrdNuke, airMopAlways);
+  acc = AIR_CALLOC(bins, double);
+  airMopAdd(mop, acc, airFree, airMopAlways);
+  if (!acc) {
+    biffAddf(NRRD, "%s: couldn't allocate %u bins", me, bins);
+    airMopError(mop); return 1;
+  }
+  sliceBytes = (nrrdElementSize(nsin->nrrd)*nsin->elementNum
+                /nsin->nrrd->axis[nsin->nrrd->dim-1].size);
+  slabBytes = AIR_MAX(sliceBytes, AIR_CAST(size_t, slabMB*1024*1024));
+  while (nsin->elementDone < nsin->elementNum) {
+    if (nrrdStreamSlabRead(nsin, nslab, slabBytes)
+        || nrrdHisto(nhist, nslab, range, NULL, bins, nrrdTypeDouble)) {
+      biffAddf(NRRD, "%s: trouble with slab", me);
+      airMopError(mop); return 1;
+    }
+    hist = AIR_CAST(double *, nhist->data);
+    for (bi=0; bi<bins; bi++) {
+      acc[bi] += hist[bi];
+    }
+  }
+  /* the last slab's histogram, in the output type, for the header */
+  if (nrrdHisto(nout, nslab, range, NULL, bins, type)) {
+    biffAddf(NRRD, "%s: trouble", me);
+    airMopError(mop); return 1;
+  }
+  for (bi=0; bi<bins; bi++) {
+    nrrdDInsert[type](nout->data, bi, nrrdDClamp[type](acc[bi]));
+  }
+  airMopOkay(mop);
+  return 0;
+}
+
 int
 unrrdu_histoMain(int argc, const char **argv, const char *me,
                  hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout, *nwght;
   char *minStr, *maxStr;
   int type, pret, blind8BitRange;
   unsigned int bins;
+  double slabMB;
   NrrdRange *range;
   airArray *mop;
 
@@ -75,7 +131,8 @@ unrrdu_histoMain(int argc, const char **argv, const char *me,
              "Whether to know the range of 8-bit data blindly "
              "(uchar is always [0,255], signed char is [-128,127]).");
   OPT_ADD_TYPE(type, "type to use for bins in output histogram", "uint");
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -89,6 +146,33 @@ unrrdu_histoMain(int argc, const char **argv, const char *me,
   airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
   nout = nrrdNew();
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (slabMB > 0) {
+    NrrdStream *nsin;
+    if (nwght) {
+      fprintf(stderr, "%s: sorry, can't use \"-w\" with \"-stream\"\n", me);
+      airMopError(mop);
+      return 1;
+    }
+    LOAD_STREAM(inS, nsin);
+    if (unrrduStreamRangeFromStringSet(range, nsin->nrrd, minStr, maxStr,
+                                       blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    if (_unrrdu_histoStream(nout, nsin, range, bins, type, slabMB)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    SAVE(out, nout, NULL);
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
   if (nrrdRangePercentileFromStringSet(range, nin, minStr, maxStr,
                                        10*bins /* HEY magic */,
                                        blind8BitRange)
@@ -34,20 +34,43 @@ static const char *_unrrdu_imapInfoL =
  "location of the control point, and the remaining values "
  "give are the range of the map for that control point. "
  "The output value(s) is the result of linearly "
- "interpolating between value(s) from the map.\n "
+ "interpolating between value(s) from the map. "
+ "With \"-stream\", works on slabs of the input at a time, but then "
+ "rescaling needs explicit \"-min\" and \"-max\".\n "
  "* Uses nrrdApply1DIrregMap");
 
+typedef struct {
+  const Nrrd *nmap, *nacl;
+  NrrdRange *range;
+  int typeOut, rescale;
+} _unrrdu_imapParm;
+
+static int
+_unrrdu_imapSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_imapSlab";
+  _unrrdu_imapParm *parm;
+
+  parm = AIR_CAST(_unrrdu_imapParm *, _parm);
+  if (nrrdApply1DIrregMap(nout, nin[0], parm->range, parm->nmap,
+                          parm->nacl, parm->typeOut, parm->rescale)) {
+    biffAddf(NRRD, "%s: trouble applying map", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_imapMain(int argc, const char **argv, const char *me,
                 hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nmap, *nacl, *nout;
   airArray *mop;
   NrrdRange *range=NULL;
   unsigned int aclLen;
   int typeOut, rescale, pret, blind8BitRange;
-  double min, max;
+  double min, max, slabMB;
+  _unrrdu_imapParm parm;
 
   hestOptAdd(&opt, "m,map", "map", airTypeOther, 1, 1, &nmap, NULL,
              "irregular map to map input nrrd through",
@@ -79,7 +102,8 @@ unrrdu_imapMain(int argc, const char **argv, const char *me,
              "By default (not using this option), the output type "
              "is the map's type.",
              NULL, NULL, &unrrduHestMaybeTypeCB);
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -89,9 +113,6 @@ unrrdu_imapMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
   if (aclLen) {
     nacl = nrrdNew();
     airMopAdd(mop, nacl, (airMopper)nrrdNuke, airMopAlways);
@@ -107,7 +128,6 @@ unrrdu_imapMain(int argc, const char **argv, const char *me,
   if (rescale) {
     range = nrrdRangeNew(min, max);
     airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
-    nrrdRangeSafeSet(range, nin, blind8BitRange);
   }
   if (nrrdTypeDefault == typeOut) {
     typeOut = nmap->type;
@@ -118,7 +138,40 @@ unrrdu_imapMain(int argc, const char **argv, const char *me,
      but chances are most imaps will have only a handful of points,
      in which case the binary search in _nrrd1DIrregFindInterval()
      will finish quickly ... */
-  if (nrrdApply1DIrregMap(nout, nin, range, nmap, nacl, typeOut, rescale)) {
+  parm.nmap = nmap;
+  parm.nacl = nacl;
+  parm.range = range;
+  parm.typeOut = typeOut;
+  parm.rescale = rescale;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    if (range && unrrduStreamRangeSet(range, nsin->nrrd, blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_imapSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
+  if (range) {
+    nrrdRangeSafeSet(range, nin, blind8BitRange);
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_imapSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
     fprintf(stderr, "%s: trouble applying map:\n%s", me, err);
     airMopError(mop);
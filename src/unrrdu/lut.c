@@ -32,18 +32,41 @@ static const char *_unrrdu_lutInfoL =
  "has the same dimension as the input, or 2D, in which case "
  "the output has one more dimension than the input, and each "
  "value is mapped to a scanline (along axis 0) from the "
- "lookup table.\n "
+ "lookup table. "
+ "With \"-stream\", works on slabs of the input at a time, but then "
+ "rescaling needs explicit \"-min\" and \"-max\".\n "
  "* Uses nrrdApply1DLut");
 
+typedef struct {
+  const Nrrd *nmap, *nacl;
+  NrrdRange *range;
+  int typeOut, rescale;
+} _unrrdu_lutParm;
+
+static int
+_unrrdu_lutSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_lutSlab";
+  _unrrdu_lutParm *parm;
+
+  parm = AIR_CAST(_unrrdu_lutParm *, _parm);
+  if (nrrdApply1DLut(nout, nin[0], parm->range, parm->nmap,
+                     parm->typeOut, parm->rescale)) {
+    biffAddf(NRRD, "%s: trouble applying LUT", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_lutMain(int argc, const char **argv, const char *me,
                hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nlut, *nout;
   airArray *mop;
   int typeOut, rescale, pret, blind8BitRange;
-  double min, max;
+  double min, max, slabMB;
+  _unrrdu_lutParm parm;
   NrrdRange *range=NULL;
 
   hestOptAdd(&opt, "m,map", "lut", airTypeOther, 1, 1, &nlut, NULL,
@@ -74,7 +97,8 @@ unrrdu_lutMain(int argc, const char **argv, const char *me,
              "By default (not using this option), the output type "
              "is the lut's type.",
              NULL, NULL, &unrrduHestMaybeTypeCB);
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -84,9 +108,6 @@ unrrdu_lutMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
   /* see comment rmap.c */
   if (!( AIR_EXISTS(nlut->axis[nlut->dim - 1].min) &&
          AIR_EXISTS(nlut->axis[nlut->dim - 1].max) )) {
@@ -95,13 +116,45 @@ unrrdu_lutMain(int argc, const char **argv, const char *me,
   if (rescale) {
     range = nrrdRangeNew(min, max);
     airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
-    nrrdRangeSafeSet(range, nin, blind8BitRange);
   }
 
   if (nrrdTypeDefault == typeOut) {
     typeOut = nlut->type;
   }
-  if (nrrdApply1DLut(nout, nin, range, nlut, typeOut, rescale)) {
+  parm.nmap = nlut;
+  parm.nacl = NULL;
+  parm.range = range;
+  parm.typeOut = typeOut;
+  parm.rescale = rescale;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    if (range && unrrduStreamRangeSet(range, nsin->nrrd, blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_lutSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
+  if (range) {
+    nrrdRangeSafeSet(range, nin, blind8BitRange);
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_lutSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
     fprintf(stderr, "%s: trouble applying LUT:\n%s", me, err);
     airMopError(mop);
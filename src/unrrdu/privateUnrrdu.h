@@ -73,13 +73,33 @@ extern "C" {
   hestOptAdd(&opt, name, "pos0", airTypeOther, needmin, -1, &(var),     \
              deflt, desc, &(saw), NULL, &unrrduHestPosCB)
 
+/* char *var; for commands that may stream the input (see OPT_ADD_STREAM)
+   and so have to open it themselves, with LOAD or nrrdStreamReadOpen */
+#define OPT_ADD_NIN_NAME(var, desc) \
+  hestOptAdd(&opt, "i,input", "nin", airTypeString, 1, 1, &(var), "-", desc)
+
+/* double var */
+#define OPT_ADD_STREAM(var) \
+  hestOptAdd(&opt, "stream", "MB", airTypeDouble, 1, 1, &(var), "0", \
+             "if > 0, instead of reading the whole input into memory, " \
+             "read it in slabs (of whole slices along the slowest axis) " \
+             "of about this many megabytes, and write out each " \
+             "corresponding slab of output before reading the next.  " \
+             "Memory use is then proportional to the slab size, not " \
+             "the input size, for NRRD input and output with raw, gzip, " \
+             "or bzip2 (or, for input, gzip-blocked) encoding and " \
+             "attached data (as in pipes) or a single data file.  The " \
+             "output is the same as without streaming, but ranges that " \
+             "would have been learned from the data have to be given " \
+             "explicitly.")
+
 /* int var */
 #define OPT_ADD_TYPE(var, desc, dflt) \
   hestOptAdd(&opt, "t,type", "type", airTypeEnum, 1, 1, &(var), dflt, desc, \
              NULL, nrrdType)
 
 /*
-** USAGE, PARSE, SAVE
+** USAGE, PARSE, LOAD, SAVE
 **
 ** These are macros at their worst and most fragile, because of how
 ** many local variables are assumed.  This code is basically the same,
@@ -141,6 +161,73 @@ in the error messages.
     }                                                                   \
   }
 
+/*
+** LOAD and LOAD_STREAM do the input reading that hest would do for
+** OPT_ADD_NIN, for commands using OPT_ADD_NIN_NAME, including the
+** "quiet-quit" functionality (see PARSE)
+*/
+#define LOAD_ERROR(inS) \
+  airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways); \
+  if (!(getenv(UNRRDU_QUIET_QUIT_ENV) \
+        && airEndsWith(err, UNRRDU_QUIET_QUIT_STR "\n"))) { \
+    fprintf(stderr, "%s: error reading nrrd from \"%s\":\n%s", \
+            me, (inS), err); \
+  } \
+  airMopError(mop); \
+  return 1
+
+/* Nrrd *nin */
+#define LOAD(inS, nin) \
+  (nin) = nrrdNew(); \
+  airMopAdd(mop, (nin), (airMopper)nrrdNuke, airMopAlways); \
+  if (nrrdLoad((nin), (inS), NULL)) { \
+    LOAD_ERROR(inS); \
+  }
+
+/* NrrdStream *nst */
+#define LOAD_STREAM(inS, nst) \
+  (nst) = nrrdStreamNew(); \
+  airMopAdd(mop, (nst), (airMopper)nrrdStreamNix, airMopAlways); \
+  if (nrrdStreamReadOpen((nst), (inS))) { \
+    LOAD_ERROR(inS); \
+  }
+
+/*
+** for operands (as of "unu 2op" and "unu 3op") that can be either a nrrd
+** or a number, using nrrdHestIter for the nrrd or number distinction.
+** Needs char perr[AIR_STRLEN_HUGE].  NrrdIter *iter
+*/
+#define LOAD_OPERAND(str, iter) \
+  if (nrrdHestIter->parse(&(iter), (str), perr)) { \
+    if (!(getenv(UNRRDU_QUIET_QUIT_ENV) \
+          && airEndsWith(perr, UNRRDU_QUIET_QUIT_STR "\n"))) { \
+      fprintf(stderr, "%s: error parsing \"%s\" as nrrd or number:\n%s", \
+              me, (str), perr); \
+    } \
+    airMopError(mop); \
+    return 1; \
+  } \
+  airMopAdd(mop, (iter), (airMopper)nrrdIterNix, airMopAlways)
+
+/*
+** streaming version of LOAD_OPERAND: if str can't be opened as a file,
+** it is taken as a number (put in val) if nrrdHestIter would do the
+** same, as decided by nrrdHestIterNumber.  Uses pret.
+** NrrdStream *nst; int isNrrd; double val
+*/
+#define LOAD_STREAM_OPERAND(str, nst, isNrrd, val) \
+  (nst) = nrrdStreamNew(); \
+  airMopAdd(mop, (nst), (airMopper)nrrdStreamNix, airMopAlways); \
+  pret = nrrdStreamReadOpen((nst), (str)); \
+  (isNrrd) = !pret; \
+  if (pret) { \
+    if (2 == pret && nrrdHestIterNumber(&(val), (str))) { \
+      biffDone(NRRD); \
+    } else { \
+      LOAD_ERROR(str); \
+    } \
+  }
+
 #define SAVE(outS, nout, io) \
   if (nrrdSave((outS), (nout), (io))) { \
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways); \
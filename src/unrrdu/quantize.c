@@ -34,21 +34,56 @@ static const char *_unrrdu_quantizeInfoL =
  "suffixed with \"" NRRD_MINMAX_PERC_SUFF "\", no space in between). "
  "This does only linear quantization. "
  "See also \"unu convert\", \"unu 2op x\", "
- "and \"unu 3op clamp\".\n "
+ "and \"unu 3op clamp\". "
+ "With \"-stream\", works on slabs of the input at a time, but then "
+ "the min and max have to be given as regular numbers.\n "
  "* Uses nrrdQuantize");
 
+typedef struct {
+  NrrdRange *range;
+  unsigned int bits;
+  int srgb;
+  double gamma;
+} _unrrdu_quantizeParm;
+
+static int
+_unrrdu_quantizeSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_quantizeSlab";
+  _unrrdu_quantizeParm *parm;
+  int E;
+
+  parm = AIR_CAST(_unrrdu_quantizeParm *, _parm);
+  E = 0;
+  if (parm->srgb) {
+    E = nrrdArithSRGBGamma(nin[0], nin[0], parm->range, AIR_TRUE);
+  } else if (1 != parm->gamma) {
+    E = nrrdArithGamma(nin[0], nin[0], parm->range, parm->gamma);
+  }
+  if (E) {
+    biffAddf(NRRD, "%s: error doing gamma", me);
+    return 1;
+  }
+  if (nrrdQuantize(nout, nin[0], parm->range, parm->bits)) {
+    biffAddf(NRRD, "%s: error quantizing", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_quantizeMain(int argc, const char **argv, const char *me,
                     hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout;
   char *minStr, *maxStr, *gammaS;
   int pret, blind8BitRange, srgb;
   unsigned int bits, hbins, srgbIdx;
-  double gamma;
+  double gamma, slabMB;
   NrrdRange *range;
+  NrrdIoState *nio;
   airArray *mop;
+  _unrrdu_quantizeParm parm;
 
   hestOptAdd(&opt, "b,bits", "bits", airTypeOther, 1, 1, &bits, NULL,
              "Number of bits to quantize down to; determines the type "
@@ -101,13 +136,15 @@ unrrdu_quantizeMain(int argc, const char **argv, const char *me,
              "or max by percentiles.  This has to be large enough so that "
              "any errant very high or very low values do not compress the "
              "interesting part of the histogram to an inscrutably small "
-             "number of bins.");
+             "number of bins.  With \"-hb 0\", the percentiles are "
+             "instead found exactly, by selection among the values.");
   hestOptAdd(&opt, "blind8", "bool", airTypeBool, 1, 1, &blind8BitRange,
              nrrdStateBlind8BitRange ? "true" : "false",
              "if not using \"-min\" or \"-max\", whether to know "
              "the range of 8-bit data blindly (uchar is always [0,255], "
              "signed char is [-128,127])");
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -126,41 +163,61 @@ unrrdu_quantizeMain(int argc, const char **argv, const char *me,
 
   range = nrrdRangeNew(AIR_NAN, AIR_NAN);
   airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  parm.range = range;
+  parm.bits = bits;
+  parm.srgb = !strcmp(gammaS, "srgb");
+  parm.gamma = gamma;
+  nio = NULL;
+  if (hestSourceUser == opt[srgbIdx].source) {
+    /* HEY copied from overrgb.c */
+    nio = nrrdIoStateNew();
+    airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+    nio->PNGsRGBIntentKnown = AIR_TRUE;
+    nio->PNGsRGBIntent = srgb; /* even if it is nrrdFormatPNGsRGBIntentNone;
+                                  that's handled by the writer */
+  }
+
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    if (unrrduStreamRangeFromStringSet(range, nsin->nrrd, minStr, maxStr,
+                                       blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (nio) {
+      nsout->nio->PNGsRGBIntentKnown = nio->PNGsRGBIntentKnown;
+      nsout->nio->PNGsRGBIntent = nio->PNGsRGBIntent;
+    }
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_quantizeSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
   if (nrrdRangePercentileFromStringSet(range, nin, minStr, maxStr,
                                        hbins, blind8BitRange)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
     fprintf(stderr, "%s: error learning range:\n%s", me, err);
     airMopError(mop); return 1;
   }
-  int E=0;
-  if (!strcmp(gammaS, "srgb")) {
-    E = nrrdArithSRGBGamma(nin, nin, range, AIR_TRUE);
-  } else if (1 != gamma) {
-    E = nrrdArithGamma(nin, nin, range, gamma);
-  }
-  if (E) {
-    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error going gamma:\n%s", me, err);
-    airMopError(mop); return 1;
-  }
-  if (nrrdQuantize(nout, nin, range, bits)) {
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_quantizeSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error quantizing:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop); return 1;
   }
 
-  NrrdIoState *nio = NULL;
-  if (hestSourceUser == opt[srgbIdx].source) {
-    /* HEY copied from overrgb.c */
-    nio = nrrdIoStateNew();
-    airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
-    nio->PNGsRGBIntentKnown = AIR_TRUE;
-    nio->PNGsRGBIntent = srgb; /* even if it is nrrdFormatPNGsRGBIntentNone;
-                                  that's handled by the writer */
-  }
-
   SAVE(out, nout, nio);
 
   airMopOkay(mop);
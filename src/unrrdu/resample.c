@@ -52,10 +52,10 @@ unrrdu_resampleMain(int argc, const char **argv, const char *me,
     verbose, overrideCenter, minSet=AIR_FALSE, maxSet=AIR_FALSE,
     offSet=AIR_FALSE;
   unsigned int scaleLen, ai, samplesOut, minLen, maxLen, offLen,
-    aspRatNum, nonAspRatNum;
+    aspRatNum, nonAspRatNum, threadNum;
   airArray *mop;
   double *scale;
-  double padVal, *min, *max, *off, aspRatScl=AIR_NAN;
+  double padVal, *min, *max, *off, aspRatScl=AIR_NAN, memMB;
   NrrdResampleInfo *info;
   NrrdResampleContext *rsmc;
   NrrdKernelSpec *unuk;
@@ -186,6 +186,17 @@ unrrdu_resampleMain(int argc, const char **argv, const char *me,
              "is unknown.");
   hestOptAdd(&opt, "verbose", "v", airTypeInt, 1, 1, &verbose, "0",
              "(not available with \"-old\") verbosity level");
+  hestOptAdd(&opt, "nt,threads", "# threads", airTypeUInt, 1, 1,
+             &threadNum, "1",
+             "(not available with \"-old\") number of threads to use "
+             "for resampling the scanlines of each pass. The output is "
+             "identical regardless of the number of threads.");
+  hestOptAdd(&opt, "mem", "MB", airTypeDouble, 1, 1, &memMB, "0",
+             "(not available with \"-old\") approximate limit, in "
+             "megabytes, on the memory used for intermediate results; "
+             "if needed, the volume is resampled in slabs along the "
+             "slowest axis to stay within this. The output is identical "
+             "regardless. \"0\" means no limit.");
   OPT_ADD_NIN(nin, "input nrrd");
   OPT_ADD_NOUT(out, "output nrrd");
 
@@ -441,6 +452,11 @@ unrrdu_resampleMain(int argc, const char **argv, const char *me,
     if (!E) E |= nrrdResamplePadValueSet(rsmc, padVal);
     if (!E) E |= nrrdResampleRenormalizeSet(rsmc, !norenorm);
     if (!E) E |= nrrdResampleNonExistentSet(rsmc, neb);
+    if (!E) E |= nrrdResampleThreadNumSet(rsmc, threadNum);
+    if (!E) E |= nrrdResampleMemoryBudgetSet(rsmc, (memMB > 0
+                                                    ? AIR_CAST(size_t,
+                                                               memMB*1024*1024)
+                                                    : 0));
     if (!E) E |= nrrdResampleExecute(rsmc, nout);
     if (E) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
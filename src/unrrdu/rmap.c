@@ -39,19 +39,42 @@ static const char *_unrrdu_rmapInfoL =
  "either case, the output is the result of linearly "
  "interpolating between map points, either scalar values "
  "(\"grayscale\"), or scanlines along axis 0 "
- "(\"color\").\n "
+ "(\"color\"). "
+ "With \"-stream\", works on slabs of the input at a time, but then "
+ "rescaling needs explicit \"-min\" and \"-max\".\n "
  "* Uses nrrdApply1DRegMap");
 
+typedef struct {
+  const Nrrd *nmap, *nacl;
+  NrrdRange *range;
+  int typeOut, rescale;
+} _unrrdu_rmapParm;
+
+static int
+_unrrdu_rmapSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_rmapSlab";
+  _unrrdu_rmapParm *parm;
+
+  parm = AIR_CAST(_unrrdu_rmapParm *, _parm);
+  if (nrrdApply1DRegMap(nout, nin[0], parm->range, parm->nmap,
+                        parm->typeOut, parm->rescale)) {
+    biffAddf(NRRD, "%s: trouble applying map", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_rmapMain(int argc, const char **argv, const char *me,
                 hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nmap, *nout;
   airArray *mop;
   NrrdRange *range=NULL;
   int typeOut, rescale, pret, blind8BitRange;
-  double min, max;
+  double min, max, slabMB;
+  _unrrdu_rmapParm parm;
 
   hestOptAdd(&opt, "m,map", "map", airTypeOther, 1, 1, &nmap, NULL,
              "regular map to map input nrrd through",
@@ -85,7 +108,8 @@ unrrdu_rmapMain(int argc, const char **argv, const char *me,
              "By default (not using this option), the output type "
              "is the map's type.",
              NULL, NULL, &unrrduHestMaybeTypeCB);
-  OPT_ADD_NIN(nin, "input nrrd");
+  OPT_ADD_NIN_NAME(inS, "input nrrd");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -95,9 +119,6 @@ unrrdu_rmapMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
-  nout = nrrdNew();
-  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
   /* here is a big difference between unu and nrrd: we enforce
      rescaling any time that the map domain is implicit.  This
      is how the pre-1.6 functionality is recreated.  Also, whenever
@@ -112,13 +133,45 @@ unrrdu_rmapMain(int argc, const char **argv, const char *me,
   if (rescale) {
     range = nrrdRangeNew(min, max);
     airMopAdd(mop, range, (airMopper)nrrdRangeNix, airMopAlways);
-    nrrdRangeSafeSet(range, nin, blind8BitRange);
   }
 
   if (nrrdTypeDefault == typeOut) {
     typeOut = nmap->type;
   }
-  if (nrrdApply1DRegMap(nout, nin, range, nmap, typeOut, rescale)) {
+  parm.nmap = nmap;
+  parm.nacl = NULL;
+  parm.range = range;
+  parm.typeOut = typeOut;
+  parm.rescale = rescale;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    if (range && unrrduStreamRangeSet(range, nsin->nrrd, blind8BitRange)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error setting range:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_rmapSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
+  if (range) {
+    nrrdRangeSafeSet(range, nin, blind8BitRange);
+  }
+  nout = nrrdNew();
+  airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
+  if (_unrrdu_rmapSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
     fprintf(stderr, "%s: trouble applying map:\n%s", me, err);
     airMopError(mop);
@@ -76,6 +76,11 @@ unrrdu_saveMain(int argc, const char **argv, const char *me,
   if (nrrdEncodingGzip->available()) {
     strcat(encInfo,
            "\n \b\bo \"gzip\", \"gz\": gzip compressed raw data");
+    strcat(encInfo,
+           "\n \b\bo \"gzip-blocked\", \"gzb\": gzip compressed raw data, "
+           "in independent blocks (see \"-bs\"), which can be compressed "
+           "and decompressed in parallel (see \"-nt\"), and still read "
+           "by plain gzip");
   }
   if (nrrdEncodingBzip2->available()) {
     strcat(encInfo,
@@ -100,6 +105,14 @@ unrrdu_saveMain(int argc, const char **argv, const char *me,
              "friends; \"big\" for everyone else. "
              "Defaults to endianness of this machine",
              NULL, airEndian);
+  hestOptAdd(&opt, "bs,blocksize", "size", airTypeSize_t, 1, 1,
+             &(nio->zlibBlockSize), "0",
+             "with gzip-blocked encoding, number of bytes of raw data "
+             "in each independently compressed block (0 for default)");
+  hestOptAdd(&opt, "nt,threadnum", "# thr", airTypeUInt, 1, 1,
+             &(nio->threadNum), "1",
+             "number of threads to use for compression, with the "
+             "gzip-blocked encoding");
   OPT_ADD_NIN(nin, "input nrrd");
   OPT_ADD_NOUT(out, "output nrrd");
   hestOptAdd(&opt, "od,ouputdata", "name", airTypeString, 1, 1, &outData, "",
@@ -123,7 +136,8 @@ unrrdu_saveMain(int argc, const char **argv, const char *me,
     nio->bareText = AIR_TRUE;
   }
   nio->encoding = nrrdEncodingArray[enc[0]];
-  if (nrrdEncodingTypeGzip == enc[0]) {
+  if (nrrdEncodingTypeGzip == enc[0]
+      || nrrdEncodingTypeGzipBlocked == enc[0]) {
     nio->zlibLevel = enc[1];
     nio->zlibStrategy = enc[2];
   } else if (nrrdEncodingTypeBzip2 == enc[0]) {
@@ -31,17 +31,20 @@ static const char *_unrrdu_sliceInfoL =
    "dimension by the number of slice axes (except when the "
    "input is or gets down to 1-D). Can slice on all axes "
    "in order to sample a single value from the array. "
-   "Per-axis information is preserved.\n "
-   "* Uses nrrdSlice (possibly called multiple times)");
+   "Per-axis information is preserved. With \"-lazy\", only the "
+   "slice data is read from the input file, when possible.\n "
+   "* Uses nrrdSlice (possibly called multiple times), and "
+   "nrrdLoad with nio->readCrop (with -lazy)");
 
 int
 unrrdu_sliceMain(int argc, const char **argv, const char *me,
                  hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
-  Nrrd *nin, *nout;
+  char *inS, *out, *err;
+  Nrrd *nin, *nhdr, *nout;
+  NrrdIoState *nio;
   unsigned int *axis;
-  int pret, axi, axisNum, posNum;
+  int pret, axi, axisNum, posNum, lazy;
   size_t pos[NRRD_DIM_MAX];
   long int *_pos;
   airArray *mop;
@@ -61,7 +64,13 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
              "\b\bo M-<int> give index relative "
              "to the last sample on the axis (M == #samples-1).",
              &posNum, NULL, &unrrduHestPosCB);
-  OPT_ADD_NIN(nin, "input nrrd");
+  hestOptAdd(&opt, "lazy", NULL, airTypeInt, 0, 0, &lazy, NULL,
+             "read from the input file only the data in the slice, "
+             "instead of reading all of it and then slicing. Only NRRD "
+             "files with raw, gzip, bzip2, or gzip-blocked encoding "
+             "benefit; other inputs (including stdin) are read in full.");
+  hestOptAdd(&opt, "i,input", "nin", airTypeString, 1, 1, &inS, "-",
+             "input nrrd");
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -70,6 +79,20 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
   USAGE(_unrrdu_sliceInfoL);
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
+
+  /* with -lazy, first read only the header, to learn the axis sizes */
+  lazy = lazy && strcmp("-", inS);
+  nio = nrrdIoStateNew();
+  airMopAdd(mop, nio, (airMopper)nrrdIoStateNix, airMopAlways);
+  nio->skipData = lazy;
+  nin = nrrdNew();
+  airMopAdd(mop, nin, (airMopper)nrrdNuke, airMopAlways);
+  nhdr = NULL;
+  if (nrrdLoad(nin, inS, nio)) {
+    airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+    fprintf(stderr, "%s: error reading input \"%s\":\n%s", me, inS, err);
+    airMopError(mop); return 1;
+  }
   if (axisNum != posNum) {
     fprintf(stderr, "%s: # axes %u != # positions %u\n", me, axisNum, posNum);
     airMopError(mop); return 1;
@@ -103,6 +126,31 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
            AIR_CAST(unsigned int, pos[axi]));
     */
   }
+  if (lazy) {
+    /* read the slab that is only one sample thick on the slice axes,
+       so that below we slice at position 0 of it */
+    Nrrd *nslab;
+    unsigned int ai;
+    nrrdIoStateInit(nio);
+    nio->readCrop = AIR_TRUE;
+    for (ai=0; ai<nin->dim; ai++) {
+      nio->readCropMin[ai] = 0;
+      nio->readCropMax[ai] = nin->axis[ai].size - 1;
+    }
+    for (axi=0; axi<axisNum; axi++) {
+      nio->readCropMin[axis[axi]] = nio->readCropMax[axis[axi]] = pos[axi];
+    }
+    nslab = nrrdNew();
+    airMopAdd(mop, nslab, (airMopper)nrrdNuke, airMopAlways);
+    if (nrrdLoad(nslab, inS, nio)) {
+      airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+      fprintf(stderr, "%s: error reading slab of input:\n%s", me, err);
+      airMopError(mop); return 1;
+    }
+    /* nhdr keeps the header, for setting the content */
+    nhdr = nin;
+    nin = nslab;
+  }
   /* check on possibly adjust slice axes downward */
   if (axisNum > 1) {
     int axj;
@@ -132,7 +180,7 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
 
   if (1 == axisNum) {
     /* old single axis code */
-    if (nrrdSlice(nout, nin, axis[0], pos[0])) {
+    if (nrrdSlice(nout, nin, axis[0], lazy ? 0 : pos[0])) {
       airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
       fprintf(stderr, "%s: error slicing nrrd:\n%s", me, err);
       airMopError(mop); return 1;
@@ -152,7 +200,7 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
                     (0 == axi
                      ? nin          /* use nin for only first input */
                      : ntmp[tidx]), /* use an ntmp for all but first input */
-                    axis[axi], pos[axi])) {
+                    axis[axi], lazy ? 0 : pos[axi])) {
         airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
         fprintf(stderr, "%s: error with slice %d of %d:\n%s", me,
                 axi+1, axisNum, err);
@@ -161,6 +209,17 @@ unrrdu_sliceMain(int argc, const char **argv, const char *me,
       tidx = 1 - tidx;
     }
   }
+  if (lazy) {
+    /* say in the content what the slicing of the whole input would */
+    for (axi=0; axi<axisNum; axi++) {
+      if (nrrdContentSet_va(nout, "slice", 0 == axi ? nhdr : nout, "%d,%d",
+                            axis[axi], AIR_CAST(int, pos[axi]))) {
+        airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
+        fprintf(stderr, "%s: error setting content:\n%s", me, err);
+        airMopError(mop); return 1;
+      }
+    }
+  }
 
   SAVE(out, nout, NULL);
 
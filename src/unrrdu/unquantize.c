@@ -28,27 +28,51 @@
 static const char *_unrrdu_unquantizeInfoL =
   (INFO ". Uses the oldMin and oldMax fields in the Nrrd of quantized values "
    "to regenerate approximate versions of the original unquantized values. "
-   "Can also override these with \"-min\" and \"-max\".\n "
+   "Can also override these with \"-min\" and \"-max\". "
+   "With \"-stream\", works on slabs of the input at a time.\n "
    "* Uses nrrdUnquantize");
 
+typedef struct {
+  double oldMin, oldMax;
+  int dbl;
+} _unrrdu_unquantizeParm;
+
+static int
+_unrrdu_unquantizeSlab(Nrrd *nout, Nrrd *const *nin, void *_parm) {
+  static const char me[]="_unrrdu_unquantizeSlab";
+  _unrrdu_unquantizeParm *parm;
+
+  parm = AIR_CAST(_unrrdu_unquantizeParm *, _parm);
+  if (AIR_EXISTS(parm->oldMin))
+    nin[0]->oldMin = parm->oldMin;
+  if (AIR_EXISTS(parm->oldMax))
+    nin[0]->oldMax = parm->oldMax;
+  if (nrrdUnquantize(nout, nin[0],
+                     parm->dbl ? nrrdTypeDouble : nrrdTypeFloat)) {
+    biffAddf(NRRD, "%s: error unquantizing nrrd", me);
+    return 1;
+  }
+  return 0;
+}
+
 int
 unrrdu_unquantizeMain(int argc, const char **argv, const char *me,
                       hestParm *hparm) {
   hestOpt *opt = NULL;
-  char *out, *err;
+  char *inS, *out, *err;
   Nrrd *nin, *nout;
   int dbl, pret;
-  double oldMin, oldMax;
+  double oldMin, oldMax, slabMB;
   airArray *mop;
+  _unrrdu_unquantizeParm parm;
 
   /* mandatory arg so that "unu unquantize" produces usage info */
-  hestOptAdd(&opt, "i,input", "nin", airTypeOther, 1, 1, &nin, NULL,
+  hestOptAdd(&opt, "i,input", "nin", airTypeString, 1, 1, &inS, NULL,
              "input nrrd.  That this argument is required instead of "
              "optional, as with most unu commands, is a quirk caused by the "
              "need to have \"unu unquantize\" generate usage info, combined "
              "with the fact that all the other arguments have sensible "
-             "defaults",
-             NULL, NULL, nrrdHestNrrd);
+             "defaults");
   hestOptAdd(&opt, "min,minimum", "value", airTypeDouble, 1, 1, &oldMin, "nan",
              "Lowest value prior to quantization.  Defaults to "
              "nin->oldMin if it exists, otherwise 0.0");
@@ -57,6 +81,7 @@ unrrdu_unquantizeMain(int argc, const char **argv, const char *me,
              "nin->oldMax if it exists, otherwise 1.0");
   hestOptAdd(&opt, "double", NULL, airTypeBool, 0, 0, &dbl, NULL,
              "Use double for output type, instead of float");
+  OPT_ADD_STREAM(slabMB);
   OPT_ADD_NOUT(out, "output nrrd");
 
   mop = airMopNew();
@@ -66,16 +91,31 @@ unrrdu_unquantizeMain(int argc, const char **argv, const char *me,
   PARSE();
   airMopAdd(mop, opt, (airMopper)hestParseFree, airMopAlways);
 
+  parm.oldMin = oldMin;
+  parm.oldMax = oldMax;
+  parm.dbl = dbl;
+  if (slabMB > 0) {
+    NrrdStream *nsin, *nsout;
+    LOAD_STREAM(inS, nsin);
+    nsout = nrrdStreamNew();
+    airMopAdd(mop, nsout, (airMopper)nrrdStreamNix, airMopAlways);
+    if (unrrduStreamSlabs(nsout, out, &nsin, 1, slabMB,
+                          _unrrdu_unquantizeSlab, &parm)) {
+      airMopAdd(mop, err = biffGetDone(UNRRDU), airFree, airMopAlways);
+      fprintf(stderr, "%s: error streaming:\n%s", me, err);
+      airMopError(mop);
+      return 1;
+    }
+    airMopOkay(mop);
+    return 0;
+  }
+
+  LOAD(inS, nin);
   nout = nrrdNew();
   airMopAdd(mop, nout, (airMopper)nrrdNuke, airMopAlways);
-
-  if (AIR_EXISTS(oldMin))
-    nin->oldMin = oldMin;
-  if (AIR_EXISTS(oldMax))
-    nin->oldMax = oldMax;
-  if (nrrdUnquantize(nout, nin, dbl ? nrrdTypeDouble : nrrdTypeFloat)) {
+  if (_unrrdu_unquantizeSlab(nout, &nin, &parm)) {
     airMopAdd(mop, err = biffGetDone(NRRD), airFree, airMopAlways);
-    fprintf(stderr, "%s: error unquantizing nrrd:\n%s", me, err);
+    fprintf(stderr, "%s: error:\n%s", me, err);
     airMopError(mop);
     return 1;
   }
@@ -220,6 +220,14 @@ enum {
   unrrduScaleLast
 };
 
+/*
+******** unrrduSlabFunc
+**
+** what unrrduStreamSlabs calls on each slab of input (one Nrrd per
+** streamed input), to produce the corresponding slab of output
+*/
+typedef int (unrrduSlabFunc)(Nrrd *nout, Nrrd *const *nin, void *data);
+
 /* flotsam.c */
 UNRRDU_EXPORT const int unrrduPresent;
 UNRRDU_EXPORT const char *unrrduBiffKey;
@@ -240,6 +248,17 @@ UNRRDU_EXPORT hestCB unrrduHestBitsCB;
 UNRRDU_EXPORT hestCB unrrduHestFileCB;
 UNRRDU_EXPORT hestCB unrrduHestEncodingCB;
 UNRRDU_EXPORT hestCB unrrduHestFormatCB;
+UNRRDU_EXPORT int unrrduStreamRangeSet(NrrdRange *range, const Nrrd *nhdr,
+                                       int blind8BitRange);
+UNRRDU_EXPORT int unrrduStreamRangeFromStringSet(NrrdRange *range,
+                                                 const Nrrd *nhdr,
+                                                 const char *minStr,
+                                                 const char *maxStr,
+                                                 int blind8BitRange);
+UNRRDU_EXPORT int unrrduStreamSlabs(NrrdStream *nsout, const char *outS,
+                                    NrrdStream *const *nsin,
+                                    unsigned int nsinNum, double slabMB,
+                                    unrrduSlabFunc *func, void *data);
 
 
 #ifdef __cplusplus